@@ -0,0 +1,84 @@
+#include "bench.h"
+
+#include <cstring>
+
+#include "../rm/rm.h"
+
+static vector<Attribute> appendDescriptor()
+{
+    vector<Attribute> attrs(2);
+    attrs[0].name = "id";
+    attrs[0].type = TypeInt;
+    attrs[0].length = 4;
+    attrs[1].name = "comment";
+    attrs[1].type = TypeVarChar;
+    attrs[1].length = 100;
+    return attrs;
+}
+
+static void makeAppendTuple(int id, char *tuple)
+{
+    int length = 40;
+    tuple[0] = 0;
+    memcpy(tuple + 1, &id, sizeof(int));
+    memcpy(tuple + 1 + sizeof(int), &length, sizeof(int));
+    memset(tuple + 1 + 2 * sizeof(int), 'a' + id % 26, length);
+}
+
+// Load a record file through insertRecord and through appendRecord with a tail page, then a
+// table through insertTuple into a regular table and an append-only one, reporting the pages
+void runAppendBench(const BenchOptions &options)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    RelationManager *rm = RelationManager::instance();
+    vector<Attribute> attrs = appendDescriptor();
+    vector<int> keys = shuffledKeys(options.size, options.seed);
+    char tuple[PAGE_SIZE];
+    RID rid;
+
+    for (int append = 0; append < 2; append++) {
+        const string fileName = "bench_append";
+        rbfm->destroyFile(fileName);
+        FileHandle fileHandle;
+        if (rbfm->createFile(fileName) != SUCCESS || rbfm->openFile(fileName, fileHandle) != SUCCESS) {
+            cerr << "append: creating " << fileName << " failed." << endl;
+            return;
+        }
+        TailPage tail;
+        BenchRun insert("append", append ? "rbfm_append" : "rbfm_insert", options.size);
+        for (unsigned i = 0; i < options.size; i++) {
+            makeAppendTuple(keys[i], tuple);
+            insert.begin();
+            if (append)
+                rbfm->appendRecord(fileHandle, attrs, tuple, tail, rid);
+            else
+                rbfm->insertRecord(fileHandle, attrs, tuple, rid);
+            insert.end();
+        }
+        rbfm->flushTail(fileHandle, tail);
+        insert.addMetric("pages", fileHandle.getNumberOfPages());
+        insert.finish();
+        rbfm->closeFile(fileHandle);
+        rbfm->destroyFile(fileName);
+    }
+
+    for (int append = 0; append < 2; append++) {
+        string tableName = append ? "bench_append_only" : "bench_append_regular";
+        rm->deleteTable(tableName);
+        if (rm->createTable(tableName, attrs, FormatSlotted, PAGE_SIZE, DEFAULT_FILL_FACTOR, append) != SUCCESS) {
+            cerr << "append: creating " << tableName << " failed." << endl;
+            continue;
+        }
+        BenchRun insert("append", append ? "rm_append" : "rm_insert", options.size);
+        for (unsigned i = 0; i < options.size; i++) {
+            makeAppendTuple(keys[i], tuple);
+            insert.begin();
+            rm->insertTuple(tableName, tuple, rid);
+            insert.end();
+        }
+        rm->flush(tableName);
+        insert.addMetric("pages", getPageCount(tableName + TABLE_FILE_EXTENSION));
+        insert.finish();
+        rm->deleteTable(tableName);
+    }
+}
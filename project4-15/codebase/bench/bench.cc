@@ -0,0 +1,331 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../rm/rm.h"
+
+// The JSON objects of the finished runs
+static vector<string> results;
+
+BenchRun::BenchRun(const string &suite, const string &name, unsigned size, const string &keyType)
+{
+    this->suite = suite;
+    this->name = name;
+    this->keyType = keyType;
+    this->size = size;
+    pageReads = 0;
+    pageWrites = 0;
+    latencies.reserve(size);
+}
+
+// Nearest-rank percentile of sorted latencies
+static uint64_t percentile(const vector<uint64_t> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    size_t rank = (size_t) ceil(p * sorted.size());
+    return sorted[rank ? rank - 1 : 0];
+}
+
+void BenchRun::addMetric(const string &name, double value)
+{
+    metrics.push_back(make_pair(name, value));
+}
+
+void BenchRun::finish()
+{
+    vector<uint64_t> sorted(latencies);
+    sort(sorted.begin(), sorted.end());
+    uint64_t total = 0;
+    for (uint64_t latency: sorted)
+        total += latency;
+    double ops = max<size_t>(sorted.size(), 1);
+
+    ostringstream json;
+    json << fixed << setprecision(3)
+         << "    {\"suite\": \"" << suite << "\", \"name\": \"" << name << "\"";
+    if (!keyType.empty())
+        json << ", \"key_type\": \"" << keyType << "\"";
+    json << ", \"size\": " << size << ", \"ops\": " << sorted.size()
+         << ", \"seconds\": " << total / 1e9
+         << ", \"ops_per_sec\": " << (total ? sorted.size() / (total / 1e9) : 0.0)
+         << ",\n     \"latency_ns\": {\"mean\": " << total / ops
+         << ", \"p50\": " << percentile(sorted, 0.50) << ", \"p90\": " << percentile(sorted, 0.90)
+         << ", \"p99\": " << percentile(sorted, 0.99) << ", \"p999\": " << percentile(sorted, 0.999)
+         << ", \"max\": " << (sorted.empty() ? 0 : sorted.back()) << "}"
+         << ",\n     \"page_reads_per_op\": " << pageReads / ops
+         << ", \"page_writes_per_op\": " << pageWrites / ops;
+    for (auto &metric: metrics)
+        json << ", \"" << metric.first << "\": " << metric.second;
+    json << "}";
+    results.push_back(json.str());
+
+    cerr << suite << "." << name << (keyType.empty() ? "" : "." + keyType) << ": " << sorted.size() << " ops, "
+         << (long) (total ? sorted.size() / (total / 1e9) : 0) << " ops/s, p99 " << percentile(sorted, 0.99) << " ns" << endl;
+}
+
+void writeReport(ostream &out, const BenchOptions &options)
+{
+    out << "{\n  \"size\": " << options.size << ",\n  \"seed\": " << options.seed << ",\n  \"device\": \"" << options.device
+        << "\",\n  \"benchmarks\": [\n";
+    for (unsigned i = 0; i < results.size(); i++)
+        out << results[i] << (i + 1 < results.size() ? ",\n" : "\n");
+    out << "  ]\n}" << endl;
+}
+
+string getKeyTypeName(AttrType type)
+{
+    switch (type) {
+        case TypeInt: return "int";
+        case TypeReal: return "real";
+        case TypeVarChar: return "varchar";
+    }
+    return "";
+}
+
+unsigned makeKey(AttrType type, int i, void *key)
+{
+    switch (type) {
+        case TypeInt:
+            memcpy(key, &i, sizeof(int));
+            return sizeof(int);
+        case TypeReal: {
+            float f = i;
+            memcpy(key, &f, sizeof(float));
+            return sizeof(float);
+        }
+        case TypeVarChar: {
+            char digits[BENCH_MAX_KEY_SIZE];
+            int length = snprintf(digits, sizeof(digits), "k%010d", i);
+            memcpy(key, &length, sizeof(int));
+            memcpy((char *) key + sizeof(int), digits, length);
+            return sizeof(int) + length;
+        }
+    }
+    return 0;
+}
+
+vector<int> shuffledKeys(unsigned n, unsigned seed)
+{
+    vector<int> keys(n);
+    for (unsigned i = 0; i < n; i++)
+        keys[i] = i;
+    minstd_rand random(seed);
+    shuffle(keys.begin(), keys.end(), random);
+    return keys;
+}
+
+long getPageCacheKB(const string &fileName)
+{
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        return -1;
+    struct stat sb;
+    long kb = -1;
+    if (fstat(fd, &sb) == 0 && sb.st_size > 0) {
+        // mincore tells which pages of a mapping are resident
+        void *map = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (map != MAP_FAILED) {
+            long osPageSize = sysconf(_SC_PAGESIZE);
+            vector<unsigned char> resident((sb.st_size + osPageSize - 1) / osPageSize);
+            if (mincore(map, sb.st_size, resident.data()) == 0) {
+                kb = 0;
+                for (unsigned char page: resident)
+                    kb += (page & 1) * osPageSize / 1024;
+            }
+            munmap(map, sb.st_size);
+        }
+    }
+    close(fd);
+    return kb;
+}
+
+long getResidentKB()
+{
+    long pages, resident;
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (statm == NULL)
+        return -1;
+    if (fscanf(statm, "%ld %ld", &pages, &resident) != 2)
+        resident = -1;
+    fclose(statm);
+    return resident < 0 ? -1 : resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+unsigned getPageCount(const string &fileName)
+{
+    PagedFileManager *pfm = PagedFileManager::instance();
+    FileHandle fileHandle;
+    if (pfm->openFile(fileName, fileHandle) != SUCCESS)
+        return 0;
+    unsigned pages = fileHandle.getNumberOfPages();
+    pfm->closeFile(fileHandle);
+    return pages;
+}
+
+static void usage()
+{
+    cerr << "usage: bench [--size N] [--seed N] [--keys int,real,varchar] [--out FILE] [--stats FILE]" << endl
+         << "             [--device posix|direct|memory] [--latency READ_US,WRITE_US,BYTES_PER_SEC]" << endl
+         << "             [pfm|rbfm|ix|rm|qe|ycsb|tpch|pax|dict|compress|pagesize|slots|vacuum|fillfactor|append|overflow|direct ...]" << endl;
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+    options.size = 5000;
+    options.seed = 181;
+    string keys = "int,real,varchar";
+    string outFile;
+    string device = "posix";
+    string latency;
+    string statsFile;
+    vector<string> suites;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if ((arg == "--size" || arg == "--seed" || arg == "--keys" || arg == "--out" || arg == "--device" ||
+                arg == "--latency" || arg == "--stats") && i + 1 == argc)
+            usage();
+        if (arg == "--size")
+            options.size = max(atoi(argv[++i]), 100);
+        else if (arg == "--seed")
+            options.seed = atoi(argv[++i]);
+        else if (arg == "--keys")
+            keys = argv[++i];
+        else if (arg == "--out")
+            outFile = argv[++i];
+        else if (arg == "--device")
+            device = argv[++i];
+        else if (arg == "--latency")
+            latency = argv[++i];
+        else if (arg == "--stats")
+            statsFile = argv[++i];
+        else if (arg == "pfm" || arg == "rbfm" || arg == "ix" || arg == "rm" || arg == "qe" ||
+                arg == "ycsb" || arg == "tpch" || arg == "pax" || arg == "dict" || arg == "compress" ||
+                arg == "pagesize" || arg == "slots" || arg == "vacuum" ||
+                arg == "fillfactor" || arg == "append" || arg == "overflow" || arg == "direct")
+            suites.push_back(arg);
+        else
+            usage();
+    }
+
+    stringstream keyList(keys);
+    string key;
+    while (getline(keyList, key, ',')) {
+        if (key == "int")
+            options.keyTypes.push_back(TypeInt);
+        else if (key == "real")
+            options.keyTypes.push_back(TypeReal);
+        else if (key == "varchar")
+            options.keyTypes.push_back(TypeVarChar);
+        else
+            usage();
+    }
+    if (suites.empty())
+        suites = {"pfm", "rbfm", "ix", "rm", "qe", "ycsb", "tpch", "pax", "dict", "compress", "pagesize", "slots", "vacuum",
+                  "fillfactor", "append", "overflow"};
+
+    // Every file lives on the chosen device, slowed down if asked to
+    MemoryPageDevice memoryDevice;
+    PosixPageDevice directDevice(true);
+    PageDevice *pageDevice = PagedFileManager::instance()->getDevice();
+    if (device == "memory")
+        pageDevice = &memoryDevice;
+    else if (device == "direct")
+        pageDevice = &directDevice;
+    else if (device != "posix")
+        usage();
+    unsigned readLatency, writeLatency;
+    unsigned long bandwidth;
+    LatencyPageDevice *slowDevice = NULL;
+    if (!latency.empty()) {
+        if (sscanf(latency.c_str(), "%u,%u,%lu", &readLatency, &writeLatency, &bandwidth) != 3)
+            usage();
+        slowDevice = new LatencyPageDevice(pageDevice, readLatency, writeLatency, bandwidth);
+        pageDevice = slowDevice;
+    }
+    PagedFileManager::instance()->setDevice(pageDevice);
+    options.device = device + (latency.empty() ? "" : " " + latency);
+
+    // rm and qe work on a catalog of their own in the current directory
+    RelationManager *rm = RelationManager::instance();
+    rm->deleteCatalog();
+    if (rm->createCatalog() != SUCCESS) {
+        cerr << "Creating the catalog failed." << endl;
+        return 1;
+    }
+
+    for (const string &suite: suites) {
+        if (suite == "pfm")
+            runPfmBench(options);
+        else if (suite == "rbfm")
+            runRbfmBench(options);
+        else if (suite == "ix")
+            runIxBench(options);
+        else if (suite == "rm")
+            runRmBench(options);
+        else if (suite == "qe")
+            runQeBench(options);
+        else if (suite == "ycsb")
+            runYcsbBench(options);
+        else if (suite == "tpch")
+            runTpchBench(options);
+        else if (suite == "pax")
+            runPaxBench(options);
+        else if (suite == "dict")
+            runDictBench(options);
+        else if (suite == "compress")
+            runCompressBench(options);
+        else if (suite == "pagesize")
+            runPageSizeBench(options);
+        else if (suite == "slots")
+            runSlotsBench(options);
+        else if (suite == "vacuum")
+            runVacuumBench(options);
+        else if (suite == "fillfactor")
+            runFillFactorBench(options);
+        else if (suite == "append")
+            runAppendBench(options);
+        else if (suite == "overflow")
+            runOverflowBench(options);
+        else
+            runDirectBench(options);
+    }
+    rm->deleteCatalog();
+    PagedFileManager::instance()->setDevice(NULL);
+    delete slowDevice;
+    if (directDevice.getBufferedFallbacks() > 0)
+        cerr << "The file system doesn't support direct I/O, files were opened buffered." << endl;
+
+    if (outFile.empty()) {
+        writeReport(cout, options);
+    } else {
+        ofstream out(outFile.c_str());
+        writeReport(out, options);
+    }
+
+    // Per-file statistics of every suite, in Prometheus text for a .prom file and JSON otherwise
+    if (!statsFile.empty()) {
+        ofstream out(statsFile.c_str());
+        if (statsFile.size() > 5 && statsFile.compare(statsFile.size() - 5, 5, ".prom") == 0)
+            StatsRegistry::instance()->writePrometheus(out);
+        else
+            StatsRegistry::instance()->writeJson(out);
+    }
+    return 0;
+}
@@ -0,0 +1,108 @@
+#ifndef _bench_h_
+#define _bench_h_
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <ctime>
+#include <cstdint>
+
+#include "../rbf/pfm.h"
+#include "../rbf/rbfm.h"
+
+using namespace std;
+
+// Largest key makeKey() produces: a varchar with its length prefix
+#define BENCH_MAX_KEY_SIZE 16
+
+// What every benchmark runs with, from the command line
+struct BenchOptions {
+    unsigned size;                  // records, index entries, tuples or page operations
+    vector<AttrType> keyTypes;      // benchmarks with a key run once per type
+    unsigned seed;                  // for the shuffled keys and random accesses
+    string device;                  // where the files live, for the report
+};
+
+// Measures one benchmark. Call begin() and end() around every operation, then finish().
+// Only the time and page I/O between begin() and end() count, so setup can happen in between.
+class BenchRun {
+public:
+    BenchRun(const string &suite, const string &name, unsigned size, const string &keyType = "");
+
+    void begin()
+    {
+        pageReads -= FileHandle::totalReadPageCounter;
+        pageWrites -= FileHandle::totalWritePageCounter + FileHandle::totalAppendPageCounter;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+    }
+
+    void end()
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        latencies.push_back((uint64_t) (now.tv_sec - start.tv_sec) * 1000000000 + now.tv_nsec - start.tv_nsec);
+        pageReads += FileHandle::totalReadPageCounter;
+        pageWrites += FileHandle::totalWritePageCounter + FileHandle::totalAppendPageCounter;
+    }
+
+    // Report an extra value with the run, such as a memory footprint
+    void addMetric(const string &name, double value);
+
+    // Add the results to the report
+    void finish();
+
+private:
+    string suite;
+    string name;
+    string keyType;
+    unsigned size;
+    struct timespec start;
+    vector<uint64_t> latencies;     // in ns, one per operation
+    long pageReads;
+    long pageWrites;                // appended pages included
+    vector<pair<string, double> > metrics;
+};
+
+// All finished runs as one JSON document
+void writeReport(ostream &out, const BenchOptions &options);
+
+string getKeyTypeName(AttrType type);
+
+// Key i of the given type in the API format, ordered like i: varchars are zero-padded numbers.
+// Returns the key's length.
+unsigned makeKey(AttrType type, int i, void *key);
+
+// 0 .. n - 1 in a random order
+vector<int> shuffledKeys(unsigned n, unsigned seed);
+
+// KB of the file in the OS page cache, -1 if it can't be told (not a file of the file system)
+long getPageCacheKB(const string &fileName);
+// KB of memory the process has resident
+long getResidentKB();
+// Pages of a paged file, 0 if it can't be opened
+unsigned getPageCount(const string &fileName);
+
+// The page appends and reads and writes of the pfm suite, named with the suffix.
+// Each run reports how much of the file ended up in the page cache.
+void runPageWorkload(const BenchOptions &options, const string &suite, const string &suffix);
+
+void runPfmBench(const BenchOptions &options);
+void runRbfmBench(const BenchOptions &options);
+void runIxBench(const BenchOptions &options);
+void runRmBench(const BenchOptions &options);
+void runQeBench(const BenchOptions &options);
+void runYcsbBench(const BenchOptions &options);
+void runTpchBench(const BenchOptions &options);
+void runDirectBench(const BenchOptions &options);
+void runPaxBench(const BenchOptions &options);
+void runDictBench(const BenchOptions &options);
+void runCompressBench(const BenchOptions &options);
+void runPageSizeBench(const BenchOptions &options);
+void runSlotsBench(const BenchOptions &options);
+void runVacuumBench(const BenchOptions &options);
+void runFillFactorBench(const BenchOptions &options);
+void runAppendBench(const BenchOptions &options);
+void runOverflowBench(const BenchOptions &options);
+
+#endif
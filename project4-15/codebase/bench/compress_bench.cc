@@ -0,0 +1,122 @@
+#include "bench.h"
+
+#include <cstring>
+
+#include "../rm/rm.h"
+
+static const char *commentWords[] = {"carefully", "final", "deposits", "quickly", "regular", "packages", "ironic", "requests"};
+
+static unsigned makeTuple(int key, char *tuple)
+{
+    tuple[0] = 0;
+    unsigned offset = 1;
+    memcpy(tuple + offset, &key, sizeof(int));
+    offset += sizeof(int);
+    int quantity = 1 + key % 50;
+    memcpy(tuple + offset, &quantity, sizeof(int));
+    offset += sizeof(int);
+    float price = quantity * 901.5f;
+    memcpy(tuple + offset, &price, sizeof(float));
+    offset += sizeof(float);
+    string comment;
+    for (int word = 0; word < 4; word++)
+        comment += string(word ? " " : "") + commentWords[(key * 7 + word * 3) % 8];
+    int length = comment.size();
+    memcpy(tuple + offset, &length, sizeof(int));
+    memcpy(tuple + offset + sizeof(int), comment.data(), length);
+    return offset + sizeof(int) + length;
+}
+
+// Pages of a file over the bytes they take on the device
+static double getCompressionRatio(const string &fileName)
+{
+    FileHandle fileHandle;
+    if (PagedFileManager::instance()->openFile(fileName, fileHandle) != SUCCESS)
+        return 0;
+    double ratio = (double) fileHandle.getNumberOfPages() * PAGE_SIZE / fileHandle.getStoredBytes();
+    PagedFileManager::instance()->closeFile(fileHandle);
+    return ratio;
+}
+
+static void runScans(RelationManager *rm, const string &tableName, const string &suffix, unsigned size)
+{
+    vector<string> attrNames;
+    attrNames.push_back("l_orderkey");
+    attrNames.push_back("l_extendedprice");
+    attrNames.push_back("l_comment");
+    RM_ScanIterator scanIterator;
+    RID rid;
+    char tuple[PAGE_SIZE];
+    BenchRun scan("compress", "scan" + suffix, size);
+    rm->scan(tableName, "", NO_OP, NULL, attrNames, scanIterator);
+    while (true) {
+        scan.begin();
+        RC rc = scanIterator.getNextTuple(rid, tuple);
+        scan.end();
+        if (rc)
+            break;
+    }
+    scanIterator.close();
+    scan.addMetric("ratio", getCompressionRatio(tableName + TABLE_FILE_EXTENSION));
+    scan.finish();
+
+    RM_IndexScanIterator indexScanIterator;
+    char key[PAGE_SIZE];
+    BenchRun indexScan("compress", "index_scan" + suffix, size);
+    rm->indexScan(tableName, "l_orderkey", NULL, NULL, false, false, indexScanIterator);
+    while (true) {
+        indexScan.begin();
+        RC rc = indexScanIterator.getNextEntry(rid, key);
+        indexScan.end();
+        if (rc)
+            break;
+    }
+    indexScanIterator.close();
+    indexScan.addMetric("ratio", getCompressionRatio(tableName + "_l_orderkey" + INDEX_FILE_EXTENSION));
+    indexScan.finish();
+}
+
+// A lineitem-like table and its key index scanned as loaded, then again once compressed as a cold table
+void runCompressBench(const BenchOptions &options)
+{
+    RelationManager *rm = RelationManager::instance();
+    const string tableName = "bench_compress";
+    vector<Attribute> attrs;
+    Attribute attr;
+    attr.name = "l_orderkey";
+    attr.type = TypeInt;
+    attr.length = 4;
+    attrs.push_back(attr);
+    attr.name = "l_quantity";
+    attrs.push_back(attr);
+    attr.name = "l_extendedprice";
+    attr.type = TypeReal;
+    attrs.push_back(attr);
+    attr.name = "l_comment";
+    attr.type = TypeVarChar;
+    attr.length = 44;
+    attrs.push_back(attr);
+
+    rm->deleteTable(tableName);
+    if (rm->createTable(tableName, attrs) != SUCCESS || rm->createIndex(tableName, "l_orderkey") != SUCCESS) {
+        cerr << "compress: creating " << tableName << " failed." << endl;
+        return;
+    }
+    vector<int> keys = shuffledKeys(options.size, options.seed);
+    char tuple[PAGE_SIZE];
+    RID rid;
+    for (unsigned i = 0; i < options.size; i++) {
+        makeTuple(keys[i], tuple);
+        rm->insertTuple(tableName, tuple, rid);
+    }
+    runScans(rm, tableName, "_plain", options.size);
+
+    BenchRun compress("compress", "compress_table", 1);
+    compress.begin();
+    rm->compressTable(tableName);
+    compress.end();
+    compress.finish();
+    runScans(rm, tableName, "_compressed", options.size);
+
+    rm->deleteTable(tableName);
+}
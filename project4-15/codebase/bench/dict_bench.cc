@@ -0,0 +1,110 @@
+#include "bench.h"
+
+#include <cstring>
+
+#include "../rm/rm.h"
+
+static const char *shipModes[] = {"AIR", "FOB", "MAIL", "RAIL", "REG AIR", "SHIP", "TRUCK"};
+
+static unsigned makeTuple(int i, char *tuple)
+{
+    tuple[0] = 0;
+    unsigned offset = 1;
+    memcpy(tuple + offset, &i, sizeof(int));
+    offset += sizeof(int);
+    const char *shipMode = shipModes[(i * 7919) % 7];
+    int length = strlen(shipMode);
+    memcpy(tuple + offset, &length, sizeof(int));
+    memcpy(tuple + offset + sizeof(int), shipMode, length);
+    offset += sizeof(int) + length;
+    float price = i * 1.5;
+    memcpy(tuple + offset, &price, sizeof(float));
+    return offset + sizeof(float);
+}
+
+// One operation per tuple with ship mode TRUCK
+static void runShipModeScan(RelationManager *rm, const string &tableName, BenchRun &run)
+{
+    char value[sizeof(int) + 8];
+    int length = 5;
+    memcpy(value, &length, sizeof(int));
+    memcpy(value + sizeof(int), "TRUCK", length);
+    vector<string> attrNames(1, "l_orderkey");
+    RM_ScanIterator scanIterator;
+    RID rid;
+    char tuple[PAGE_SIZE];
+    rm->scan(tableName, "l_shipmode", EQ_OP, value, attrNames, scanIterator);
+    while (true) {
+        run.begin();
+        RC rc = scanIterator.getNextTuple(rid, tuple);
+        run.end();
+        if (rc)
+            break;
+    }
+    scanIterator.close();
+}
+
+static void runDictBench(const BenchOptions &options, const string &tableName, bool encoded)
+{
+    RelationManager *rm = RelationManager::instance();
+    const string suffix = encoded ? "_encoded" : "_plain";
+    vector<Attribute> attrs;
+    Attribute attr;
+    attr.name = "l_orderkey";
+    attr.type = TypeInt;
+    attr.length = 4;
+    attrs.push_back(attr);
+    attr.name = "l_shipmode";
+    attr.type = TypeVarChar;
+    attr.length = 10;
+    attrs.push_back(attr);
+    attr.name = "l_extendedprice";
+    attr.type = TypeReal;
+    attr.length = 4;
+    attrs.push_back(attr);
+
+    rm->deleteTable(tableName);
+    if (rm->createTable(tableName, attrs) != SUCCESS || (encoded && rm->encodeColumn(tableName, "l_shipmode") != SUCCESS)) {
+        cerr << "dict: creating " << tableName << " failed." << endl;
+        return;
+    }
+
+    char tuple[PAGE_SIZE];
+    RID rid;
+    BenchRun insert("dict", "insert" + suffix, options.size);
+    for (unsigned i = 0; i < options.size; i++) {
+        makeTuple(i, tuple);
+        insert.begin();
+        rm->insertTuple(tableName, tuple, rid);
+        insert.end();
+    }
+    insert.addMetric("pages", getPageCount(tableName + TABLE_FILE_EXTENSION));
+    insert.finish();
+
+    BenchRun scan("dict", "scan_eq" + suffix, options.size);
+    runShipModeScan(rm, tableName, scan);
+    scan.finish();
+}
+
+// A lineitem-like table whose ship mode is one of the 7 TPC-H values, with the column stored as
+// strings and dictionary encoded from the start, then the plain table migrated
+void runDictBench(const BenchOptions &options)
+{
+    RelationManager *rm = RelationManager::instance();
+    runDictBench(options, "bench_dict_encoded", true);
+    runDictBench(options, "bench_dict_plain", false);
+
+    BenchRun migrate("dict", "migrate", options.size);
+    migrate.begin();
+    rm->encodeColumn("bench_dict_plain", "l_shipmode");
+    migrate.end();
+    migrate.addMetric("pages", getPageCount(string("bench_dict_plain") + TABLE_FILE_EXTENSION));
+    migrate.finish();
+
+    BenchRun scan("dict", "scan_eq_migrated", options.size);
+    runShipModeScan(rm, "bench_dict_plain", scan);
+    scan.finish();
+
+    rm->deleteTable("bench_dict_encoded");
+    rm->deleteTable("bench_dict_plain");
+}
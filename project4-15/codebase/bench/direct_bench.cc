@@ -0,0 +1,20 @@
+#include "bench.h"
+
+// The pfm workload on files of the file system, through the OS page cache and then with direct I/O.
+// The runs tell the throughput given up for the page cache memory saved.
+void runDirectBench(const BenchOptions &options)
+{
+    PagedFileManager *pfm = PagedFileManager::instance();
+    PageDevice *previous = pfm->getDevice();
+    PosixPageDevice bufferedDevice(false);
+    PosixPageDevice directDevice(true);
+
+    pfm->setDevice(&bufferedDevice);
+    runPageWorkload(options, "direct", "_buffered");
+    pfm->setDevice(&directDevice);
+    runPageWorkload(options, "direct", "_direct");
+    pfm->setDevice(previous);
+
+    if (directDevice.getBufferedFallbacks() > 0)
+        cerr << "direct: the file system doesn't support direct I/O, the _direct runs were buffered." << endl;
+}
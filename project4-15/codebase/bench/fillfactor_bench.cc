@@ -0,0 +1,68 @@
+#include "bench.h"
+
+#include <cstring>
+
+#include "../rm/rm.h"
+
+// Load a table at each fill factor, grow every tuple by an update and read them all back,
+// reporting the share of tuples the updates forwarded and the pages of the table
+void runFillFactorBench(const BenchOptions &options)
+{
+    const unsigned fillFactors[] = {100, 90, 80, 70};
+    RelationManager *rm = RelationManager::instance();
+    vector<Attribute> attrs(2);
+    attrs[0].name = "id";
+    attrs[0].type = TypeInt;
+    attrs[0].length = 4;
+    attrs[1].name = "comment";
+    attrs[1].type = TypeVarChar;
+    attrs[1].length = 100;
+
+    vector<int> keys = shuffledKeys(options.size, options.seed);
+    char tuple[PAGE_SIZE];
+    for (unsigned fillFactor: fillFactors) {
+        string tableName = "bench_fill_" + to_string(fillFactor);
+        rm->deleteTable(tableName);
+        if (rm->createTable(tableName, attrs, FormatSlotted, PAGE_SIZE, fillFactor) != SUCCESS) {
+            cerr << "fillfactor: creating " << tableName << " failed." << endl;
+            continue;
+        }
+
+        vector<RID> rids(options.size);
+        for (unsigned i = 0; i < options.size; i++) {
+            int length = 40;
+            tuple[0] = 0;
+            memcpy(tuple + 1, &keys[i], sizeof(int));
+            memcpy(tuple + 1 + sizeof(int), &length, sizeof(int));
+            memset(tuple + 1 + 2 * sizeof(int), 'c', length);
+            rm->insertTuple(tableName, tuple, rids[i]);
+        }
+
+        // Half as long again
+        BenchRun update("fillfactor", "update_" + to_string(fillFactor), options.size);
+        for (unsigned i = 0; i < options.size; i++) {
+            int length = 60;
+            memcpy(tuple + 1, &keys[i], sizeof(int));
+            memcpy(tuple + 1 + sizeof(int), &length, sizeof(int));
+            memset(tuple + 1 + 2 * sizeof(int), 'c', length);
+            update.begin();
+            rm->updateTuple(tableName, tuple, rids[i]);
+            update.end();
+        }
+        update.finish();
+
+        FileStats *stats = StatsRegistry::instance()->getFileStats(tableName + ".t");
+        uint64_t hops = stats->forwardHops;
+        BenchRun read("fillfactor", "read_" + to_string(fillFactor), options.size);
+        for (unsigned i = 0; i < options.size; i++) {
+            read.begin();
+            rm->readTuple(tableName, rids[i], tuple);
+            read.end();
+        }
+        read.addMetric("forwarded_ratio", (double) (stats->forwardHops - hops) / options.size);
+        read.addMetric("pages", getPageCount(tableName + TABLE_FILE_EXTENSION));
+        read.finish();
+
+        rm->deleteTable(tableName);
+    }
+}
@@ -0,0 +1,81 @@
+#include "bench.h"
+
+#include "../ix/ix.h"
+
+// Ranges per range scan benchmark, each covering 1% of the keys
+#define IX_BENCH_RANGE_SCANS 100
+
+static void runIxBench(const BenchOptions &options, AttrType keyType)
+{
+    const string fileName = "bench_index";
+    const string type = getKeyTypeName(keyType);
+    IndexManager *ixm = IndexManager::instance();
+    Attribute attr;
+    attr.name = "key";
+    attr.type = keyType;
+    attr.length = keyType == TypeVarChar ? BENCH_MAX_KEY_SIZE : 4;
+    char key[BENCH_MAX_KEY_SIZE];
+    char high[BENCH_MAX_KEY_SIZE];
+    char found[BENCH_MAX_KEY_SIZE];
+
+    ixm->destroyFile(fileName);
+    IXFileHandle ixfileHandle;
+    if (ixm->createFile(fileName) != SUCCESS || ixm->openFile(fileName, ixfileHandle) != SUCCESS) {
+        cerr << "ix: creating " << fileName << " failed." << endl;
+        return;
+    }
+
+    vector<int> keys = shuffledKeys(options.size, options.seed);
+    BenchRun insert("ix", "insert", options.size, type);
+    for (unsigned i = 0; i < options.size; i++) {
+        RID rid;
+        rid.pageNum = keys[i] / 100;
+        rid.slotNum = keys[i] % 100;
+        makeKey(keyType, keys[i], key);
+        insert.begin();
+        ixm->insertEntry(ixfileHandle, attr, key, rid);
+        insert.end();
+    }
+    insert.finish();
+
+    // Open a scan on [key, key], fetch the entry and close
+    vector<int> order = shuffledKeys(options.size, options.seed + 1);
+    BenchRun lookup("ix", "point_lookup", options.size, type);
+    for (unsigned i = 0; i < options.size; i++) {
+        IX_ScanIterator scanIterator;
+        RID rid;
+        makeKey(keyType, order[i], key);
+        lookup.begin();
+        ixm->scan(ixfileHandle, attr, key, key, true, true, scanIterator);
+        scanIterator.getNextEntry(rid, found);
+        scanIterator.close();
+        lookup.end();
+    }
+    lookup.finish();
+
+    // One operation per range
+    unsigned rangeSize = max(options.size / 100, 1u);
+    BenchRun rangeScan("ix", "range_scan", options.size, type);
+    for (unsigned i = 0; i < IX_BENCH_RANGE_SCANS; i++) {
+        IX_ScanIterator scanIterator;
+        RID rid;
+        int low = order[i] % (options.size - rangeSize + 1);
+        makeKey(keyType, low, key);
+        makeKey(keyType, low + rangeSize - 1, high);
+        rangeScan.begin();
+        ixm->scan(ixfileHandle, attr, key, high, true, true, scanIterator);
+        while (scanIterator.getNextEntry(rid, found) == SUCCESS);
+        scanIterator.close();
+        rangeScan.end();
+    }
+    rangeScan.finish();
+
+    ixm->closeFile(ixfileHandle);
+    ixm->destroyFile(fileName);
+}
+
+void runIxBench(const BenchOptions &options)
+{
+    for (AttrType keyType: options.keyTypes)
+        runIxBench(options, keyType);
+}
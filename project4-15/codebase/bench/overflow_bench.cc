@@ -0,0 +1,86 @@
+#include "bench.h"
+
+#include <cstring>
+
+#include "../rm/rm.h"
+
+static const int bodyLength = 2000;
+
+static unsigned makeWideTuple(int id, char *tuple)
+{
+    tuple[0] = 0;
+    memcpy(tuple + 1, &id, sizeof(int));
+    memcpy(tuple + 1 + sizeof(int), &bodyLength, sizeof(int));
+    for (int i = 0; i < bodyLength; i++)
+        tuple[1 + 2 * sizeof(int) + i] = 'a' + (id + i) % 26;
+    return 1 + 2 * sizeof(int) + bodyLength;
+}
+
+// One operation per tuple returned
+static void runWideScan(RelationManager *rm, const string &tableName, const string &attributeName, BenchRun &run)
+{
+    vector<string> attrNames(1, attributeName);
+    RM_ScanIterator scanIterator;
+    RID rid;
+    char tuple[PAGE_SIZE];
+    rm->scan(tableName, "", NO_OP, NULL, attrNames, scanIterator);
+    while (true) {
+        run.begin();
+        RC rc = scanIterator.getNextTuple(rid, tuple);
+        run.end();
+        if (rc)
+            break;
+    }
+    scanIterator.close();
+}
+
+// A table of ids with a 2000 byte body, stored in the tuples and out of line (plain and
+// compressed), scanned for the ids only and for the bodies
+void runOverflowBench(const BenchOptions &options)
+{
+    RelationManager *rm = RelationManager::instance();
+    vector<Attribute> attrs(2);
+    attrs[0].name = "id";
+    attrs[0].type = TypeInt;
+    attrs[0].length = 4;
+    attrs[1].name = "body";
+    attrs[1].type = TypeVarChar;
+    attrs[1].length = bodyLength;
+    vector<int> keys = shuffledKeys(options.size, options.seed);
+    const char *layouts[] = {"inline", "out_of_line", "out_of_line_lz"};
+    char tuple[PAGE_SIZE];
+    RID rid;
+
+    for (int layout = 0; layout < 3; layout++) {
+        const string suffix = string("_") + layouts[layout];
+        const string tableName = "bench_overflow";
+        rm->deleteTable(tableName);
+        if (rm->createTable(tableName, attrs) != SUCCESS ||
+            (layout > 0 && rm->storeOutOfLine(tableName, "body", OVERFLOW_DEFAULT_THRESHOLD, layout == 2) != SUCCESS)) {
+            cerr << "overflow: creating " << tableName << " failed." << endl;
+            return;
+        }
+
+        BenchRun insert("overflow", "insert" + suffix, options.size);
+        for (unsigned i = 0; i < options.size; i++) {
+            makeWideTuple(keys[i], tuple);
+            insert.begin();
+            rm->insertTuple(tableName, tuple, rid);
+            insert.end();
+        }
+        string fileName = tableName + TABLE_FILE_EXTENSION;
+        insert.addMetric("pages", getPageCount(fileName));
+        insert.addMetric("overflow_pages", getPageCount(fileName + ".ovf"));
+        insert.finish();
+
+        BenchRun scanIds("overflow", "scan_id" + suffix, options.size);
+        runWideScan(rm, tableName, "id", scanIds);
+        scanIds.finish();
+
+        BenchRun scanBodies("overflow", "scan_body" + suffix, options.size);
+        runWideScan(rm, tableName, "body", scanBodies);
+        scanBodies.finish();
+
+        rm->deleteTable(tableName);
+    }
+}
@@ -0,0 +1,115 @@
+#include "bench.h"
+
+#include <cstring>
+
+#include "../rm/rm.h"
+#include "../ix/ix.h"
+
+// A customer name of NAME_LENGTH characters, ordered like i
+#define NAME_LENGTH 40
+
+static unsigned makeName(int i, char *name)
+{
+    int length = NAME_LENGTH;
+    memcpy(name, &length, sizeof(int));
+    snprintf(name + sizeof(int), NAME_LENGTH + 1, "customer-%031d", i);
+    return sizeof(int) + NAME_LENGTH;
+}
+
+// Levels of the index on the table's name
+static unsigned getIndexHeight(const string &tableName)
+{
+    IndexManager *im = IndexManager::instance();
+    IXFileHandle ixfileHandle;
+    if (im->openFile(tableName + "_name" + INDEX_FILE_EXTENSION, ixfileHandle) != SUCCESS)
+        return 0;
+    unsigned height = 0, leafCount, entryCount;
+    im->getTreeStatistics(ixfileHandle, height, leafCount, entryCount);
+    im->closeFile(ixfileHandle);
+    return height;
+}
+
+// The same table and name index with pages of 4 KB up to MAX_PAGE_SIZE: load, scan, index scan and lookups
+void runPageSizeBench(const BenchOptions &options)
+{
+    RelationManager *rm = RelationManager::instance();
+    vector<Attribute> attrs;
+    Attribute attr;
+    attr.name = "name";
+    attr.type = TypeVarChar;
+    attr.length = NAME_LENGTH;
+    attrs.push_back(attr);
+    attr.name = "comment";
+    attr.length = 100;
+    attrs.push_back(attr);
+
+    vector<int> keys = shuffledKeys(options.size, options.seed);
+    vector<string> attrNames(1, "name");
+    char tuple[PAGE_SIZE];
+    char key[PAGE_SIZE];
+    RID rid;
+    for (unsigned pageSize = PAGE_SIZE; pageSize <= MAX_PAGE_SIZE; pageSize *= 2) {
+        string suffix = "_" + to_string(pageSize / 1024) + "k";
+        string tableName = "bench_pagesize" + suffix;
+        rm->deleteTable(tableName);
+        if (rm->createTable(tableName, attrs, FormatSlotted, pageSize) != SUCCESS ||
+                rm->createIndex(tableName, "name", pageSize) != SUCCESS) {
+            cerr << "pagesize: creating " << tableName << " failed." << endl;
+            continue;
+        }
+
+        BenchRun insert("pagesize", "insert" + suffix, options.size);
+        for (unsigned i = 0; i < options.size; i++) {
+            tuple[0] = 0;
+            unsigned offset = 1 + makeName(keys[i], tuple + 1);
+            int length = 20 + keys[i] % 80;
+            memcpy(tuple + offset, &length, sizeof(int));
+            memset(tuple + offset + sizeof(int), 'a' + keys[i] % 26, length);
+            insert.begin();
+            rm->insertTuple(tableName, tuple, rid);
+            insert.end();
+        }
+        insert.finish();
+
+        RM_ScanIterator scanIterator;
+        BenchRun scan("pagesize", "scan" + suffix, options.size);
+        rm->scan(tableName, "", NO_OP, NULL, attrNames, scanIterator);
+        while (true) {
+            scan.begin();
+            RC rc = scanIterator.getNextTuple(rid, tuple);
+            scan.end();
+            if (rc)
+                break;
+        }
+        scanIterator.close();
+        scan.finish();
+
+        RM_IndexScanIterator indexScanIterator;
+        BenchRun indexScan("pagesize", "index_scan" + suffix, options.size);
+        rm->indexScan(tableName, "name", NULL, NULL, false, false, indexScanIterator);
+        while (true) {
+            indexScan.begin();
+            RC rc = indexScanIterator.getNextEntry(rid, key);
+            indexScan.end();
+            if (rc)
+                break;
+        }
+        indexScanIterator.close();
+        indexScan.addMetric("height", getIndexHeight(tableName));
+        indexScan.finish();
+
+        // Descents from the root, one per name
+        BenchRun lookup("pagesize", "index_lookup" + suffix, options.size);
+        for (unsigned i = 0; i < options.size; i++) {
+            makeName(keys[i], key);
+            lookup.begin();
+            rm->indexScan(tableName, "name", key, key, true, true, indexScanIterator);
+            indexScanIterator.getNextEntry(rid, key);
+            indexScanIterator.close();
+            lookup.end();
+        }
+        lookup.finish();
+
+        rm->deleteTable(tableName);
+    }
+}
@@ -0,0 +1,115 @@
+#include "bench.h"
+
+#include <cstring>
+#include <sstream>
+
+// Records have 20 attributes: 10 ints, 5 reals and 5 varchars of 8 to 16 bytes
+#define PAX_BENCH_ATTRIBUTES 20
+
+static vector<Attribute> recordDescriptor()
+{
+    vector<Attribute> descriptor;
+    for (unsigned i = 0; i < PAX_BENCH_ATTRIBUTES; i++) {
+        Attribute attr;
+        stringstream name;
+        name << "a" << i;
+        attr.name = name.str();
+        attr.type = i < 10 ? TypeInt : (i < 15 ? TypeReal : TypeVarChar);
+        attr.length = attr.type == TypeVarChar ? 16 : 4;
+        descriptor.push_back(attr);
+    }
+    return descriptor;
+}
+
+static unsigned makeRecord(const vector<Attribute> &descriptor, int i, char *record)
+{
+    unsigned nullBytes = (descriptor.size() + 7) / 8;
+    memset(record, 0, nullBytes);
+    unsigned offset = nullBytes;
+    for (unsigned j = 0; j < descriptor.size(); j++) {
+        if (descriptor[j].type == TypeInt) {
+            int value = i * (j + 1);
+            memcpy(record + offset, &value, sizeof(int));
+            offset += sizeof(int);
+        } else if (descriptor[j].type == TypeReal) {
+            float value = i * 0.5 + j;
+            memcpy(record + offset, &value, sizeof(float));
+            offset += sizeof(float);
+        } else {
+            int length = 8 + (i + j) % 9;
+            memcpy(record + offset, &length, sizeof(int));
+            memset(record + offset + sizeof(int), 'a' + (i + j) % 26, length);
+            offset += sizeof(int) + length;
+        }
+    }
+    return offset;
+}
+
+static void runScan(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &descriptor,
+        const string &conditionAttribute, CompOp compOp, const void *value, BenchRun &run)
+{
+    // The first int and the first real
+    vector<string> attrNames;
+    attrNames.push_back("a0");
+    attrNames.push_back("a10");
+    RBFM_ScanIterator scanIterator;
+    RID rid;
+    char record[PAGE_SIZE];
+    rbfm->scan(fileHandle, descriptor, conditionAttribute, compOp, value, attrNames, scanIterator);
+    while (true) {
+        run.begin();
+        RC rc = scanIterator.getNextRecord(rid, record);
+        run.end();
+        if (rc)
+            break;
+    }
+    scanIterator.close();
+}
+
+static void runPaxBench(const BenchOptions &options, FileFormat format, const string &suffix)
+{
+    const string fileName = "bench_pax";
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    vector<Attribute> descriptor = recordDescriptor();
+    char record[PAGE_SIZE];
+
+    rbfm->destroyFile(fileName);
+    FileHandle fileHandle;
+    if (rbfm->createFile(fileName, format) != SUCCESS || rbfm->openFile(fileName, fileHandle) != SUCCESS) {
+        cerr << "pax: creating " << fileName << " failed." << endl;
+        return;
+    }
+
+    vector<int> keys = shuffledKeys(options.size, options.seed);
+    BenchRun insert("pax", "insert" + suffix, options.size);
+    RID rid;
+    for (unsigned i = 0; i < options.size; i++) {
+        makeRecord(descriptor, keys[i], record);
+        insert.begin();
+        rbfm->insertRecord(fileHandle, descriptor, record, rid);
+        insert.end();
+    }
+    insert.addMetric("pages", fileHandle.getNumberOfPages());
+    insert.finish();
+
+    // One operation per record returned
+    BenchRun scan("pax", "scan" + suffix, options.size);
+    runScan(rbfm, fileHandle, descriptor, "", NO_OP, NULL, scan);
+    scan.finish();
+
+    // a5 below its median: half the records
+    int median = options.size / 2 * 6;
+    BenchRun scanFiltered("pax", "scan_filtered" + suffix, options.size);
+    runScan(rbfm, fileHandle, descriptor, "a5", LT_OP, &median, scanFiltered);
+    scanFiltered.finish();
+
+    rbfm->closeFile(fileHandle);
+    rbfm->destroyFile(fileName);
+}
+
+// Scans that project 2 of 20 attributes, over a slotted file and then a PAX file of the same records
+void runPaxBench(const BenchOptions &options)
+{
+    runPaxBench(options, FormatSlotted, "_slotted");
+    runPaxBench(options, FormatPax, "_pax");
+}
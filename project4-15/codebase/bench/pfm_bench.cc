@@ -0,0 +1,76 @@
+#include "bench.h"
+
+#include <cstring>
+
+#include "../rbf/arena.h"
+
+static void finishPageRun(BenchRun &run, const string &fileName)
+{
+    long pageCacheKB = getPageCacheKB(fileName);
+    if (pageCacheKB >= 0)
+        run.addMetric("page_cache_kb", pageCacheKB);
+    run.addMetric("rss_kb", getResidentKB());
+    run.finish();
+}
+
+// Page appends, then random and sequential page reads and random page writes.
+// One page per ten operations, so the file is options.size / 10 pages.
+void runPageWorkload(const BenchOptions &options, const string &suite, const string &suffix)
+{
+    const string fileName = "bench_pages";
+    PagedFileManager *pfm = PagedFileManager::instance();
+    unsigned pages = max(options.size / 10, 10u);
+    // Aligned, so direct I/O needs no bounce buffer
+    char *page = (char *) PageBufferPool::acquire();
+    memset(page, 'p', PAGE_SIZE);
+
+    pfm->destroyFile(fileName);
+    FileHandle fileHandle;
+    if (pfm->createFile(fileName) != SUCCESS || pfm->openFile(fileName, fileHandle) != SUCCESS) {
+        cerr << suite << ": creating " << fileName << " failed." << endl;
+        PageBufferPool::release(page);
+        return;
+    }
+
+    BenchRun append(suite, "page_append" + suffix, pages);
+    for (unsigned i = 0; i < pages; i++) {
+        append.begin();
+        fileHandle.appendPage(page);
+        append.end();
+    }
+    finishPageRun(append, fileName);
+
+    vector<int> order = shuffledKeys(options.size, options.seed);
+    BenchRun randomRead(suite, "page_read_random" + suffix, options.size);
+    for (unsigned i = 0; i < options.size; i++) {
+        randomRead.begin();
+        fileHandle.readPage(order[i] % pages, page);
+        randomRead.end();
+    }
+    finishPageRun(randomRead, fileName);
+
+    BenchRun sequentialRead(suite, "page_read_sequential" + suffix, options.size);
+    for (unsigned i = 0; i < options.size; i++) {
+        sequentialRead.begin();
+        fileHandle.readPage(i % pages, page);
+        sequentialRead.end();
+    }
+    finishPageRun(sequentialRead, fileName);
+
+    BenchRun randomWrite(suite, "page_write_random" + suffix, options.size);
+    for (unsigned i = 0; i < options.size; i++) {
+        randomWrite.begin();
+        fileHandle.writePage(order[i] % pages, page);
+        randomWrite.end();
+    }
+    finishPageRun(randomWrite, fileName);
+
+    pfm->closeFile(fileHandle);
+    pfm->destroyFile(fileName);
+    PageBufferPool::release(page);
+}
+
+void runPfmBench(const BenchOptions &options)
+{
+    runPageWorkload(options, "pfm", "");
+}
@@ -0,0 +1,160 @@
+#include "bench.h"
+
+#include <cstring>
+
+#include "../qe/qe.h"
+
+// bench_qe(A int, B real, C varchar(30)) with A = i and B = i, and bench_qe_outer(A int) with
+// every tenth value of A. The operators run over them one getNextTuple call per operation.
+static RC createQeTables(RelationManager &rm, unsigned size)
+{
+    vector<Attribute> attrs;
+    Attribute attr;
+    attr.name = "A";
+    attr.type = TypeInt;
+    attr.length = 4;
+    attrs.push_back(attr);
+    rm.deleteTable("bench_qe_outer");
+    RC rc = rm.createTable("bench_qe_outer", attrs);
+    if (rc)
+        return rc;
+
+    attr.name = "B";
+    attr.type = TypeReal;
+    attrs.push_back(attr);
+    attr.name = "C";
+    attr.type = TypeVarChar;
+    attr.length = 30;
+    attrs.push_back(attr);
+    rm.deleteTable("bench_qe");
+    if ((rc = rm.createTable("bench_qe", attrs)))
+        return rc;
+
+    char tuple[PAGE_SIZE];
+    RID rid;
+    for (unsigned i = 0; i < size; i++) {
+        int a = i;
+        float b = i;
+        int length = 10 + i % 20;
+        tuple[0] = 0;
+        memcpy(tuple + 1, &a, sizeof(int));
+        if (i % 10 == 0 && (rc = rm.insertTuple("bench_qe_outer", tuple, rid)))
+            return rc;
+        memcpy(tuple + 1 + sizeof(int), &b, sizeof(float));
+        memcpy(tuple + 1 + 2 * sizeof(int), &length, sizeof(int));
+        memset(tuple + 1 + 3 * sizeof(int), 'c', length);
+        if ((rc = rm.insertTuple("bench_qe", tuple, rid)))
+            return rc;
+    }
+    return rm.createIndex("bench_qe", "A");
+}
+
+static void drain(BenchRun &run, Iterator *plan)
+{
+    char tuple[PAGE_SIZE];
+    while (true) {
+        run.begin();
+        RC rc = plan->getNextTuple(tuple);
+        run.end();
+        if (rc)
+            break;
+    }
+    run.finish();
+}
+
+// Wall time in ns of running SELECT C FROM bench_qe WHERE B < half to the end, with every operator
+// wrapped in a default Instrument or with none wrapped
+static uint64_t timeFilterPlan(RelationManager &rm, const Condition &cond, bool instrumented)
+{
+    TableScan scan(rm, "bench_qe");
+    Instrument scanned(&scan, "TableScan");
+    Filter filter(instrumented ? (Iterator *) &scanned : &scan, cond);
+    Instrument filtered(&filter, "Filter", vector<Instrument *>(1, &scanned));
+    Project project(instrumented ? (Iterator *) &filtered : &filter, vector<string>(1, "bench_qe.C"));
+    Instrument root(&project, "Project", vector<Instrument *>(1, &filtered));
+    Iterator *plan = instrumented ? (Iterator *) &root : &project;
+
+    char tuple[PAGE_SIZE];
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (plan->getNextTuple(tuple) == SUCCESS)
+        ;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (uint64_t) (end.tv_sec - start.tv_sec) * 1000000000 + end.tv_nsec - start.tv_nsec;
+}
+
+void runQeBench(const BenchOptions &options)
+{
+    RelationManager &rm = *RelationManager::instance();
+    if (createQeTables(rm, options.size) != SUCCESS) {
+        cerr << "qe: creating the tables failed." << endl;
+        return;
+    }
+
+    // SELECT * FROM bench_qe WHERE B < size / 2
+    float half = options.size / 2;
+    Condition cond;
+    cond.lhsAttr = "bench_qe.B";
+    cond.op = LT_OP;
+    cond.bRhsIsAttr = false;
+    cond.rhsValue.type = TypeReal;
+    cond.rhsValue.data = &half;
+    {
+        TableScan scan(rm, "bench_qe");
+        Filter filter(&scan, cond);
+        BenchRun run("qe", "filter", options.size);
+        drain(run, &filter);
+    }
+
+    // SELECT C FROM bench_qe
+    {
+        TableScan scan(rm, "bench_qe");
+        Project project(&scan, vector<string>(1, "bench_qe.C"));
+        BenchRun run("qe", "project", options.size);
+        drain(run, &project);
+    }
+
+    // SELECT C FROM bench_qe WHERE B < size / 2 with every operator counted by an Instrument. The
+    // overhead is the median ratio of an instrumented run to a plain run right after it, so both
+    // see the same cache and clock rate.
+    {
+        TableScan scan(rm, "bench_qe");
+        Instrument scanned(&scan, "TableScan");
+        Filter filter(&scanned, cond);
+        Instrument filtered(&filter, "Filter", vector<Instrument *>(1, &scanned));
+        Project project(&filtered, vector<string>(1, "bench_qe.C"));
+        Instrument root(&project, "Project", vector<Instrument *>(1, &filtered));
+        BenchRun run("qe", "instrument", options.size);
+        vector<double> ratios;
+        for (int i = 0; i < 21; i++) {
+            uint64_t instrumented = timeFilterPlan(rm, cond, true);
+            ratios.push_back((double) instrumented / timeFilterPlan(rm, cond, false));
+        }
+        sort(ratios.begin(), ratios.end());
+        run.addMetric("overhead", ratios[ratios.size() / 2]);
+        drain(run, &root);
+    }
+
+    // SELECT * FROM bench_qe_outer, bench_qe WHERE bench_qe_outer.A = bench_qe.A
+    cond.lhsAttr = "bench_qe_outer.A";
+    cond.op = EQ_OP;
+    cond.bRhsIsAttr = true;
+    cond.rhsAttr = "bench_qe.A";
+    {
+        TableScan outer(rm, "bench_qe_outer");
+        IndexScan inner(rm, "bench_qe", "A");
+        INLJoin join(&outer, &inner, cond);
+        BenchRun run("qe", "inl_join", options.size);
+        drain(run, &join);
+    }
+    {
+        TableScan outer(rm, "bench_qe_outer");
+        TableScan inner(rm, "bench_qe");
+        HashJoin join(&outer, &inner, cond);
+        BenchRun run("qe", "hash_join", options.size);
+        drain(run, &join);
+    }
+
+    rm.deleteTable("bench_qe_outer");
+    rm.deleteTable("bench_qe");
+}
@@ -0,0 +1,113 @@
+#include "bench.h"
+
+#include <cstring>
+
+// Records are (key, payload): a key of the benchmarked type and a 40 byte varchar that
+// updates grow to 120 bytes, moving some records to other pages.
+static vector<Attribute> recordDescriptor(AttrType keyType)
+{
+    vector<Attribute> descriptor;
+    Attribute attr;
+    attr.name = "key";
+    attr.type = keyType;
+    attr.length = keyType == TypeVarChar ? BENCH_MAX_KEY_SIZE : 4;
+    descriptor.push_back(attr);
+    attr.name = "payload";
+    attr.type = TypeVarChar;
+    attr.length = 120;
+    descriptor.push_back(attr);
+    return descriptor;
+}
+
+static void makeRecord(AttrType keyType, int i, int payloadLength, char *record)
+{
+    record[0] = 0;
+    unsigned offset = 1 + makeKey(keyType, i, record + 1);
+    memcpy(record + offset, &payloadLength, sizeof(int));
+    memset(record + offset + sizeof(int), 'a' + i % 26, payloadLength);
+}
+
+static void runRbfmBench(const BenchOptions &options, AttrType keyType)
+{
+    const string fileName = "bench_records";
+    const string type = getKeyTypeName(keyType);
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    vector<Attribute> descriptor = recordDescriptor(keyType);
+    char record[PAGE_SIZE];
+
+    rbfm->destroyFile(fileName);
+    FileHandle fileHandle;
+    if (rbfm->createFile(fileName) != SUCCESS || rbfm->openFile(fileName, fileHandle) != SUCCESS) {
+        cerr << "rbfm: creating " << fileName << " failed." << endl;
+        return;
+    }
+
+    vector<int> keys = shuffledKeys(options.size, options.seed);
+    vector<RID> rids(options.size);
+    BenchRun insert("rbfm", "insert", options.size, type);
+    for (unsigned i = 0; i < options.size; i++) {
+        makeRecord(keyType, keys[i], 40, record);
+        insert.begin();
+        rbfm->insertRecord(fileHandle, descriptor, record, rids[i]);
+        insert.end();
+    }
+    insert.finish();
+
+    vector<int> order = shuffledKeys(options.size, options.seed + 1);
+    BenchRun read("rbfm", "read", options.size, type);
+    for (unsigned i = 0; i < options.size; i++) {
+        read.begin();
+        rbfm->readRecord(fileHandle, descriptor, rids[order[i]], record);
+        read.end();
+    }
+    read.finish();
+
+    BenchRun update("rbfm", "update", options.size, type);
+    for (unsigned i = 0; i < options.size; i++) {
+        makeRecord(keyType, keys[order[i]], 120, record);
+        update.begin();
+        rbfm->updateRecord(fileHandle, descriptor, record, rids[order[i]]);
+        update.end();
+    }
+    update.finish();
+
+    // One operation per record returned
+    vector<string> attrNames(1, "payload");
+    RBFM_ScanIterator scanIterator;
+    RID rid;
+    rbfm->scan(fileHandle, descriptor, "", NO_OP, NULL, attrNames, scanIterator);
+    BenchRun scan("rbfm", "scan", options.size, type);
+    while (true) {
+        scan.begin();
+        RC rc = scanIterator.getNextRecord(rid, record);
+        scan.end();
+        if (rc)
+            break;
+    }
+    scanIterator.close();
+    scan.finish();
+
+    // Keys below the median: half the records
+    char median[BENCH_MAX_KEY_SIZE];
+    makeKey(keyType, options.size / 2, median);
+    rbfm->scan(fileHandle, descriptor, "key", LT_OP, median, attrNames, scanIterator);
+    BenchRun scanFiltered("rbfm", "scan_filtered", options.size, type);
+    while (true) {
+        scanFiltered.begin();
+        RC rc = scanIterator.getNextRecord(rid, record);
+        scanFiltered.end();
+        if (rc)
+            break;
+    }
+    scanIterator.close();
+    scanFiltered.finish();
+
+    rbfm->closeFile(fileHandle);
+    rbfm->destroyFile(fileName);
+}
+
+void runRbfmBench(const BenchOptions &options)
+{
+    for (AttrType keyType: options.keyTypes)
+        runRbfmBench(options, keyType);
+}
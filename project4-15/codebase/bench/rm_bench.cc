@@ -0,0 +1,78 @@
+#include "bench.h"
+
+#include <cstring>
+
+#include "../rm/rm.h"
+
+// Catalog operations, then tuple inserts and reads through the RelationManager,
+// which also keep an index and the statistics up to date
+void runRmBench(const BenchOptions &options)
+{
+    RelationManager *rm = RelationManager::instance();
+    unsigned tables = max(options.size / 50, 10u);
+    vector<Attribute> attrs;
+    Attribute attr;
+    attr.name = "id";
+    attr.type = TypeInt;
+    attr.length = 4;
+    attrs.push_back(attr);
+    attr.name = "name";
+    attr.type = TypeVarChar;
+    attr.length = 40;
+    attrs.push_back(attr);
+
+    BenchRun create("rm", "create_table", tables);
+    for (unsigned i = 0; i < tables; i++) {
+        string tableName = "bench_table_" + to_string(i);
+        rm->deleteTable(tableName);
+        create.begin();
+        rm->createTable(tableName, attrs);
+        create.end();
+    }
+    create.finish();
+
+    vector<int> order = shuffledKeys(options.size, options.seed);
+    BenchRun getAttributes("rm", "get_attributes", options.size);
+    for (unsigned i = 0; i < options.size; i++) {
+        vector<Attribute> tableAttrs;
+        getAttributes.begin();
+        rm->getAttributes("bench_table_" + to_string(order[i] % tables), tableAttrs);
+        getAttributes.end();
+    }
+    getAttributes.finish();
+
+    BenchRun destroy("rm", "delete_table", tables);
+    for (unsigned i = 1; i < tables; i++) {
+        destroy.begin();
+        rm->deleteTable("bench_table_" + to_string(i));
+        destroy.end();
+    }
+    destroy.finish();
+
+    const string tableName = "bench_table_0";
+    rm->createIndex(tableName, "id");
+    char tuple[PAGE_SIZE];
+    vector<RID> rids(options.size);
+    BenchRun insert("rm", "insert_tuple", options.size);
+    for (unsigned i = 0; i < options.size; i++) {
+        int length = 20 + order[i] % 20;
+        tuple[0] = 0;
+        memcpy(tuple + 1, &order[i], sizeof(int));
+        memcpy(tuple + 1 + sizeof(int), &length, sizeof(int));
+        memset(tuple + 1 + 2 * sizeof(int), 'n', length);
+        insert.begin();
+        rm->insertTuple(tableName, tuple, rids[i]);
+        insert.end();
+    }
+    insert.finish();
+
+    BenchRun read("rm", "read_tuple", options.size);
+    for (unsigned i = 0; i < options.size; i++) {
+        read.begin();
+        rm->readTuple(tableName, rids[order[i]], tuple);
+        read.end();
+    }
+    read.finish();
+
+    rm->deleteTable(tableName);
+}
@@ -0,0 +1,81 @@
+#include "bench.h"
+
+#include <cstring>
+
+// Records of two ints, stored in 15 bytes: the slot directory is a large part of each page
+static vector<Attribute> recordDescriptor()
+{
+    vector<Attribute> descriptor(2);
+    descriptor[0].name = "id";
+    descriptor[0].type = TypeInt;
+    descriptor[0].length = 4;
+    descriptor[1].name = "value";
+    descriptor[1].type = TypeInt;
+    descriptor[1].length = 4;
+    return descriptor;
+}
+
+// Load, scan and read back a narrow table, reporting the records per page next to what slots
+// of 8 bytes (a 32 bit offset and length) would fit
+void runSlotsBench(const BenchOptions &options)
+{
+    const string fileName = "bench_slots";
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    vector<Attribute> descriptor = recordDescriptor();
+    char record[PAGE_SIZE];
+
+    rbfm->destroyFile(fileName);
+    FileHandle fileHandle;
+    if (rbfm->createFile(fileName) != SUCCESS || rbfm->openFile(fileName, fileHandle) != SUCCESS) {
+        cerr << "slots: creating " << fileName << " failed." << endl;
+        return;
+    }
+
+    vector<int> keys = shuffledKeys(options.size, options.seed);
+    vector<RID> rids(options.size);
+    BenchRun insert("slots", "insert", options.size);
+    for (unsigned i = 0; i < options.size; i++) {
+        int value = keys[i] * 7;
+        record[0] = 0;
+        memcpy(record + 1, &keys[i], sizeof(int));
+        memcpy(record + 1 + sizeof(int), &value, sizeof(int));
+        insert.begin();
+        rbfm->insertRecord(fileHandle, descriptor, record, rids[i]);
+        insert.end();
+    }
+    unsigned pages = fileHandle.getNumberOfPages();
+    unsigned storedSize = sizeof(RecordLength) + descriptor.size() * sizeof(ColumnOffset) + 1 + 2 * sizeof(int);
+    insert.addMetric("pages", pages);
+    insert.addMetric("tuples_per_page", pages == 0 ? 0 : (double) options.size / pages);
+    insert.addMetric("tuples_per_page_8_byte_slots", (PAGE_SIZE - sizeof(SlotDirectoryHeader)) / (storedSize + 8));
+    insert.finish();
+
+    // One operation per record returned
+    vector<string> attrNames;
+    attrNames.push_back("id");
+    attrNames.push_back("value");
+    RBFM_ScanIterator scanIterator;
+    RID rid;
+    BenchRun scan("slots", "scan", options.size);
+    rbfm->scan(fileHandle, descriptor, "", NO_OP, NULL, attrNames, scanIterator);
+    while (true) {
+        scan.begin();
+        RC rc = scanIterator.getNextRecord(rid, record);
+        scan.end();
+        if (rc)
+            break;
+    }
+    scanIterator.close();
+    scan.finish();
+
+    BenchRun read("slots", "read", options.size);
+    for (unsigned i = 0; i < options.size; i++) {
+        read.begin();
+        rbfm->readRecord(fileHandle, descriptor, rids[i], record);
+        read.end();
+    }
+    read.finish();
+
+    rbfm->closeFile(fileHandle);
+    rbfm->destroyFile(fileName);
+}
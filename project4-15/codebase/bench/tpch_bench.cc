@@ -0,0 +1,285 @@
+#include "bench.h"
+
+#include <cstring>
+#include <map>
+#include <random>
+
+#include "../qe/qe.h"
+
+// Times every query is run, after one untimed run that prints its result
+#define TPCH_REPETITIONS 5
+// Days of order dates, from day 0
+#define TPCH_DAYS 2557
+
+// A cut-down TPC-H schema: nation, customer, orders and lineitem with the columns the queries use.
+// options.size lineitems, four per order, ten orders per customer and 25 nations.
+static Attribute makeAttribute(const string &name, AttrType type, unsigned length = 4)
+{
+    Attribute attr;
+    attr.name = name;
+    attr.type = type;
+    attr.length = length;
+    return attr;
+}
+
+static unsigned putInt(char *tuple, unsigned offset, int value)
+{
+    memcpy(tuple + offset, &value, sizeof(int));
+    return offset + sizeof(int);
+}
+
+static unsigned putReal(char *tuple, unsigned offset, float value)
+{
+    memcpy(tuple + offset, &value, sizeof(float));
+    return offset + sizeof(float);
+}
+
+static unsigned putVarChar(char *tuple, unsigned offset, const string &value)
+{
+    int length = value.length();
+    memcpy(tuple + offset, &length, sizeof(int));
+    memcpy(tuple + offset + sizeof(int), value.c_str(), length);
+    return offset + sizeof(int) + length;
+}
+
+static string nationName(int nation)
+{
+    return "NATION_" + to_string(nation);
+}
+
+static const char *segments[] = {"AUTOMOBILE", "BUILDING", "FURNITURE", "HOUSEHOLD", "MACHINERY"};
+static const char *returnFlags[] = {"A", "N", "R"};
+
+static RC createTpchTables(RelationManager &rm, const BenchOptions &options)
+{
+    vector<Attribute> nation = {makeAttribute("n_nationkey", TypeInt), makeAttribute("n_name", TypeVarChar, 25)};
+    vector<Attribute> customer = {makeAttribute("c_custkey", TypeInt), makeAttribute("c_nationkey", TypeInt),
+            makeAttribute("c_acctbal", TypeReal), makeAttribute("c_mktsegment", TypeVarChar, 10)};
+    vector<Attribute> orders = {makeAttribute("o_orderkey", TypeInt), makeAttribute("o_custkey", TypeInt),
+            makeAttribute("o_totalprice", TypeReal), makeAttribute("o_orderdate", TypeInt)};
+    vector<Attribute> lineitem = {makeAttribute("l_orderkey", TypeInt), makeAttribute("l_quantity", TypeReal),
+            makeAttribute("l_extendedprice", TypeReal), makeAttribute("l_discount", TypeReal),
+            makeAttribute("l_shipdate", TypeInt), makeAttribute("l_returnflag", TypeVarChar, 1)};
+    const vector<pair<string, vector<Attribute> > > tables = {
+        {"nation", nation}, {"customer", customer}, {"orders", orders}, {"lineitem", lineitem}};
+    RC rc;
+    for (const auto &table: tables) {
+        rm.deleteTable(table.first);
+        if ((rc = rm.createTable(table.first, table.second)))
+            return rc;
+    }
+
+    unsigned lineitems = options.size;
+    unsigned orderCount = (lineitems + 3) / 4;
+    unsigned customerCount = max((orderCount + 9) / 10, 1u);
+    minstd_rand random(options.seed);
+    char tuple[PAGE_SIZE];
+    RID rid;
+
+    for (int n = 0; n < 25; n++) {
+        tuple[0] = 0;
+        putVarChar(tuple, putInt(tuple, 1, n), nationName(n));
+        if ((rc = rm.insertTuple("nation", tuple, rid)))
+            return rc;
+    }
+    for (unsigned c = 0; c < customerCount; c++) {
+        unsigned offset = putInt(tuple, 1, c);
+        offset = putInt(tuple, offset, random() % 25);
+        offset = putReal(tuple, offset, (random() % 1100000) / 100.0f - 1000);
+        putVarChar(tuple, offset, segments[random() % 5]);
+        if ((rc = rm.insertTuple("customer", tuple, rid)))
+            return rc;
+    }
+    vector<int> orderDates(orderCount);
+    for (unsigned o = 0; o < orderCount; o++) {
+        orderDates[o] = random() % (TPCH_DAYS - 151);
+        unsigned offset = putInt(tuple, 1, o);
+        offset = putInt(tuple, offset, random() % customerCount);
+        offset = putReal(tuple, offset, (random() % 50000000) / 100.0f);
+        putInt(tuple, offset, orderDates[o]);
+        if ((rc = rm.insertTuple("orders", tuple, rid)))
+            return rc;
+    }
+    for (unsigned l = 0; l < lineitems; l++) {
+        float quantity = 1 + random() % 50;
+        unsigned offset = putInt(tuple, 1, l / 4);
+        offset = putReal(tuple, offset, quantity);
+        offset = putReal(tuple, offset, quantity * (900 + random() % 200));
+        offset = putReal(tuple, offset, (random() % 11) / 100.0f);
+        offset = putInt(tuple, offset, orderDates[l / 4] + 1 + random() % 121);
+        putVarChar(tuple, offset, returnFlags[random() % 3]);
+        if ((rc = rm.insertTuple("lineitem", tuple, rid)))
+            return rc;
+    }
+
+    // For the index nested-loop joins
+    if ((rc = rm.createIndex("customer", "c_custkey")) || (rc = rm.createIndex("orders", "o_orderkey")) ||
+            (rc = rm.createIndex("lineitem", "l_orderkey")))
+        return rc;
+
+    // The planner only costs what the statistics describe
+    for (const auto &table: tables) {
+        if ((rc = rm.analyze(table.first)))
+            return rc;
+    }
+    return SUCCESS;
+}
+
+static Condition compare(const string &attr, CompOp op, AttrType type, void *value)
+{
+    Condition cond;
+    cond.lhsAttr = attr;
+    cond.op = op;
+    cond.bRhsIsAttr = false;
+    cond.rhsValue.type = type;
+    cond.rhsValue.data = value;
+    return cond;
+}
+
+static Condition join(const string &lhsAttr, const string &rhsAttr)
+{
+    Condition cond;
+    cond.lhsAttr = lhsAttr;
+    cond.op = EQ_OP;
+    cond.bRhsIsAttr = true;
+    cond.rhsAttr = rhsAttr;
+    return cond;
+}
+
+// Q1, pricing summary: per return flag, SUM(l_quantity), SUM(l_extendedprice),
+// SUM(l_extendedprice * (1 - l_discount)) and COUNT(*) of the lineitems shipped by a date
+static double query1(RelationManager &rm)
+{
+    int shipDate = TPCH_DAYS - 90;
+    Planner planner(rm);
+    Iterator *plan = planner.planScan("lineitem", {compare("lineitem.l_shipdate", LE_OP, TypeInt, &shipDate)},
+            {"lineitem.l_returnflag", "lineitem.l_quantity", "lineitem.l_extendedprice", "lineitem.l_discount"});
+    map<char, vector<double> > groups;
+    char tuple[PAGE_SIZE];
+    while (plan && plan->getNextTuple(tuple) == SUCCESS) {
+        float quantity, price, discount;
+        char flag = tuple[1 + sizeof(int)];
+        unsigned offset = 1 + sizeof(int) + 1;
+        memcpy(&quantity, tuple + offset, sizeof(float));
+        memcpy(&price, tuple + offset + sizeof(float), sizeof(float));
+        memcpy(&discount, tuple + offset + 2 * sizeof(float), sizeof(float));
+        vector<double> &sums = groups[flag];
+        sums.resize(4);
+        sums[0] += quantity;
+        sums[1] += price;
+        sums[2] += price * (1 - discount);
+        sums[3]++;
+    }
+    return groups.size();
+}
+
+// Q3, shipping priority: the ten unshipped orders of the BUILDING segment with the highest revenue
+static double query3(RelationManager &rm)
+{
+    int date = TPCH_DAYS / 2;
+    char segment[sizeof(int) + 8];
+    putVarChar(segment, 0, "BUILDING");
+    Planner planner(rm);
+    Iterator *plan = planner.planJoin({"customer", "orders", "lineitem"},
+            {compare("customer.c_mktsegment", EQ_OP, TypeVarChar, segment),
+             compare("orders.o_orderdate", LT_OP, TypeInt, &date),
+             compare("lineitem.l_shipdate", GT_OP, TypeInt, &date),
+             join("customer.c_custkey", "orders.o_custkey"),
+             join("lineitem.l_orderkey", "orders.o_orderkey")},
+            {"lineitem.l_orderkey", "lineitem.l_extendedprice", "lineitem.l_discount"});
+    map<int, double> revenue;
+    char tuple[PAGE_SIZE];
+    while (plan && plan->getNextTuple(tuple) == SUCCESS) {
+        int order;
+        float price, discount;
+        memcpy(&order, tuple + 1, sizeof(int));
+        memcpy(&price, tuple + 1 + sizeof(int), sizeof(float));
+        memcpy(&discount, tuple + 1 + sizeof(int) + sizeof(float), sizeof(float));
+        revenue[order] += price * (1 - discount);
+    }
+    vector<double> top;
+    for (const auto &order: revenue)
+        top.push_back(order.second);
+    sort(top.rbegin(), top.rend());
+    top.resize(min<size_t>(top.size(), 10));
+    return top.size();
+}
+
+// Q5, local supplier volume cut down to one nation: revenue of its customers' orders in one year
+static double query5(RelationManager &rm)
+{
+    int from = 365, to = 730;
+    char name[sizeof(int) + 16];
+    putVarChar(name, 0, nationName(7));
+    Planner planner(rm);
+    Iterator *plan = planner.planJoin({"nation", "customer", "orders", "lineitem"},
+            {compare("nation.n_name", EQ_OP, TypeVarChar, name),
+             compare("orders.o_orderdate", GE_OP, TypeInt, &from),
+             compare("orders.o_orderdate", LT_OP, TypeInt, &to),
+             join("nation.n_nationkey", "customer.c_nationkey"),
+             join("customer.c_custkey", "orders.o_custkey"),
+             join("orders.o_orderkey", "lineitem.l_orderkey")},
+            {"lineitem.l_extendedprice", "lineitem.l_discount"});
+    double revenue = 0;
+    char tuple[PAGE_SIZE];
+    while (plan && plan->getNextTuple(tuple) == SUCCESS) {
+        float price, discount;
+        memcpy(&price, tuple + 1, sizeof(float));
+        memcpy(&discount, tuple + 1 + sizeof(float), sizeof(float));
+        revenue += price * (1 - discount);
+    }
+    return revenue;
+}
+
+// Q6, forecasting revenue change: SUM(l_extendedprice * l_discount) over a year of small discounted lineitems
+static double query6(RelationManager &rm)
+{
+    int from = 365, to = 730;
+    float lowDiscount = 0.05f, highDiscount = 0.07f, quantity = 24;
+    Planner planner(rm);
+    Iterator *plan = planner.planScan("lineitem",
+            {compare("lineitem.l_shipdate", GE_OP, TypeInt, &from),
+             compare("lineitem.l_shipdate", LT_OP, TypeInt, &to),
+             compare("lineitem.l_discount", GE_OP, TypeReal, &lowDiscount),
+             compare("lineitem.l_discount", LE_OP, TypeReal, &highDiscount),
+             compare("lineitem.l_quantity", LT_OP, TypeReal, &quantity)},
+            {"lineitem.l_extendedprice", "lineitem.l_discount"});
+    double revenue = 0;
+    char tuple[PAGE_SIZE];
+    while (plan && plan->getNextTuple(tuple) == SUCCESS) {
+        float price, discount;
+        memcpy(&price, tuple + 1, sizeof(float));
+        memcpy(&discount, tuple + 1 + sizeof(float), sizeof(float));
+        revenue += price * discount;
+    }
+    return revenue;
+}
+
+// The plans come from the Planner and the aggregation is done here, there being no aggregate operator.
+// Each query returns something to check it by: its number of groups or rows, or the revenue.
+void runTpchBench(const BenchOptions &options)
+{
+    RelationManager &rm = *RelationManager::instance();
+    if (createTpchTables(rm, options) != SUCCESS) {
+        cerr << "tpch: creating the tables failed." << endl;
+        return;
+    }
+
+    const vector<pair<string, double (*)(RelationManager &)> > queries = {
+        {"q1", query1}, {"q3", query3}, {"q5", query5}, {"q6", query6}};
+    for (const auto &query: queries) {
+        cerr << "tpch." << query.first << " result: " << query.second(rm) << endl;
+        BenchRun run("tpch", query.first, options.size);
+        for (unsigned i = 0; i < TPCH_REPETITIONS; i++) {
+            run.begin();
+            query.second(rm);
+            run.end();
+        }
+        run.finish();
+    }
+
+    rm.deleteTable("lineitem");
+    rm.deleteTable("orders");
+    rm.deleteTable("customer");
+    rm.deleteTable("nation");
+}
@@ -0,0 +1,104 @@
+#include "bench.h"
+
+#include <cstring>
+
+#include "../rm/rm.h"
+
+// Pages vacuumed per step
+#define VACUUM_BENCH_STEP 16
+
+// Look every surviving tuple up through the index, one operation per tuple
+static void lookUp(const string &tableName, const vector<int> &ids, const string &name)
+{
+    RelationManager *rm = RelationManager::instance();
+    char tuple[PAGE_SIZE];
+    char key[sizeof(int)];
+    BenchRun lookup("vacuum", name, ids.size());
+    for (int id: ids) {
+        RM_IndexScanIterator indexIterator;
+        RID rid;
+        lookup.begin();
+        rm->indexScan(tableName, "id", &id, &id, true, true, indexIterator);
+        if (indexIterator.getNextEntry(rid, key) == SUCCESS)
+            rm->readTuple(tableName, rid, tuple);
+        indexIterator.close();
+        lookup.end();
+    }
+    lookup.finish();
+}
+
+// Grow a quarter of an indexed table's tuples so that they are forwarded, delete more than half of
+// them, and compare index lookups before and after a vacuum run a range of pages at a time
+void runVacuumBench(const BenchOptions &options)
+{
+    const string tableName = "bench_vacuum";
+    RelationManager *rm = RelationManager::instance();
+    vector<Attribute> attrs(2);
+    attrs[0].name = "id";
+    attrs[0].type = TypeInt;
+    attrs[0].length = 4;
+    attrs[1].name = "payload";
+    attrs[1].type = TypeVarChar;
+    attrs[1].length = 400;
+
+    rm->deleteTable(tableName);
+    if (rm->createTable(tableName, attrs) != SUCCESS || rm->createIndex(tableName, "id") != SUCCESS) {
+        cerr << "vacuum: creating " << tableName << " failed." << endl;
+        return;
+    }
+
+    vector<int> keys = shuffledKeys(options.size, options.seed);
+    vector<RID> rids(options.size);
+    char tuple[PAGE_SIZE];
+    for (unsigned i = 0; i < options.size; i++) {
+        int length = 20;
+        tuple[0] = 0;
+        memcpy(tuple + 1, &keys[i], sizeof(int));
+        memcpy(tuple + 1 + sizeof(int), &length, sizeof(int));
+        memset(tuple + 1 + 2 * sizeof(int), 'v', length);
+        rm->insertTuple(tableName, tuple, rids[i]);
+    }
+
+    BenchRun update("vacuum", "grow_tuple", options.size / 4);
+    for (unsigned i = 0; i < options.size; i += 4) {
+        int length = 400;
+        memcpy(tuple + 1, &keys[i], sizeof(int));
+        memcpy(tuple + 1 + sizeof(int), &length, sizeof(int));
+        memset(tuple + 1 + 2 * sizeof(int), 'v', length);
+        update.begin();
+        rm->updateTuple(tableName, tuple, rids[i]);
+        update.end();
+    }
+    update.finish();
+
+    // Keep the even tuples, half of the grown ones
+    vector<int> survivors;
+    for (unsigned i = 0; i < options.size; i++) {
+        if (i % 2 == 0 && i % 8 != 4)
+            survivors.push_back(keys[i]);
+        else
+            rm->deleteTuple(tableName, rids[i]);
+    }
+
+    unsigned pagesBefore = getPageCount(tableName + TABLE_FILE_EXTENSION);
+    lookUp(tableName, survivors, "lookup_before");
+
+    RM_VacuumIterator vacuumIterator;
+    BenchRun vacuum("vacuum", "vacuum_step", pagesBefore / VACUUM_BENCH_STEP + 1);
+    rm->vacuum(tableName, vacuumIterator);
+    while (true) {
+        vacuum.begin();
+        RC rc = vacuumIterator.vacuumPages(VACUUM_BENCH_STEP);
+        vacuum.end();
+        if (rc)
+            break;
+    }
+    vacuumIterator.close();
+    unsigned pagesAfter = getPageCount(tableName + TABLE_FILE_EXTENSION);
+    vacuum.addMetric("pages_before", pagesBefore);
+    vacuum.addMetric("pages_after", pagesAfter);
+    vacuum.finish();
+
+    lookUp(tableName, survivors, "lookup_after");
+    rm->deleteTable(tableName);
+}
@@ -0,0 +1,243 @@
+#include "bench.h"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+
+#include "../rm/rm.h"
+
+// usertable(ycsb_key int, field0 .. field3 varchar(50)), indexed on ycsb_key.
+// YCSB's ten 100 byte fields would leave three records per page; four of 50 bytes keep about fifteen.
+#define YCSB_FIELD_COUNT    4
+#define YCSB_FIELD_LENGTH   50
+#define YCSB_MAX_SCAN       100
+#define YCSB_ZIPFIAN_THETA  0.99
+
+// Mix of operations of one workload, as fractions summing to 1
+struct YcsbWorkload {
+    const char *name;
+    double read;
+    double update;
+    double insert;
+    double scan;
+    double readModifyWrite;
+    bool latest;            // reads favour the most recently inserted keys (workload D)
+};
+
+static const YcsbWorkload workloads[] = {
+    {"a", 0.50, 0.50, 0.00, 0.00, 0.00, false},     // update heavy
+    {"b", 0.95, 0.05, 0.00, 0.00, 0.00, false},     // read mostly
+    {"c", 1.00, 0.00, 0.00, 0.00, 0.00, false},     // read only
+    {"f", 0.50, 0.00, 0.00, 0.00, 0.50, false},     // read-modify-write
+    {"d", 0.95, 0.00, 0.05, 0.00, 0.00, true},      // read latest
+    {"e", 0.00, 0.00, 0.05, 0.95, 0.00, false},     // short ranges
+};
+
+// Zipfian ranks over [0, items) as in YCSB (Gray et al., "Quickly generating billion-record
+// synthetic databases"): rank 0 is the most popular.
+class ZipfianGenerator {
+public:
+    ZipfianGenerator(unsigned items)
+    {
+        this->items = items;
+        double zetan = 0;
+        for (unsigned i = 1; i <= items; i++)
+            zetan += 1 / pow(i, YCSB_ZIPFIAN_THETA);
+        double zeta2 = 1 + pow(0.5, YCSB_ZIPFIAN_THETA);
+        this->zetan = zetan;
+        alpha = 1 / (1 - YCSB_ZIPFIAN_THETA);
+        eta = (1 - pow(2.0 / items, 1 - YCSB_ZIPFIAN_THETA)) / (1 - zeta2 / zetan);
+    }
+
+    unsigned next(double u) const
+    {
+        double uz = u * zetan;
+        if (uz < 1)
+            return 0;
+        if (uz < 1 + pow(0.5, YCSB_ZIPFIAN_THETA))
+            return 1;
+        return min((unsigned) (items * pow(eta * u - eta + 1, alpha)), items - 1);
+    }
+
+private:
+    unsigned items;
+    double zetan;
+    double alpha;
+    double eta;
+};
+
+// Spread the popular ranks over the key space, like YCSB's scrambled zipfian
+static unsigned scramble(unsigned rank, unsigned items)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned i = 0; i < sizeof(rank); i++) {
+        hash ^= (rank >> (8 * i)) & 0xff;
+        hash *= 1099511628211ULL;
+    }
+    return hash % items;
+}
+
+static unsigned makeYcsbTuple(int key, unsigned version, char *tuple)
+{
+    tuple[0] = 0;
+    unsigned offset = 1;
+    memcpy(tuple + offset, &key, sizeof(int));
+    offset += sizeof(int);
+    for (unsigned f = 0; f < YCSB_FIELD_COUNT; f++) {
+        int length = YCSB_FIELD_LENGTH;
+        memcpy(tuple + offset, &length, sizeof(int));
+        offset += sizeof(int);
+        memset(tuple + offset, 'a' + (key + f + version) % 26, length);
+        offset += length;
+    }
+    return offset;
+}
+
+// The primary key lookup every read and update starts with
+static RC findKey(RelationManager *rm, int key, RID &rid)
+{
+    RM_IndexScanIterator scanIterator;
+    char found[sizeof(int)];
+    RC rc = rm->indexScan("usertable", "ycsb_key", &key, &key, true, true, scanIterator);
+    if (rc == SUCCESS)
+        rc = scanIterator.getNextEntry(rid, found);
+    scanIterator.close();
+    return rc;
+}
+
+static RC readKey(RelationManager *rm, int key, char *tuple)
+{
+    RID rid;
+    RC rc = findKey(rm, key, rid);
+    return rc ? rc : rm->readTuple("usertable", rid, tuple);
+}
+
+static RC updateKey(RelationManager *rm, int key, unsigned version, char *tuple)
+{
+    RID rid;
+    RC rc = findKey(rm, key, rid);
+    if (rc)
+        return rc;
+    makeYcsbTuple(key, version, tuple);
+    return rm->updateTuple("usertable", tuple, rid);
+}
+
+static RC scanKeys(RelationManager *rm, int key, unsigned length, char *tuple)
+{
+    RM_IndexScanIterator scanIterator;
+    int high = key + length - 1;
+    RID rid;
+    char found[sizeof(int)];
+    RC rc = rm->indexScan("usertable", "ycsb_key", &key, &high, true, true, scanIterator);
+    while (rc == SUCCESS && scanIterator.getNextEntry(rid, found) == SUCCESS)
+        rc = rm->readTuple("usertable", rid, tuple);
+    scanIterator.close();
+    return rc;
+}
+
+// Load options.size records, then run options.size operations of every workload in YCSB's
+// recommended order (A, B, C, F, D, E: the inserting ones last).
+void runYcsbBench(const BenchOptions &options)
+{
+    RelationManager *rm = RelationManager::instance();
+    vector<Attribute> attrs;
+    Attribute attr;
+    attr.name = "ycsb_key";
+    attr.type = TypeInt;
+    attr.length = 4;
+    attrs.push_back(attr);
+    for (unsigned f = 0; f < YCSB_FIELD_COUNT; f++) {
+        attr.name = "field" + to_string(f);
+        attr.type = TypeVarChar;
+        attr.length = YCSB_FIELD_LENGTH;
+        attrs.push_back(attr);
+    }
+    rm->deleteTable("usertable");
+    if (rm->createTable("usertable", attrs) != SUCCESS || rm->createIndex("usertable", "ycsb_key") != SUCCESS) {
+        cerr << "ycsb: creating usertable failed." << endl;
+        return;
+    }
+
+    char tuple[PAGE_SIZE];
+    vector<int> keys = shuffledKeys(options.size, options.seed);
+    BenchRun load("ycsb", "load", options.size);
+    for (unsigned i = 0; i < options.size; i++) {
+        RID rid;
+        makeYcsbTuple(keys[i], 0, tuple);
+        load.begin();
+        rm->insertTuple("usertable", tuple, rid);
+        load.end();
+    }
+    load.finish();
+
+    ZipfianGenerator zipfian(options.size);
+    minstd_rand random(options.seed);
+    uniform_real_distribution<double> uniform(0, 1);
+    unsigned recordCount = options.size;
+    unsigned version = 1;
+
+    for (const YcsbWorkload &workload: workloads) {
+        string name = string("workload_") + workload.name;
+        BenchRun total("ycsb", name, options.size);
+        BenchRun read("ycsb", name + ".read", options.size);
+        BenchRun update("ycsb", name + ".update", options.size);
+        BenchRun insert("ycsb", name + ".insert", options.size);
+        BenchRun scan("ycsb", name + ".scan", options.size);
+        BenchRun readModifyWrite("ycsb", name + ".read_modify_write", options.size);
+
+        for (unsigned i = 0; i < options.size; i++) {
+            double op = uniform(random);
+            unsigned rank = zipfian.next(uniform(random));
+            int key = workload.latest ? recordCount - 1 - rank : scramble(rank, recordCount);
+            RC rc;
+
+            total.begin();
+            if ((op -= workload.read) < 0) {
+                read.begin();
+                rc = readKey(rm, key, tuple);
+                read.end();
+            } else if ((op -= workload.update) < 0) {
+                update.begin();
+                rc = updateKey(rm, key, version++, tuple);
+                update.end();
+            } else if ((op -= workload.insert) < 0) {
+                RID rid;
+                makeYcsbTuple(recordCount++, 0, tuple);
+                insert.begin();
+                rc = rm->insertTuple("usertable", tuple, rid);
+                insert.end();
+            } else if ((op -= workload.scan) < 0) {
+                scan.begin();
+                rc = scanKeys(rm, key, 1 + random() % YCSB_MAX_SCAN, tuple);
+                scan.end();
+            } else {
+                readModifyWrite.begin();
+                rc = readKey(rm, key, tuple);
+                if (rc == SUCCESS)
+                    rc = updateKey(rm, key, version++, tuple);
+                readModifyWrite.end();
+            }
+            total.end();
+
+            if (rc) {
+                cerr << "ycsb: workload " << workload.name << " failed on key " << key << "." << endl;
+                rm->deleteTable("usertable");
+                return;
+            }
+        }
+
+        total.finish();
+        if (workload.read > 0)
+            read.finish();
+        if (workload.update > 0)
+            update.finish();
+        if (workload.insert > 0)
+            insert.finish();
+        if (workload.scan > 0)
+            scan.finish();
+        if (workload.readModifyWrite > 0)
+            readModifyWrite.finish();
+    }
+
+    rm->deleteTable("usertable");
+}
@@ -3,6 +3,7 @@
 
 #include "../rbf/pfm.h"
 #include "../rbf/rbfm.h"
+#include "../rbf/arena.h"
 
 #include <vector>
 #include <string>
@@ -27,11 +28,11 @@ IndexManager::~IndexManager()
 {
 }
 
-RC IndexManager::createFile(const string &fileName)
+RC IndexManager::createFile(const string &fileName, unsigned pageSize)
 {
     PagedFileManager *pfm = PagedFileManager::instance();
 
-    if (pfm->createFile(fileName.c_str()))
+    if (pfm->createFile(fileName.c_str(), false, pageSize))
         return IX_CREATE_FAILED;
 
     // Open the file we just created
@@ -40,19 +41,21 @@ RC IndexManager::createFile(const string &fileName)
     if (rc)
         return IX_OPEN_FAILED;
 
-    void *pageData = calloc(PAGE_SIZE, 1);
+    void *pageData = PageBufferPool::acquire();
     if (pageData == NULL)
         return IX_MALLOC_FAILED;
+    memset(pageData, 0, pageSize);
 
     // Initialize the first page with metadata. root page will be page 1
     MetaHeader meta;
     meta.rootPage = 1;
+    meta.version = IX_NODE_VERSION;
     setMetaData(meta, pageData);
     rc = handle.appendPage(pageData);
     if (rc)
     {
         closeFile(handle);
-        free(pageData);
+        PageBufferPool::release(pageData);
         return IX_APPEND_FAILED;
     }
 
@@ -60,14 +63,14 @@ RC IndexManager::createFile(const string &fileName)
     setNodeType(IX_TYPE_INTERNAL, pageData);
     InternalHeader header;
     header.entriesNumber = 0;
-    header.freeSpaceOffset = PAGE_SIZE;
+    header.freeSpaceOffset = pageSize;
     header.leftChildPage = 2;
     setInternalHeader(header, pageData);
     rc = handle.appendPage(pageData);
     if (rc)
     {
         closeFile(handle);
-        free(pageData);
+        PageBufferPool::release(pageData);
         return IX_APPEND_FAILED;
     }
 
@@ -77,18 +80,18 @@ RC IndexManager::createFile(const string &fileName)
     leafHeader.next            = 0;
     leafHeader.prev            = 0;
     leafHeader.entriesNumber   = 0;
-    leafHeader.freeSpaceOffset = PAGE_SIZE;
+    leafHeader.freeSpaceOffset = pageSize;
     setLeafHeader(leafHeader, pageData);
     rc = handle.appendPage(pageData);
     if (rc)
     {
         closeFile(handle);
-        free(pageData);
+        PageBufferPool::release(pageData);
         return IX_APPEND_FAILED;
     }
 
     closeFile(handle);
-    free(pageData);
+    PageBufferPool::release(pageData);
     return SUCCESS;
 }
 
@@ -123,26 +126,35 @@ RC IndexManager::insertEntry(IXFileHandle &ixfileHandle, const Attribute &attrib
     RC rc = getRootPageNum(ixfileHandle, rootPage);
     if (rc)
         return rc;
-    return insert(attribute, key, rid, ixfileHandle, rootPage, childEntry);
+
+    // The descent reads one node per level, and a root split adds one
+    FileStats *stats = ixfileHandle.fh.stats;
+    uint64_t visits = stats->nodeVisits;
+    uint64_t rootSplits = stats->rootSplits;
+    rc = insert(attribute, key, rid, ixfileHandle, rootPage, childEntry);
+    if (rc == SUCCESS)
+        stats->treeHeight = stats->nodeVisits - visits + stats->rootSplits - rootSplits;
+    return rc;
 }
 
 RC IndexManager::insert(const Attribute &attribute, const void *key, const RID &rid, IXFileHandle &fileHandle, int32_t pageID, ChildEntry &childEntry)
 {
-    void *pageData = malloc(PAGE_SIZE);
+    void *pageData = PageBufferPool::acquire();
     if(pageData == NULL)
         return IX_MALLOC_FAILED;
     if (fileHandle.readPage(pageID, pageData))
     {
-        free(pageData);
+        PageBufferPool::release(pageData);
         return IX_READ_FAILED;
     }
+    fileHandle.fh.stats->nodeVisits++;
 
     NodeType type = getNodetype(pageData);
 
     if (type == IX_TYPE_INTERNAL)
     {
         int32_t childPage = getNextChildPage(attribute, key, pageData);
-        free (pageData);
+        PageBufferPool::release(pageData);
         if (childPage == 0)
             return IX_BAD_CHILD;
 
@@ -153,10 +165,10 @@ RC IndexManager::insert(const Attribute &attribute, const void *key, const RID &
         if(childEntry.key == NULL)
             return SUCCESS;
         // If we're here, we need to handle a split
-        pageData = malloc(PAGE_SIZE);
+        pageData = PageBufferPool::acquire();
         if (fileHandle.readPage(pageID, pageData))
         {
-            free(pageData);
+            PageBufferPool::release(pageData);
             return IX_READ_FAILED;
         }
 
@@ -169,7 +181,7 @@ RC IndexManager::insert(const Attribute &attribute, const void *key, const RID &
             free (childEntry.key);
             childEntry.key = NULL;
             childEntry.childPage = 0;
-            free(pageData);
+            PageBufferPool::release(pageData);
             pageData = NULL;
             // If write succeeded, rc is success, otherwise it's a failure.
             return rc == SUCCESS ? SUCCESS : IX_WRITE_FAILED;
@@ -177,13 +189,14 @@ RC IndexManager::insert(const Attribute &attribute, const void *key, const RID &
         else if (IX_NO_FREE_SPACE)
         {
             rc = splitInternal(fileHandle, attribute, pageID, pageData, childEntry);
-            free(pageData);
+            fileHandle.fh.stats->internalSplits++;
+            PageBufferPool::release(pageData);
             pageData = NULL;
             return rc;
         }
         else // Some other error, probably will not occur
         {
-            free(pageData);
+            PageBufferPool::release(pageData);
             free(childEntry.key);
             childEntry.key = NULL;
             return IX_INSERT_INTERNAL_FAILED;
@@ -205,20 +218,21 @@ RC IndexManager::insert(const Attribute &attribute, const void *key, const RID &
             childEntry.key = NULL;
             childEntry.childPage = 0;
 
-            free(pageData);
+            PageBufferPool::release(pageData);
             pageData = NULL;
             return SUCCESS;
         }
         else if (rc == IX_NO_FREE_SPACE) // Leaf is full and needs to be split
         {
             rc = splitLeaf(fileHandle, attribute, key, rid, pageID, pageData, childEntry);
-            free(pageData);
+            fileHandle.fh.stats->leafSplits++;
+            PageBufferPool::release(pageData);
             pageData = NULL;
             return rc;
         }
         else // Some other error, probably will not occur
         {
-            free(pageData);
+            PageBufferPool::release(pageData);
             pageData = NULL;
             free(childEntry.key);
             childEntry.key = NULL;
@@ -232,13 +246,14 @@ RC IndexManager::splitLeaf(IXFileHandle &fileHandle, const Attribute &attribute,
     LeafHeader originalHeader = getLeafHeader(originalLeaf);
 
     // Create new leaf to hold overflow
-    void *newLeaf = calloc(PAGE_SIZE, 1);
+    void *newLeaf = PageBufferPool::acquire();
+    memset(newLeaf, 0, fileHandle.getPageSize());
     setNodeType(IX_TYPE_LEAF, newLeaf);
     LeafHeader newHeader;
     newHeader.prev = pageID;
     newHeader.next = originalHeader.next;
     newHeader.entriesNumber = 0;
-    newHeader.freeSpaceOffset = PAGE_SIZE;
+    newHeader.freeSpaceOffset = fileHandle.getPageSize();
     setLeafHeader(newHeader, newLeaf);
 
     int32_t newPageNum = fileHandle.getNumberOfPages();
@@ -262,7 +277,7 @@ RC IndexManager::splitLeaf(IXFileHandle &fileHandle, const Attribute &attribute,
         
         lastSize = getKeyLengthLeaf(attribute, key);
         size += lastSize;
-        if (size >= PAGE_SIZE / 2)
+        if (size >= (int) fileHandle.getPageSize() / 2)
         {
             if (i >= originalHeader.entriesNumber - 1 || compareLeafSlot(attribute, key, originalLeaf, i+1) != 0)
                 break;
@@ -309,7 +324,7 @@ RC IndexManager::splitLeaf(IXFileHandle &fileHandle, const Attribute &attribute,
     {
         if (insertIntoLeaf(attribute, ins_key, ins_rid, originalLeaf))
         {
-            free(newLeaf);
+            PageBufferPool::release(newLeaf);
             return -1;
         }
     }
@@ -317,22 +332,22 @@ RC IndexManager::splitLeaf(IXFileHandle &fileHandle, const Attribute &attribute,
     {
         if (insertIntoLeaf(attribute, ins_key, ins_rid, newLeaf))
         {
-            free(newLeaf);
+            PageBufferPool::release(newLeaf);
             return -1;
         }
     }
 
     if(fileHandle.writePage(pageID, originalLeaf))
     {
-        free(newLeaf);
+        PageBufferPool::release(newLeaf);
         return IX_WRITE_FAILED;
     }
     if(fileHandle.appendPage(newLeaf))
     {
-        free(newLeaf);
+        PageBufferPool::release(newLeaf);
         return IX_APPEND_FAILED;
     }
-    free(newLeaf);
+    PageBufferPool::release(newLeaf);
     return SUCCESS;
 }
 
@@ -452,7 +467,7 @@ RC IndexManager::splitInternal(IXFileHandle &fileHandle, const Attribute &attrib
         
         lastSize = getKeyLengthInternal(attribute, key);
         size += lastSize;
-        if (size >= PAGE_SIZE / 2)
+        if (size >= (int) fileHandle.getPageSize() / 2)
         {
             break;
         }
@@ -461,11 +476,12 @@ RC IndexManager::splitInternal(IXFileHandle &fileHandle, const Attribute &attrib
     IndexEntry middleEntry = getIndexEntry(i, original);
 
     // Create new leaf to hold overflow
-    void *newIntern = calloc(PAGE_SIZE, 1);
+    void *newIntern = PageBufferPool::acquire();
+    memset(newIntern, 0, fileHandle.getPageSize());
     setNodeType(IX_TYPE_INTERNAL, newIntern);
     InternalHeader newHeader;
     newHeader.entriesNumber = 0;
-    newHeader.freeSpaceOffset = PAGE_SIZE;
+    newHeader.freeSpaceOffset = fileHandle.getPageSize();
     newHeader.leftChildPage = middleEntry.childPage;
     setInternalHeader(newHeader, newIntern);
 
@@ -477,6 +493,10 @@ RC IndexManager::splitInternal(IXFileHandle &fileHandle, const Attribute &attrib
     else
         memcpy(middleKey, &(middleEntry.integer), INT_SIZE);
 
+    // If new key is less than middle key, it goes in the original node, else in the new node.
+    // Decided now: once the middle entry is deleted, its varchar is no longer on the page
+    bool intoOriginal = compareSlot(attribute, childEntry.key, original, i) < 0;
+
     // Create storage for shifting keys from one page to the other
     void *moving_key = malloc (attribute.length + 4);
     // Repeatedly insert an entry from one page into the other, then delete the entry from the original page
@@ -506,12 +526,11 @@ RC IndexManager::splitInternal(IXFileHandle &fileHandle, const Attribute &attrib
     // Delete middle entry
     deleteEntryFromInternal(attribute, middleKey, original);
 
-    // If new key is less than middle key, put it in original node, else put it in new node
-    if (compareSlot(attribute, childEntry.key, original, i) < 0)
+    if (intoOriginal)
     {
         if (insertIntoInternal(attribute, childEntry, original))
         {
-            free(newIntern);
+            PageBufferPool::release(newIntern);
             return -1;
         }
     }
@@ -519,22 +538,22 @@ RC IndexManager::splitInternal(IXFileHandle &fileHandle, const Attribute &attrib
     {
         if (insertIntoInternal(attribute, childEntry, newIntern))
         {
-            free(newIntern);
+            PageBufferPool::release(newIntern);
             return -1;
         }
     }
 
     if(fileHandle.writePage(pageID, original))
     {
-        free(newIntern);
+        PageBufferPool::release(newIntern);
         return IX_WRITE_FAILED;
     }
     if(fileHandle.appendPage(newIntern))
     {
-        free(newIntern);
+        PageBufferPool::release(newIntern);
         return IX_APPEND_FAILED;
     }
-    free(newIntern);
+    PageBufferPool::release(newIntern);
 
     // Take the key of middle entry and allow it to propogate up
     free(childEntry.key);
@@ -547,12 +566,13 @@ RC IndexManager::splitInternal(IXFileHandle &fileHandle, const Attribute &attrib
     if (pageID == rootPage)
     {
         // Create new page and set appropriate headers
-        void *newRoot = calloc(PAGE_SIZE, 1);
+        void *newRoot = PageBufferPool::acquire();
+        memset(newRoot, 0, fileHandle.getPageSize());
 
         setNodeType(IX_TYPE_INTERNAL, newRoot);
         InternalHeader rootHeader;
         rootHeader.entriesNumber = 0;
-        rootHeader.freeSpaceOffset = PAGE_SIZE;
+        rootHeader.freeSpaceOffset = fileHandle.getPageSize();
         // Left most will be the smaller of these two pages
         rootHeader.leftChildPage = pageID;
         setInternalHeader(rootHeader, newRoot);
@@ -565,11 +585,13 @@ RC IndexManager::splitInternal(IXFileHandle &fileHandle, const Attribute &attrib
             return IX_APPEND_FAILED;
         MetaHeader metahead;
         metahead.rootPage = newRootPage;
+        metahead.version = IX_NODE_VERSION;
         setMetaData(metahead, newRoot);
         if(fileHandle.writePage(0, newRoot))
             return IX_WRITE_FAILED;
+        fileHandle.fh.stats->rootSplits++;
         // Free memory
-        free(newRoot);
+        PageBufferPool::release(newRoot);
         free(childEntry.key);
         childEntry.key = NULL;
 
@@ -586,10 +608,10 @@ RC IndexManager::deleteEntry(IXFileHandle &ixfileHandle, const Attribute &attrib
         return rc;
     // leafPage is page number of leaf where this entry would be
     // Read in page
-    void *pageData = malloc(PAGE_SIZE);
+    void *pageData = PageBufferPool::acquire();
     if (ixfileHandle.readPage(leafPage, pageData))
     {
-        free(pageData);
+        PageBufferPool::release(pageData);
         return IX_READ_FAILED;
     }
 
@@ -597,12 +619,12 @@ RC IndexManager::deleteEntry(IXFileHandle &ixfileHandle, const Attribute &attrib
     rc = deleteEntryFromLeaf(attribute, key, rid, pageData);
     if (rc)
     {
-        free(pageData);
+        PageBufferPool::release(pageData);
         return rc;
     }
 
     rc = ixfileHandle.writePage(leafPage, pageData);
-    free(pageData);
+    PageBufferPool::release(pageData);
     return rc;
 }
 
@@ -618,6 +640,56 @@ RC IndexManager::scan(IXFileHandle &ixfileHandle,
     return ix_ScanIterator.initialize(ixfileHandle, attribute, lowKey, highKey, lowKeyInclusive, highKeyInclusive);
 }
 
+RC IndexManager::getTreeStatistics(IXFileHandle &ixfileHandle, unsigned &height, unsigned &leafCount, unsigned &entryCount)
+{
+    void *pageData = PageBufferPool::acquire();
+    if (pageData == NULL)
+        return IX_MALLOC_FAILED;
+
+    int32_t pageNum;
+    RC rc = getRootPageNum(ixfileHandle, pageNum);
+    if (rc)
+    {
+        PageBufferPool::release(pageData);
+        return rc;
+    }
+
+    // Walk down the leftmost path to the first leaf
+    height = 1;
+    while (true)
+    {
+        if (ixfileHandle.readPage(pageNum, pageData))
+        {
+            PageBufferPool::release(pageData);
+            return IX_READ_FAILED;
+        }
+        if (getNodetype(pageData) == IX_TYPE_LEAF)
+            break;
+        pageNum = getInternalHeader(pageData).leftChildPage;
+        height++;
+    }
+
+    // Then follow the linked list of leaves
+    leafCount = 0;
+    entryCount = 0;
+    while (true)
+    {
+        LeafHeader header = getLeafHeader(pageData);
+        leafCount++;
+        entryCount += header.entriesNumber;
+        if (header.next == 0)
+            break;
+        if (ixfileHandle.readPage(header.next, pageData))
+        {
+            PageBufferPool::release(pageData);
+            return IX_READ_FAILED;
+        }
+    }
+
+    PageBufferPool::release(pageData);
+    return SUCCESS;
+}
+
 void IndexManager::printBtree(IXFileHandle &ixfileHandle, const Attribute &attribute) const
 {
     int32_t rootPage;
@@ -631,7 +703,7 @@ void IndexManager::printBtree(IXFileHandle &ixfileHandle, const Attribute &attri
 // Print comma from calling context.
 void IndexManager::printBtree_rec(IXFileHandle &ixfileHandle, string prefix, const int32_t currPage, const Attribute &attr) const
 {
-    void *pageData = malloc(PAGE_SIZE);
+    void *pageData = PageBufferPool::acquire();
     ixfileHandle.readPage(currPage, pageData);
 
     NodeType type = getNodetype(pageData);
@@ -643,7 +715,7 @@ void IndexManager::printBtree_rec(IXFileHandle &ixfileHandle, string prefix, con
     {
         printInternalNode(ixfileHandle, pageData, attr, prefix);
     }
-    free(pageData);
+    PageBufferPool::release(pageData);
 }
 
 void IndexManager::printInternalNode(IXFileHandle &ixfileHandle, void *pageData, const Attribute &attr, string prefix) const
@@ -781,6 +853,7 @@ void IndexManager::printInternalSlot(const Attribute &attr, const int32_t slotNu
 
 IX_ScanIterator::IX_ScanIterator()
 {
+    page = NULL;
 }
 
 IX_ScanIterator::~IX_ScanIterator()
@@ -798,7 +871,7 @@ RC IX_ScanIterator::initialize(IXFileHandle &fh, Attribute attribute, const void
     highKeyInclusive = highInc;
 
     // Initialize our storage
-    page = malloc(PAGE_SIZE);
+    page = PageBufferPool::acquire();
     if (page == NULL)
         return IX_MALLOC_FAILED;
     // Initialize starting slot number
@@ -810,13 +883,13 @@ RC IX_ScanIterator::initialize(IXFileHandle &fh, Attribute attribute, const void
     RC rc = im->find(*fileHandle, attr, lowKey, startPageNum);
     if (rc)
     {
-        free(page);
+        PageBufferPool::release(page);
         return rc;
     }
     rc = fileHandle->readPage(startPageNum, page);
     if (rc)
     {
-        free(page);
+        PageBufferPool::release(page);
         return rc;
     }
 
@@ -882,7 +955,8 @@ RC IX_ScanIterator::getNextEntry(RID &rid, void *key)
 
 RC IX_ScanIterator::close()
 {
-    free(page);
+    PageBufferPool::release(page);
+    page = NULL;
     return SUCCESS;
 }
 
@@ -929,6 +1003,11 @@ unsigned IXFileHandle::getNumberOfPages()
     return fh.getNumberOfPages();
 }
 
+unsigned IXFileHandle::getPageSize()
+{
+    return fh.getPageSize();
+}
+
 // Private helpers -----------------------
 
 void IndexManager::setMetaData(const MetaHeader header, void *pageData)
@@ -1017,18 +1096,20 @@ DataEntry IndexManager::getDataEntry(const int slotNum, const void *pageData) co
 
 RC IndexManager::getRootPageNum(IXFileHandle &fileHandle, int32_t &result) const
 {
-    void *metaPage = malloc(PAGE_SIZE);
+    void *metaPage = PageBufferPool::acquire();
     if (metaPage == NULL)
         return IX_MALLOC_FAILED;
     RC rc = fileHandle.readPage(0, metaPage);
     if (rc)
     {
-        free(metaPage);
+        PageBufferPool::release(metaPage);
         return IX_READ_FAILED;
     }
 
     MetaHeader header = getMetaData(metaPage);
-    free(metaPage);
+    PageBufferPool::release(metaPage);
+    if (header.version != IX_NODE_VERSION)
+        return IX_WRONG_VERSION;
     result = header.rootPage;
     return SUCCESS;
 }
@@ -1039,30 +1120,37 @@ RC IndexManager::find(IXFileHandle &handle, const Attribute attr, const void *ke
     RC rc = getRootPageNum(handle, rootPageNum);
     if (rc)
         return rc;
-    return treeSearch(handle, attr, key, rootPageNum, resultPageNum);
+
+    FileStats *stats = handle.fh.stats;
+    uint64_t visits = stats->nodeVisits;
+    rc = treeSearch(handle, attr, key, rootPageNum, resultPageNum);
+    if (rc == SUCCESS)
+        stats->treeHeight = stats->nodeVisits - visits;
+    return rc;
 }
 
 RC IndexManager::treeSearch(IXFileHandle &handle, const Attribute attr, const void *key, const int32_t currPageNum, int32_t &resultPageNum)
 {
-    void *pageData = malloc(PAGE_SIZE);
+    void *pageData = PageBufferPool::acquire();
 
     if (handle.readPage(currPageNum, pageData))
     {
-        free (pageData);
+        PageBufferPool::release(pageData);
         return IX_READ_FAILED;
     }
+    handle.fh.stats->nodeVisits++;
 
     // Found our leaf!
     if (getNodetype(pageData) == IX_TYPE_LEAF)
     {
         resultPageNum = currPageNum;
-        free(pageData);
+        PageBufferPool::release(pageData);
         return SUCCESS;
     }
 
     int32_t nextChildPage = getNextChildPage(attr, key, pageData);
 
-    free(pageData);
+    PageBufferPool::release(pageData);
     return treeSearch(handle, attr, key, nextChildPage, resultPageNum);
 }
 
@@ -24,6 +24,7 @@
 #define IX_INSERT_INTERNAL_FAILED 11
 #define IX_WRITE_FAILED           12
 #define IX_NO_FREE_SPACE          13
+#define IX_WRONG_VERSION          14
 
 
 // Headers and data types
@@ -39,7 +40,7 @@ typedef struct LeafHeader
 	uint32_t next;
 	uint32_t prev;
 	uint16_t entriesNumber;
-	uint16_t freeSpaceOffset;
+	uint32_t freeSpaceOffset;
 } LeafHeader;
 
 typedef struct DataEntry
@@ -69,7 +70,7 @@ typedef struct IndexEntry
 typedef struct InternalHeader
 {
 	uint16_t entriesNumber;
-	uint16_t freeSpaceOffset;
+	uint32_t freeSpaceOffset;
     uint32_t leftChildPage;
 } InternalHeader;
 
@@ -85,8 +86,13 @@ typedef struct ChildEntry
 typedef struct MetaHeader
 {
 	uint32_t rootPage;
+	uint32_t version;	// IX_NODE_VERSION
 } MetaHeader;
 
+// Layout of the node headers of a file, since their free space offsets are 32 bits. Files of
+// another version (0 before it was recorded) are rejected when their root is looked up.
+#define IX_NODE_VERSION 2
+
 class IX_ScanIterator;
 class IXFileHandle;
 
@@ -95,8 +101,8 @@ class IndexManager {
     public:
         static IndexManager* instance();
 
-        // Create an index file.
-        RC createFile(const string &fileName);
+        // Create an index file, with pages of pageSize bytes (see PagedFileManager::isValidPageSize).
+        RC createFile(const string &fileName, unsigned pageSize = PAGE_SIZE);
 
         // Delete an index file.
         RC destroyFile(const string &fileName);
@@ -124,6 +130,9 @@ class IndexManager {
 
         // Print the B+ tree in pre-order (in a JSON record format)
         void printBtree(IXFileHandle &ixfileHandle, const Attribute &attribute) const;
+
+        // Number of levels in the tree (counting the leaves), number of leaf pages and entries
+        RC getTreeStatistics(IXFileHandle &ixfileHandle, unsigned &height, unsigned &leafCount, unsigned &entryCount);
         friend class IX_ScanIterator;
 
     protected:
@@ -221,6 +230,7 @@ class IXFileHandle {
 	// Put the current counter values of associated PF FileHandles into variables
 	RC collectCounterValues(unsigned &readPageCount, unsigned &writePageCount, unsigned &appendPageCount);
     unsigned getNumberOfPages();
+    unsigned getPageSize();
 
 	// Added these
 	RC readPage(PageNum pageNum, void *data);
@@ -0,0 +1,113 @@
+#include <iostream>
+#include <sstream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "ix.h"
+#include "ix_test_util.h"
+#include "../rbf/stats.h"
+
+IndexManager *indexManager;
+
+int testCase_16(const string &indexFileName, const Attribute &attribute)
+{
+    // Checks the index counters of the statistics registry
+    // Functions tested
+    // 1. Insert entries until the tree has three levels
+    // 2. Split, node visit and tree height counters
+    // 3. Scan
+    // 4. Prometheus dump
+    cerr << endl << "***** In IX Test Case 16 *****" << endl;
+
+    RID rid;
+    IXFileHandle ixfileHandle;
+    IX_ScanIterator ix_ScanIterator;
+    unsigned numOfTuples = 30;
+    char key[PAGE_SIZE];
+    unsigned count = attribute.length;
+
+    RC rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    StatsRegistry *registry = StatsRegistry::instance();
+    registry->reset();
+    FileStats *stats = registry->getFileStats(indexFileName);
+
+    // Four keys fit in a node
+    for (unsigned i = 1; i <= numOfTuples; i++)
+    {
+        *(int *)key = count;
+        memset(key + sizeof(int), 96 + i, count);
+        rid.pageNum = i;
+        rid.slotNum = i;
+
+        rc = indexManager->insertEntry(ixfileHandle, attribute, &key, rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+
+    unsigned height, leafCount, entryCount;
+    rc = indexManager->getTreeStatistics(ixfileHandle, height, leafCount, entryCount);
+    assert(rc == success && "indexManager::getTreeStatistics() should not fail.");
+    cerr << "height: " << stats->treeHeight << ", node visits: " << stats->nodeVisits << ", leaf splits: " << stats->leafSplits
+         << ", internal splits: " << stats->internalSplits << ", root splits: " << stats->rootSplits << endl;
+    if (height != 3 || stats->treeHeight != height || stats->leafSplits != leafCount - 1 ||
+            stats->internalSplits == 0 || stats->rootSplits != 1 || stats->nodeVisits < 2 * numOfTuples) {
+        cerr << "The index counters are not correct." << endl;
+        return fail;
+    }
+
+    // A scan descends the tree once
+    uint64_t visits = stats->nodeVisits;
+    rc = indexManager->scan(ixfileHandle, attribute, NULL, NULL, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+    unsigned returned = 0;
+    while (ix_ScanIterator.getNextEntry(rid, key) == success)
+        returned++;
+    ix_ScanIterator.close();
+    if (returned != numOfTuples || stats->nodeVisits != visits + height || stats->treeHeight != height) {
+        cerr << "The scan was not counted." << endl;
+        return fail;
+    }
+
+    ostringstream prometheus, expected;
+    registry->writePrometheus(prometheus);
+    expected << "ix_tree_height{file=\"" << indexFileName << "\"} " << height << "\n";
+    if (prometheus.str().find(expected.str()) == string::npos) {
+        cerr << "The tree height is not in the dump." << endl;
+        return fail;
+    }
+
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+
+    return success;
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "stats_idx";
+    Attribute attrEmpName;
+    attrEmpName.length = PAGE_SIZE / 5;
+    attrEmpName.name = "EmpName";
+    attrEmpName.type = TypeVarChar;
+
+    remove("stats_idx");
+
+    RC result = testCase_16(indexFileName, attrEmpName);
+    if (result == success) {
+        cerr << "***** IX Test Case 16 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 16 failed. *****" << endl;
+        return fail;
+    }
+}
@@ -0,0 +1,178 @@
+#include <iostream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+// Key i: the zero padded number, then filler up to the attribute's length
+static void prepareKey(unsigned i, const Attribute &attribute, char *key)
+{
+    *(int *)key = attribute.length;
+    memset(key + sizeof(int), 'k', attribute.length);
+    char digits[16];
+    snprintf(digits, sizeof(digits), "%08u", i);
+    memcpy(key + sizeof(int), digits, 8);
+}
+
+// Inserts numOfTuples keys in an index of pageSize pages and scans them back; returns the tree height
+int buildAndScan(const string &indexFileName, const Attribute &attribute, unsigned pageSize, unsigned numOfTuples, unsigned &height)
+{
+    RID rid;
+    IXFileHandle ixfileHandle;
+    IX_ScanIterator ix_ScanIterator;
+    char key[PAGE_SIZE];
+    char expectedKey[PAGE_SIZE];
+
+    RC rc = indexManager->createFile(indexFileName, pageSize);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    if (ixfileHandle.getPageSize() != pageSize) {
+        cerr << "The index has pages of " << ixfileHandle.getPageSize() << " bytes, not " << pageSize << "." << endl;
+        return fail;
+    }
+
+    // Keys in an order that splits nodes all over the tree
+    for (unsigned i = 0; i < numOfTuples; i++)
+    {
+        unsigned k = (i * 7919) % numOfTuples;
+        prepareKey(k, attribute, key);
+        rid.pageNum = k;
+        rid.slotNum = k % 100;
+        rc = indexManager->insertEntry(ixfileHandle, attribute, key, rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+
+    // Delete the odd keys
+    for (unsigned i = 1; i < numOfTuples; i += 2)
+    {
+        prepareKey(i, attribute, key);
+        rid.pageNum = i;
+        rid.slotNum = i % 100;
+        rc = indexManager->deleteEntry(ixfileHandle, attribute, key, rid);
+        assert(rc == success && "indexManager::deleteEntry() should not fail.");
+    }
+
+    unsigned leafCount, entryCount;
+    rc = indexManager->getTreeStatistics(ixfileHandle, height, leafCount, entryCount);
+    assert(rc == success && "indexManager::getTreeStatistics() should not fail.");
+    cerr << "Pages of " << pageSize / 1024 << " KB: height " << height << ", leaves " << leafCount << ", entries " << entryCount << endl;
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+
+    // The even keys, in order, after reopening
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    unsigned expected = 100;
+    char lowKey[PAGE_SIZE];
+    prepareKey(expected, attribute, lowKey);
+    rc = indexManager->scan(ixfileHandle, attribute, lowKey, NULL, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+    while (ix_ScanIterator.getNextEntry(rid, key) == success)
+    {
+        prepareKey(expected, attribute, expectedKey);
+        if (memcmp(key, expectedKey, sizeof(int) + attribute.length) != 0 || rid.pageNum != expected || rid.slotNum != expected % 100) {
+            cerr << "Wrong entry " << rid.pageNum << " in the scan, expected " << expected << "." << endl;
+            return fail;
+        }
+        expected += 2;
+    }
+    ix_ScanIterator.close();
+    if (expected != numOfTuples || entryCount != numOfTuples / 2) {
+        cerr << "The scan stopped at " << expected << " of " << numOfTuples << " keys." << endl;
+        return fail;
+    }
+
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return success;
+}
+
+int testCase_17(const string &indexFileName, const Attribute &attribute)
+{
+    // Checks indexes with pages larger than PAGE_SIZE
+    // Functions tested
+    // 1. Create an index of 16 KB and 64 KB pages
+    // 2. Insert and delete entries
+    // 3. Tree height against an index of PAGE_SIZE pages
+    // 4. Scan after reopening
+    // 5. Rejecting an index written before node headers had 32 bit offsets
+    cerr << endl << "***** In IX Test Case 17 *****" << endl;
+
+    unsigned numOfTuples = 6000;
+    unsigned height, smallHeight, largeHeight;
+    if (buildAndScan(indexFileName, attribute, PAGE_SIZE, numOfTuples, smallHeight) != success ||
+        buildAndScan(indexFileName, attribute, 4 * PAGE_SIZE, numOfTuples, height) != success ||
+        buildAndScan(indexFileName, attribute, MAX_PAGE_SIZE, numOfTuples, largeHeight) != success)
+        return fail;
+
+    if (height > smallHeight || largeHeight >= smallHeight) {
+        cerr << "Larger pages should make a lower tree." << endl;
+        return fail;
+    }
+
+    RC rc = indexManager->createFile(indexFileName, 3 * PAGE_SIZE);
+    assert(rc != success && "Creating an index of 12 KB pages should fail.");
+
+    // An index whose meta page has no version has the 16 bit offsets of the old node headers
+    rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    PagedFileManager *pfm = PagedFileManager::instance();
+    FileHandle fileHandle;
+    char page[PAGE_SIZE];
+    rc = pfm->openFile(indexFileName, fileHandle);
+    assert(rc == success && "PagedFileManager::openFile() should not fail.");
+    rc = fileHandle.readPage(0, page);
+    assert(rc == success && "FileHandle::readPage() should not fail.");
+    memset(page + offsetof(MetaHeader, version), 0, sizeof(uint32_t));
+    rc = fileHandle.writePage(0, page);
+    assert(rc == success && "FileHandle::writePage() should not fail.");
+    pfm->closeFile(fileHandle);
+
+    IXFileHandle ixfileHandle;
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    char key[PAGE_SIZE];
+    prepareKey(1, attribute, key);
+    RID rid = {1, 1};
+    IX_ScanIterator ix_ScanIterator;
+    if (indexManager->insertEntry(ixfileHandle, attribute, key, rid) != IX_WRONG_VERSION ||
+        indexManager->scan(ixfileHandle, attribute, NULL, NULL, true, true, ix_ScanIterator) != IX_WRONG_VERSION) {
+        cerr << "An index of another version should be rejected." << endl;
+        return fail;
+    }
+    indexManager->closeFile(ixfileHandle);
+    indexManager->destroyFile(indexFileName);
+    return success;
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "pagesize_idx";
+    Attribute attrEmpName;
+    attrEmpName.length = 100;
+    attrEmpName.name = "EmpName";
+    attrEmpName.type = TypeVarChar;
+
+    remove("pagesize_idx");
+
+    RC result = testCase_17(indexFileName, attrEmpName);
+    if (result == success) {
+        cerr << "***** IX Test Case 17 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 17 failed. *****" << endl;
+        return fail;
+    }
+}
@@ -1,6 +1,23 @@
 
 #include "qe.h"
 
+#include <ctime>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+
+void *Iterator::allocateBuffer(size_t size) {
+	return arena ? arena->allocate(size) : malloc(size);
+}
+
+void Iterator::freeBuffer(void *buffer) {
+	if (!arena)
+		free(buffer);
+}
 
 bool Iterator::fieldIsNull(void *data, int i) {
 	uint8_t nullByte = ((uint8_t *) data)[i / 8];
@@ -45,265 +62,382 @@ unsigned Iterator::getActualTupleLength(void *tuple, vector<Attribute> &recordDe
 	return offset;
 }
 
+int Iterator::compareFields(const char *a, const char *b, AttrType type) {
+	int cmp;
+	if (type == TypeInt) {
+		int32_t x, y;
+		memcpy(&x, a, INT_SIZE);
+		memcpy(&y, b, INT_SIZE);
+		cmp = (x > y) - (x < y);
+	} else if (type == TypeReal) {
+		float x, y;
+		memcpy(&x, a, REAL_SIZE);
+		memcpy(&y, b, REAL_SIZE);
+		cmp = (x > y) - (x < y);
+	} else {
+		uint32_t xLength, yLength;
+		memcpy(&xLength, a, VARCHAR_LENGTH_SIZE);
+		memcpy(&yLength, b, VARCHAR_LENGTH_SIZE);
+		cmp = memcmp(a + VARCHAR_LENGTH_SIZE, b + VARCHAR_LENGTH_SIZE, min(xLength, yLength));
+		if (cmp == 0)
+			cmp = (xLength > yLength) - (xLength < yLength);
+		cmp = (cmp > 0) - (cmp < 0);
+	}
+	return cmp;
+}
+
+unsigned Iterator::getMaxTupleLength(const vector<Attribute> &recordDescriptor) {
+	unsigned length = getNumNullBytes(recordDescriptor.size());
+	for (const Attribute &attr: recordDescriptor) {
+		length += attr.length;
+		if (attr.type == TypeVarChar)
+			length += VARCHAR_LENGTH_SIZE;
+	}
+	return length;
+}
+
+unsigned Iterator::getFieldOffsets(const void *tuple, const vector<Attribute> &recordDescriptor, unsigned *offsets) {
+	unsigned offset = getNumNullBytes(recordDescriptor.size());
+
+	for (size_t i = 0; i < recordDescriptor.size(); i++) {
+		if (fieldIsNull((void *) tuple, i)) {
+			offsets[i] = 0;
+			continue;
+		}
+		offsets[i] = offset;
+		if (recordDescriptor[i].type == TypeVarChar) {
+			uint32_t varcharLength;
+			memcpy(&varcharLength, (char *) tuple + offset, VARCHAR_LENGTH_SIZE);
+			offset += VARCHAR_LENGTH_SIZE + varcharLength;
+		} else {
+			offset += recordDescriptor[i].length;
+		}
+	}
+
+	return offset;
+}
+
 Filter::Filter(Iterator* input, const Condition &condition)
 {
 	this->input = input;
-	this->attrNames = attrNames;
-	this->cond = condition;
+	init(vector<Condition>(1, condition));
+}
 
+Filter::Filter(Iterator* input, const vector<Condition> &conditions)
+{
+	this->input = input;
+	init(conditions);
+}
 
-	// right side is a join operator not a filter
-	if(cond.bRhsIsAttr);
+// Push what the input can evaluate itself, then compile the remaining conditions
+void Filter::init(const vector<Condition> &conditions)
+{
+	TableScan *tableScan = dynamic_cast<TableScan *>(input->getSource());
+	IndexScan *indexScan = dynamic_cast<IndexScan *>(input->getSource());
+	for (const Condition &cond: conditions) {
+		if (tableScan && tableScan->pushCondition(cond))
+			continue;
+		if (indexScan && indexScan->pushCondition(cond))
+			continue;
+		conds.push_back(cond);
+	}
 
+	batch = NULL;
+	compile();
+}
 
+// Resolve every condition's attributes and allocate the batch once, so getNextTuple never allocates
+void Filter::compile()
+{
+	inputAttrs.clear();
 	input->getAttributes(inputAttrs);
 
+	auto findAttr = [&](const string &name) {
+		auto pred = [&](const Attribute &attr) { return attr.name == name; };
+		return (unsigned) distance(inputAttrs.begin(), find_if(inputAttrs.begin(), inputAttrs.end(), pred));
+	};
 
-	for(unsigned i = 0; i < inputAttrs.size(); ++i){
-		if(inputAttrs[i].name == this->cond.lhsAttr){
-			this->index = i;
-		}
+	valid = true;
+	lhsIndexes.clear();
+	rhsIndexes.clear();
+	for (Condition &cond: conds) {
+		unsigned lhs = findAttr(cond.lhsAttr);
+		unsigned rhs = cond.bRhsIsAttr ? findAttr(cond.rhsAttr) : 0;
+		if (cond.op != NO_OP && (lhs == inputAttrs.size() || rhs == inputAttrs.size()))
+			valid = false;
+		lhsIndexes.push_back(lhs);
+		rhsIndexes.push_back(rhs);
 	}
 
-
-	inputTupleSize = 0;
-	for (Attribute &attr: inputAttrs) {
-		inputTupleSize += attr.length;
-	}
+	inputTupleSize = getMaxTupleLength(inputAttrs);
+	freeBuffer(batch);
+	batch = (char *) allocateBuffer(FILTER_BATCH_SIZE * inputTupleSize);
+	fieldOffsets.resize(FILTER_BATCH_SIZE * inputAttrs.size());
+	batchCount = 0;
+	batchPos = 0;
+	inputDone = false;
 }
 
 Filter::~Filter()
 {
+	freeBuffer(batch);
 }
 
 RC Filter::getNextTuple(void *data)
 {
-	void *origData = malloc(inputTupleSize);
-	void *origAttr;
-	bool status = false;
-	RC rc;
-	while((rc = input ->getNextTuple(origData)) == SUCCESS) {
-		unsigned nullIndicatorSize = getNumNullBytes(inputAttrs.size());
+	if (!valid)
+		return QE_ATTR_NOT_FOUND;
 
-		// value at this position is null
-		if(fieldIsNull(origData, index)){
-			if(cond.op == NO_OP){
-				memcpy(data, origData, inputTupleSize);
+	while (true) {
+		// Hand out the matching tuples of the current batch
+		while (batchPos < batchCount) {
+			unsigned i = batchPos++;
+			if (PredicateEvaluator::bitIsSet(batchMatches, i)) {
+				memcpy(data, batch + i * inputTupleSize, tupleLengths[i]);
 				return SUCCESS;
-			}else{
-				continue;
 			}
 		}
+		if (inputDone)
+			return QE_EOF;
+		fillBatch();
+	}
+}
 
-		unsigned offset = nullIndicatorSize;
-		// advance data through fields until we reach index
-		for (unsigned i = 0; i < index; i++) {
-			switch (inputAttrs[i].type) {
-			case TypeInt:
-			case TypeReal:
-				offset += INT_SIZE;
-				break;
-			case TypeVarChar:
-				uint32_t varchar_length;
-				memcpy(&varchar_length, (char*)origData + offset, VARCHAR_LENGTH_SIZE);
-				offset += VARCHAR_LENGTH_SIZE + varchar_length;
-				break;
-			}
-		}
-		
-		if(cond.rhsValue.type == TypeInt || cond.rhsValue.type == TypeReal){
-			origAttr= malloc(INT_SIZE);
-			memcpy(origAttr, (char*)origData + offset, INT_SIZE);
-		}else{
-			
-			int32_t varchar_length;
-			memcpy(&varchar_length, (char*)origData + offset, VARCHAR_LENGTH_SIZE);
-
-			origAttr= malloc(varchar_length + VARCHAR_LENGTH_SIZE);
-			memcpy(origAttr, (char*)origData + offset, varchar_length + VARCHAR_LENGTH_SIZE);
+// Pull up to FILTER_BATCH_SIZE tuples from the input and test each condition on all of them at once
+RC Filter::fillBatch()
+{
+	batchCount = 0;
+	batchPos = 0;
+	while (batchCount < FILTER_BATCH_SIZE) {
+		char *tuple = batch + batchCount * inputTupleSize;
+		if (input->getNextTuple(tuple) != SUCCESS) {
+			inputDone = true;
+			break;
 		}
+		tupleLengths[batchCount] = getFieldOffsets(tuple, inputAttrs, &fieldOffsets[batchCount * inputAttrs.size()]);
+		batchCount++;
+	}
+
+	memset(batchMatches, 0xFF, sizeof(batchMatches));
+	for (unsigned c = 0; c < conds.size(); c++) {
+		if (conds[c].op == NO_OP)
+			continue;
+		evaluateCondition(c);
+		for (unsigned i = 0; i < sizeof(batchMatches); i++)
+			batchMatches[i] &= condMatches[i];
+	}
+	return SUCCESS;
+}
 
-		switch (cond.rhsValue.type)
-		{
-			case TypeInt:
-				status = filterData(*(uint32_t *)origAttr, cond.op, *(uint32_t *)cond.rhsValue.data);
-				break;
-			case TypeReal:
-				status = filterData(*(float*)origAttr, cond.op, *(float*)cond.rhsValue.data);
-				break;
-			case TypeVarChar:
-				status = filterData(origAttr, cond.op, cond.rhsValue.data);
-				break;
-			default: status = false;
+// Test condition c on the current batch, leaving the result in condMatches
+void Filter::evaluateCondition(unsigned c)
+{
+	PredicateEvaluator *pe = PredicateEvaluator::instance();
+	const Condition &cond = conds[c];
+	unsigned lhs = lhsIndexes[c];
+	AttrType type = inputAttrs[lhs].type;
+	bool present[FILTER_BATCH_SIZE];
+
+	memset(condMatches, 0, sizeof(condMatches));
+
+	// Attribute to attribute comparisons are done one tuple at a time
+	if (cond.bRhsIsAttr) {
+		unsigned rhs = rhsIndexes[c];
+		if (inputAttrs[rhs].type != type)
+			return;
+		for (unsigned i = 0; i < batchCount; i++) {
+			const char *lhsField, *rhsField;
+			uint32_t lhsLength, rhsLength;
+			if (!getField(i, lhs, lhsField, lhsLength) || !getField(i, rhs, rhsField, rhsLength))
+				continue;
+
+			bool match;
+			if (type == TypeInt) {
+				int32_t l, r;
+				memcpy(&l, lhsField, INT_SIZE);
+				memcpy(&r, rhsField, INT_SIZE);
+				match = PredicateEvaluator::compare(l, cond.op, r);
+			} else if (type == TypeReal) {
+				float l, r;
+				memcpy(&l, lhsField, REAL_SIZE);
+				memcpy(&r, rhsField, REAL_SIZE);
+				match = PredicateEvaluator::compare(l, cond.op, r);
+			} else {
+				match = PredicateEvaluator::compareVarChar(lhsField, lhsLength, cond.op, rhsField, rhsLength);
+			}
+			if (match)
+				condMatches[i / CHAR_BIT] |= 1 << (i % CHAR_BIT);
 		}
+		return;
+	}
 
-		if(status == true){
-			memcpy(data, origData, inputTupleSize);
-			return SUCCESS;
+	for (unsigned i = 0; i < batchCount; i++) {
+		const char *field = NULL;
+		uint32_t length = 0;
+		present[i] = getField(i, lhs, field, length);
+		intValues[i] = 0;
+		realValues[i] = 0;
+		varcharValues[i] = field;
+		varcharLengths[i] = length;
+		if (present[i] && type == TypeInt)
+			memcpy(&intValues[i], field, INT_SIZE);
+		else if (present[i] && type == TypeReal)
+			memcpy(&realValues[i], field, REAL_SIZE);
+	}
+
+	if (type == TypeInt) {
+		int32_t value;
+		memcpy(&value, cond.rhsValue.data, INT_SIZE);
+		pe->evalInt(intValues, batchCount, cond.op, value, condMatches);
+	} else if (type == TypeReal) {
+		float value;
+		memcpy(&value, cond.rhsValue.data, REAL_SIZE);
+		pe->evalReal(realValues, batchCount, cond.op, value, condMatches);
+	} else if (cond.op == EQ_OP || cond.op == NE_OP) {
+		pe->evalVarCharEq(varcharValues, varcharLengths, batchCount, cond.op, cond.rhsValue.data, condMatches);
+	} else {
+		// Range comparisons on varchars have no kernel, test them one at a time
+		uint32_t valueLength;
+		memcpy(&valueLength, cond.rhsValue.data, VARCHAR_LENGTH_SIZE);
+		const char *valueString = (char *) cond.rhsValue.data + VARCHAR_LENGTH_SIZE;
+		for (unsigned i = 0; i < batchCount; i++) {
+			if (present[i] && PredicateEvaluator::compareVarChar(varcharValues[i], varcharLengths[i], cond.op, valueString, valueLength))
+				condMatches[i / CHAR_BIT] |= 1 << (i % CHAR_BIT);
 		}
 	}
-	return QE_EOF;
-}
-
-bool Filter::filterData(uint32_t recordInt, CompOp compOp, const uint32_t intValue)
-{
-    switch (compOp)
-    {
-        case EQ_OP: return recordInt == intValue;
-        case LT_OP: return recordInt < intValue;
-        case GT_OP: return recordInt > intValue;
-        case LE_OP: return recordInt <= intValue;
-        case GE_OP: return recordInt >= intValue;
-        case NE_OP: return recordInt != intValue;
-        case NO_OP: return true;
-        // Should never happen
-        default: return false;
-    }
-}
-
-bool Filter::filterData(float recordReal, CompOp compOp, const float realValue)
-{
-    switch (compOp)
-    {
-        case EQ_OP: return recordReal == realValue;
-        case LT_OP: return recordReal < realValue;
-        case GT_OP: return recordReal > realValue;
-        case LE_OP: return recordReal <= realValue;
-        case GE_OP: return recordReal >= realValue;
-        case NE_OP: return recordReal != realValue;
-        case NO_OP: return true;
-        // Should never happen
-        default: return false;
-    }
-}
-
-bool Filter::filterData(void *recordString, CompOp compOp, const void *value)
-{
-
-    int32_t valueSize;
-    memcpy(&valueSize, value, VARCHAR_LENGTH_SIZE);
-    char valueStr[valueSize + 1];
-    valueStr[valueSize] = '\0';
-    memcpy(valueStr, (char*) value + VARCHAR_LENGTH_SIZE, valueSize);
-	
-	int32_t recordSize;
-    memcpy(&recordSize, recordString, VARCHAR_LENGTH_SIZE);
-    char recordStr[recordSize + 1];
-    recordStr[recordSize] = '\0';
-    memcpy(recordStr, (char*) recordString + VARCHAR_LENGTH_SIZE, recordSize);
-
-	
-    int cmp = strcmp(recordStr, valueStr);
-    switch (compOp)
-    {
-        case EQ_OP: return cmp == 0;
-        case LT_OP: return cmp <  0;
-        case GT_OP: return cmp >  0;
-        case LE_OP: return cmp <= 0;
-        case GE_OP: return cmp >= 0;
-        case NE_OP: return cmp != 0;
-        // Should never happen
-        default: return false;
-    }
-	return false;
+
+	// Null values never satisfy a comparison
+	for (unsigned i = 0; i < batchCount; i++) {
+		if (!present[i])
+			condMatches[i / CHAR_BIT] &= ~(1 << (i % CHAR_BIT));
+	}
+}
+
+// Point field at attribute index of buffered tuple i. Returns false if it is null
+bool Filter::getField(unsigned tuple, unsigned index, const char *&field, uint32_t &length)
+{
+	unsigned offset = fieldOffsets[tuple * inputAttrs.size() + index];
+	if (offset == 0)
+		return false;
+
+	const char *data = batch + tuple * inputTupleSize;
+	if (inputAttrs[index].type == TypeVarChar) {
+		memcpy(&length, data + offset, VARCHAR_LENGTH_SIZE);
+		field = data + offset + VARCHAR_LENGTH_SIZE;
+	} else {
+		length = INT_SIZE;
+		field = data + offset;
+	}
+	return true;
 }
+
 void Filter::getAttributes(vector<Attribute> &attrs) const
 {
 	attrs.clear();
-	for (string attrName: attrNames) {
-		auto pred = [&](Attribute attr) { return attr.name == attrName; };
-		vector<Attribute>::const_iterator attr = find_if(inputAttrs.begin(), inputAttrs.end(), pred);
-		attrs.push_back(*attr);
+	attrs = inputAttrs;
+}
+
+void Filter::pushProjection(const vector<string> &attrNames)
+{
+	vector<string> needed = attrNames;
+	for (const Condition &cond: conds) {
+		needed.push_back(cond.lhsAttr);
+		if (cond.bRhsIsAttr)
+			needed.push_back(cond.rhsAttr);
 	}
+	input->pushProjection(needed);
+	compile();
 }
 
 Project::Project(Iterator *input, const vector<string> &attrNames)
 {
 	this->input = input;
 	this->attrNames = attrNames;
+	// Don't let the input produce columns nobody above us reads
+	input->pushProjection(attrNames);
 	input->getAttributes(inputAttrs);
-	inputTupleSize = 0;
-	for (Attribute &attr: inputAttrs) {
-		inputTupleSize += attr.length;
+
+	// Resolve the projected attributes once
+	valid = true;
+	for (const string &name: attrNames) {
+		auto pred = [&](const Attribute &attr) { return attr.name == name; };
+		unsigned index = distance(inputAttrs.begin(), find_if(inputAttrs.begin(), inputAttrs.end(), pred));
+		if (index == inputAttrs.size()) {
+			valid = false;
+			continue;
+		}
+		projection.push_back(index);
+		attrs.push_back(inputAttrs[index]);
 	}
+
+	inputData = (char *) allocateBuffer(getMaxTupleLength(inputAttrs));
+	fieldOffsets.resize(inputAttrs.size());
 }
 
 Project::~Project()
 {
+	freeBuffer(inputData);
 }
 
 RC Project::getNextTuple(void *data)
 {
-	void *origData = malloc(inputTupleSize);
-	if (input->getNextTuple(origData) != QE_EOF) {
-		if(projectAttributes(origData, data))
-			return QE_EOF;
-		return SUCCESS;
-	}
-	return QE_EOF;
+	if (!valid)
+		return QE_ATTR_NOT_FOUND;
+
+	RC rc = input->getNextTuple(inputData);
+	if (rc)
+		return rc;
+
+	projectAttributes(data);
+	return SUCCESS;
 }
 
-RC Project::projectAttributes(void *origData, void *newData) {
-	unsigned origNumNullBytes = getNumNullBytes(inputAttrs.size());
-	unsigned newNumNullBytes = getNumNullBytes(attrNames.size());
+void Project::projectAttributes(void *newData) {
+	getFieldOffsets(inputData, inputAttrs, fieldOffsets.data());
 
 	// set all null bytes in newData to 0
+	unsigned newNumNullBytes = getNumNullBytes(projection.size());
 	memset(newData, 0, newNumNullBytes);
 
-	// offset into newData
-	// skip null bytes
+	// offset into newData, skip null bytes
 	unsigned newOffset = newNumNullBytes;
-	// iterate through list of new attribute names
-	for (unsigned newIndex = 0; newIndex < attrNames.size(); newIndex++) {
-		// offset into origData
-		unsigned origOffset = origNumNullBytes;
-		// iterate through original record descriptor
-		unsigned origIndex;
-		for (origIndex = 0; origIndex < inputAttrs.size(); origIndex++) {
-			Attribute curAttr = inputAttrs[origIndex];
-			bool nullField = fieldIsNull(origData, origIndex);
-			// if this entry in the record descriptor matches the current attribute name
-			// AND this field in the original tuple is null
-			if (curAttr.name == attrNames[newIndex] && nullField) {
-				// set this field to be null in the new tuple
-				setFieldNull(newData, newIndex);
-				// break from inner loop
-				break;
-			}
-			// if this entry in the record descriptor matches the current attribute name
-			// AND this field in the original tuple is NOT null
-			else if (curAttr.name == attrNames[newIndex] && !nullField) {
-				// copy this field from the old tuple to the new one
-				unsigned fieldSize = getFieldLength((char *) origData + origOffset, curAttr);
-				memcpy((char *) newData + newOffset, (char *) origData + origOffset, fieldSize);
-				newOffset += fieldSize;
-				// break from inner loop
-				break;
-			}
-			// if neither of these conditions are met and this field isn't null, advance origOffset and loop
-			if (!nullField) {
-				unsigned fieldLength = getFieldLength((char *) origData + origOffset, curAttr);
-				origOffset += fieldLength;
-			}
+	for (unsigned newIndex = 0; newIndex < projection.size(); newIndex++) {
+		unsigned origIndex = projection[newIndex];
+		unsigned origOffset = fieldOffsets[origIndex];
+		if (origOffset == 0) {
+			setFieldNull(newData, newIndex);
+			continue;
 		}
-		if (origIndex == inputAttrs.size())
-			return QE_ATTR_NOT_FOUND;
+		// copy this field from the old tuple to the new one
+		unsigned fieldSize = getFieldLength(inputData + origOffset, inputAttrs[origIndex]);
+		memcpy((char *) newData + newOffset, inputData + origOffset, fieldSize);
+		newOffset += fieldSize;
 	}
-
-	return SUCCESS;
 }
 
 void Project::getAttributes(vector<Attribute> &attrs) const
 {
 	attrs.clear();
-	attrs = inputAttrs;
+	attrs = this->attrs;
 }
 
 INLJoin::INLJoin(Iterator *leftIn,
 	  IndexScan *rightIn,
 	  const Condition &condition)
 {
-	cartProd = new CartProd(leftIn, rightIn);
+	// An equality on the indexed attribute lets every left tuple probe the index for its key
+	// instead of scanning all of it
+	int probeIndex = -1;
+	if (condition.op == EQ_OP && condition.bRhsIsAttr && condition.rhsAttr == rightIn->tableName + "." + rightIn->attrName) {
+		vector<Attribute> leftAttrs;
+		leftIn->getAttributes(leftAttrs);
+		for (unsigned i = 0; i < leftAttrs.size(); i++) {
+			if (leftAttrs[i].name == condition.lhsAttr)
+				probeIndex = i;
+		}
+	}
+
+	cartProd = new CartProd(leftIn, rightIn, probeIndex);
 	cartProd->getAttributes(attrs);
 
 	filter = new Filter(cartProd, condition);
@@ -323,75 +457,1462 @@ RC INLJoin::getNextTuple(void *data)
 void INLJoin::getAttributes(vector<Attribute> &attrs) const
 {
 	attrs.clear();
-	copy(this->attrs.begin(), this->attrs.end(), attrs.begin());
+	attrs = this->attrs;
 }
 
+
 // Pretty much assumes all properties of the INLJoin that calls it (except the
 // Condition) and iterates through the inner table for every tuple in the outer
-CartProd::CartProd(Iterator *leftIn, IndexScan *rightIn)
+CartProd::CartProd(Iterator *leftIn, IndexScan *rightIn, int probeIndex)
 {
 	this->leftIn = leftIn;
 	this->rightIn = rightIn;
+	this->probeIndex = probeIndex;
 	leftIn->getAttributes(leftAttrs);
 	rightIn->getAttributes(rightAttrs);
+	leftOffsets.resize(leftAttrs.size());
 
-	leftInputTupleSize = 0;
-	for(Attribute attr : leftAttrs){
-		leftInputTupleSize += attr.length;
-	}
-
-	rightInputTupleSize = 0;
-	for(Attribute attr : rightAttrs){
-		rightInputTupleSize += attr.length;
-	}
-
-	leftData = malloc(leftInputTupleSize);
+	leftData = (char *) allocateBuffer(getMaxTupleLength(leftAttrs));
+	rightData = (char *) allocateBuffer(getMaxTupleLength(rightAttrs));
 
 	leftIterEmpty = leftIn->getNextTuple(leftData) == QE_EOF;
+	if (!leftIterEmpty)
+		setLeftTuple(false);
 }
 
 CartProd::~CartProd()
 {
-	free(leftData);
+	freeBuffer(leftData);
+	freeBuffer(rightData);
+}
+
+// The left tuple's fields are copied unchanged into every output tuple, measure them once.
+// Then start the right input over for it, unless it's the first left tuple of a full scan
+void CartProd::setLeftTuple(bool restart)
+{
+	leftFieldsLength = getActualTupleLength(leftData, leftAttrs) - getNumNullBytes(leftAttrs.size());
+	leftMatchable = true;
+	rightMatched = false;
+
+	if (probeIndex >= 0) {
+		getFieldOffsets(leftData, leftAttrs, leftOffsets.data());
+		char *key = leftData + leftOffsets[probeIndex];
+		leftMatchable = leftOffsets[probeIndex] != 0;
+		if (leftMatchable)
+			rightIn->setIterator(key, key, true, true);
+	} else if (restart) {
+		rightIn->setIterator(NULL, NULL, true, true);
+	}
 }
 
 RC CartProd::getNextTuple(void *data)
 {
 	if (leftIterEmpty)
 		return QE_EOF;
-	
-	void *rightData = malloc(rightInputTupleSize);
 
-	if(rightIn->getNextTuple(rightData) == QE_EOF){
+	while (!leftMatchable || rightIn->getNextTuple(rightData) == QE_EOF) {
+		// Without probing every left tuple sees the same right input, so an empty one stays empty
+		if (probeIndex < 0 && !rightMatched) {
+			leftIterEmpty = true;
+			return QE_EOF;
+		}
+		if (leftIn->getNextTuple(leftData) == QE_EOF) {
+			leftIterEmpty = true;
+			return QE_EOF;
+		}
+		setLeftTuple(true);
+	}
+	rightMatched = true;
+
+	// Output is one null indicator covering both sides, then the left fields, then the right fields
+	unsigned leftNullBytes = getNumNullBytes(leftAttrs.size());
+	unsigned rightNullBytes = getNumNullBytes(rightAttrs.size());
+	unsigned nullBytes = getNumNullBytes(leftAttrs.size() + rightAttrs.size());
+	memset(data, 0, nullBytes);
+	for (unsigned i = 0; i < leftAttrs.size(); i++) {
+		if (fieldIsNull(leftData, i))
+			setFieldNull(data, i);
+	}
+	for (unsigned i = 0; i < rightAttrs.size(); i++) {
+		if (fieldIsNull(rightData, i))
+			setFieldNull(data, leftAttrs.size() + i);
+	}
+
+	unsigned rightFieldsLength = getActualTupleLength(rightData, rightAttrs) - rightNullBytes;
+	memcpy((char *) data + nullBytes, leftData + leftNullBytes, leftFieldsLength);
+	memcpy((char *) data + nullBytes + leftFieldsLength, rightData + rightNullBytes, rightFieldsLength);
+
+	return SUCCESS;
+}
+
+
+void CartProd::getAttributes(vector<Attribute> &attrs) const
+{
+	attrs.clear();
+	attrs = leftAttrs;
+	attrs.insert(attrs.end(), rightAttrs.begin(), rightAttrs.end());
+}
+
+unsigned Sort::nextSortId = 0;
+
+Sort::Sort(Iterator *input, const vector<string> &keys, const vector<bool> &asc, unsigned memPages)
+{
+	this->input = input;
+	this->asc = asc;
+	input->getAttributes(attrs);
+	for (Attribute &attr: attrs)
+		attrNames.push_back(attr.name);
+
+	// Resolve the sort keys once
+	valid = keys.size() == asc.size();
+	for (const string &key: keys) {
+		auto pred = [&](const Attribute &attr) { return attr.name == key; };
+		unsigned index = distance(attrs.begin(), find_if(attrs.begin(), attrs.end(), pred));
+		if (index == attrs.size())
+			valid = false;
+		keyIndexes.push_back(index);
+	}
 
-		if(leftIn->getNextTuple(leftData) == QE_EOF){
-			free(rightData);
+	sortId = nextSortId++;
+	nextRunId = 0;
+	tupleSize = getMaxTupleLength(attrs);
+	capacity = max(2u, memPages * PAGE_SIZE / tupleSize);
+	fanIn = memPages > 2 ? memPages - 1 : 2;
+	sorted = false;
+	inMemory = false;
+
+	// One spare slot to read the next input tuple into while the heap is full
+	workspace = (char *) allocateBuffer((capacity + 1) * tupleSize);
+	workspaceOffsets.resize((capacity + 1) * attrs.size());
+	slotRuns.resize(capacity + 1);
+	heap.reserve(capacity + 1);
+}
+
+Sort::~Sort()
+{
+	for (SortRun *run: runs)
+		destroyRun(run);
+	freeBuffer(workspace);
+}
+
+RC Sort::getNextTuple(void *data)
+{
+	if (!valid)
+		return QE_ATTR_NOT_FOUND;
+
+	// The input is consumed on the first call
+	if (!sorted) {
+		RC rc = sortInput();
+		if (rc)
+			return rc;
+		sorted = true;
+	}
+
+	if (inMemory) {
+		if (heap.empty())
 			return QE_EOF;
+		auto after = [&](unsigned a, unsigned b) { return slotBefore(b, a); };
+		pop_heap(heap.begin(), heap.end(), after);
+		unsigned s = heap.back();
+		heap.pop_back();
+		memcpy(data, slot(s), getActualTupleLength(slot(s), attrs));
+		return SUCCESS;
+	}
+
+	if (tree.empty() || runs[tree[0]]->done)
+		return QE_EOF;
+	int winner = tree[0];
+	SortRun *run = runs[winner];
+	memcpy(data, run->tuple, getActualTupleLength(run->tuple, attrs));
+	RC rc = advanceRun(run);
+	if (rc)
+		return rc;
+	adjust(winner);
+	return SUCCESS;
+}
+
+void Sort::getAttributes(vector<Attribute> &attrs) const
+{
+	attrs.clear();
+	attrs = this->attrs;
+}
+
+bool Sort::sortedOn(const string &attrName) const
+{
+	return valid && !keyIndexes.empty() && attrs[keyIndexes[0]].name == attrName && asc[0];
+}
+
+// Sort everything in memory if it fits, otherwise spill runs and merge them down to at most fanIn
+RC Sort::sortInput()
+{
+	auto after = [&](unsigned a, unsigned b) { return slotBefore(b, a); };
+
+	unsigned count = 0;
+	while (count < capacity) {
+		if (input->getNextTuple(slot(count)) != SUCCESS)
+			break;
+		getFieldOffsets(slot(count), attrs, slotOffsets(count));
+		slotRuns[count] = 0;
+		heap.push_back(count);
+		count++;
+	}
+	make_heap(heap.begin(), heap.end(), after);
+
+	if (count < capacity) {
+		inMemory = true;
+		return SUCCESS;
+	}
+
+	RC rc = createRuns();
+	if (rc)
+		return rc;
+
+	// Intermediate passes, each replaces the first fanIn runs by their merge
+	while (runs.size() > fanIn) {
+		rc = mergeRuns(fanIn);
+		if (rc)
+			return rc;
+	}
+
+	for (SortRun *run: runs) {
+		rc = openRun(run);
+		if (rc)
+			return rc;
+	}
+	startMerge(runs.size());
+	return SUCCESS;
+}
+
+// Replacement selection: always write out the smallest tuple in memory that can still extend
+// the current run. On random input the runs come out about twice as long as the workspace
+RC Sort::createRuns()
+{
+	RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+	auto after = [&](unsigned a, unsigned b) { return slotBefore(b, a); };
+
+	unsigned spare = capacity;
+	bool inputDone = false;
+	unsigned currentRun = 0;
+	SortRun *run;
+	RC rc = createRun(run);
+	if (rc)
+		return rc;
+
+	RID rid;
+	while (!heap.empty()) {
+		pop_heap(heap.begin(), heap.end(), after);
+		unsigned s = heap.back();
+		heap.pop_back();
+
+		if (slotRuns[s] != currentRun) {
+			rbfm->closeFile(run->fileHandle);
+			if ((rc = createRun(run)))
+				return rc;
+			currentRun = slotRuns[s];
 		}
+		if (rbfm->appendRecord(run->fileHandle, attrs, slot(s), rid))
+			return RBFM_WRITE_FAILED;
 
-		rightIn->setIterator(NULL, NULL, true, true);
+		if (inputDone)
+			continue;
+		if (input->getNextTuple(slot(spare)) != SUCCESS) {
+			inputDone = true;
+			continue;
+		}
+		// A tuple that sorts before the one just written has to wait for the next run
+		getFieldOffsets(slot(spare), attrs, slotOffsets(spare));
+		bool smaller = compareTuples(slot(spare), slotOffsets(spare), slot(s), slotOffsets(s)) < 0;
+		slotRuns[spare] = smaller ? currentRun + 1 : currentRun;
+		heap.push_back(spare);
+		push_heap(heap.begin(), heap.end(), after);
+		spare = s;
+	}
 
-		if (rightIn->getNextTuple(rightData) == QE_EOF) {
-			free(rightData);
+	rbfm->closeFile(run->fileHandle);
+	return SUCCESS;
+}
+
+// Merge the first count runs into a new run at the end of the list
+RC Sort::mergeRuns(unsigned count)
+{
+	RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+	RC rc;
+	for (unsigned i = 0; i < count; i++) {
+		if ((rc = openRun(runs[i])))
+			return rc;
+	}
+	startMerge(count);
+
+	SortRun *output;
+	if ((rc = createRun(output)))
+		return rc;
+
+	RID rid;
+	while (!runs[tree[0]]->done) {
+		int winner = tree[0];
+		if (rbfm->appendRecord(output->fileHandle, attrs, runs[winner]->tuple, rid))
+			return RBFM_WRITE_FAILED;
+		if ((rc = advanceRun(runs[winner])))
+			return rc;
+		adjust(winner);
+	}
+	rbfm->closeFile(output->fileHandle);
+
+	// createRun added output at the end, drop the merged runs from the front
+	for (unsigned i = 0; i < count; i++)
+		destroyRun(runs[i]);
+	runs.erase(runs.begin(), runs.begin() + count);
+	tree.clear();
+	return SUCCESS;
+}
+
+RC Sort::createRun(SortRun *&run)
+{
+	RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+	run = new SortRun();
+	run->fileName = "sort_" + to_string(sortId) + "_" + to_string(nextRunId++) + ".run";
+	run->tuple = NULL;
+	run->done = true;
+	runs.push_back(run);
+
+	rbfm->destroyFile(run->fileName);
+	if (rbfm->createFile(run->fileName))
+		return RBFM_CREATE_FAILED;
+	if (rbfm->openFile(run->fileName, run->fileHandle))
+		return RBFM_OPEN_FAILED;
+	return SUCCESS;
+}
+
+// Start scanning a finished run and load its first tuple
+RC Sort::openRun(SortRun *run)
+{
+	RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+	if (rbfm->openFile(run->fileName, run->fileHandle))
+		return RBFM_OPEN_FAILED;
+	RC rc = rbfm->scan(run->fileHandle, attrs, "", NO_OP, NULL, attrNames, run->iter);
+	if (rc)
+		return rc;
+
+	run->tuple = (char *) allocateBuffer(tupleSize);
+	run->offsets.resize(attrs.size());
+	run->done = false;
+	return advanceRun(run);
+}
+
+RC Sort::advanceRun(SortRun *run)
+{
+	RID rid;
+	RC rc = run->iter.getNextRecord(rid, run->tuple);
+	if (rc == RBFM_EOF) {
+		run->done = true;
+		return SUCCESS;
+	}
+	if (rc)
+		return rc;
+	getFieldOffsets(run->tuple, attrs, run->offsets.data());
+	return SUCCESS;
+}
+
+void Sort::destroyRun(SortRun *run)
+{
+	RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+	if (run->tuple) {
+		run->iter.close();
+		freeBuffer(run->tuple);
+	}
+	rbfm->closeFile(run->fileHandle);
+	rbfm->destroyFile(run->fileName);
+	delete run;
+}
+
+// Build the loser tree over runs[0, count). -1 stands for a key smaller than everything,
+// so every leaf gets played against the others once
+void Sort::startMerge(unsigned count)
+{
+	tree.assign(count, -1);
+	for (int s = count - 1; s >= 0; s--)
+		adjust(s);
+}
+
+// Replay leaf s from the bottom of the tree up to the root
+void Sort::adjust(int s)
+{
+	int t = (s + tree.size()) / 2;
+	while (t > 0) {
+		if (beats(tree[t], s))
+			swap(s, tree[t]);
+		t /= 2;
+	}
+	tree[0] = s;
+}
+
+// Does run a win against run b? Exhausted runs lose to everything, ties go to the earlier run
+bool Sort::beats(int a, int b)
+{
+	if (a == -1)
+		return true;
+	if (b == -1)
+		return false;
+	if (runs[a]->done || runs[b]->done)
+		return !runs[a]->done;
+	int cmp = compareTuples(runs[a]->tuple, runs[a]->offsets.data(), runs[b]->tuple, runs[b]->offsets.data());
+	return cmp < 0 || (cmp == 0 && a < b);
+}
+
+// Order of workspace slots during replacement selection: by run, then by key
+bool Sort::slotBefore(unsigned a, unsigned b)
+{
+	if (slotRuns[a] != slotRuns[b])
+		return slotRuns[a] < slotRuns[b];
+	return compareTuples(slot(a), slotOffsets(a), slot(b), slotOffsets(b)) < 0;
+}
+
+// Compare two tuples on the sort keys. Nulls sort before every value
+int Sort::compareTuples(const char *a, const unsigned *aOffsets, const char *b, const unsigned *bOffsets) const
+{
+	for (unsigned k = 0; k < keyIndexes.size(); k++) {
+		unsigned index = keyIndexes[k];
+		unsigned aOffset = aOffsets[index];
+		unsigned bOffset = bOffsets[index];
+		int cmp;
+		if (aOffset == 0 || bOffset == 0)
+			cmp = (aOffset != 0) - (bOffset != 0);
+		else
+			cmp = compareFields(a + aOffset, b + bOffset, attrs[index].type);
+		if (cmp != 0)
+			return asc[k] ? cmp : -cmp;
+	}
+	return 0;
+}
+
+unsigned SMJoin::nextJoinId = 0;
+
+SMJoin::SMJoin(Iterator *leftIn, Iterator *rightIn, const Condition &condition, unsigned memPages)
+{
+	// The budget is shared by the rewind buffer and the sorts we may have to add
+	unsigned pages = max(1u, memPages / 3);
+
+	leftSort = NULL;
+	rightSort = NULL;
+	if (!sortedOn(leftIn, condition.lhsAttr)) {
+		leftSort = new Sort(leftIn, vector<string>(1, condition.lhsAttr), vector<bool>(1, true), pages);
+		leftIn = leftSort;
+	}
+	if (condition.bRhsIsAttr && !sortedOn(rightIn, condition.rhsAttr)) {
+		rightSort = new Sort(rightIn, vector<string>(1, condition.rhsAttr), vector<bool>(1, true), pages);
+		rightIn = rightSort;
+	}
+	this->leftIn = leftIn;
+	this->rightIn = rightIn;
+
+	leftIn->getAttributes(leftAttrs);
+	rightIn->getAttributes(rightAttrs);
+	for (Attribute &attr: rightAttrs)
+		rightAttrNames.push_back(attr.name);
+
+	auto findAttr = [](const vector<Attribute> &attrs, const string &name) {
+		auto pred = [&](const Attribute &attr) { return attr.name == name; };
+		return (unsigned) distance(attrs.begin(), find_if(attrs.begin(), attrs.end(), pred));
+	};
+	leftIndex = findAttr(leftAttrs, condition.lhsAttr);
+	rightIndex = findAttr(rightAttrs, condition.rhsAttr);
+	valid = condition.bRhsIsAttr && condition.op == EQ_OP &&
+			leftIndex < leftAttrs.size() && rightIndex < rightAttrs.size() &&
+			leftAttrs[leftIndex].type == rightAttrs[rightIndex].type;
+	keyType = valid ? leftAttrs[leftIndex].type : TypeInt;
+
+	started = false;
+	leftData = (char *) allocateBuffer(getMaxTupleLength(leftAttrs));
+	rightData = (char *) allocateBuffer(getMaxTupleLength(rightAttrs));
+	leftOffsets.resize(leftAttrs.size());
+	rightOffsets.resize(rightAttrs.size());
+	leftDone = true;
+	rightDone = true;
+
+	groupCapacity = pages * PAGE_SIZE;
+	group = (char *) allocateBuffer(groupCapacity);
+	groupKey = (char *) allocateBuffer(getMaxTupleLength(rightAttrs));
+	spillData = (char *) allocateBuffer(getMaxTupleLength(rightAttrs));
+	groupUsed = 0;
+	groupCount = 0;
+	groupPos = 0;
+	inGroup = false;
+	spillFileName = "smjoin_" + to_string(nextJoinId++) + ".spill";
+	spilling = false;
+	spillScanOpen = false;
+}
+
+SMJoin::~SMJoin()
+{
+	clearGroup();
+	delete leftSort;
+	delete rightSort;
+	freeBuffer(leftData);
+	freeBuffer(rightData);
+	freeBuffer(group);
+	freeBuffer(groupKey);
+	freeBuffer(spillData);
+}
+
+// Index scans return their key in order, as does a Sort whose first key is ascending
+bool SMJoin::sortedOn(Iterator *input, const string &attrName)
+{
+	input = input->getSource();
+	IndexScan *indexScan = dynamic_cast<IndexScan *>(input);
+	if (indexScan)
+		return attrName == indexScan->tableName + "." + indexScan->attrName;
+	Sort *sort = dynamic_cast<Sort *>(input);
+	if (sort)
+		return sort->sortedOn(attrName);
+	return false;
+}
+
+RC SMJoin::getNextTuple(void *data)
+{
+	if (!valid)
+		return QE_ATTR_NOT_FOUND;
+
+	RC rc;
+	if (!started) {
+		started = true;
+		if ((rc = advanceLeft()) || (rc = advanceRight()))
+			return rc;
+	}
+
+	while (true) {
+		if (inGroup) {
+			if (groupPos < groupCount) {
+				if ((rc = nextGroupTuple()))
+					return rc;
+				joinTuples(data);
+				return SUCCESS;
+			}
+			// Replay the group for the next left tuple if it has the same key
+			if ((rc = advanceLeft()))
+				return rc;
+			if (!leftDone && leftOffsets[leftIndex] != 0 && compareFields(leftKey(), groupKey, keyType) == 0) {
+				if ((rc = rewindGroup()))
+					return rc;
+				continue;
+			}
+			clearGroup();
+		}
+
+		if (leftDone || rightDone)
 			return QE_EOF;
+
+		// Null keys never join
+		if (leftOffsets[leftIndex] == 0) {
+			if ((rc = advanceLeft()))
+				return rc;
+			continue;
 		}
+		if (rightOffsets[rightIndex] == 0) {
+			if ((rc = advanceRight()))
+				return rc;
+			continue;
+		}
+
+		int cmp = compareFields(leftKey(), rightKey(), keyType);
+		if (cmp < 0)
+			rc = advanceLeft();
+		else if (cmp > 0)
+			rc = advanceRight();
+		else
+			rc = loadGroup();
+		if (rc)
+			return rc;
 	}
+}
+
+void SMJoin::getAttributes(vector<Attribute> &attrs) const
+{
+	attrs.clear();
+	attrs = leftAttrs;
+	attrs.insert(attrs.end(), rightAttrs.begin(), rightAttrs.end());
+}
+
+// The end of an input is not an error, anything else the input returns is
+RC SMJoin::advanceLeft()
+{
+	RC rc = leftIn->getNextTuple(leftData);
+	leftDone = rc != SUCCESS;
+	if (!leftDone)
+		getFieldOffsets(leftData, leftAttrs, leftOffsets.data());
+	return rc == QE_EOF ? SUCCESS : rc;
+}
+
+RC SMJoin::advanceRight()
+{
+	RC rc = rightIn->getNextTuple(rightData);
+	rightDone = rc != SUCCESS;
+	if (!rightDone)
+		getFieldOffsets(rightData, rightAttrs, rightOffsets.data());
+	return rc == QE_EOF ? SUCCESS : rc;
+}
+
+// Read every right tuple with the current right key into the rewind buffer
+RC SMJoin::loadGroup()
+{
+	RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+	memcpy(groupKey, rightKey(), getFieldLength((void *) rightKey(), rightAttrs[rightIndex]));
+
+	RID rid;
+	while (!rightDone && rightOffsets[rightIndex] != 0 && compareFields(rightKey(), groupKey, keyType) == 0) {
+		unsigned length = getActualTupleLength(rightData, rightAttrs);
+		if (!spilling && groupUsed + length <= groupCapacity) {
+			memcpy(group + groupUsed, rightData, length);
+			groupTuples.push_back(groupUsed);
+			groupUsed += length;
+		} else {
+			// The rest of an oversized group goes to disk
+			if (!spilling) {
+				rbfm->destroyFile(spillFileName);
+				if (rbfm->createFile(spillFileName))
+					return RBFM_CREATE_FAILED;
+				if (rbfm->openFile(spillFileName, spillHandle))
+					return RBFM_OPEN_FAILED;
+				spilling = true;
+			}
+			if (rbfm->appendRecord(spillHandle, rightAttrs, rightData, rid))
+				return RBFM_WRITE_FAILED;
+		}
+		groupCount++;
+		RC rc = advanceRight();
+		if (rc)
+			return rc;
+	}
+
+	inGroup = true;
+	return rewindGroup();
+}
+
+RC SMJoin::rewindGroup()
+{
+	groupPos = 0;
+	if (!spilling)
+		return SUCCESS;
 
-	unsigned leftTupleActualSize = getActualTupleLength(leftData, leftAttrs);
-	unsigned rightTupleActualSize = getActualTupleLength(rightData, rightAttrs);
+	RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+	if (spillScanOpen)
+		spillIter.close();
+	spillScanOpen = true;
+	return rbfm->scan(spillHandle, rightAttrs, "", NO_OP, NULL, rightAttrNames, spillIter);
+}
 
-	memcpy(data, leftData, leftTupleActualSize);
-	memcpy((char *) data + leftTupleActualSize, rightData, rightTupleActualSize);
+RC SMJoin::nextGroupTuple()
+{
+	if (groupPos < groupTuples.size()) {
+		groupTuple = group + groupTuples[groupPos++];
+		return SUCCESS;
+	}
 
-	// free(rightData);
+	RID rid;
+	RC rc = spillIter.getNextRecord(rid, spillData);
+	if (rc)
+		return rc;
+	groupTuple = spillData;
+	groupPos++;
 	return SUCCESS;
 }
 
+void SMJoin::clearGroup()
+{
+	groupTuples.clear();
+	groupUsed = 0;
+	groupCount = 0;
+	groupPos = 0;
+	inGroup = false;
 
-void CartProd::getAttributes(vector<Attribute> &attrs) const
+	if (spilling) {
+		RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+		if (spillScanOpen)
+			spillIter.close();
+		rbfm->closeFile(spillHandle);
+		rbfm->destroyFile(spillFileName);
+		spilling = false;
+		spillScanOpen = false;
+	}
+}
+
+// Output is one null indicator covering both sides, then the left fields, then the right fields
+void SMJoin::joinTuples(void *data)
+{
+	unsigned leftNullBytes = getNumNullBytes(leftAttrs.size());
+	unsigned rightNullBytes = getNumNullBytes(rightAttrs.size());
+	unsigned nullBytes = getNumNullBytes(leftAttrs.size() + rightAttrs.size());
+	memset(data, 0, nullBytes);
+	for (unsigned i = 0; i < leftAttrs.size(); i++) {
+		if (leftOffsets[i] == 0)
+			setFieldNull(data, i);
+	}
+	for (unsigned i = 0; i < rightAttrs.size(); i++) {
+		if (fieldIsNull(groupTuple, i))
+			setFieldNull(data, leftAttrs.size() + i);
+	}
+
+	unsigned leftLength = getActualTupleLength(leftData, leftAttrs) - leftNullBytes;
+	unsigned rightLength = getActualTupleLength(groupTuple, rightAttrs) - rightNullBytes;
+	memcpy((char *) data + nullBytes, leftData + leftNullBytes, leftLength);
+	memcpy((char *) data + nullBytes + leftLength, groupTuple + rightNullBytes, rightLength);
+}
+
+HashJoin::HashJoin(Iterator *leftIn, Iterator *rightIn, const Condition &condition)
+{
+	this->leftIn = leftIn;
+	this->rightIn = rightIn;
+	leftIn->getAttributes(leftAttrs);
+	rightIn->getAttributes(rightAttrs);
+
+	auto findAttr = [](const vector<Attribute> &attrs, const string &name) {
+		auto pred = [&](const Attribute &attr) { return attr.name == name; };
+		return (unsigned) distance(attrs.begin(), find_if(attrs.begin(), attrs.end(), pred));
+	};
+	leftIndex = findAttr(leftAttrs, condition.lhsAttr);
+	rightIndex = findAttr(rightAttrs, condition.rhsAttr);
+	valid = condition.bRhsIsAttr && condition.op == EQ_OP &&
+			leftIndex < leftAttrs.size() && rightIndex < rightAttrs.size() &&
+			leftAttrs[leftIndex].type == rightAttrs[rightIndex].type;
+	keyType = valid ? leftAttrs[leftIndex].type : TypeInt;
+
+	built = false;
+	leftData = (char *) allocateBuffer(getMaxTupleLength(leftAttrs));
+	leftOffsets.resize(leftAttrs.size());
+	match = table.end();
+	matchEnd = table.end();
+}
+
+HashJoin::~HashJoin()
+{
+	freeBuffer(leftData);
+}
+
+// Read the whole right input into memory, indexed by join key. Tuples with a null key never match
+RC HashJoin::build()
+{
+	unsigned maxLength = getMaxTupleLength(rightAttrs);
+	vector<unsigned> offsets(rightAttrs.size());
+	string key;
+	while (true) {
+		unsigned start = tuples.size();
+		tuples.resize(start + maxLength);
+		RC rc = rightIn->getNextTuple(tuples.data() + start);
+		if (rc) {
+			tuples.resize(start);
+			if (rc != QE_EOF)
+				return rc;
+			break;
+		}
+		unsigned length = getFieldOffsets(tuples.data() + start, rightAttrs, offsets.data());
+		tuples.resize(start + length);
+		if (getKey(tuples.data() + start, offsets.data(), rightIndex, key))
+			table.emplace(key, start);
+	}
+	built = true;
+	return SUCCESS;
+}
+
+// The key as bytes that are equal exactly when the values are. Returns false if it is null
+bool HashJoin::getKey(const char *tuple, const unsigned *offsets, unsigned index, string &key) const
+{
+	if (offsets[index] == 0)
+		return false;
+	const char *field = tuple + offsets[index];
+	if (keyType == TypeVarChar) {
+		uint32_t length;
+		memcpy(&length, field, VARCHAR_LENGTH_SIZE);
+		key.assign(field, VARCHAR_LENGTH_SIZE + length);
+	} else if (keyType == TypeReal) {
+		// 0.0 and -0.0 compare equal
+		float value;
+		memcpy(&value, field, REAL_SIZE);
+		if (value == 0)
+			value = 0;
+		key.assign((char *) &value, REAL_SIZE);
+	} else {
+		key.assign(field, INT_SIZE);
+	}
+	return true;
+}
+
+RC HashJoin::getNextTuple(void *data)
+{
+	if (!valid)
+		return QE_ATTR_NOT_FOUND;
+	RC rc;
+	if (!built && (rc = build()))
+		return rc;
+
+	string key;
+	while (match == matchEnd) {
+		if ((rc = leftIn->getNextTuple(leftData)))
+			return rc;
+		getFieldOffsets(leftData, leftAttrs, leftOffsets.data());
+		if (!getKey(leftData, leftOffsets.data(), leftIndex, key))
+			continue;
+		tie(match, matchEnd) = table.equal_range(key);
+	}
+
+	joinTuples(tuples.data() + match->second, data);
+	++match;
+	return SUCCESS;
+}
+
+void HashJoin::getAttributes(vector<Attribute> &attrs) const
 {
 	attrs.clear();
-	// copy(leftAttrs.begin(), leftAttrs.end(), attrs.begin());
 	attrs = leftAttrs;
 	attrs.insert(attrs.end(), rightAttrs.begin(), rightAttrs.end());
 }
+
+// Output is one null indicator covering both sides, then the left fields, then the right fields
+void HashJoin::joinTuples(const char *rightTuple, void *data)
+{
+	unsigned leftNullBytes = getNumNullBytes(leftAttrs.size());
+	unsigned rightNullBytes = getNumNullBytes(rightAttrs.size());
+	unsigned nullBytes = getNumNullBytes(leftAttrs.size() + rightAttrs.size());
+	memset(data, 0, nullBytes);
+	for (unsigned i = 0; i < leftAttrs.size(); i++) {
+		if (leftOffsets[i] == 0)
+			setFieldNull(data, i);
+	}
+	for (unsigned i = 0; i < rightAttrs.size(); i++) {
+		if (fieldIsNull((void *) rightTuple, i))
+			setFieldNull(data, leftAttrs.size() + i);
+	}
+
+	unsigned leftLength = getActualTupleLength(leftData, leftAttrs) - leftNullBytes;
+	unsigned rightLength = getActualTupleLength((void *) rightTuple, rightAttrs) - rightNullBytes;
+	memcpy((char *) data + nullBytes, leftData + leftNullBytes, leftLength);
+	memcpy((char *) data + nullBytes + leftLength, rightTuple + rightNullBytes, rightLength);
+}
+
+static inline uint64_t monotonicNanos()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// Reading the clock around every getNextTuple call has to be cheap. The time stamp counter costs
+// about a third of clock_gettime; it is converted to nanoseconds with the rate measured since the
+// first Instrument was created.
+static uint64_t calibrationTicks = 0;
+static uint64_t calibrationNanos = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+static inline uint64_t readClock()
+{
+	return __rdtsc();
+}
+
+static double ticksPerNano()
+{
+	uint64_t nanos = monotonicNanos() - calibrationNanos;
+	return nanos ? (double) (readClock() - calibrationTicks) / nanos : 1.0;
+}
+#else
+static inline uint64_t readClock()
+{
+	return monotonicNanos();
+}
+
+static double ticksPerNano()
+{
+	return 1.0;
+}
+#endif
+
+Instrument::Instrument(Iterator *input, const string &label, const vector<Instrument *> &children, bool timing)
+{
+	this->input = input;
+	this->label = label;
+	this->children = children;
+	calls = 0;
+	rows = 0;
+	pageReads = 0;
+	pageWrites = 0;
+	this->timing = timing;
+	ticks = 0;
+	if (timing && calibrationNanos == 0) {
+		calibrationTicks = readClock();
+		calibrationNanos = monotonicNanos();
+	}
+}
+
+// Two clock reads per call, if timing, and the page counters of all file handles before and after
+RC Instrument::getNextTuple(void *data)
+{
+	unsigned long reads = FileHandle::totalReadPageCounter;
+	unsigned long writes = FileHandle::totalWritePageCounter + FileHandle::totalAppendPageCounter;
+	uint64_t start = timing ? readClock() : 0;
+
+	RC rc = input->getNextTuple(data);
+
+	if (timing)
+		ticks += readClock() - start;
+	pageReads += FileHandle::totalReadPageCounter - reads;
+	pageWrites += FileHandle::totalWritePageCounter + FileHandle::totalAppendPageCounter - writes;
+	calls++;
+	if (rc == SUCCESS)
+		rows++;
+	return rc;
+}
+
+uint64_t Instrument::getNanos() const
+{
+	return ticks / ticksPerNano();
+}
+
+// Children can also run outside of this operator's calls (e.g. in a constructor), so don't go below 0
+uint64_t Instrument::getExclusiveNanos() const
+{
+	uint64_t nanos = getNanos();
+	uint64_t childNanos = 0;
+	for (const Instrument *child: children)
+		childNanos += child->getNanos();
+	return nanos > childNanos ? nanos - childNanos : 0;
+}
+
+unsigned long Instrument::getExclusivePageReads() const
+{
+	unsigned long childReads = 0;
+	for (const Instrument *child: children)
+		childReads += child->pageReads;
+	return pageReads > childReads ? pageReads - childReads : 0;
+}
+
+unsigned long Instrument::getExclusivePageWrites() const
+{
+	unsigned long childWrites = 0;
+	for (const Instrument *child: children)
+		childWrites += child->pageWrites;
+	return pageWrites > childWrites ? pageWrites - childWrites : 0;
+}
+
+void Instrument::print(ostream &out, unsigned depth) const
+{
+	ios::fmtflags flags = out.flags();
+	streamsize precision = out.precision();
+
+	out << string(2 * depth, ' ') << (depth ? "-> " : "") << label << fixed << setprecision(3)
+		<< "  (rows " << rows << ", calls " << calls;
+	if (timing)
+		out << ", time " << getNanos() / 1e6 << " ms, self " << getExclusiveNanos() / 1e6 << " ms";
+	out << ", pages read " << pageReads << " (self " << getExclusivePageReads() << ")"
+		<< ", written " << pageWrites << " (self " << getExclusivePageWrites() << "))" << endl;
+	out.flags(flags);
+	out.precision(precision);
+
+	for (const Instrument *child: children)
+		child->print(out, depth + 1);
+}
+
+Planner::Planner(RelationManager &rm) : rm(rm)
+{
+	outputRows = 0;
+}
+
+// Operators only point at their inputs, so delete from the top of each plan down
+Planner::~Planner()
+{
+	for (auto op = operators.rbegin(); op != operators.rend(); ++op)
+		delete *op;
+}
+
+Iterator *Planner::planScan(const string &tableName, const vector<Condition> &conditions, const vector<string> &attrNames)
+{
+	ArenaScope scope(&arena);
+	scans.assign(1, ScanEstimate());
+	steps.clear();
+	if (estimateScan(tableName, conditions, scans[0]) != SUCCESS)
+		return NULL;
+	outputRows = scans[0].outputRows;
+
+	Iterator *plan = buildScan(scans[0]);
+	if (!attrNames.empty()) {
+		plan = new Project(plan, attrNames);
+		operators.push_back(plan);
+	}
+	return plan;
+}
+
+Iterator *Planner::planJoin(const vector<string> &tableNames, const vector<Condition> &conditions, const vector<string> &attrNames)
+{
+	ArenaScope scope(&arena);
+	unsigned n = tableNames.size();
+	scans.assign(n, ScanEstimate());
+	steps.clear();
+	if (n == 0 || n > sizeof(unsigned) * CHAR_BIT - 1)
+		return NULL;
+	for (unsigned i = 0; i < n; i++)
+		scans[i].tableName = tableNames[i];
+
+	// Conditions on one table go to its scan, the others join two tables
+	vector<vector<Condition> > selections(n);
+	vector<Condition> joinConds;
+	vector<unsigned> joinTables;    // bitmask of the two tables of each join condition
+	for (const Condition &cond: conditions) {
+		int lhs = findScan(cond.lhsAttr);
+		int rhs = cond.bRhsIsAttr ? findScan(cond.rhsAttr) : lhs;
+		if (lhs < 0 || rhs < 0)
+			return NULL;
+		if (lhs == rhs) {
+			selections[lhs].push_back(cond);
+		} else {
+			joinConds.push_back(cond);
+			joinTables.push_back((1u << lhs) | (1u << rhs));
+		}
+	}
+	for (unsigned i = 0; i < n; i++) {
+		if (estimateScan(tableNames[i], selections[i], scans[i]) != SUCCESS)
+			return NULL;
+	}
+
+	// best[set] holds the steps of the cheapest left-deep plan joining the tables in set.
+	// Adding a table only makes the set bigger, so every set is complete before it is extended.
+	unsigned all = (1u << n) - 1;
+	vector<vector<JoinStep> > best(all + 1);
+	for (unsigned i = 0; i < n; i++) {
+		JoinStep first;
+		first.scan = i;
+		first.rows = scans[i].outputRows;
+		first.cost = scans[i].paths[scans[i].chosen].cost;
+		best[1u << i].push_back(first);
+	}
+
+	for (unsigned set = 1; set < all; set++) {
+		if (best[set].empty())
+			continue;
+		const JoinStep &last = best[set].back();
+		for (unsigned j = 0; j < n; j++) {
+			unsigned next = set | (1u << j);
+			if (next == set)
+				continue;
+
+			// The join conditions between the set and j, equalities as keys with lhs on the set's side
+			double selectivity = 1.0;
+			vector<Condition> keys;
+			for (unsigned c = 0; c < joinConds.size(); c++) {
+				if ((joinTables[c] & next) != joinTables[c] || !(joinTables[c] & (1u << j)))
+					continue;
+				selectivity *= getJoinSelectivity(joinConds[c]);
+				if (joinConds[c].op != EQ_OP)
+					continue;
+				keys.push_back(joinConds[c]);
+				if (findScan(keys.back().lhsAttr) == (int) j)
+					swap(keys.back().lhsAttr, keys.back().rhsAttr);
+			}
+			// No cross products
+			if (keys.empty())
+				continue;
+
+			const ScanEstimate &inner = scans[j];
+			const AccessPath &innerPath = inner.paths[inner.chosen];
+			JoinStep step;
+			step.scan = j;
+			step.rows = last.rows * inner.outputRows * selectivity;
+
+			// A hash join reads the inner table once and probes the hash table with every outer tuple
+			step.method = "HashJoin";
+			step.condition = keys[0];
+			step.cost = last.cost + innerPath.cost + (last.rows + innerPath.rows) * PLANNER_CPU_TUPLE_COST;
+
+			// An index nested-loop join descends the inner index once per outer tuple and fetches the matches
+			for (const Condition &key: keys) {
+				string attrName = key.rhsAttr.substr(inner.tableName.size() + 1);
+				const ColumnStatistics *column = getColumn(inner, key.rhsAttr);
+				if (column == NULL || column->indexHeight < 0 ||
+						find(inner.indexedAttrs.begin(), inner.indexedAttrs.end(), attrName) == inner.indexedAttrs.end())
+					continue;
+				double matches = inner.stats.rowCount / getDistinctCount(inner, key.rhsAttr);
+				double cost = last.cost + last.rows * ((column->indexHeight - 1) * PLANNER_RANDOM_PAGE_COST
+						+ PLANNER_SEQ_PAGE_COST + matches * (PLANNER_RANDOM_PAGE_COST + PLANNER_CPU_TUPLE_COST));
+				if (cost < step.cost) {
+					step.method = "INLJoin";
+					step.condition = key;
+					step.cost = cost;
+				}
+			}
+
+			if (best[next].empty() || step.cost < best[next].back().cost) {
+				best[next] = best[set];
+				best[next].push_back(step);
+			}
+		}
+	}
+	if (best[all].empty())
+		return NULL;
+	steps = best[all];
+	outputRows = steps.back().rows;
+
+	auto sameCondition = [](const Condition &a, const Condition &b) {
+		return a.op == b.op && ((a.lhsAttr == b.lhsAttr && a.rhsAttr == b.rhsAttr) ||
+				(a.lhsAttr == b.rhsAttr && a.rhsAttr == b.lhsAttr));
+	};
+
+	Iterator *plan = buildScan(scans[steps[0].scan]);
+	unsigned set = 1u << steps[0].scan;
+	for (unsigned k = 1; k < steps.size(); k++) {
+		const JoinStep &step = steps[k];
+		const ScanEstimate &inner = scans[step.scan];
+		set |= 1u << step.scan;
+
+		// The index scan of an INLJoin covers the whole inner table, so its selections come after the join
+		vector<Condition> filterConds;
+		if (step.method == "INLJoin") {
+			IndexScan *indexScan = new IndexScan(rm, inner.tableName, step.condition.rhsAttr.substr(inner.tableName.size() + 1));
+			operators.push_back(indexScan);
+			plan = new INLJoin(plan, indexScan, step.condition);
+			filterConds = inner.conditions;
+		} else {
+			plan = new HashJoin(plan, buildScan(inner), step.condition);
+		}
+		operators.push_back(plan);
+
+		// And so do the join conditions other than the key that this table completes
+		for (unsigned c = 0; c < joinConds.size(); c++) {
+			if ((joinTables[c] & set) == joinTables[c] && (joinTables[c] & (1u << step.scan)) &&
+					!sameCondition(joinConds[c], step.condition))
+				filterConds.push_back(joinConds[c]);
+		}
+		if (!filterConds.empty()) {
+			plan = new Filter(plan, filterConds);
+			operators.push_back(plan);
+		}
+	}
+
+	if (!attrNames.empty()) {
+		plan = new Project(plan, attrNames);
+		operators.push_back(plan);
+	}
+	return plan;
+}
+
+void Planner::explain(ostream &out) const
+{
+	ios::fmtflags flags = out.flags();
+	streamsize precision = out.precision();
+
+	for (const ScanEstimate &scan: scans) {
+		out << "Access paths for " << scan.tableName;
+		if (scan.haveStats)
+			out << " (" << scan.stats.rowCount << " rows, " << scan.stats.pageCount << " pages)" << endl;
+		else
+			out << " (no statistics)" << endl;
+		out << fixed << setprecision(2);
+		for (unsigned i = 0; i < scan.paths.size(); i++) {
+			out << (i == scan.chosen ? "  * " : "    ") << left << setw(40) << scan.paths[i].description << right
+				<< " cost " << setw(10) << scan.paths[i].cost << "  rows " << setw(10) << scan.paths[i].rows << endl;
+		}
+		out.flags(flags);
+	}
+
+	if (steps.size() > 1) {
+		out << "Join order" << endl << fixed << setprecision(2);
+		for (unsigned k = 0; k < steps.size(); k++) {
+			const JoinStep &step = steps[k];
+			string description = scans[step.scan].tableName;
+			if (k > 0)
+				description = step.method + " " + description + " on " + step.condition.lhsAttr + " = " + step.condition.rhsAttr;
+			out << "    " << left << setw(40) << description << right
+				<< " cost " << setw(10) << step.cost << "  rows " << setw(10) << step.rows << endl;
+		}
+	}
+	out << fixed << setprecision(2) << "Estimated result: " << outputRows << " rows" << endl;
+
+	out.flags(flags);
+	out.precision(precision);
+}
+
+RC Planner::estimateScan(const string &tableName, const vector<Condition> &conditions, ScanEstimate &scan)
+{
+	scan.tableName = tableName;
+	scan.conditions = conditions;
+	scan.paths.clear();
+	scan.chosen = 0;
+
+	vector<Attribute> attrs;
+	RC rc = rm.getAttributes(tableName, attrs);
+	if (rc)
+		return rc;
+	rm.getIndexedAttributes(tableName, scan.indexedAttrs);
+	scan.haveStats = loadStatistics(scan) == SUCCESS;
+
+	// Without statistics there is nothing to compare, so the table is scanned
+	AccessPath tableScan;
+	tableScan.description = "TableScan " + tableName;
+	tableScan.rows = scan.haveStats ? scan.stats.rowCount : 0;
+	tableScan.cost = scan.haveStats ? scan.stats.pageCount * PLANNER_SEQ_PAGE_COST + tableScan.rows * PLANNER_CPU_TUPLE_COST : 0;
+	scan.paths.push_back(tableScan);
+	scan.outputRows = tableScan.rows * getSelectivity(scan, conditions);
+
+	// An index range scan descends the tree once, reads the leaves in the range in order and then
+	// fetches every matching tuple from the heap with a random read
+	for (const string &attrName: scan.indexedAttrs) {
+		const ColumnStatistics *column = getColumn(scan, tableName + "." + attrName);
+		if (!scan.haveStats || column == NULL || column->indexHeight < 0)
+			continue;
+		const Condition *low, *high;
+		getRange(conditions, tableName + "." + attrName, low, high);
+		if (!low && !high)
+			continue;
+
+		double selectivity = getRangeSelectivity(scan, low, high);
+		AccessPath path;
+		path.indexAttr = attrName;
+		path.rows = selectivity * scan.stats.rowCount;
+		path.cost = (column->indexHeight - 1) * PLANNER_RANDOM_PAGE_COST
+				+ max(1.0, ceil(selectivity * column->indexLeaves)) * PLANNER_SEQ_PAGE_COST
+				+ path.rows * (PLANNER_RANDOM_PAGE_COST + PLANNER_CPU_TUPLE_COST);
+		path.description = "IndexScan " + tableName + "." + attrName + " "
+				+ (low ? (low->op == GT_OP ? "(" : "[") + formatValue(low->rhsValue) : "(-inf") + ", "
+				+ (high ? formatValue(high->rhsValue) + (high->op == LT_OP ? ")" : "]") : "+inf)");
+		scan.paths.push_back(path);
+		if (path.cost < scan.paths[scan.chosen].cost)
+			scan.chosen = scan.paths.size() - 1;
+	}
+	return SUCCESS;
+}
+
+// The chosen access path, then a Filter that hands the range (or one condition) to the scan and
+// evaluates the rest
+Iterator *Planner::buildScan(const ScanEstimate &scan)
+{
+	const AccessPath &path = scan.paths[scan.chosen];
+	Iterator *plan;
+	if (path.indexAttr.empty())
+		plan = new TableScan(rm, scan.tableName);
+	else
+		plan = new IndexScan(rm, scan.tableName, path.indexAttr);
+	operators.push_back(plan);
+	if (!scan.conditions.empty()) {
+		plan = new Filter(plan, scan.conditions);
+		operators.push_back(plan);
+	}
+	return plan;
+}
+
+// The statistics of the last RelationManager::analyze, which is left to the user: planning never
+// scans a whole table. Their row count follows the inserts and deletes since. A table never
+// analyzed is estimated from PLANNER_SAMPLE_PAGES of its pages. The height and leaves of each
+// index come from its tree, so an index created or dropped after the last analyze is costed right.
+RC Planner::loadStatistics(ScanEstimate &scan)
+{
+	RC rc = rm.getStatistics(scan.tableName, scan.stats);
+	if (rc == RM_NO_STATISTICS)
+		return rm.sampleStatistics(scan.tableName, PLANNER_SAMPLE_PAGES, scan.stats);
+	if (rc)
+		return rc;
+
+	for (ColumnStatistics &column: scan.stats.columns) {
+		column.indexHeight = -1;
+		if (find(scan.indexedAttrs.begin(), scan.indexedAttrs.end(), column.name) == scan.indexedAttrs.end())
+			continue;
+		unsigned height, leaves;
+		rc = rm.getIndexStatistics(scan.tableName, column.name, height, leaves);
+		if (rc == RM_NO_MATCHING_INDEX)
+			continue;
+		if (rc)
+			return rc;
+		column.indexHeight = height;
+		column.indexLeaves = leaves;
+	}
+	return SUCCESS;
+}
+
+// Index of the scan of the table attrName (rel.attr) belongs to, -1 if none
+int Planner::findScan(const string &attrName) const
+{
+	for (unsigned i = 0; i < scans.size(); i++) {
+		string prefix = scans[i].tableName + ".";
+		if (attrName.compare(0, prefix.size(), prefix) == 0)
+			return i;
+	}
+	return -1;
+}
+
+const ColumnStatistics *Planner::getColumn(const ScanEstimate &scan, const string &attrName)
+{
+	string prefix = scan.tableName + ".";
+	if (!scan.haveStats || attrName.compare(0, prefix.size(), prefix) != 0)
+		return NULL;
+	for (const ColumnStatistics &column: scan.stats.columns) {
+		if (column.name == attrName.substr(prefix.size()))
+			return &column;
+	}
+	return NULL;
+}
+
+double Planner::getNonNullFraction(const ScanEstimate &scan, const string &attrName)
+{
+	const ColumnStatistics *column = getColumn(scan, attrName);
+	if (column == NULL || scan.stats.rowCount <= 0)
+		return 1.0;
+	return max(0.0, 1.0 - (double) column->nullCount / scan.stats.rowCount);
+}
+
+// Without statistics, assume the default selectivity for an equality
+double Planner::getDistinctCount(const ScanEstimate &scan, const string &attrName)
+{
+	const ColumnStatistics *column = getColumn(scan, attrName);
+	if (column == NULL)
+		return 1.0 / PLANNER_DEFAULT_SELECTIVITY;
+	return max(1, column->distinctCount);
+}
+
+// Conditions are assumed independent, except the bounds of a range on one attribute
+double Planner::getSelectivity(const ScanEstimate &scan, const vector<Condition> &conditions)
+{
+	double selectivity = 1.0;
+	set<string> rangeAttrs;
+	for (const Condition &cond: conditions) {
+		const Condition *low, *high;
+		getRange(conditions, cond.lhsAttr, low, high);
+		if (&cond == low || &cond == high)
+			rangeAttrs.insert(cond.lhsAttr);
+		else
+			selectivity *= getSelectivity(scan, cond);
+	}
+	for (const string &attrName: rangeAttrs) {
+		const Condition *low, *high;
+		getRange(conditions, attrName, low, high);
+		selectivity *= getRangeSelectivity(scan, low, high);
+	}
+	return selectivity;
+}
+
+double Planner::getRangeSelectivity(const ScanEstimate &scan, const Condition *low, const Condition *high)
+{
+	if (low == NULL && high == NULL)
+		return 1.0;
+	if (low == NULL || low == high)
+		return getSelectivity(scan, *high);
+	if (high == NULL)
+		return getSelectivity(scan, *low);
+	// low < x < high is what's left of the non-null values after removing x <= low and x >= high
+	double selectivity = getSelectivity(scan, *low) + getSelectivity(scan, *high) - getNonNullFraction(scan, low->lhsAttr);
+	return max(0.0, selectivity);
+}
+
+double Planner::getSelectivity(const ScanEstimate &scan, const Condition &cond)
+{
+	if (cond.op == NO_OP)
+		return 1.0;
+	const ColumnStatistics *column = getColumn(scan, cond.lhsAttr);
+	if (cond.bRhsIsAttr || column == NULL || scan.stats.rowCount <= 0)
+		return PLANNER_DEFAULT_SELECTIVITY;
+	if (!column->hasRange)
+		return 0.0;
+
+	string value = getRawValue(cond.rhsValue);
+	double equal = 1.0 / max(column->distinctCount, 1);
+	double below = getFractionBelow(*column, value);
+	// Nothing equals a value outside the column's range
+	if ((below == 0.0 && value != column->minValue) || (below == 1.0 && value != column->maxValue))
+		equal = 0.0;
+
+	double selectivity;
+	switch (cond.op) {
+	case EQ_OP: selectivity = equal; break;
+	case NE_OP: selectivity = 1.0 - equal; break;
+	case LT_OP: selectivity = below; break;
+	case LE_OP: selectivity = below + equal; break;
+	case GT_OP: selectivity = 1.0 - below - equal; break;
+	case GE_OP: selectivity = 1.0 - below; break;
+	default: selectivity = 1.0; break;
+	}
+	return min(1.0, max(0.0, selectivity)) * getNonNullFraction(scan, cond.lhsAttr);
+}
+
+// Every value of the side with fewer distinct values is assumed to find its match on the other side
+double Planner::getJoinSelectivity(const Condition &cond) const
+{
+	if (cond.op != EQ_OP)
+		return PLANNER_DEFAULT_SELECTIVITY;
+	double lhsDistinct = getDistinctCount(scans[findScan(cond.lhsAttr)], cond.lhsAttr);
+	double rhsDistinct = getDistinctCount(scans[findScan(cond.rhsAttr)], cond.rhsAttr);
+	return 1.0 / max(lhsDistinct, rhsDistinct);
+}
+
+// Every bucket of an equi-depth histogram holds the same number of values. Numbers are assumed
+// to be spread evenly inside a bucket, a varchar is put in the middle of its bucket.
+double Planner::getFractionBelow(const ColumnStatistics &column, const string &value)
+{
+	const vector<string> &bounds = column.histogram;
+	if (bounds.size() < 2)
+		return 0.5;
+
+	auto toNumber = [&](const string &raw) {
+		if (column.type == TypeInt) {
+			int32_t x;
+			memcpy(&x, raw.data(), INT_SIZE);
+			return (double) x;
+		}
+		float x;
+		memcpy(&x, raw.data(), REAL_SIZE);
+		return (double) x;
+	};
+	auto less = [&](const string &a, const string &b) {
+		return column.type == TypeVarChar ? a < b : toNumber(a) < toNumber(b);
+	};
+
+	unsigned buckets = bounds.size() - 1;
+	if (!less(bounds[0], value))
+		return 0.0;
+	if (less(bounds[buckets], value))
+		return 1.0;
+
+	// bounds[b] < value <= bounds[b + 1]
+	unsigned b = 0;
+	while (b < buckets - 1 && less(bounds[b + 1], value))
+		b++;
+	double within = 0.5;
+	if (column.type != TypeVarChar) {
+		double lowBound = toNumber(bounds[b]);
+		double highBound = toNumber(bounds[b + 1]);
+		if (highBound > lowBound)
+			within = (toNumber(value) - lowBound) / (highBound - lowBound);
+	}
+	return (b + within) / buckets;
+}
+
+void Planner::getRange(const vector<Condition> &conditions, const string &attrName, const Condition *&low, const Condition *&high)
+{
+	low = NULL;
+	high = NULL;
+	for (const Condition &cond: conditions) {
+		if (cond.bRhsIsAttr || cond.lhsAttr != attrName)
+			continue;
+		bool isLow = cond.op == EQ_OP || cond.op == GT_OP || cond.op == GE_OP;
+		bool isHigh = cond.op == EQ_OP || cond.op == LT_OP || cond.op == LE_OP;
+		if ((!isLow && !isHigh) || (isLow && low) || (isHigh && high))
+			continue;
+		if (isLow)
+			low = &cond;
+		if (isHigh)
+			high = &cond;
+	}
+}
+
+string Planner::getRawValue(const Value &value)
+{
+	if (value.type != TypeVarChar)
+		return string((char *) value.data, INT_SIZE);
+	uint32_t length;
+	memcpy(&length, value.data, VARCHAR_LENGTH_SIZE);
+	return string((char *) value.data + VARCHAR_LENGTH_SIZE, length);
+}
+
+string Planner::formatValue(const Value &value)
+{
+	ostringstream out;
+	if (value.type == TypeInt)
+		out << *(int32_t *) value.data;
+	else if (value.type == TypeReal)
+		out << *(float *) value.data;
+	else
+		out << "\"" << getRawValue(value) << "\"";
+	return out.str();
+}
@@ -6,8 +6,11 @@
 #include <cmath>
 #include <cstring>
 #include <iostream>
+#include <unordered_map>
 
 #include "../rbf/rbfm.h"
+#include "../rbf/arena.h"
+#include "../rbf/predicate.h"
 #include "../rm/rm.h"
 #include "../ix/ix.h"
 
@@ -15,6 +18,18 @@
 
 #define QE_ATTR_NOT_FOUND 1
 
+// Number of input tuples Filter tests with one predicate kernel call
+#define FILTER_BATCH_SIZE 64
+
+// Planner costs, in units of one sequential page read
+#define PLANNER_SEQ_PAGE_COST       1.0
+#define PLANNER_RANDOM_PAGE_COST    4.0
+#define PLANNER_CPU_TUPLE_COST      0.01
+// Selectivity of a condition the statistics can't estimate
+#define PLANNER_DEFAULT_SELECTIVITY (1.0 / 3)
+// Pages read to estimate the statistics of a table that was never analyzed
+#define PLANNER_SAMPLE_PAGES        16
+
 using namespace std;
 
 typedef enum{ MIN=0, MAX, COUNT, SUM, AVG } AggregateOp;
@@ -41,17 +56,35 @@ struct Condition {
 
 class Iterator {
     // All the relational operators and access methods are iterators.
+    // Operators take their buffers from the arena current when they are constructed (see
+    // ArenaScope), or from the heap outside of any. The arena has to outlive them.
     public:
+        Iterator() : arena(Arena::getCurrent()) {};
         virtual RC getNextTuple(void *data) = 0;
         virtual void getAttributes(vector<Attribute> &attrs) const = 0;
+        // Narrow the output to (at least) the named attributes, given as rel.attr.
+        // Only valid before the first getNextTuple(). Iterators that can't narrow ignore it.
+        virtual void pushProjection(const vector<string> &attrNames) {};
+        // The iterator doing the work, looking through wrappers such as Instrument
+        virtual Iterator *getSource() { return this; };
         virtual ~Iterator() {};
     
     protected:
+        Arena *arena;
+        void *allocateBuffer(size_t size);
+        void freeBuffer(void *buffer);      // buffers of an arena stay until it is reset
+
         bool fieldIsNull(void *data, int i);
         void setFieldNull(void *data, int i);
         unsigned getNumNullBytes(unsigned numAttributes);
         unsigned getFieldLength(void *field, Attribute &attr);
         unsigned getActualTupleLength(void *tuple, vector<Attribute> &recordDescriptor);
+        // Largest tuple the descriptor allows: null bytes, every field present and varchars at full length
+        unsigned getMaxTupleLength(const vector<Attribute> &recordDescriptor);
+        // Fill offsets[i] with the offset of field i in tuple, or 0 if it is null. Returns the tuple length
+        unsigned getFieldOffsets(const void *tuple, const vector<Attribute> &recordDescriptor, unsigned *offsets);
+        // Three way comparison of two non-null fields of the same type (varchars include their length)
+        static int compareFields(const char *a, const char *b, AttrType type);
 };
 
 
@@ -62,14 +95,23 @@ class TableScan : public Iterator
         RelationManager &rm;
         RM_ScanIterator *iter;
         string tableName;
+        string relName;
         vector<Attribute> attrs;
         vector<string> attrNames;
         RID rid;
 
+        // Selection evaluated by the RBFM scan itself (see pushCondition)
+        string condAttrName;
+        CompOp compOp;
+        const void *value;
+
         TableScan(RelationManager &rm, const string &tableName, const char *alias = NULL):rm(rm)
         {
         	//Set members
         	this->tableName = tableName;
+        	this->relName = tableName;
+        	compOp = NO_OP;
+        	value = NULL;
 
             // Get Attributes from RM
             rm.getAttributes(tableName, attrs);
@@ -84,7 +126,7 @@ class TableScan : public Iterator
 
             // Call RM scan to get an iterator
             iter = new RM_ScanIterator();
-            rm.scan(tableName, "", NO_OP, NULL, attrNames, *iter);
+            rm.scan(relName, condAttrName, compOp, value, attrNames, *iter);
 
             // Set alias
             if(alias) this->tableName = alias;
@@ -96,7 +138,42 @@ class TableScan : public Iterator
             iter->close();
             delete iter;
             iter = new RM_ScanIterator();
-            rm.scan(tableName, "", NO_OP, NULL, attrNames, *iter);
+            rm.scan(relName, condAttrName, compOp, value, attrNames, *iter);
+        };
+
+        // Let the RBFM scan evaluate cond (attribute op value on this relation) instead of
+        // returning every tuple. Only one condition can be pushed. Returns false if cond was not taken.
+        bool pushCondition(const Condition &cond)
+        {
+            string prefix = tableName + ".";
+            if(compOp != NO_OP || cond.op == NO_OP || cond.bRhsIsAttr || cond.lhsAttr.compare(0, prefix.size(), prefix) != 0)
+                return false;
+            string name = cond.lhsAttr.substr(prefix.size());
+            auto pred = [&](const Attribute &attr) {return attr.name == name;};
+            if(find_if(attrs.begin(), attrs.end(), pred) == attrs.end())
+                return false;
+
+            compOp = cond.op;
+            value = cond.rhsValue.data;
+            condAttrName = name;
+            setIterator();
+            return true;
+        };
+
+        // Only read the named attributes out of each record
+        void pushProjection(const vector<string> &names)
+        {
+            vector<Attribute> projected;
+            attrNames.clear();
+            for(Attribute &attr : attrs)
+            {
+                if(find(names.begin(), names.end(), tableName + "." + attr.name) == names.end())
+                    continue;
+                projected.push_back(attr);
+                attrNames.push_back(attr.name);
+            }
+            attrs = projected;
+            setIterator();
         };
 
         RC getNextTuple(void *data)
@@ -134,16 +211,28 @@ class IndexScan : public Iterator
         RelationManager &rm;
         RM_IndexScanIterator *iter;
         string tableName;
+        string relName;
         string attrName;
         vector<Attribute> attrs;
         char key[PAGE_SIZE];
         RID rid;
 
+        // Key range pushed down from a Filter (see pushCondition)
+        void *lowKey;
+        void *highKey;
+        bool lowKeyInclusive;
+        bool highKeyInclusive;
+
         IndexScan(RelationManager &rm, const string &tableName, const string &attrName, const char *alias = NULL):rm(rm)
         {
         	// Set members
         	this->tableName = tableName;
+        	this->relName = tableName;
         	this->attrName = attrName;
+        	lowKey = NULL;
+        	highKey = NULL;
+        	lowKeyInclusive = true;
+        	highKeyInclusive = true;
 
 
             // Get Attributes from RM
@@ -166,16 +255,42 @@ class IndexScan : public Iterator
             iter->close();
             delete iter;
             iter = new RM_IndexScanIterator();
-            rm.indexScan(tableName, attrName, lowKey, highKey, lowKeyInclusive,
+            rm.indexScan(relName, attrName, lowKey, highKey, lowKeyInclusive,
                            highKeyInclusive, *iter);
         };
 
+        // Turn a range condition on the indexed attribute into scan bounds. At most one
+        // lower and one upper bound are taken. Returns false if cond was not taken.
+        bool pushCondition(const Condition &cond)
+        {
+            if(cond.bRhsIsAttr || cond.lhsAttr != tableName + "." + attrName)
+                return false;
+
+            bool low = cond.op == EQ_OP || cond.op == GT_OP || cond.op == GE_OP;
+            bool high = cond.op == EQ_OP || cond.op == LT_OP || cond.op == LE_OP;
+            if((!low && !high) || (low && lowKey) || (high && highKey))
+                return false;
+
+            if(low)
+            {
+                lowKey = cond.rhsValue.data;
+                lowKeyInclusive = cond.op != GT_OP;
+            }
+            if(high)
+            {
+                highKey = cond.rhsValue.data;
+                highKeyInclusive = cond.op != LT_OP;
+            }
+            setIterator(lowKey, highKey, lowKeyInclusive, highKeyInclusive);
+            return true;
+        };
+
         RC getNextTuple(void *data)
         {
             int rc = iter->getNextEntry(rid, key);
             if(rc == 0)
             {
-                rc = rm.readTuple(tableName.c_str(), rid, data);
+                rc = rm.readTuple(relName, rid, data);
             }
             return rc;
         };
@@ -209,24 +324,49 @@ class Filter : public Iterator {
         Filter(Iterator *input,               // Iterator of input R
                const Condition &condition     // Selection condition
         );
+        Filter(Iterator *input,                       // Iterator of input R
+               const vector<Condition> &conditions    // Conjunction of selection conditions
+        );
         ~Filter();
 
         RC getNextTuple(void *data);
         // For attribute in vector<Attribute>, name it as rel.attr
         void getAttributes(vector<Attribute> &attrs) const;
+        // Passes the narrowed list plus the attributes its own conditions need on to the input
+        void pushProjection(const vector<string> &attrNames);
 
     private:
         Iterator *input;
-        vector<string> attrNames;
         vector<Attribute> inputAttrs;
-        Condition cond;
+        // Conditions left to evaluate here, after pushing what the input can take
+        vector<Condition> conds;
+
+        // Compiled conditions: input attribute index of each lhs and (if any) rhs attribute
+        vector<unsigned> lhsIndexes;
+        vector<unsigned> rhsIndexes;
+        bool valid;
 
-        unsigned index;
         unsigned inputTupleSize;
 
-        bool filterData(uint32_t recordInt, CompOp compOp, const uint32_t value);
-        bool filterData(float recordReal, CompOp compOp, const float value);
-        bool filterData(void *recordString, CompOp compOp, const void *value);
+        // Input tuples are buffered FILTER_BATCH_SIZE at a time and tested together
+        char *batch;
+        unsigned batchCount;
+        unsigned batchPos;
+        bool inputDone;
+        vector<unsigned> fieldOffsets;  // inputAttrs.size() offsets per buffered tuple
+        unsigned tupleLengths[FILTER_BATCH_SIZE];
+        uint8_t batchMatches[FILTER_BATCH_SIZE / CHAR_BIT];
+        uint8_t condMatches[FILTER_BATCH_SIZE / CHAR_BIT];
+        int32_t intValues[FILTER_BATCH_SIZE];
+        float realValues[FILTER_BATCH_SIZE];
+        const char *varcharValues[FILTER_BATCH_SIZE];
+        uint32_t varcharLengths[FILTER_BATCH_SIZE];
+
+        void init(const vector<Condition> &conditions);
+        void compile();
+        RC fillBatch();
+        void evaluateCondition(unsigned c);
+        bool getField(unsigned tuple, unsigned index, const char *&field, uint32_t &length);
 };
 
 
@@ -245,18 +385,25 @@ class Project : public Iterator {
         Iterator *input;
         vector<string> attrNames;
         vector<Attribute> inputAttrs;
-        unsigned inputTupleSize;
+        vector<Attribute> attrs;
 
-        RC projectAttributes(void *origData, void *newData);
+        // Input attribute index of each projected attribute
+        vector<unsigned> projection;
+        bool valid;
 
+        // Scratch space reused for every tuple
+        char *inputData;
+        vector<unsigned> fieldOffsets;
 
+        void projectAttributes(void *newData);
 };
 
 class CartProd : public Iterator {
     
     public:
         CartProd(Iterator *leftIn,           // Iterator of input R
-                IndexScan *rightIn           // IndexScan Iterator of input S
+                IndexScan *rightIn,          // IndexScan Iterator of input S
+                int probeIndex = -1          // Left attribute whose value each right scan is restricted to
         );
         ~CartProd();
 
@@ -269,11 +416,20 @@ class CartProd : public Iterator {
         IndexScan *rightIn;
         vector<Attribute> leftAttrs;
         vector<Attribute> rightAttrs;
-        unsigned leftInputTupleSize;
-        unsigned rightInputTupleSize;
 
-        void* leftData;
+        // Both inputs are read into buffers allocated once
+        char *leftData;
+        char *rightData;
+        unsigned leftFieldsLength;
         bool leftIterEmpty;
+
+        // With a probe index the right input is rescanned for [key, key] of every left tuple
+        int probeIndex;
+        vector<unsigned> leftOffsets;
+        bool leftMatchable;     // false if the left key is null
+        bool rightMatched;      // the right input returned something for this left tuple
+
+        void setLeftTuple(bool restart);
 };
 
 class INLJoin : public Iterator {
@@ -295,4 +451,319 @@ class INLJoin : public Iterator {
         vector<Attribute> attrs;
 };
 
+class HashJoin : public Iterator {
+    // In-memory hash join operator: the right input is loaded into a hash table on the
+    // join key, then probed with every left tuple
+    public:
+        HashJoin(Iterator *leftIn,          // Iterator of input R
+                 Iterator *rightIn,         // Iterator of input S, held in memory
+                 const Condition &condition // Equi-join condition
+        );
+        ~HashJoin();
+
+        RC getNextTuple(void *data);
+        // For attribute in vector<Attribute>, name it as rel.attr
+        void getAttributes(vector<Attribute> &attrs) const;
+
+    private:
+        Iterator *leftIn;
+        Iterator *rightIn;
+        vector<Attribute> leftAttrs;
+        vector<Attribute> rightAttrs;
+        unsigned leftIndex;
+        unsigned rightIndex;
+        AttrType keyType;
+        bool valid;
+        bool built;
+
+        // Right tuples back to back, and the start of each one by join key
+        vector<char> tuples;
+        unordered_multimap<string, unsigned> table;
+        unordered_multimap<string, unsigned>::const_iterator match;
+        unordered_multimap<string, unsigned>::const_iterator matchEnd;
+
+        char *leftData;
+        vector<unsigned> leftOffsets;
+
+        RC build();
+        bool getKey(const char *tuple, const unsigned *offsets, unsigned index, string &key) const;
+        void joinTuples(const char *rightTuple, void *data);
+};
+
+// A sorted run of tuples spilled to a temporary RBFM file
+struct SortRun {
+    string fileName;
+    FileHandle fileHandle;
+    RBFM_ScanIterator iter;
+    char *tuple;                // current tuple while the run is being merged
+    vector<unsigned> offsets;   // field offsets of tuple
+    bool done;
+};
+
+class Sort : public Iterator {
+    // External merge sort operator
+    public:
+        Sort(Iterator *input,                   // Iterator of input R
+             const vector<string> &keys,        // Sort attributes, most significant first
+             const vector<bool> &asc,           // Ascending (true) or descending order of each key
+             unsigned memPages                  // Memory budget in pages
+        );
+        ~Sort();
+
+        RC getNextTuple(void *data);
+        // For attribute in vector<Attribute>, name it as rel.attr
+        void getAttributes(vector<Attribute> &attrs) const;
+        // True if the output comes out in ascending order of attrName
+        bool sortedOn(const string &attrName) const;
+
+    private:
+        static unsigned nextSortId;
+
+        Iterator *input;
+        vector<Attribute> attrs;
+        vector<string> attrNames;
+        vector<unsigned> keyIndexes;
+        vector<bool> asc;
+        bool valid;
+
+        unsigned sortId;
+        unsigned nextRunId;
+        unsigned tupleSize;
+        unsigned capacity;      // tuples held in memory by replacement selection
+        unsigned fanIn;         // runs merged at once
+        bool sorted;
+
+        // Replacement selection workspace: capacity + 1 tuple slots, each tagged with its run.
+        // heap orders the slots by (run, key)
+        char *workspace;
+        vector<unsigned> workspaceOffsets;
+        vector<unsigned> slotRuns;
+        vector<unsigned> heap;
+        bool inMemory;          // the whole input fit in the workspace, nothing was spilled
+
+        // Loser tree over the runs being merged: tree[0] is the winner, the other nodes hold losers
+        vector<SortRun *> runs;
+        vector<int> tree;
+
+        RC sortInput();
+        RC createRuns();
+        RC mergeRuns(unsigned count);
+        RC createRun(SortRun *&run);
+        RC openRun(SortRun *run);
+        RC advanceRun(SortRun *run);
+        void destroyRun(SortRun *run);
+        void startMerge(unsigned count);
+        void adjust(int s);
+        bool beats(int a, int b);
+        bool slotBefore(unsigned a, unsigned b);
+
+        char *slot(unsigned i) { return workspace + i * tupleSize; };
+        unsigned *slotOffsets(unsigned i) { return &workspaceOffsets[i * attrs.size()]; };
+        int compareTuples(const char *a, const unsigned *aOffsets, const char *b, const unsigned *bOffsets) const;
+};
+
+class SMJoin : public Iterator {
+    // Sort-merge join operator
+    public:
+        SMJoin(Iterator *leftIn,            // Iterator of input R
+               Iterator *rightIn,           // Iterator of input S
+               const Condition &condition,  // Equi-join condition
+               unsigned memPages            // Memory budget in pages, for sorting and the rewind buffer
+        );
+        ~SMJoin();
+
+        RC getNextTuple(void *data);
+        // For attribute in vector<Attribute>, name it as rel.attr
+        void getAttributes(vector<Attribute> &attrs) const;
+
+    private:
+        static unsigned nextJoinId;
+
+        // Inputs in join key order. Inputs that aren't known to be sorted are wrapped in a Sort we own
+        Iterator *leftIn;
+        Iterator *rightIn;
+        Sort *leftSort;
+        Sort *rightSort;
+        vector<Attribute> leftAttrs;
+        vector<Attribute> rightAttrs;
+        vector<string> rightAttrNames;
+        unsigned leftIndex;
+        unsigned rightIndex;
+        AttrType keyType;
+        bool valid;
+
+        // Current tuple of each input, read ahead on the first getNextTuple()
+        bool started;
+        char *leftData;
+        char *rightData;
+        vector<unsigned> leftOffsets;
+        vector<unsigned> rightOffsets;
+        bool leftDone;
+        bool rightDone;
+
+        // Rewind buffer: the right tuples sharing the current key, replayed for every left tuple
+        // with that key. Tuples that don't fit in memory go to a temporary RBFM file
+        char *group;
+        unsigned groupCapacity;
+        unsigned groupUsed;
+        vector<unsigned> groupTuples;   // start of each buffered tuple
+        unsigned groupCount;            // tuples in the group, in memory and spilled
+        unsigned groupPos;
+        bool inGroup;
+        char *groupKey;
+        string spillFileName;
+        FileHandle spillHandle;
+        RBFM_ScanIterator spillIter;
+        bool spilling;
+        bool spillScanOpen;
+        char *spillData;
+        char *groupTuple;               // right tuple being joined
+
+        static bool sortedOn(Iterator *input, const string &attrName);
+        RC advanceLeft();
+        RC advanceRight();
+        RC loadGroup();
+        RC rewindGroup();
+        RC nextGroupTuple();
+        void clearGroup();
+        void joinTuples(void *data);
+        const char *leftKey() { return leftData + leftOffsets[leftIndex]; };
+        const char *rightKey() { return rightData + rightOffsets[rightIndex]; };
+};
+
+class Instrument : public Iterator {
+    // EXPLAIN ANALYZE: wraps an iterator and measures its getNextTuple calls.
+    // Build the plan bottom up, wrapping each operator and passing the wrapped inputs as its children.
+    // Counting rows and page I/O costs 1-3% on a Filter/Project pipeline. Timing reads the clock
+    // around every call, which costs about 10% more there, so it is only done when asked for.
+    public:
+        Instrument(Iterator *input,                                 // Iterator to measure
+                   const string &label,                             // e.g. "Filter emp.age > 30"
+                   const vector<Instrument *> &children = vector<Instrument *>(),
+                   bool timing = false);
+        ~Instrument() {};
+
+        RC getNextTuple(void *data);
+        void getAttributes(vector<Attribute> &attrs) const { input->getAttributes(attrs); };
+        void pushProjection(const vector<string> &attrNames) { input->pushProjection(attrNames); };
+        Iterator *getSource() { return input->getSource(); };
+
+        // Time spent in the calls, inclusive of the children
+        uint64_t getNanos() const;
+        // Time and page I/O spent in this operator, without its children
+        uint64_t getExclusiveNanos() const;
+        unsigned long getExclusivePageReads() const;
+        unsigned long getExclusivePageWrites() const;
+
+        // One line per operator, each child indented under its parent
+        void print(ostream &out, unsigned depth = 0) const;
+
+        string label;
+        vector<Instrument *> children;
+        unsigned long calls;
+        unsigned long rows;
+        // Inclusive of the children
+        unsigned long pageReads;
+        unsigned long pageWrites;       // appended pages included
+
+    private:
+        Iterator *input;
+        bool timing;
+        uint64_t ticks;                 // of the clock read around every call, see readClock()
+};
+
+// One way of reading a table, with the planner's estimates
+struct AccessPath {
+    string description;     // e.g. "IndexScan emp.age [20, 30)"
+    string indexAttr;       // indexed attribute, empty for a TableScan
+    double rows;            // tuples read from the table
+    double cost;
+};
+
+// What the planner knows about one table of a query
+struct ScanEstimate {
+    string tableName;
+    TableStatistics stats;
+    bool haveStats;
+    vector<string> indexedAttrs;
+    vector<Condition> conditions;   // conditions on this table alone
+    vector<AccessPath> paths;
+    unsigned chosen;
+    double outputRows;              // tuples left after all of conditions
+};
+
+// One step of a left-deep join plan: a table joined to the result of the previous steps
+struct JoinStep {
+    unsigned scan;                  // index of the table's ScanEstimate
+    string method;                  // "INLJoin" or "HashJoin", empty for the first table
+    Condition condition;            // equi-join condition used as the key, lhs on the left side
+    double rows;
+    double cost;                    // of the plan up to and including this step
+};
+
+class Planner {
+    // Cost-based access path selection and join ordering, from the statistics of the last
+    // RelationManager::analyze of every table, or a sample of a few pages of a table never
+    // analyzed, and the tree of every index in Indexes. Planning never runs analyze.
+    public:
+        Planner(RelationManager &rm);
+        ~Planner();     // deletes every operator it built
+
+        // Cheapest way to evaluate SELECT attrNames FROM tableName WHERE conditions:
+        // a TableScan or an IndexScan on one of the table's indexes, then a Filter with the
+        // conditions the scan can't take and a Project. Empty attrNames keeps every attribute.
+        // Attribute names are rel.attr. Returns NULL if the table doesn't exist.
+        Iterator *planScan(const string &tableName, const vector<Condition> &conditions, const vector<string> &attrNames);
+
+        // Cheapest left-deep plan for SELECT attrNames FROM tableNames WHERE conditions, found by
+        // dynamic programming over the subsets of tables. Each join probes the inner table's index
+        // on the join key (INLJoin) or builds a HashJoin. Every table has to be connected to the
+        // others by equi-join conditions; returns NULL if they aren't or a table doesn't exist.
+        Iterator *planJoin(const vector<string> &tableNames, const vector<Condition> &conditions, const vector<string> &attrNames);
+
+        // Print the access paths considered for every table, the chosen ones marked with *,
+        // and the join order of the last plan
+        void explain(ostream &out) const;
+
+        const AccessPath &getChosenPath(unsigned scan = 0) const { return scans[scan].paths[scans[scan].chosen]; };
+        const vector<JoinStep> &getJoinSteps() const { return steps; };
+        // Where the operators of every plan so far keep their buffers
+        const Arena &getArena() const { return arena; };
+
+    private:
+        RelationManager &rm;
+        vector<Iterator *> operators;
+        Arena arena;
+
+        // Estimates of the last plan
+        vector<ScanEstimate> scans;
+        vector<JoinStep> steps;
+        double outputRows;
+
+        RC estimateScan(const string &tableName, const vector<Condition> &conditions, ScanEstimate &scan);
+        Iterator *buildScan(const ScanEstimate &scan);
+        RC loadStatistics(ScanEstimate &scan);
+        int findScan(const string &attrName) const;
+        static const ColumnStatistics *getColumn(const ScanEstimate &scan, const string &attrName);
+        static double getNonNullFraction(const ScanEstimate &scan, const string &attrName);
+        static double getDistinctCount(const ScanEstimate &scan, const string &attrName);
+
+        // Fraction of the table's rows satisfying the whole conjunction, a key range or one condition
+        static double getSelectivity(const ScanEstimate &scan, const vector<Condition> &conditions);
+        static double getRangeSelectivity(const ScanEstimate &scan, const Condition *low, const Condition *high);
+        static double getSelectivity(const ScanEstimate &scan, const Condition &cond);
+        // Fraction of the column's non-null values below value, from its histogram
+        static double getFractionBelow(const ColumnStatistics &column, const string &value);
+        // Fraction of the cross product of two sides satisfying a join condition between them
+        double getJoinSelectivity(const Condition &cond) const;
+
+        // The first lower and upper bound on attrName, the ones IndexScan::pushCondition takes.
+        // An equality condition is both.
+        static void getRange(const vector<Condition> &conditions, const string &attrName,
+                             const Condition *&low, const Condition *&high);
+        // Value in the raw format of the Statistics entries, and as text
+        static string getRawValue(const Value &value);
+        static string formatValue(const Value &value);
+};
+
 #endif
@@ -673,6 +673,19 @@ int createIndexforRightC() {
 	return rm->createIndex("right", "C");
 }
 
+// Passes on the first tuples of its input, then fails with RBFM_READ_FAILED instead of reaching the end
+class FailingInput : public Iterator {
+	public:
+		FailingInput(Iterator *input, int tuples): input(input), tuples(tuples) {};
+		RC getNextTuple(void *data) { return tuples-- > 0 ? input->getNextTuple(data) : RBFM_READ_FAILED; };
+		void getAttributes(vector<Attribute> &attrs) const { input->getAttributes(attrs); };
+		Iterator *getSource() { return input->getSource(); };
+
+	private:
+		Iterator *input;
+		int tuples;
+};
+
 int deleteAndCreateCatalog() {
   // Try to delete the System Catalog.
   // If this is the first time, it will generate an error. It's OK and we will ignore that.
@@ -0,0 +1,176 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "qe_test_util.h"
+
+// Count every heap allocation made by the process. operator new goes through malloc as well.
+static unsigned long allocations = 0;
+
+extern "C" void *__libc_malloc(size_t size);
+
+extern "C" void *malloc(size_t size) {
+	allocations++;
+	return __libc_malloc(size);
+}
+
+const int allocTupleCount = 1000;
+
+int createAllocTable() {
+	vector<Attribute> attrs;
+
+	Attribute attr;
+	attr.name = "A";
+	attr.type = TypeInt;
+	attr.length = 4;
+	attrs.push_back(attr);
+
+	attr.name = "B";
+	attr.type = TypeInt;
+	attr.length = 4;
+	attrs.push_back(attr);
+
+	attr.name = "C";
+	attr.type = TypeReal;
+	attr.length = 4;
+	attrs.push_back(attr);
+
+	attr.name = "D";
+	attr.type = TypeVarChar;
+	attr.length = 30;
+	attrs.push_back(attr);
+
+	rm->deleteTable("allocleft");
+	return rm->createTable("allocleft", attrs);
+}
+
+int populateAllocTable() {
+	RC rc = success;
+	RID rid;
+	char buf[bufSize];
+
+	// a, b in [0, 999], c in [0.0, 999.0], d is (i % 10 + 1) copies of a letter
+	for (int i = 0; i < allocTupleCount; ++i) {
+		int offset = 0;
+		memset(buf, 0, 1);
+		offset += 1;
+		memcpy(buf + offset, &i, sizeof(int));
+		offset += sizeof(int);
+		memcpy(buf + offset, &i, sizeof(int));
+		offset += sizeof(int);
+		float c = (float) i;
+		memcpy(buf + offset, &c, sizeof(float));
+		offset += sizeof(float);
+		int length = i % 10 + 1;
+		memcpy(buf + offset, &length, sizeof(int));
+		offset += sizeof(int);
+		memset(buf + offset, 'a' + i % 26, length);
+
+		rc = rm->insertTuple("allocleft", buf, rid);
+		if (rc != success)
+			return rc;
+	}
+	return rc;
+}
+
+RC testCase_11() {
+	// Filter with a conjunction of conditions, then Project
+	// SELECT A, D FROM allocleft WHERE B >= 100 AND C < 800.0 AND D <> "a"
+	// Once the first tuple is out, no operator may allocate.
+	cerr << endl << "***** In QE Test Case 11 *****" << endl;
+
+	RC rc = success;
+	TableScan *ts = new TableScan(*rm, "allocleft");
+
+	int compB = 100;
+	float compC = 800.0;
+	char compD[5];
+	int lengthD = 1;
+	memcpy(compD, &lengthD, sizeof(int));
+	compD[4] = 'a';
+
+	vector<Condition> conds(3);
+	conds[0].lhsAttr = "allocleft.B";
+	conds[0].op = GE_OP;
+	conds[0].bRhsIsAttr = false;
+	conds[0].rhsValue.type = TypeInt;
+	conds[0].rhsValue.data = &compB;
+	conds[1].lhsAttr = "allocleft.C";
+	conds[1].op = LT_OP;
+	conds[1].bRhsIsAttr = false;
+	conds[1].rhsValue.type = TypeReal;
+	conds[1].rhsValue.data = &compC;
+	conds[2].lhsAttr = "allocleft.D";
+	conds[2].op = NE_OP;
+	conds[2].bRhsIsAttr = false;
+	conds[2].rhsValue.type = TypeVarChar;
+	conds[2].rhsValue.data = compD;
+
+	Filter *filter = new Filter(ts, conds);
+
+	vector<string> attrNames;
+	attrNames.push_back("allocleft.A");
+	attrNames.push_back("allocleft.D");
+	Project *project = new Project(filter, attrNames);
+
+	// 100..799, minus the rows whose D is "a" (multiples of 130)
+	int expectedResultCnt = 694;
+	int actualResultCnt = 0;
+	unsigned long steadyAllocations = 0;
+
+	char data[bufSize];
+	while (project->getNextTuple(data) != QE_EOF) {
+		// Don't count the first tuple: it fills the scan and filter buffers
+		if (actualResultCnt == 0)
+			steadyAllocations = allocations;
+
+		int a;
+		memcpy(&a, data + 1, sizeof(int));
+		int length;
+		memcpy(&length, data + 1 + sizeof(int), sizeof(int));
+		if (data[0] != 0 || a < 100 || a >= 800 || length != a % 10 + 1 || data[1 + 2 * sizeof(int)] != 'a' + a % 26) {
+			cerr << "***** A returned value is not correct. *****" << endl;
+			rc = fail;
+			break;
+		}
+		actualResultCnt++;
+	}
+	steadyAllocations = allocations - steadyAllocations;
+
+	cerr << "Tuples: " << actualResultCnt << ", allocations after the first tuple: " << steadyAllocations << endl;
+	if (expectedResultCnt != actualResultCnt) {
+		cerr << "***** The number of returned tuple is not correct. *****" << endl;
+		rc = fail;
+	}
+	if (steadyAllocations != 0) {
+		cerr << "***** Operators allocated memory per tuple. *****" << endl;
+		rc = fail;
+	}
+
+	delete project;
+	delete filter;
+	delete ts;
+	return rc;
+}
+
+int main() {
+	// Tables created: allocleft
+	// Indexes created: none
+
+	if (createAllocTable() != success || populateAllocTable() != success) {
+		cerr << "***** Creating the allocleft table failed. *****" << endl;
+		cerr << "***** [FAIL] QE Test Case 11 failed. *****" << endl;
+		return fail;
+	}
+
+	if (testCase_11() != success) {
+		cerr << "***** [FAIL] QE Test Case 11 failed. *****" << endl;
+		return fail;
+	} else {
+		cerr << "***** QE Test Case 11 finished. The result will be examined. *****" << endl;
+		return success;
+	}
+}
@@ -0,0 +1,138 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "qe_test_util.h"
+
+RC testAliasedIndexScan() {
+	// Pushdown into an index scan under an alias
+	// SELECT * FROM left L WHERE L.B <= 30
+	RC rc = success;
+	IndexScan *is = new IndexScan(*rm, "left", "B", "L");
+
+	int compVal = 30;
+	Condition cond;
+	cond.lhsAttr = "L.B";
+	cond.op = LE_OP;
+	cond.bRhsIsAttr = false;
+	cond.rhsValue.type = TypeInt;
+	cond.rhsValue.data = &compVal;
+
+	Filter *filter = new Filter(is, cond);
+
+	// The bound is taken by the index scan, which still reads the table by its own name
+	if (is->highKey == NULL) {
+		cerr << "***** The condition was not pushed into the index scan. *****" << endl;
+		rc = fail;
+	}
+
+	int expectedResultCnt = 21;  // 10~30
+	int actualResultCnt = 0;
+	char data[bufSize];
+	RC scanRC;
+	while ((scanRC = filter->getNextTuple(data)) == success) {
+		int valueB;
+		memcpy(&valueB, data + 1 + sizeof(int), sizeof(int));
+		if (valueB < 10 || valueB > compVal) {
+			cerr << "***** A returned value is not correct. *****" << endl;
+			rc = fail;
+			break;
+		}
+		actualResultCnt++;
+	}
+
+	if (scanRC != QE_EOF && rc == success) {
+		cerr << "***** The aliased index scan failed to read a tuple. *****" << endl;
+		rc = fail;
+	}
+	if (expectedResultCnt != actualResultCnt) {
+		cerr << "***** The number of returned tuple is not correct. *****" << endl;
+		rc = fail;
+	}
+
+	delete filter;
+	delete is;
+	return rc;
+}
+
+RC testCase_12() {
+	// Predicate and projection pushdown into the table scan
+	// SELECT D FROM allocleft WHERE A < 50 AND C >= 20.0
+	cerr << endl << "***** In QE Test Case 12 *****" << endl;
+
+	RC rc = success;
+	TableScan *ts = new TableScan(*rm, "allocleft");
+
+	int compA = 50;
+	float compC = 20.0;
+	vector<Condition> conds(2);
+	conds[0].lhsAttr = "allocleft.A";
+	conds[0].op = LT_OP;
+	conds[0].bRhsIsAttr = false;
+	conds[0].rhsValue.type = TypeInt;
+	conds[0].rhsValue.data = &compA;
+	conds[1].lhsAttr = "allocleft.C";
+	conds[1].op = GE_OP;
+	conds[1].bRhsIsAttr = false;
+	conds[1].rhsValue.type = TypeReal;
+	conds[1].rhsValue.data = &compC;
+
+	Filter *filter = new Filter(ts, conds);
+
+	vector<string> attrNames;
+	attrNames.push_back("allocleft.D");
+	Project *project = new Project(filter, attrNames);
+
+	// The first condition is evaluated by the scan, the Filter keeps the second and
+	// only C (for the Filter) and D (for the Project) are read out of the records
+	vector<Attribute> scanAttrs;
+	ts->getAttributes(scanAttrs);
+	if (ts->compOp != LT_OP || ts->condAttrName != "A" || scanAttrs.size() != 2 ||
+			scanAttrs[0].name != "allocleft.C" || scanAttrs[1].name != "allocleft.D") {
+		cerr << "***** The condition or projection was not pushed into the scan. *****" << endl;
+		rc = fail;
+	}
+
+	int expectedResultCnt = 30;  // 20..49
+	int actualResultCnt = 0;
+	char data[bufSize];
+	while (project->getNextTuple(data) != QE_EOF) {
+		int length;
+		memcpy(&length, data + 1, sizeof(int));
+		if (data[0] != 0 || length < 1 || length > 10) {
+			cerr << "***** A returned value is not correct. *****" << endl;
+			rc = fail;
+			break;
+		}
+		actualResultCnt++;
+	}
+
+	if (expectedResultCnt != actualResultCnt) {
+		cerr << "***** The number of returned tuple is not correct. *****" << endl;
+		rc = fail;
+	}
+
+	delete project;
+	delete filter;
+	delete ts;
+
+	if (testAliasedIndexScan() != success)
+		rc = fail;
+	return rc;
+}
+
+int main() {
+	// Tables created: none
+	// Indexes created: none
+
+	if (testCase_12() != success) {
+		cerr << "***** [FAIL] QE Test Case 12 failed. *****" << endl;
+		return fail;
+	} else {
+		cerr << "***** QE Test Case 12 finished. The result will be examined. *****" << endl;
+		return success;
+	}
+}
@@ -0,0 +1,96 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "qe_test_util.h"
+
+// Check that sort produces all allocTupleCount tuples of allocleft ordered by D ascending,
+// then A descending
+RC checkSortedOutput(Sort *sort) {
+	const int allocTupleCount = 1000;
+	int count = 0;
+	string prevD;
+	int prevA = 0;
+	char data[bufSize];
+
+	while (sort->getNextTuple(data) != QE_EOF) {
+		int offset = 1;
+		int a;
+		memcpy(&a, data + offset, sizeof(int));
+		offset += 2 * sizeof(int) + sizeof(float);
+		int length;
+		memcpy(&length, data + offset, sizeof(int));
+		offset += sizeof(int);
+		string d(data + offset, length);
+
+		if (count > 0 && (d < prevD || (d == prevD && a > prevA))) {
+			cerr << "***** Tuples are out of order at tuple " << count << ". *****" << endl;
+			return fail;
+		}
+		prevD = d;
+		prevA = a;
+		count++;
+	}
+
+	if (count != allocTupleCount) {
+		cerr << "***** The number of returned tuple is not correct: " << count << " *****" << endl;
+		return fail;
+	}
+	return success;
+}
+
+RC testCase_13() {
+	// Sort -- in memory and external
+	// SELECT * FROM allocleft ORDER BY D ASC, A DESC
+	cerr << endl << "***** In QE Test Case 13 *****" << endl;
+
+	vector<string> keys;
+	keys.push_back("allocleft.D");
+	keys.push_back("allocleft.A");
+	vector<bool> asc;
+	asc.push_back(true);
+	asc.push_back(false);
+
+	// Enough memory for the whole table
+	TableScan *ts = new TableScan(*rm, "allocleft");
+	Sort *sort = new Sort(ts, keys, asc, 100);
+	RC rc = checkSortedOutput(sort);
+	delete sort;
+	delete ts;
+	if (rc != success)
+		return rc;
+
+	// One page of memory: several runs, merged two at a time
+	ts = new TableScan(*rm, "allocleft");
+	sort = new Sort(ts, keys, asc, 1);
+	rc = checkSortedOutput(sort);
+	delete sort;
+	delete ts;
+	if (rc != success)
+		return rc;
+
+	// The runs must be gone
+	FILE *run = fopen("sort_1_0.run", "r");
+	if (run) {
+		fclose(run);
+		cerr << "***** Sort run files were not removed. *****" << endl;
+		return fail;
+	}
+	return success;
+}
+
+int main() {
+	// Tables created: none
+	// Indexes created: none
+
+	if (testCase_13() != success) {
+		cerr << "***** [FAIL] QE Test Case 13 failed. *****" << endl;
+		return fail;
+	} else {
+		cerr << "***** QE Test Case 13 finished. The result will be examined. *****" << endl;
+		return success;
+	}
+}
@@ -0,0 +1,195 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "qe_test_util.h"
+
+const int groupTupleCount = 300;
+const int groupKeys = 3;
+
+int createGroupKeyTable() {
+	vector<Attribute> attrs;
+
+	Attribute attr;
+	attr.name = "K";
+	attr.type = TypeInt;
+	attr.length = 4;
+	attrs.push_back(attr);
+
+	attr.name = "P";
+	attr.type = TypeVarChar;
+	attr.length = 40;
+	attrs.push_back(attr);
+
+	rm->deleteTable("smjgroup");
+	RC rc = rm->createTable("smjgroup", attrs);
+	if (rc != success)
+		return rc;
+
+	// k in [0, 2], each key shared by 100 tuples of about 50 bytes
+	char buf[bufSize];
+	RID rid;
+	for (int i = 0; i < groupTupleCount; ++i) {
+		int k = i % groupKeys;
+		int length = 40;
+		buf[0] = 0;
+		memcpy(buf + 1, &k, sizeof(int));
+		memcpy(buf + 1 + sizeof(int), &length, sizeof(int));
+		memset(buf + 1 + 2 * sizeof(int), 'p', length);
+		rc = rm->insertTuple("smjgroup", buf, rid);
+		if (rc != success)
+			return rc;
+	}
+	return success;
+}
+
+// Join left with itself on B through its index, one input failing after 50 tuples. The join
+// has to return the input's error rather than end as if the input were exhausted.
+RC testFailingInput(bool failLeft) {
+	IndexScan *leftScan = new IndexScan(*rm, "left", "B");
+	IndexScan *rightScan = new IndexScan(*rm, "left", "B", "r");
+	Iterator *left = failLeft ? (Iterator *) new FailingInput(leftScan, 50) : leftScan;
+	Iterator *right = failLeft ? (Iterator *) rightScan : new FailingInput(rightScan, 50);
+
+	Condition cond;
+	cond.lhsAttr = "left.B";
+	cond.op = EQ_OP;
+	cond.bRhsIsAttr = true;
+	cond.rhsAttr = "r.B";
+	SMJoin *join = new SMJoin(left, right, cond, 6);
+
+	char data[2 * bufSize];
+	int count = 0;
+	RC rc;
+	while ((rc = join->getNextTuple(data)) == success)
+		count++;
+
+	delete join;
+	if (left != leftScan)
+		delete left;
+	if (right != rightScan)
+		delete right;
+	delete leftScan;
+	delete rightScan;
+	if (rc != RBFM_READ_FAILED || count > 50) {
+		cerr << "***** The join did not return the error of its " << (failLeft ? "left" : "right")
+			<< " input: " << rc << " after " << count << " tuples *****" << endl;
+		return fail;
+	}
+	return success;
+}
+
+// Count the join results and check that both join attributes are equal
+RC countJoin(SMJoin *join, unsigned leftFields, unsigned keyField, unsigned rightKeyField, int &count) {
+	vector<Attribute> attrs;
+	join->getAttributes(attrs);
+	if (attrs.size() != 2 * leftFields) {
+		cerr << "***** The join attributes are not correct. *****" << endl;
+		return fail;
+	}
+
+	char data[2 * bufSize];
+	count = 0;
+	while (join->getNextTuple(data) != QE_EOF) {
+		// Walk the fields to find both keys
+		unsigned offset = 1;
+		string keys[2];
+		for (unsigned i = 0; i < attrs.size(); i++) {
+			unsigned length = attrs[i].type == TypeVarChar ? sizeof(int) + *(int *) (data + offset) : sizeof(int);
+			if (i == keyField)
+				keys[0] = string(data + offset, length);
+			if (i == rightKeyField)
+				keys[1] = string(data + offset, length);
+			offset += length;
+		}
+		if (keys[0] != keys[1]) {
+			cerr << "***** Joined tuples with different keys. *****" << endl;
+			return fail;
+		}
+		count++;
+	}
+	return success;
+}
+
+RC testCase_14() {
+	// Sort-merge join of unsorted inputs
+	cerr << endl << "***** In QE Test Case 14 *****" << endl;
+
+	// SELECT * FROM allocleft, allocleft AS r WHERE allocleft.D = r.D
+	// Neither input is sorted, so both get sorted first
+	TableScan *left = new TableScan(*rm, "allocleft");
+	TableScan *right = new TableScan(*rm, "allocleft", "r");
+
+	Condition cond;
+	cond.lhsAttr = "allocleft.D";
+	cond.op = EQ_OP;
+	cond.bRhsIsAttr = true;
+	cond.rhsAttr = "r.D";
+
+	SMJoin *join = new SMJoin(left, right, cond, 6);
+
+	// Every pair of tuples with the same D joins
+	map<string, int> frequencies;
+	for (int i = 0; i < 1000; i++)
+		frequencies[string(i % 10 + 1, 'a' + i % 26)]++;
+	int expectedResultCnt = 0;
+	for (auto &frequency: frequencies)
+		expectedResultCnt += frequency.second * frequency.second;
+
+	int actualResultCnt;
+	RC rc = countJoin(join, 4, 3, 7, actualResultCnt);
+	delete join;
+	delete left;
+	delete right;
+	if (rc != success)
+		return rc;
+	if (actualResultCnt != expectedResultCnt) {
+		cerr << "***** The number of returned tuple is not correct: " << actualResultCnt << " *****" << endl;
+		return fail;
+	}
+
+	// SELECT * FROM smjgroup, smjgroup AS r WHERE smjgroup.K = r.K
+	// Each key group is bigger than the rewind buffer and has to spill
+	if (createGroupKeyTable() != success) {
+		cerr << "***** Creating the smjgroup table failed. *****" << endl;
+		return fail;
+	}
+	left = new TableScan(*rm, "smjgroup");
+	right = new TableScan(*rm, "smjgroup", "r");
+	cond.lhsAttr = "smjgroup.K";
+	cond.rhsAttr = "r.K";
+	join = new SMJoin(left, right, cond, 3);
+
+	rc = countJoin(join, 2, 0, 2, actualResultCnt);
+	delete join;
+	delete left;
+	delete right;
+	if (rc != success)
+		return rc;
+	expectedResultCnt = groupKeys * (groupTupleCount / groupKeys) * (groupTupleCount / groupKeys);
+	if (actualResultCnt != expectedResultCnt) {
+		cerr << "***** The number of returned tuple is not correct: " << actualResultCnt << " *****" << endl;
+		return fail;
+	}
+
+	if (testFailingInput(true) != success || testFailingInput(false) != success)
+		return fail;
+	return success;
+}
+
+int main() {
+	// Tables created: smjgroup
+	// Indexes created: none
+
+	if (testCase_14() != success) {
+		cerr << "***** [FAIL] QE Test Case 14 failed. *****" << endl;
+		return fail;
+	} else {
+		cerr << "***** QE Test Case 14 finished. The result will be examined. *****" << endl;
+		return success;
+	}
+}
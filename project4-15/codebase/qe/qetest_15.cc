@@ -0,0 +1,184 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "qe_test_util.h"
+
+// Plan a scan of allocleft, check the access path the planner picked and count the results
+RC checkPlan(const vector<Condition> &conds, const vector<string> &attrNames, const string &expectedIndex, int expectedResultCnt) {
+	Planner planner(*rm);
+	Iterator *plan = planner.planScan("allocleft", conds, attrNames);
+	if (plan == NULL) {
+		cerr << "***** The planner failed. *****" << endl;
+		return fail;
+	}
+	planner.explain(cerr);
+
+	if (planner.getChosenPath().indexAttr != expectedIndex) {
+		cerr << "***** The planner chose the wrong access path. *****" << endl;
+		return fail;
+	}
+
+	int actualResultCnt = 0;
+	char data[bufSize];
+	while (plan->getNextTuple(data) != QE_EOF)
+		actualResultCnt++;
+	if (actualResultCnt != expectedResultCnt) {
+		cerr << "***** The number of returned tuple is not correct: " << actualResultCnt << " *****" << endl;
+		return fail;
+	}
+	return success;
+}
+
+// A table that was never analyzed is planned from a sample of its pages
+RC testSampledTable() {
+	const string tableName = "allocsample";
+	const int tupleCount = 5000;
+	vector<Attribute> attrs(2);
+	attrs[0].name = "A";
+	attrs[0].type = TypeInt;
+	attrs[0].length = 4;
+	attrs[1].name = "B";
+	attrs[1].type = TypeVarChar;
+	attrs[1].length = 100;
+	rm->deleteTable(tableName);
+	if (rm->createTable(tableName, attrs) != success || rm->createIndex(tableName, "A") != success) {
+		cerr << "***** Creating " << tableName << " failed. *****" << endl;
+		return fail;
+	}
+	char buf[bufSize];
+	RID rid;
+	int length = 80;
+	for (int i = 0; i < tupleCount; i++) {
+		buf[0] = 0;
+		memcpy(buf + 1, &i, sizeof(int));
+		memcpy(buf + 1 + sizeof(int), &length, sizeof(int));
+		memset(buf + 1 + 2 * sizeof(int), 'a' + i % 26, length);
+		if (rm->insertTuple(tableName, buf, rid) != success) {
+			cerr << "***** Populating " << tableName << " failed. *****" << endl;
+			return fail;
+		}
+	}
+
+	// SELECT * FROM allocsample WHERE A = 7: one tuple by the index, even without statistics
+	int valueA = 7;
+	vector<Condition> conds(1);
+	conds[0].lhsAttr = tableName + ".A";
+	conds[0].op = EQ_OP;
+	conds[0].bRhsIsAttr = false;
+	conds[0].rhsValue.type = TypeInt;
+	conds[0].rhsValue.data = &valueA;
+	Planner planner(*rm);
+	Iterator *plan = planner.planScan(tableName, conds, vector<string>());
+	RC rc = success;
+	if (plan == NULL || planner.getChosenPath().indexAttr != "A") {
+		cerr << "***** The planner did not use the index of the table never analyzed. *****" << endl;
+		rc = fail;
+	}
+	if (plan)
+		planner.explain(cerr);
+
+	// The row count is scaled up from the sampled pages, which are nowhere near all of them
+	Planner scanPlanner(*rm);
+	if (rc == success && scanPlanner.planScan(tableName, vector<Condition>(), vector<string>()) != NULL) {
+		double rows = scanPlanner.getChosenPath().rows;
+		if (rows < tupleCount * 0.9 || rows > tupleCount * 1.1) {
+			cerr << "***** The sampled row count is not close: " << rows << " *****" << endl;
+			rc = fail;
+		}
+	}
+
+	TableStatistics stats;
+	if (rm->getStatistics(tableName, stats) != RM_NO_STATISTICS) {
+		cerr << "***** The planner stored the sampled statistics. *****" << endl;
+		rc = fail;
+	}
+	rm->deleteTable(tableName);
+	return rc;
+}
+
+RC testCase_15() {
+	// Cost-based choice between TableScan and IndexScan
+	cerr << endl << "***** In QE Test Case 15 *****" << endl;
+
+	if (testSampledTable() != success)
+		return fail;
+
+	int valueA = 7;
+	int highA = 900;
+	float valueC = 500.0;
+	vector<Condition> conds(2);
+	conds[0].lhsAttr = "allocleft.A";
+	conds[0].op = EQ_OP;
+	conds[0].bRhsIsAttr = false;
+	conds[0].rhsValue.type = TypeInt;
+	conds[0].rhsValue.data = &valueA;
+	conds[1].lhsAttr = "allocleft.C";
+	conds[1].op = LT_OP;
+	conds[1].bRhsIsAttr = false;
+	conds[1].rhsValue.type = TypeReal;
+	conds[1].rhsValue.data = &valueC;
+
+	vector<string> attrNames;
+	attrNames.push_back("allocleft.D");
+
+	// Planning leaves the statistics as they were: analyze is up to the user
+	TableStatistics before, after;
+	RC statsRc = rm->getStatistics("allocleft", before);
+	Planner planner(*rm);
+	planner.planScan("allocleft", conds, attrNames);
+	RC rc = success;
+	if (rm->getStatistics("allocleft", after) != statsRc ||
+			(statsRc == success && (after.rowCount != before.rowCount || after.modifications != before.modifications))) {
+		cerr << "***** The planner analyzed allocleft. *****" << endl;
+		rc = fail;
+	}
+	if (rc == success && rm->analyze("allocleft") != success) {
+		cerr << "***** Analyzing allocleft failed. *****" << endl;
+		rc = fail;
+	}
+
+	// The index comes after the last analyze, the planner reads its tree
+	if (rc == success && rm->createIndex("allocleft", "A") != success) {
+		cerr << "***** Creating the index on allocleft.A failed. *****" << endl;
+		rc = fail;
+	}
+
+	// SELECT D FROM allocleft WHERE A = 7 AND C < 500.0
+	// One tuple: the index is cheaper
+	if (rc == success)
+		rc = checkPlan(conds, attrNames, "A", 1);
+
+	// SELECT D FROM allocleft WHERE A >= 7 AND A < 900 AND C < 500.0
+	// Half the table: reading it sequentially is cheaper than a random read per tuple
+	if (rc == success) {
+		conds[0].op = GE_OP;
+		conds.push_back(conds[0]);
+		conds[2].op = LT_OP;
+		conds[2].rhsValue.data = &highA;
+		rc = checkPlan(conds, attrNames, "", 493);
+	}
+
+	// SELECT * FROM allocleft
+	if (rc == success)
+		rc = checkPlan(vector<Condition>(), vector<string>(), "", 1000);
+
+	rm->destroyIndex("allocleft", "A");
+	return rc;
+}
+
+int main() {
+	// Tables created: none
+	// Indexes created: none
+
+	if (testCase_15() != success) {
+		cerr << "***** [FAIL] QE Test Case 15 failed. *****" << endl;
+		return fail;
+	} else {
+		cerr << "***** QE Test Case 15 finished. The result will be examined. *****" << endl;
+		return success;
+	}
+}
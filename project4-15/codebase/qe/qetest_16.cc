@@ -0,0 +1,237 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "qe_test_util.h"
+
+const int orderTupleCount = 1000;
+const int customerTupleCount = 100;
+const int regionTupleCount = 10;
+
+// orders(A, B) with B = A % 100, customers(B, C) with C = B % 10 and regions(C, D) with D = "region" + C
+int createJoinTable(const string &tableName, const string &key, const string &value, AttrType valueType, int tupleCount) {
+	vector<Attribute> attrs;
+
+	Attribute attr;
+	attr.name = key;
+	attr.type = TypeInt;
+	attr.length = 4;
+	attrs.push_back(attr);
+
+	attr.name = value;
+	attr.type = valueType;
+	attr.length = valueType == TypeVarChar ? 10 : 4;
+	attrs.push_back(attr);
+
+	rm->deleteTable(tableName);
+	RC rc = rm->createTable(tableName, attrs);
+	if (rc != success)
+		return rc;
+
+	char buf[bufSize];
+	RID rid;
+	for (int i = 0; i < tupleCount; ++i) {
+		buf[0] = 0;
+		memcpy(buf + 1, &i, sizeof(int));
+		if (valueType == TypeVarChar) {
+			string name = "region" + to_string(i);
+			int length = name.length();
+			memcpy(buf + 1 + sizeof(int), &length, sizeof(int));
+			memcpy(buf + 1 + 2 * sizeof(int), name.c_str(), length);
+		} else {
+			int v = i % (tupleCount / 10);
+			memcpy(buf + 1 + sizeof(int), &v, sizeof(int));
+		}
+		rc = rm->insertTuple(tableName, buf, rid);
+		if (rc != success)
+			return rc;
+	}
+	return success;
+}
+
+Condition joinCondition(const string &lhsAttr, const string &rhsAttr) {
+	Condition cond;
+	cond.lhsAttr = lhsAttr;
+	cond.op = EQ_OP;
+	cond.bRhsIsAttr = true;
+	cond.rhsAttr = rhsAttr;
+	return cond;
+}
+
+// Hash join orders with customers on B, one input failing after 50 tuples. Every order has one
+// customer, so 50 tuples come out if the probe side fails and none if the build side does.
+RC testFailingHashJoin(bool failLeft) {
+	TableScan *leftScan = new TableScan(*rm, "orders");
+	TableScan *rightScan = new TableScan(*rm, "customers");
+	Iterator *left = failLeft ? (Iterator *) new FailingInput(leftScan, 50) : leftScan;
+	Iterator *right = failLeft ? (Iterator *) rightScan : new FailingInput(rightScan, 50);
+	HashJoin *join = new HashJoin(left, right, joinCondition("orders.B", "customers.B"));
+
+	char data[bufSize];
+	int count = 0;
+	RC rc;
+	while ((rc = join->getNextTuple(data)) == success)
+		count++;
+
+	delete join;
+	if (left != leftScan)
+		delete left;
+	if (right != rightScan)
+		delete right;
+	delete leftScan;
+	delete rightScan;
+	if (rc != RBFM_READ_FAILED || count != (failLeft ? 50 : 0)) {
+		cerr << "***** The hash join did not return the error of its " << (failLeft ? "left" : "right")
+			<< " input: " << rc << " after " << count << " tuples *****" << endl;
+		return fail;
+	}
+	return success;
+}
+
+RC testCase_16() {
+	// Join order enumeration over three tables
+	cerr << endl << "***** In QE Test Case 16 *****" << endl;
+
+	vector<string> tableNames;
+	tableNames.push_back("orders");
+	tableNames.push_back("customers");
+	tableNames.push_back("regions");
+
+	int valueC = 3;
+	vector<Condition> conds;
+	conds.push_back(joinCondition("orders.B", "customers.B"));
+	conds.push_back(joinCondition("customers.C", "regions.C"));
+	conds.push_back(Condition());
+	conds[2].lhsAttr = "regions.C";
+	conds[2].op = EQ_OP;
+	conds[2].bRhsIsAttr = false;
+	conds[2].rhsValue.type = TypeInt;
+	conds[2].rhsValue.data = &valueC;
+
+	vector<string> attrNames;
+	attrNames.push_back("orders.A");
+
+	// SELECT orders.A FROM orders, customers, regions
+	// WHERE orders.B = customers.B AND customers.C = regions.C AND regions.C = 3
+	// The one region should be joined first, orders (the biggest table) last
+	for (const string &tableName: tableNames) {
+		if (rm->analyze(tableName) != success) {
+			cerr << "***** Analyzing " << tableName << " failed. *****" << endl;
+			return fail;
+		}
+	}
+	Planner planner(*rm);
+	Iterator *plan = planner.planJoin(tableNames, conds, attrNames);
+	if (plan == NULL) {
+		cerr << "***** The planner failed. *****" << endl;
+		return fail;
+	}
+	planner.explain(cerr);
+
+	const vector<JoinStep> &steps = planner.getJoinSteps();
+	if (steps.size() != 3 || steps[0].scan == 0 || steps[2].scan != 0) {
+		cerr << "***** The planner chose the wrong join order. *****" << endl;
+		return fail;
+	}
+
+	int actualResultCnt = 0;
+	char data[bufSize];
+	while (plan->getNextTuple(data) != QE_EOF) {
+		int a;
+		memcpy(&a, data + 1, sizeof(int));
+		if (a % 100 % 10 != valueC) {
+			cerr << "***** A returned value is not correct. *****" << endl;
+			return fail;
+		}
+		actualResultCnt++;
+	}
+	if (actualResultCnt != 100) {
+		cerr << "***** The number of returned tuple is not correct: " << actualResultCnt << " *****" << endl;
+		return fail;
+	}
+
+	// SELECT orders.A FROM regions, orders WHERE regions.C = orders.A AND regions.D = "region3"
+	// One outer tuple: probing the index on orders.A beats hashing all of orders
+	if (rm->createIndex("orders", "A") != success || rm->analyze("orders") != success) {
+		cerr << "***** Creating the index on orders.A failed. *****" << endl;
+		return fail;
+	}
+	tableNames.clear();
+	tableNames.push_back("regions");
+	tableNames.push_back("orders");
+
+	string name = "region3";
+	char valueD[bufSize];
+	int length = name.length();
+	memcpy(valueD, &length, sizeof(int));
+	memcpy(valueD + sizeof(int), name.c_str(), length);
+	conds.clear();
+	conds.push_back(joinCondition("regions.C", "orders.A"));
+	conds.push_back(Condition());
+	conds[1].lhsAttr = "regions.D";
+	conds[1].op = EQ_OP;
+	conds[1].bRhsIsAttr = false;
+	conds[1].rhsValue.type = TypeVarChar;
+	conds[1].rhsValue.data = valueD;
+
+	Planner indexPlanner(*rm);
+	plan = indexPlanner.planJoin(tableNames, conds, attrNames);
+	if (plan == NULL) {
+		cerr << "***** The planner failed. *****" << endl;
+		return fail;
+	}
+	indexPlanner.explain(cerr);
+
+	const vector<JoinStep> &indexSteps = indexPlanner.getJoinSteps();
+	if (indexSteps.size() != 2 || indexSteps[0].scan != 0 || indexSteps[1].method != "INLJoin") {
+		cerr << "***** The planner did not use the index on orders.A. *****" << endl;
+		return fail;
+	}
+
+	actualResultCnt = 0;
+	while (plan->getNextTuple(data) != QE_EOF) {
+		int a;
+		memcpy(&a, data + 1, sizeof(int));
+		if (a != 3) {
+			cerr << "***** A returned value is not correct. *****" << endl;
+			return fail;
+		}
+		actualResultCnt++;
+	}
+	if (actualResultCnt != 1) {
+		cerr << "***** The number of returned tuple is not correct: " << actualResultCnt << " *****" << endl;
+		return fail;
+	}
+
+	if (testFailingHashJoin(true) != success || testFailingHashJoin(false) != success)
+		return fail;
+	return success;
+}
+
+int main() {
+	// Tables created: orders, customers, regions
+	// Indexes created: orders.A
+
+	if (createJoinTable("orders", "A", "B", TypeInt, orderTupleCount) != success ||
+			createJoinTable("customers", "B", "C", TypeInt, customerTupleCount) != success ||
+			createJoinTable("regions", "C", "D", TypeVarChar, regionTupleCount) != success) {
+		cerr << "***** Creating the join tables failed. *****" << endl;
+		cerr << "***** [FAIL] QE Test Case 16 failed. *****" << endl;
+		return fail;
+	}
+
+	RC rc = testCase_16();
+	rm->deleteTable("orders");
+	rm->deleteTable("customers");
+	rm->deleteTable("regions");
+	if (rc != success) {
+		cerr << "***** [FAIL] QE Test Case 16 failed. *****" << endl;
+		return fail;
+	} else {
+		cerr << "***** QE Test Case 16 finished. The result will be examined. *****" << endl;
+		return success;
+	}
+}
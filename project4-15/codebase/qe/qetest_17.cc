@@ -0,0 +1,103 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+#include "qe_test_util.h"
+
+// Run a plan to the end, returning the number of tuples
+int drain(Iterator *plan) {
+	char data[bufSize];
+	int count = 0;
+	while (plan->getNextTuple(data) != QE_EOF)
+		count++;
+	return count;
+}
+
+RC testCase_17() {
+	// EXPLAIN ANALYZE of SELECT A, D FROM allocleft WHERE A < 500 AND C >= 100.0
+	cerr << endl << "***** In QE Test Case 17 *****" << endl;
+
+	int compA = 500;
+	float compC = 100.0;
+	vector<Condition> conds(2);
+	conds[0].lhsAttr = "allocleft.A";
+	conds[0].op = LT_OP;
+	conds[0].bRhsIsAttr = false;
+	conds[0].rhsValue.type = TypeInt;
+	conds[0].rhsValue.data = &compA;
+	conds[1].lhsAttr = "allocleft.C";
+	conds[1].op = GE_OP;
+	conds[1].bRhsIsAttr = false;
+	conds[1].rhsValue.type = TypeReal;
+	conds[1].rhsValue.data = &compC;
+
+	vector<string> attrNames;
+	attrNames.push_back("allocleft.A");
+	attrNames.push_back("allocleft.D");
+
+	// Every operator wrapped and timed. The scan still takes the first condition through the wrapper.
+	TableScan *ts = new TableScan(*rm, "allocleft");
+	Instrument *scan = new Instrument(ts, "TableScan allocleft", vector<Instrument *>(), true);
+	Filter *filter = new Filter(scan, conds);
+	Instrument *filtered = new Instrument(filter, "Filter allocleft.A < 500 AND allocleft.C >= 100.0", vector<Instrument *>(1, scan), true);
+	Project *project = new Project(filtered, attrNames);
+	Instrument *root = new Instrument(project, "Project allocleft.A, allocleft.D", vector<Instrument *>(1, filtered), true);
+
+	int actualResultCnt = drain(root);
+	root->print(cerr);
+
+	RC rc = success;
+	if (actualResultCnt != 400 || root->rows != 400 || root->calls != 401 || filtered->rows != 400 || scan->rows != 500) {
+		cerr << "***** The row counts are not correct. *****" << endl;
+		rc = fail;
+	}
+	if (ts->compOp != LT_OP || scan->pageReads == 0 || scan->getExclusivePageReads() != scan->pageReads ||
+			root->pageReads != scan->pageReads || root->getExclusivePageReads() != 0) {
+		cerr << "***** The page reads are not attributed to the scan. *****" << endl;
+		rc = fail;
+	}
+
+	delete root;
+	delete project;
+	delete filtered;
+	delete filter;
+	delete scan;
+	delete ts;
+
+	// The same plan instrumented without timing, the default
+	ts = new TableScan(*rm, "allocleft");
+	scan = new Instrument(ts, "TableScan allocleft");
+	filter = new Filter(scan, conds);
+	filtered = new Instrument(filter, "Filter", vector<Instrument *>(1, scan));
+	project = new Project(filtered, attrNames);
+	root = new Instrument(project, "Project", vector<Instrument *>(1, filtered));
+	drain(root);
+	if (root->rows != 400 || root->getNanos() != 0 || scan->pageReads == 0) {
+		cerr << "***** The counts without timing are not correct. *****" << endl;
+		rc = fail;
+	}
+	delete root;
+	delete project;
+	delete filtered;
+	delete filter;
+	delete scan;
+	delete ts;
+	return rc;
+}
+
+int main() {
+	// Tables created: none
+	// Indexes created: none
+
+	if (testCase_17() != success) {
+		cerr << "***** [FAIL] QE Test Case 17 failed. *****" << endl;
+		return fail;
+	} else {
+		cerr << "***** QE Test Case 17 finished. The result will be examined. *****" << endl;
+		return success;
+	}
+}
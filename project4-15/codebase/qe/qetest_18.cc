@@ -0,0 +1,103 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "qe_test_util.h"
+
+RC testCase_18() {
+	// Operators taking their buffers from a query arena
+	// SELECT A, D FROM allocleft WHERE B >= 100 ORDER BY D
+	cerr << endl << "***** In QE Test Case 18 *****" << endl;
+
+	RC rc = success;
+	Arena arena;
+	TableScan *ts;
+	Filter *filter;
+	Project *project;
+	Sort *sort;
+
+	int compB = 100;
+	vector<Condition> conds(1);
+	conds[0].lhsAttr = "allocleft.B";
+	conds[0].op = GE_OP;
+	conds[0].bRhsIsAttr = false;
+	conds[0].rhsValue.type = TypeInt;
+	conds[0].rhsValue.data = &compB;
+
+	vector<string> attrNames;
+	attrNames.push_back("allocleft.A");
+	attrNames.push_back("allocleft.D");
+
+	{
+		ArenaScope scope(&arena);
+		ts = new TableScan(*rm, "allocleft");
+		filter = new Filter(ts, conds);
+		project = new Project(filter, attrNames);
+		// One page of memory, so the sort spills runs and merges them
+		sort = new Sort(project, vector<string>(1, "allocleft.D"), vector<bool>(1, true), 1);
+	}
+
+	size_t allocated = arena.getAllocatedBytes();
+	int expectedResultCnt = 900;
+	int actualResultCnt = 0;
+	string prevD;
+	char data[bufSize];
+	while (sort->getNextTuple(data) != QE_EOF) {
+		int length;
+		memcpy(&length, data + 1 + sizeof(int), sizeof(int));
+		string d(data + 1 + 2 * sizeof(int), length);
+		if (d < prevD) {
+			cerr << "***** Tuples are out of order. *****" << endl;
+			rc = fail;
+			break;
+		}
+		prevD = d;
+		actualResultCnt++;
+	}
+
+	// The sort buffers its runs in the arena, nothing comes from it per tuple
+	cerr << "Tuples: " << actualResultCnt << ", arena bytes: " << allocated << " after construction, "
+		 << arena.getAllocatedBytes() << " at the end, " << arena.getReservedBytes() << " reserved" << endl;
+	if (expectedResultCnt != actualResultCnt) {
+		cerr << "***** The number of returned tuple is not correct. *****" << endl;
+		rc = fail;
+	}
+	if (allocated == 0 || arena.getAllocatedBytes() > allocated + 64 * bufSize ||
+			arena.getReservedBytes() < arena.getAllocatedBytes()) {
+		cerr << "***** The operators did not use the arena. *****" << endl;
+		rc = fail;
+	}
+
+	delete sort;
+	delete project;
+	delete filter;
+	delete ts;
+
+	// Operators built by the planner live in its arena
+	Planner planner(*rm);
+	Iterator *plan = planner.planScan("allocleft", conds, attrNames);
+	actualResultCnt = 0;
+	while (plan && plan->getNextTuple(data) != QE_EOF)
+		actualResultCnt++;
+	if (actualResultCnt != expectedResultCnt || planner.getArena().getAllocatedBytes() == 0) {
+		cerr << "***** The planned operators did not use the arena. *****" << endl;
+		rc = fail;
+	}
+	return rc;
+}
+
+int main() {
+	// Tables created: none
+	// Indexes created: none
+
+	if (testCase_18() != success) {
+		cerr << "***** [FAIL] QE Test Case 18 failed. *****" << endl;
+		return fail;
+	} else {
+		cerr << "***** QE Test Case 18 finished. The result will be examined. *****" << endl;
+		return success;
+	}
+}
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+#include "arena.h"
+#include "pfm.h"
+
+thread_local Arena *Arena::current = NULL;
+
+Arena::Arena(size_t chunkSize)
+{
+    this->chunkSize = chunkSize;
+    next = NULL;
+    end = NULL;
+    allocatedBytes = 0;
+    reservedBytes = 0;
+}
+
+Arena::~Arena()
+{
+    reset();
+}
+
+void *Arena::allocate(size_t size, size_t alignment)
+{
+    uintptr_t aligned = ((uintptr_t) next + alignment - 1) & ~(uintptr_t) (alignment - 1);
+    if (next == NULL || aligned + size > (uintptr_t) end)
+    {
+        // Allocations too big for a chunk get one of their own
+        size_t bytes = max(chunkSize, size + alignment);
+        char *chunk = (char *) malloc(bytes);
+        if (chunk == NULL)
+            return NULL;
+        chunks.push_back(chunk);
+        reservedBytes += bytes;
+        next = chunk;
+        end = chunk + bytes;
+        aligned = ((uintptr_t) next + alignment - 1) & ~(uintptr_t) (alignment - 1);
+    }
+
+    next = (char *) (aligned + size);
+    allocatedBytes += size;
+    return (void *) aligned;
+}
+
+void Arena::reset()
+{
+    for (char *chunk : chunks)
+        free(chunk);
+    chunks.clear();
+    next = NULL;
+    end = NULL;
+    allocatedBytes = 0;
+    reservedBytes = 0;
+}
+
+size_t Arena::getAllocatedBytes() const
+{
+    return allocatedBytes;
+}
+
+size_t Arena::getReservedBytes() const
+{
+    return reservedBytes;
+}
+
+Arena *Arena::getCurrent()
+{
+    return current;
+}
+
+
+ArenaScope::ArenaScope(Arena *arena)
+{
+    previous = Arena::current;
+    Arena::current = arena;
+}
+
+ArenaScope::~ArenaScope()
+{
+    Arena::current = previous;
+}
+
+
+// Set once the buffers of this thread went back to the heap, for pages read and written during
+// exit (see RelationManager's tail pages), which then come from the heap
+static thread_local bool pageBuffersGone = false;
+
+// The free buffers of one thread, given back to the heap when the thread exits
+struct PageBufferList
+{
+    PageBufferList()
+    {
+        pages.reserve(PAGE_BUFFER_POOL_SIZE);
+        heapAllocations = 0;
+    }
+
+    ~PageBufferList()
+    {
+        for (void *page : pages)
+            free(page);
+        pageBuffersGone = true;
+    }
+
+    vector<void *> pages;
+    unsigned long heapAllocations;
+};
+
+static thread_local PageBufferList pageBuffers;
+
+void *PageBufferPool::acquire()
+{
+    if (pageBuffersGone)
+        return aligned_alloc(PAGE_SIZE, MAX_PAGE_SIZE);
+    if (!pageBuffers.pages.empty())
+    {
+        void *page = pageBuffers.pages.back();
+        pageBuffers.pages.pop_back();
+        return page;
+    }
+    pageBuffers.heapAllocations++;
+    return aligned_alloc(PAGE_SIZE, MAX_PAGE_SIZE);
+}
+
+void PageBufferPool::release(void *page)
+{
+    if (page == NULL)
+        return;
+    if (pageBuffersGone)
+        free(page);
+    else if (pageBuffers.pages.size() < PAGE_BUFFER_POOL_SIZE)
+        pageBuffers.pages.push_back(page);
+    else
+        free(page);
+}
+
+unsigned long PageBufferPool::getHeapAllocations()
+{
+    return pageBuffers.heapAllocations;
+}
@@ -0,0 +1,72 @@
+#ifndef _arena_h_
+#define _arena_h_
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// Bytes an Arena takes from the heap at a time
+#define ARENA_CHUNK_SIZE (64 * 1024)
+
+// Page buffers each thread keeps for reuse
+#define PAGE_BUFFER_POOL_SIZE 32
+
+// Monotonic allocator for the buffers of one query. Allocations are carved out of large chunks
+// and only given back all at once, by reset() or the destructor.
+class Arena
+{
+public:
+    Arena(size_t chunkSize = ARENA_CHUNK_SIZE);
+    ~Arena();
+
+    void *allocate(size_t size, size_t alignment = alignof(max_align_t));
+    void reset();
+
+    size_t getAllocatedBytes() const;                   // handed out by allocate()
+    size_t getReservedBytes() const;                    // taken from the heap
+
+    // The arena of the innermost ArenaScope of this thread, NULL outside of any
+    static Arena *getCurrent();
+
+private:
+    Arena(const Arena &);
+    Arena &operator=(const Arena &);
+
+    friend class ArenaScope;
+    static thread_local Arena *current;
+
+    size_t chunkSize;
+    vector<char *> chunks;
+    char *next;                                         // free space of the last chunk
+    char *end;
+    size_t allocatedBytes;
+    size_t reservedBytes;
+};
+
+
+// Makes an arena current on this thread until the scope ends
+class ArenaScope
+{
+public:
+    ArenaScope(Arena *arena);
+    ~ArenaScope();
+
+private:
+    Arena *previous;
+};
+
+
+// MAX_PAGE_SIZE buffers aligned to PAGE_SIZE for reading and writing pages of any size. Released buffers are kept
+// by the releasing thread, up to PAGE_BUFFER_POOL_SIZE, and handed out again by acquire().
+class PageBufferPool
+{
+public:
+    static void *acquire();
+    static void release(void *page);                    // NULL is ignored
+
+    // Buffers this thread took from the heap so far
+    static unsigned long getHeapAllocations();
+};
+
+#endif
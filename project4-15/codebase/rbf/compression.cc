@@ -0,0 +1,495 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+#include "compression.h"
+#include "arena.h"
+
+// Shortest copy worth a sequence
+#define LZ_MIN_MATCH    4
+#define LZ_MAX_OFFSET   0xFFFF
+#define LZ_HASH_BITS    12
+
+// PageExtents of one page of the translation table
+#define EXTENTS_PER_TABLE_PAGE (PAGE_SIZE / sizeof(PageExtent))
+
+// The part of a length that didn't fit its nibble of the token, 255 at a time
+static bool putLength(char *out, unsigned capacity, unsigned &outPos, unsigned length)
+{
+    while (true)
+    {
+        if (outPos >= capacity)
+            return false;
+        unsigned chunk = min(length, 255u);
+        out[outPos++] = (char) chunk;
+        length -= chunk;
+        if (chunk < 255)
+            return true;
+    }
+}
+
+static bool getLength(const char *in, unsigned inLength, unsigned &inPos, unsigned &length)
+{
+    while (true)
+    {
+        if (inPos >= inLength)
+            return false;
+        unsigned char chunk = in[inPos++];
+        length += chunk;
+        if (chunk < 255)
+            return true;
+    }
+}
+
+// A token (literal length, match length - LZ_MIN_MATCH), the literals, then the copy. The last
+// sequence has no copy.
+static bool putSequence(char *out, unsigned capacity, unsigned &outPos, const char *literals, unsigned literalLength,
+                        unsigned offset, unsigned matchLength)
+{
+    if (outPos >= capacity)
+        return false;
+    unsigned matchCode = matchLength ? matchLength - LZ_MIN_MATCH : 0;
+    out[outPos++] = (char) ((min(literalLength, 15u) << 4) | min(matchCode, 15u));
+    if (literalLength >= 15 && !putLength(out, capacity, outPos, literalLength - 15))
+        return false;
+    if (outPos + literalLength > capacity)
+        return false;
+    memcpy(out + outPos, literals, literalLength);
+    outPos += literalLength;
+
+    if (matchLength == 0)
+        return true;
+    if (outPos + 2 > capacity)
+        return false;
+    out[outPos++] = (char) (offset & 0xFF);
+    out[outPos++] = (char) (offset >> 8);
+    return matchCode < 15 || putLength(out, capacity, outPos, matchCode - 15);
+}
+
+unsigned PageCodec::compress(const char *in, unsigned length, char *out, unsigned capacity)
+{
+    // Last position of every hashed 4 byte sequence
+    int positions[1 << LZ_HASH_BITS];
+    memset(positions, 0xFF, sizeof(positions));
+
+    unsigned outPos = 0;
+    unsigned anchor = 0;
+    unsigned pos = 0;
+    while (pos + LZ_MIN_MATCH <= length)
+    {
+        uint32_t sequence;
+        memcpy(&sequence, in + pos, sizeof(sequence));
+        unsigned hash = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+        int candidate = positions[hash];
+        positions[hash] = pos;
+        if (candidate < 0 || pos - candidate > LZ_MAX_OFFSET || memcmp(in + candidate, in + pos, LZ_MIN_MATCH) != 0)
+        {
+            pos++;
+            continue;
+        }
+
+        unsigned matchLength = LZ_MIN_MATCH;
+        while (pos + matchLength < length && in[candidate + matchLength] == in[pos + matchLength])
+            matchLength++;
+        if (!putSequence(out, capacity, outPos, in + anchor, pos - anchor, pos - candidate, matchLength))
+            return 0;
+        pos += matchLength;
+        anchor = pos;
+    }
+    if (!putSequence(out, capacity, outPos, in + anchor, length - anchor, 0, 0))
+        return 0;
+    return outPos;
+}
+
+bool PageCodec::decompress(const char *in, unsigned inLength, char *out, unsigned length)
+{
+    unsigned inPos = 0;
+    unsigned outPos = 0;
+    while (inPos < inLength)
+    {
+        unsigned char token = in[inPos++];
+        unsigned literalLength = token >> 4;
+        if (literalLength == 15 && !getLength(in, inLength, inPos, literalLength))
+            return false;
+        if (inPos + literalLength > inLength || outPos + literalLength > length)
+            return false;
+        memcpy(out + outPos, in + inPos, literalLength);
+        inPos += literalLength;
+        outPos += literalLength;
+        if (inPos == inLength)
+            break;
+
+        if (inPos + 2 > inLength)
+            return false;
+        unsigned offset = (unsigned char) in[inPos] | ((unsigned char) in[inPos + 1] << 8);
+        inPos += 2;
+        unsigned matchLength = token & 15;
+        if (matchLength == 15 && !getLength(in, inLength, inPos, matchLength))
+            return false;
+        matchLength += LZ_MIN_MATCH;
+        if (offset == 0 || offset > outPos || outPos + matchLength > length)
+            return false;
+        // Byte by byte: the copy may overlap what it writes
+        for (unsigned i = 0; i < matchLength; i++, outPos++)
+            out[outPos] = out[outPos - offset];
+    }
+    return outPos == length;
+}
+
+
+// A handle on a CompressedFile
+class CompressedPageFile : public PageFile
+{
+public:
+    CompressedPageFile(const shared_ptr<CompressedFile> &file) : file(file) {};
+
+    RC readPage(PageNum pageNum, void *data) { return file->readPage(pageNum, data); };
+    RC writePage(PageNum pageNum, const void *data) { return file->writePage(pageNum, data); };
+    RC appendPage(const void *data) { return file->writePage(file->getNumberOfPages(), data); };
+    unsigned getNumberOfPages() { return file->getNumberOfPages(); };
+    unsigned long getStoredBytes() { return file->getStoredBytes(); };
+    RC truncate(unsigned numPages) { return file->truncate(numPages); };
+
+private:
+    shared_ptr<CompressedFile> file;
+};
+
+// The compressed files with handles open on them
+static map<pair<PageDevice *, string>, weak_ptr<CompressedFile> > openFiles;
+
+string CompressedFile::getTableFileName(const string &fileName)
+{
+    return fileName + ".ptt";
+}
+
+RC CompressedFile::create(PageDevice *device, const string &fileName)
+{
+    string tableFileName = getTableFileName(fileName);
+    RC rc = device->createFile(tableFileName);
+    if (rc)
+        return rc;
+    // Handles on a destroyed file of the same name keep their own
+    openFiles.erase(make_pair(device, fileName));
+
+    PageFile *table;
+    rc = device->openFile(tableFileName, table);
+    if (rc == SUCCESS)
+    {
+        void *page = PageBufferPool::acquire();
+        memset(page, 0, PAGE_SIZE);
+        rc = table->appendPage(page);
+        PageBufferPool::release(page);
+        delete table;
+    }
+    if (rc)
+        device->destroyFile(tableFileName);
+    return rc;
+}
+
+RC CompressedFile::destroy(PageDevice *device, const string &fileName)
+{
+    openFiles.erase(make_pair(device, fileName));
+    return device->destroyFile(getTableFileName(fileName));
+}
+
+RC CompressedFile::open(PageDevice *device, const string &fileName, PageFile *&file)
+{
+    pair<PageDevice *, string> key(device, fileName);
+    shared_ptr<CompressedFile> shared = openFiles[key].lock();
+    if (!shared)
+    {
+        shared.reset(new CompressedFile());
+        RC rc = device->openFile(fileName, shared->data);
+        if (rc == SUCCESS)
+            rc = device->openFile(getTableFileName(fileName), shared->table);
+        if (rc == SUCCESS)
+            rc = shared->load();
+        if (rc)
+        {
+            openFiles.erase(key);
+            return rc;
+        }
+        openFiles[key] = shared;
+    }
+    file = new CompressedPageFile(shared);
+    return SUCCESS;
+}
+
+CompressedFile::CompressedFile()
+{
+    data = NULL;
+    table = NULL;
+    numPages = 0;
+    endSector = 0;
+    cache = aligned_alloc(PAGE_SIZE, PAGE_SIZE);
+    cachedPage = 0;
+    cacheValid = false;
+}
+
+CompressedFile::~CompressedFile()
+{
+    delete data;
+    delete table;
+    free(cache);
+}
+
+RC CompressedFile::load()
+{
+    void *page = PageBufferPool::acquire();
+    RC rc = table->readPage(0, page) ? FH_READ_FAILED : SUCCESS;
+    if (rc == SUCCESS)
+    {
+        numPages = ((uint32_t *) page)[0];
+        endSector = ((uint32_t *) page)[1];
+        extents.resize(numPages);
+    }
+    for (PageNum pageNum = 0; rc == SUCCESS && pageNum < numPages; pageNum += EXTENTS_PER_TABLE_PAGE)
+    {
+        if (table->readPage(1 + pageNum / EXTENTS_PER_TABLE_PAGE, page))
+            rc = FH_READ_FAILED;
+        else
+            memcpy(&extents[pageNum], page, min((unsigned) EXTENTS_PER_TABLE_PAGE, numPages - pageNum) * sizeof(PageExtent));
+    }
+    PageBufferPool::release(page);
+    if (rc)
+        return rc;
+
+    // The sectors no page holds are free
+    vector<pair<uint32_t, uint32_t> > held;
+    for (const PageExtent &extent : extents)
+        held.push_back(make_pair(extent.sector, extent.sectors));
+    sort(held.begin(), held.end());
+    uint32_t next = 0;
+    for (const pair<uint32_t, uint32_t> &run : held)
+    {
+        if (run.first > next)
+            freeSectors[next] = run.first - next;
+        next = max(next, run.first + run.second);
+    }
+    if (next < endSector)
+        freeSectors[next] = endSector - next;
+    return SUCCESS;
+}
+
+RC CompressedFile::writeHeader()
+{
+    void *page = PageBufferPool::acquire();
+    memset(page, 0, PAGE_SIZE);
+    ((uint32_t *) page)[0] = numPages;
+    ((uint32_t *) page)[1] = endSector;
+    RC rc = table->writePage(0, page) ? FH_WRITE_FAILED : SUCCESS;
+    PageBufferPool::release(page);
+    return rc;
+}
+
+RC CompressedFile::writeExtent(PageNum pageNum)
+{
+    PageNum tablePage = 1 + pageNum / EXTENTS_PER_TABLE_PAGE;
+    void *page = PageBufferPool::acquire();
+    RC rc = SUCCESS;
+    if (tablePage >= table->getNumberOfPages())
+        memset(page, 0, PAGE_SIZE);
+    else if (table->readPage(tablePage, page))
+        rc = FH_READ_FAILED;
+    if (rc == SUCCESS)
+    {
+        memcpy((char *) page + (pageNum % EXTENTS_PER_TABLE_PAGE) * sizeof(PageExtent), &extents[pageNum], sizeof(PageExtent));
+        rc = table->writePage(tablePage, page) ? FH_WRITE_FAILED : SUCCESS;
+    }
+    PageBufferPool::release(page);
+    return rc;
+}
+
+// The shortest free run long enough, else the end of the stream
+uint32_t CompressedFile::allocate(uint32_t sectors)
+{
+    auto best = freeSectors.end();
+    for (auto it = freeSectors.begin(); it != freeSectors.end(); ++it)
+    {
+        if (it->second >= sectors && (best == freeSectors.end() || it->second < best->second))
+            best = it;
+    }
+    if (best == freeSectors.end())
+    {
+        uint32_t sector = endSector;
+        endSector += sectors;
+        return sector;
+    }
+    uint32_t sector = best->first;
+    uint32_t left = best->second - sectors;
+    freeSectors.erase(best);
+    if (left)
+        freeSectors[sector + sectors] = left;
+    return sector;
+}
+
+void CompressedFile::release(uint32_t sector, uint32_t sectors)
+{
+    if (sectors == 0)
+        return;
+    // Merge with the free runs right after and right before
+    auto next = freeSectors.lower_bound(sector);
+    if (next != freeSectors.end() && next->first == sector + sectors)
+    {
+        sectors += next->second;
+        next = freeSectors.erase(next);
+    }
+    if (next != freeSectors.begin())
+    {
+        auto previous = prev(next);
+        if (previous->first + previous->second == sector)
+        {
+            previous->second += sectors;
+            return;
+        }
+    }
+    freeSectors[sector] = sectors;
+}
+
+RC CompressedFile::loadDataPage(PageNum dataPage)
+{
+    if (cacheValid && cachedPage == dataPage)
+        return SUCCESS;
+    cacheValid = false;
+    if (dataPage >= data->getNumberOfPages())
+        memset(cache, 0, PAGE_SIZE);
+    else if (data->readPage(dataPage, cache))
+        return FH_READ_FAILED;
+    cachedPage = dataPage;
+    cacheValid = true;
+    return SUCCESS;
+}
+
+RC CompressedFile::readBytes(uint64_t offset, unsigned length, char *out)
+{
+    while (length > 0)
+    {
+        unsigned within = offset % PAGE_SIZE;
+        unsigned bytes = min(length, (unsigned) PAGE_SIZE - within);
+        RC rc = loadDataPage(offset / PAGE_SIZE);
+        if (rc)
+            return rc;
+        memcpy(out, (char *) cache + within, bytes);
+        out += bytes;
+        offset += bytes;
+        length -= bytes;
+    }
+    return SUCCESS;
+}
+
+RC CompressedFile::writeBytes(uint64_t offset, unsigned length, const char *in)
+{
+    while (length > 0)
+    {
+        unsigned within = offset % PAGE_SIZE;
+        unsigned bytes = min(length, (unsigned) PAGE_SIZE - within);
+        RC rc = loadDataPage(offset / PAGE_SIZE);
+        if (rc)
+            return rc;
+        memcpy((char *) cache + within, in, bytes);
+        if (data->writePage(cachedPage, cache))
+        {
+            cacheValid = false;
+            return FH_WRITE_FAILED;
+        }
+        in += bytes;
+        offset += bytes;
+        length -= bytes;
+    }
+    return SUCCESS;
+}
+
+RC CompressedFile::readPage(PageNum pageNum, void *data)
+{
+    if (pageNum >= numPages)
+        return FH_PAGE_DN_EXIST;
+    const PageExtent &extent = extents[pageNum];
+    uint64_t offset = (uint64_t) extent.sector * COMPRESSION_SECTOR_SIZE;
+    if (extent.codec == PAGE_CODEC_RAW)
+        return readBytes(offset, PAGE_SIZE, (char *) data);
+
+    char stored[PAGE_SIZE];
+    RC rc = readBytes(offset, extent.length, stored);
+    if (rc)
+        return rc;
+    if (!PageCodec::decompress(stored, extent.length, (char *) data, PAGE_SIZE))
+        return FH_READ_FAILED;
+    return SUCCESS;
+}
+
+RC CompressedFile::writePage(PageNum pageNum, const void *data)
+{
+    if (pageNum > numPages)
+        return FH_PAGE_DN_EXIST;
+
+    PageExtent extent;
+    memset(&extent, 0, sizeof(extent));
+    if (pageNum < numPages)
+        extent = extents[pageNum];
+
+    // Pages that don't save a sector are kept as they are
+    char stored[PAGE_SIZE];
+    const char *bytes = stored;
+    unsigned length = PageCodec::compress((const char *) data, PAGE_SIZE, stored, PAGE_SIZE - COMPRESSION_SECTOR_SIZE);
+    extent.codec = PAGE_CODEC_LZ;
+    if (length == 0)
+    {
+        bytes = (const char *) data;
+        length = PAGE_SIZE;
+        extent.codec = PAGE_CODEC_RAW;
+    }
+
+    // Move the page if it outgrew its sectors, give back the ones it no longer needs
+    uint32_t sectors = (length + COMPRESSION_SECTOR_SIZE - 1) / COMPRESSION_SECTOR_SIZE;
+    uint32_t previousEnd = endSector;
+    if (sectors > extent.sectors)
+    {
+        release(extent.sector, extent.sectors);
+        extent.sector = allocate(sectors);
+        extent.sectors = sectors;
+    }
+    else if (sectors < extent.sectors)
+    {
+        release(extent.sector + sectors, extent.sectors - sectors);
+        extent.sectors = sectors;
+    }
+    extent.length = length;
+
+    RC rc = writeBytes((uint64_t) extent.sector * COMPRESSION_SECTOR_SIZE, length, bytes);
+    if (rc)
+        return rc;
+    bool appended = pageNum == numPages;
+    if (appended)
+    {
+        extents.push_back(extent);
+        numPages++;
+    }
+    else
+        extents[pageNum] = extent;
+    rc = writeExtent(pageNum);
+    if (rc == SUCCESS && (appended || endSector != previousEnd))
+        rc = writeHeader();
+    return rc;
+}
+
+unsigned CompressedFile::getNumberOfPages()
+{
+    return numPages;
+}
+
+RC CompressedFile::truncate(unsigned numPages)
+{
+    if (numPages > this->numPages)
+        return FH_PAGE_DN_EXIST;
+    for (PageNum pageNum = numPages; pageNum < this->numPages; pageNum++)
+        release(extents[pageNum].sector, extents[pageNum].sectors);
+    extents.resize(numPages);
+    this->numPages = numPages;
+    return writeHeader();
+}
+
+unsigned long CompressedFile::getStoredBytes()
+{
+    return (unsigned long) (data->getNumberOfPages() + table->getNumberOfPages()) * PAGE_SIZE;
+}
@@ -0,0 +1,94 @@
+#ifndef _compression_h_
+#define _compression_h_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../rbf/pfm.h"
+
+using namespace std;
+
+// How a page of a compressed file is stored
+#define PAGE_CODEC_RAW          0
+#define PAGE_CODEC_LZ           1
+
+// Compressed pages take whole sectors of the data file
+#define COMPRESSION_SECTOR_SIZE 64
+
+// An LZ77 byte codec in the style of LZ4: a sequence of literal runs, each followed by a copy of
+// earlier output (2 byte offset, at least LZ_MIN_MATCH bytes). Free space and repeated values of
+// a page make long copies; runs longer than the offset copy over themselves.
+class PageCodec
+{
+public:
+    // Compress length bytes into at most capacity bytes of out. Returns the compressed size, 0 if it doesn't fit.
+    static unsigned compress(const char *in, unsigned length, char *out, unsigned capacity);
+    // Decompress into exactly length bytes of out. Returns whether the input was well formed.
+    static bool decompress(const char *in, unsigned inLength, char *out, unsigned length);
+};
+
+// Where a page of a compressed file is stored
+typedef struct PageExtent
+{
+    uint32_t sector;        // first sector in the data file
+    uint16_t length;        // bytes of the stored page
+    uint8_t codec;
+    uint8_t sectors;        // sectors held, the page can grow into them
+} PageExtent;
+
+// A file whose pages are compressed one by one when written and decompressed when read. The data
+// file (under the file's name) is a stream of sectors holding the stored pages back to back; its
+// page translation table lives in the paged file "<file>.ptt": page 0 has the number of pages and
+// the end of the sector stream, the following pages a PageExtent per page. A page that outgrows its
+// sectors moves to free ones; the sectors it leaves are reused by the next page that needs room.
+// Every handle on the file shares one CompressedFile, which keeps the last data page it touched so
+// that consecutive pages stored in it cost one read.
+class CompressedFile
+{
+public:
+    static string getTableFileName(const string &fileName);
+
+    // The translation table of an empty file on the device
+    static RC create(PageDevice *device, const string &fileName);
+    static RC destroy(PageDevice *device, const string &fileName);
+    // A handle on a compressed file of the device, for the caller to delete
+    static RC open(PageDevice *device, const string &fileName, PageFile *&file);
+    ~CompressedFile();
+
+    RC readPage(PageNum pageNum, void *data);
+    RC writePage(PageNum pageNum, const void *data);    // pageNum may be the page after the last
+    unsigned getNumberOfPages();
+    unsigned long getStoredBytes();                     // data file and translation table
+    RC truncate(unsigned numPages);                     // the sectors of the dropped pages are reused
+
+private:
+    CompressedFile();
+
+    RC load();
+    RC writeHeader();
+    RC writeExtent(PageNum pageNum);
+
+    uint32_t allocate(uint32_t sectors);
+    void release(uint32_t sector, uint32_t sectors);
+
+    // Bring a page of the data file into the cache; pages past its end read as zeros
+    RC loadDataPage(PageNum dataPage);
+    RC readBytes(uint64_t offset, unsigned length, char *out);
+    RC writeBytes(uint64_t offset, unsigned length, const char *in);
+
+    PageFile *data;
+    PageFile *table;
+    uint32_t numPages;
+    uint32_t endSector;                                 // sectors of the stream ever used
+    vector<PageExtent> extents;
+    map<uint32_t, uint32_t> freeSectors;                // first sector of a free run -> its length
+
+    void *cache;
+    PageNum cachedPage;
+    bool cacheValid;
+};
+
+#endif
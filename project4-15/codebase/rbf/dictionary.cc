@@ -0,0 +1,346 @@
+#include <cstring>
+
+#include "dictionary.h"
+#include "arena.h"
+
+// Bytes a value page starts with: how many of its bytes are used
+#define DICTIONARY_PAGE_HEADER_SIZE sizeof(uint32_t)
+// Bytes of a value entry before its characters: attribute index and length
+#define DICTIONARY_ENTRY_HEADER_SIZE (2 * sizeof(uint16_t))
+
+// Dictionaries loaded from their files, by record file name. RM opens a record file for every
+// tuple it reads or writes, which would otherwise read all the values every time.
+static map<string, Dictionary *> loadedDictionaries;
+
+string Dictionary::getFileName(const string &recordFileName)
+{
+    return recordFileName + ".dict";
+}
+
+RC Dictionary::addAttribute(const string &recordFileName, unsigned attrIndex)
+{
+    // Handles opened from now on get a dictionary that knows the new attribute
+    evict(recordFileName);
+
+    PagedFileManager *pfm = PagedFileManager::instance();
+    string fileName = getFileName(recordFileName);
+    bool created = pfm->createFile(fileName) == SUCCESS;
+
+    FileHandle fileHandle;
+    if (pfm->openFile(fileName, fileHandle))
+        return RBFM_OPEN_FAILED;
+
+    void *page = PageBufferPool::acquire();
+    RC rc = SUCCESS;
+    if (created)
+        memset(page, 0, PAGE_SIZE);
+    else if (fileHandle.readPage(0, page))
+        rc = RBFM_READ_FAILED;
+
+    uint32_t *header = (uint32_t *) page;
+    for (unsigned i = 0; rc == SUCCESS && i < header[0]; i++)
+    {
+        if (header[1 + i] == attrIndex)
+            rc = RBFM_DICTIONARY_FAILED;
+    }
+    if (rc == SUCCESS && header[0] >= DICTIONARY_MAX_ATTRIBUTES)
+        rc = RBFM_DICTIONARY_FAILED;
+    if (rc == SUCCESS)
+    {
+        header[1 + header[0]] = attrIndex;
+        header[0]++;
+        if (created)
+            rc = fileHandle.appendPage(page) ? RBFM_APPEND_FAILED : SUCCESS;
+        else
+            rc = fileHandle.writePage(0, page) ? RBFM_WRITE_FAILED : SUCCESS;
+    }
+    PageBufferPool::release(page);
+    pfm->closeFile(fileHandle);
+
+    if (rc != SUCCESS && created)
+        pfm->destroyFile(fileName);
+    return rc;
+}
+
+RC Dictionary::destroy(const string &recordFileName)
+{
+    evict(recordFileName);
+    return PagedFileManager::instance()->destroyFile(getFileName(recordFileName));
+}
+
+RC Dictionary::open(const string &recordFileName, Dictionary *&dictionary)
+{
+    auto it = loadedDictionaries.find(recordFileName);
+    if (it != loadedDictionaries.end())
+    {
+        dictionary = it->second;
+        dictionary->users++;
+        return SUCCESS;
+    }
+
+    dictionary = new Dictionary();
+    RC rc = PagedFileManager::instance()->openFile(getFileName(recordFileName), dictionary->fileHandle);
+    if (rc)
+    {
+        delete dictionary;
+        dictionary = NULL;
+        return rc == PFM_FILE_DN_EXIST ? SUCCESS : RBFM_DICTIONARY_FAILED;
+    }
+
+    void *page = PageBufferPool::acquire();
+    rc = dictionary->fileHandle.readPage(0, page) ? RBFM_DICTIONARY_FAILED : SUCCESS;
+    uint32_t *header = (uint32_t *) page;
+    for (unsigned i = 0; rc == SUCCESS && i < header[0] && i < DICTIONARY_MAX_ATTRIBUTES; i++)
+        dictionary->attrIndexes.push_back(header[1 + i]);
+    PageBufferPool::release(page);
+
+    dictionary->values.resize(dictionary->attrIndexes.size());
+    dictionary->codes.resize(dictionary->attrIndexes.size());
+    if (rc == SUCCESS && dictionary->load() != SUCCESS)
+        rc = RBFM_DICTIONARY_FAILED;
+    if (rc != SUCCESS || dictionary->attrIndexes.empty())
+    {
+        delete dictionary;
+        dictionary = NULL;
+        return rc;
+    }
+    dictionary->users = 1;
+    loadedDictionaries[recordFileName] = dictionary;
+    return SUCCESS;
+}
+
+void Dictionary::release(Dictionary *dictionary)
+{
+    if (dictionary == NULL)
+        return;
+    dictionary->users--;
+    if (dictionary->users == 0 && dictionary->evicted)
+        delete dictionary;
+}
+
+void Dictionary::evict(const string &recordFileName)
+{
+    auto it = loadedDictionaries.find(recordFileName);
+    if (it == loadedDictionaries.end())
+        return;
+    Dictionary *dictionary = it->second;
+    loadedDictionaries.erase(it);
+    dictionary->evicted = true;
+    if (dictionary->users == 0)
+        delete dictionary;
+}
+
+Dictionary::Dictionary()
+{
+    lastPage = 0;
+    lastPageUsed = 0;
+    users = 0;
+    evicted = false;
+}
+
+Dictionary::~Dictionary()
+{
+    PagedFileManager::instance()->closeFile(fileHandle);
+}
+
+bool Dictionary::isEncoded(unsigned attrIndex) const
+{
+    return findAttribute(attrIndex) >= 0;
+}
+
+int Dictionary::findAttribute(unsigned attrIndex) const
+{
+    for (unsigned i = 0; i < attrIndexes.size(); i++)
+    {
+        if (attrIndexes[i] == attrIndex)
+            return i;
+    }
+    return -1;
+}
+
+RC Dictionary::load()
+{
+    unsigned numPages = fileHandle.getNumberOfPages();
+    if (numPages <= 1)
+        return SUCCESS;
+
+    void *page = PageBufferPool::acquire();
+    for (PageNum pageNum = lastPage == 0 ? 1 : lastPage; pageNum < numPages; pageNum++)
+    {
+        if (fileHandle.readPage(pageNum, page))
+        {
+            PageBufferPool::release(page);
+            return RBFM_READ_FAILED;
+        }
+        uint32_t used;
+        memcpy(&used, page, DICTIONARY_PAGE_HEADER_SIZE);
+        uint32_t offset = pageNum == lastPage ? lastPageUsed : DICTIONARY_PAGE_HEADER_SIZE;
+        while (offset + DICTIONARY_ENTRY_HEADER_SIZE <= used)
+        {
+            uint16_t entry[2];
+            memcpy(entry, (char *) page + offset, DICTIONARY_ENTRY_HEADER_SIZE);
+            offset += DICTIONARY_ENTRY_HEADER_SIZE;
+            int i = findAttribute(entry[0]);
+            if (i >= 0)
+            {
+                string value((char *) page + offset, entry[1]);
+                codes[i][value] = values[i].size();
+                values[i].push_back(value);
+            }
+            offset += entry[1];
+        }
+        lastPage = pageNum;
+        lastPageUsed = offset;
+    }
+    PageBufferPool::release(page);
+    return SUCCESS;
+}
+
+RC Dictionary::encode(unsigned attrIndex, const char *value, uint32_t length, uint16_t &code)
+{
+    code = lookup(attrIndex, value, length);
+    if (code != DICTIONARY_NO_CODE)
+        return SUCCESS;
+
+    int i = findAttribute(attrIndex);
+    if (i < 0 || length > PAGE_SIZE - DICTIONARY_PAGE_HEADER_SIZE - DICTIONARY_ENTRY_HEADER_SIZE)
+        return RBFM_DICTIONARY_FAILED;
+    if (values[i].size() >= DICTIONARY_NO_CODE)
+        return RBFM_DICTIONARY_FULL;
+
+    // Add the value at the end of the last value page, or on a page of its own
+    void *page = PageBufferPool::acquire();
+    uint32_t entrySize = DICTIONARY_ENTRY_HEADER_SIZE + length;
+    bool append = lastPage == 0 || lastPageUsed + entrySize > PAGE_SIZE;
+    RC rc = SUCCESS;
+    if (append)
+    {
+        memset(page, 0, PAGE_SIZE);
+        lastPageUsed = DICTIONARY_PAGE_HEADER_SIZE;
+    }
+    else if (fileHandle.readPage(lastPage, page))
+        rc = RBFM_READ_FAILED;
+
+    if (rc == SUCCESS)
+    {
+        uint16_t entry[2] = {(uint16_t) attrIndex, (uint16_t) length};
+        memcpy((char *) page + lastPageUsed, entry, DICTIONARY_ENTRY_HEADER_SIZE);
+        memcpy((char *) page + lastPageUsed + DICTIONARY_ENTRY_HEADER_SIZE, value, length);
+        uint32_t used = lastPageUsed + entrySize;
+        memcpy(page, &used, DICTIONARY_PAGE_HEADER_SIZE);
+        if (append)
+            rc = fileHandle.appendPage(page) ? RBFM_APPEND_FAILED : SUCCESS;
+        else
+            rc = fileHandle.writePage(lastPage, page) ? RBFM_WRITE_FAILED : SUCCESS;
+    }
+    PageBufferPool::release(page);
+    if (rc != SUCCESS)
+        return rc;
+
+    if (append)
+        lastPage = fileHandle.getNumberOfPages() - 1;
+    lastPageUsed += entrySize;
+    code = values[i].size();
+    string newValue(value, length);
+    codes[i][newValue] = code;
+    values[i].push_back(newValue);
+    return SUCCESS;
+}
+
+uint16_t Dictionary::lookup(unsigned attrIndex, const char *value, uint32_t length)
+{
+    int i = findAttribute(attrIndex);
+    if (i < 0)
+        return DICTIONARY_NO_CODE;
+    string key(value, length);
+    auto it = codes[i].find(key);
+    // Another handle may have given it a code since
+    if (it == codes[i].end() && load() == SUCCESS)
+        it = codes[i].find(key);
+    return it == codes[i].end() ? DICTIONARY_NO_CODE : it->second;
+}
+
+const string *Dictionary::decode(unsigned attrIndex, uint16_t code)
+{
+    int i = findAttribute(attrIndex);
+    if (i < 0)
+        return NULL;
+    if (code >= values[i].size() && load() != SUCCESS)
+        return NULL;
+    return code < values[i].size() ? &values[i][code] : NULL;
+}
+
+RC Dictionary::encodeRecord(const vector<Attribute> &recordDescriptor, const void *data, vector<char> &encoded)
+{
+    unsigned nullIndicatorSize = (recordDescriptor.size() + CHAR_BIT - 1) / CHAR_BIT;
+    const char *in = (const char *) data;
+    encoded.assign(in, in + nullIndicatorSize);
+    unsigned offset = nullIndicatorSize;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        if (in[i / CHAR_BIT] & (1 << (CHAR_BIT - 1 - i % CHAR_BIT)))
+            continue;
+        unsigned size = INT_SIZE;
+        if (recordDescriptor[i].type == TypeVarChar)
+        {
+            uint32_t length;
+            memcpy(&length, in + offset, VARCHAR_LENGTH_SIZE);
+            if (isEncoded(i))
+            {
+                uint16_t code;
+                RC rc = encode(i, in + offset + VARCHAR_LENGTH_SIZE, length, code);
+                if (rc != SUCCESS)
+                    return rc;
+                uint32_t codeLength = DICTIONARY_CODE_SIZE;
+                encoded.insert(encoded.end(), (char *) &codeLength, (char *) &codeLength + VARCHAR_LENGTH_SIZE);
+                encoded.insert(encoded.end(), (char *) &code, (char *) &code + DICTIONARY_CODE_SIZE);
+                offset += VARCHAR_LENGTH_SIZE + length;
+                continue;
+            }
+            size = VARCHAR_LENGTH_SIZE + length;
+        }
+        encoded.insert(encoded.end(), in + offset, in + offset + size);
+        offset += size;
+    }
+    return SUCCESS;
+}
+
+RC Dictionary::decodeRecord(const vector<Attribute> &recordDescriptor, const void *encoded, void *data)
+{
+    unsigned nullIndicatorSize = (recordDescriptor.size() + CHAR_BIT - 1) / CHAR_BIT;
+    const char *in = (const char *) encoded;
+    char *out = (char *) data;
+    memcpy(out, in, nullIndicatorSize);
+    unsigned inOffset = nullIndicatorSize;
+    unsigned outOffset = nullIndicatorSize;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        if (in[i / CHAR_BIT] & (1 << (CHAR_BIT - 1 - i % CHAR_BIT)))
+            continue;
+        unsigned size = INT_SIZE;
+        if (recordDescriptor[i].type == TypeVarChar)
+        {
+            uint32_t length;
+            memcpy(&length, in + inOffset, VARCHAR_LENGTH_SIZE);
+            if (isEncoded(i))
+            {
+                uint16_t code;
+                memcpy(&code, in + inOffset + VARCHAR_LENGTH_SIZE, DICTIONARY_CODE_SIZE);
+                const string *value = decode(i, code);
+                if (value == NULL)
+                    return RBFM_DICTIONARY_FAILED;
+                uint32_t valueLength = value->size();
+                memcpy(out + outOffset, &valueLength, VARCHAR_LENGTH_SIZE);
+                memcpy(out + outOffset + VARCHAR_LENGTH_SIZE, value->data(), valueLength);
+                inOffset += VARCHAR_LENGTH_SIZE + length;
+                outOffset += VARCHAR_LENGTH_SIZE + valueLength;
+                continue;
+            }
+            size = VARCHAR_LENGTH_SIZE + length;
+        }
+        memmove(out + outOffset, in + inOffset, size);
+        inOffset += size;
+        outOffset += size;
+    }
+    return SUCCESS;
+}
@@ -0,0 +1,74 @@
+#ifndef _dictionary_h_
+#define _dictionary_h_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../rbf/pfm.h"
+#include "../rbf/rbfm.h"
+
+using namespace std;
+
+// Bytes of the code an encoded varchar is stored as
+#define DICTIONARY_CODE_SIZE    2
+// Never given out: the code of values that aren't in the dictionary
+#define DICTIONARY_NO_CODE      0xFFFF
+// Attributes one dictionary file can encode
+#define DICTIONARY_MAX_ATTRIBUTES 32
+
+// The dictionaries of the encoded varchar attributes of a record file. Records store the value of
+// such an attribute as a varchar of DICTIONARY_CODE_SIZE bytes, its code. Codes are given out in
+// the order values first show up, from 0. The dictionaries live in the paged file
+// "<record file>.dict": page 0 lists the encoded attributes (count, then index in the record
+// descriptor of each), the following pages hold the values in code order. A value page starts with
+// the bytes it uses, then has an entry per value: attribute index, length and characters.
+class Dictionary
+{
+public:
+    static string getFileName(const string &recordFileName);
+
+    // Encode one more attribute, creating the dictionary file if there is none
+    static RC addAttribute(const string &recordFileName, unsigned attrIndex);
+    static RC destroy(const string &recordFileName);
+    // The dictionary of the record file, NULL if it has none. Fails if the dictionary file exists
+    // but can't be read. A dictionary stays loaded after its last release, for the next open.
+    static RC open(const string &recordFileName, Dictionary *&dictionary);
+    static void release(Dictionary *dictionary);
+    ~Dictionary();
+
+    bool isEncoded(unsigned attrIndex) const;
+
+    // The code of a value, given out now if the value is new
+    RC encode(unsigned attrIndex, const char *value, uint32_t length, uint16_t &code);
+    // The code of a value, DICTIONARY_NO_CODE if it has none
+    uint16_t lookup(unsigned attrIndex, const char *value, uint32_t length);
+    // The value of a code, NULL if there is no such code
+    const string *decode(unsigned attrIndex, uint16_t code);
+
+    // Copy a record in API format, with codes in place of the values of the encoded attributes and the other way around
+    RC encodeRecord(const vector<Attribute> &recordDescriptor, const void *data, vector<char> &encoded);
+    RC decodeRecord(const vector<Attribute> &recordDescriptor, const void *encoded, void *data);
+
+private:
+    Dictionary();
+
+    // Read the values added since the last load, by this dictionary or another one of the same file
+    RC load();
+    int findAttribute(unsigned attrIndex) const;
+    // Stop handing out the loaded dictionary of the record file, deleting it once it is released
+    static void evict(const string &recordFileName);
+
+    FileHandle fileHandle;
+    vector<unsigned> attrIndexes;
+    vector<vector<string> > values;             // per encoded attribute, indexed by code
+    vector<map<string, uint16_t> > codes;
+    PageNum lastPage;                           // the value page load() stopped in, 0 before the first
+    uint32_t lastPageUsed;                      // and the bytes of it already read
+
+    unsigned users;                             // open file handles using it
+    bool evicted;
+};
+
+#endif
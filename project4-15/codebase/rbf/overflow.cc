@@ -0,0 +1,416 @@
+#include <cstring>
+
+#include "overflow.h"
+#include "arena.h"
+#include "compression.h"
+
+// Bytes the header page starts with: the first free page and the number of attributes
+#define OVERFLOW_HEADER_SIZE (2 * sizeof(uint32_t))
+// Bytes a chain page starts with: the next page and how many bytes of the value it has
+#define OVERFLOW_PAGE_HEADER_SIZE (2 * sizeof(uint32_t))
+#define OVERFLOW_PAGE_CAPACITY (PAGE_SIZE - OVERFLOW_PAGE_HEADER_SIZE)
+
+string OverflowFile::getFileName(const string &recordFileName)
+{
+    return recordFileName + ".ovf";
+}
+
+RC OverflowFile::addAttribute(const string &recordFileName, unsigned attrIndex, unsigned threshold, bool compress)
+{
+    PagedFileManager *pfm = PagedFileManager::instance();
+    string fileName = getFileName(recordFileName);
+    bool created = pfm->createFile(fileName) == SUCCESS;
+
+    FileHandle fileHandle;
+    if (pfm->openFile(fileName, fileHandle))
+        return RBFM_OPEN_FAILED;
+
+    void *page = PageBufferPool::acquire();
+    RC rc = SUCCESS;
+    if (created)
+        memset(page, 0, PAGE_SIZE);
+    else if (fileHandle.readPage(0, page))
+        rc = RBFM_READ_FAILED;
+
+    uint32_t *header = (uint32_t *) page;
+    OverflowAttribute *entries = (OverflowAttribute *) ((char *) page + OVERFLOW_HEADER_SIZE);
+    for (unsigned i = 0; rc == SUCCESS && i < header[1]; i++)
+    {
+        if (entries[i].attrIndex == attrIndex)
+            rc = RBFM_OVERFLOW_FAILED;
+    }
+    if (rc == SUCCESS && header[1] >= OVERFLOW_MAX_ATTRIBUTES)
+        rc = RBFM_OVERFLOW_FAILED;
+    if (rc == SUCCESS)
+    {
+        entries[header[1]].attrIndex = attrIndex;
+        entries[header[1]].threshold = threshold;
+        entries[header[1]].compress = compress;
+        header[1]++;
+        if (created)
+            rc = fileHandle.appendPage(page) ? RBFM_APPEND_FAILED : SUCCESS;
+        else
+            rc = fileHandle.writePage(0, page) ? RBFM_WRITE_FAILED : SUCCESS;
+    }
+    PageBufferPool::release(page);
+    pfm->closeFile(fileHandle);
+
+    if (rc != SUCCESS && created)
+        pfm->destroyFile(fileName);
+    return rc;
+}
+
+RC OverflowFile::destroy(const string &recordFileName)
+{
+    return PagedFileManager::instance()->destroyFile(getFileName(recordFileName));
+}
+
+RC OverflowFile::open(const string &recordFileName, OverflowFile *&overflow)
+{
+    overflow = new OverflowFile();
+    RC rc = PagedFileManager::instance()->openFile(getFileName(recordFileName), overflow->fileHandle);
+    if (rc)
+    {
+        delete overflow;
+        overflow = NULL;
+        return rc == PFM_FILE_DN_EXIST ? SUCCESS : RBFM_OVERFLOW_FAILED;
+    }
+
+    void *page = PageBufferPool::acquire();
+    rc = overflow->fileHandle.readPage(0, page) ? RBFM_OVERFLOW_FAILED : SUCCESS;
+    uint32_t *header = (uint32_t *) page;
+    OverflowAttribute *entries = (OverflowAttribute *) ((char *) page + OVERFLOW_HEADER_SIZE);
+    for (unsigned i = 0; rc == SUCCESS && i < header[1] && i < OVERFLOW_MAX_ATTRIBUTES; i++)
+        overflow->attributes.push_back(entries[i]);
+    PageBufferPool::release(page);
+
+    if (rc != SUCCESS || overflow->attributes.empty())
+    {
+        delete overflow;
+        overflow = NULL;
+    }
+    return rc;
+}
+
+OverflowFile::OverflowFile()
+{
+}
+
+OverflowFile::~OverflowFile()
+{
+    PagedFileManager::instance()->closeFile(fileHandle);
+}
+
+bool OverflowFile::isOutOfLine(unsigned attrIndex) const
+{
+    return findAttribute(attrIndex) >= 0;
+}
+
+int OverflowFile::findAttribute(unsigned attrIndex) const
+{
+    for (unsigned i = 0; i < attributes.size(); i++)
+    {
+        if (attributes[i].attrIndex == attrIndex)
+            return i;
+    }
+    return -1;
+}
+
+RC OverflowFile::storeRecord(const vector<Attribute> &recordDescriptor, const void *data, vector<char> &stored)
+{
+    return storeFields(recordDescriptor, data, -1, stored);
+}
+
+RC OverflowFile::storeAttribute(const vector<Attribute> &recordDescriptor, const void *data, unsigned attrIndex, vector<char> &stored)
+{
+    if (!isOutOfLine(attrIndex))
+        return RBFM_OVERFLOW_FAILED;
+    return storeFields(recordDescriptor, data, attrIndex, stored);
+}
+
+RC OverflowFile::storeFields(const vector<Attribute> &recordDescriptor, const void *data, int attrIndex, vector<char> &stored)
+{
+    unsigned nullIndicatorSize = (recordDescriptor.size() + CHAR_BIT - 1) / CHAR_BIT;
+    const char *in = (const char *) data;
+    stored.assign(in, in + nullIndicatorSize);
+    unsigned offset = nullIndicatorSize;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        if (in[i / CHAR_BIT] & (1 << (CHAR_BIT - 1 - i % CHAR_BIT)))
+            continue;
+        unsigned size = INT_SIZE;
+        if (recordDescriptor[i].type == TypeVarChar)
+        {
+            uint32_t length;
+            memcpy(&length, in + offset, VARCHAR_LENGTH_SIZE);
+            int a = attrIndex < 0 || (unsigned) attrIndex == i ? findAttribute(i) : -1;
+            if (a >= 0)
+            {
+                RC rc = storeValue(a, in + offset + VARCHAR_LENGTH_SIZE, length, stored);
+                if (rc != SUCCESS)
+                    return rc;
+                offset += VARCHAR_LENGTH_SIZE + length;
+                continue;
+            }
+            size = VARCHAR_LENGTH_SIZE + length;
+        }
+        stored.insert(stored.end(), in + offset, in + offset + size);
+        offset += size;
+    }
+    return SUCCESS;
+}
+
+RC OverflowFile::storeValue(unsigned i, const char *value, uint32_t length, vector<char> &stored)
+{
+    uint32_t fieldLength;
+    if (length <= attributes[i].threshold)
+    {
+        fieldLength = 1 + length;
+        stored.insert(stored.end(), (char *) &fieldLength, (char *) &fieldLength + VARCHAR_LENGTH_SIZE);
+        stored.push_back(OVERFLOW_INLINE);
+        stored.insert(stored.end(), value, value + length);
+        return SUCCESS;
+    }
+
+    OverflowPointer pointer;
+    pointer.length = length;
+    pointer.storedLength = length;
+    pointer.codec = PAGE_CODEC_RAW;
+    const char *bytes = value;
+    vector<char> compressed;
+    if (attributes[i].compress)
+    {
+        // Only when it saves bytes
+        compressed.resize(length);
+        unsigned size = PageCodec::compress(value, length, compressed.data(), length - 1);
+        if (size > 0)
+        {
+            bytes = compressed.data();
+            pointer.storedLength = size;
+            pointer.codec = PAGE_CODEC_LZ;
+        }
+    }
+    RC rc = writeChain(bytes, pointer.storedLength, pointer.pageNum);
+    if (rc != SUCCESS)
+        return rc;
+
+    fieldLength = 1 + sizeof(OverflowPointer);
+    stored.insert(stored.end(), (char *) &fieldLength, (char *) &fieldLength + VARCHAR_LENGTH_SIZE);
+    stored.push_back(OVERFLOW_CHAINED);
+    stored.insert(stored.end(), (char *) &pointer, (char *) &pointer + sizeof(OverflowPointer));
+    return SUCCESS;
+}
+
+RC OverflowFile::fetchRecord(const vector<Attribute> &recordDescriptor, const void *stored, void *data)
+{
+    unsigned nullIndicatorSize = (recordDescriptor.size() + CHAR_BIT - 1) / CHAR_BIT;
+    const char *in = (const char *) stored;
+    char *out = (char *) data;
+    memcpy(out, in, nullIndicatorSize);
+    unsigned inOffset = nullIndicatorSize;
+    unsigned outOffset = nullIndicatorSize;
+    vector<char> buffer;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        if (in[i / CHAR_BIT] & (1 << (CHAR_BIT - 1 - i % CHAR_BIT)))
+            continue;
+        unsigned size = INT_SIZE;
+        if (recordDescriptor[i].type == TypeVarChar)
+        {
+            uint32_t length;
+            memcpy(&length, in + inOffset, VARCHAR_LENGTH_SIZE);
+            if (isOutOfLine(i))
+            {
+                const char *value = in + inOffset + VARCHAR_LENGTH_SIZE;
+                uint32_t valueLength = length;
+                RC rc = fetchValue(value, valueLength, buffer);
+                if (rc != SUCCESS)
+                    return rc;
+                memcpy(out + outOffset, &valueLength, VARCHAR_LENGTH_SIZE);
+                memcpy(out + outOffset + VARCHAR_LENGTH_SIZE, value, valueLength);
+                inOffset += VARCHAR_LENGTH_SIZE + length;
+                outOffset += VARCHAR_LENGTH_SIZE + valueLength;
+                continue;
+            }
+            size = VARCHAR_LENGTH_SIZE + length;
+        }
+        memcpy(out + outOffset, in + inOffset, size);
+        inOffset += size;
+        outOffset += size;
+    }
+    return SUCCESS;
+}
+
+RC OverflowFile::fetchValue(const char *&field, uint32_t &length, vector<char> &buffer)
+{
+    if (length >= 1 && field[0] == OVERFLOW_INLINE)
+    {
+        field++;
+        length--;
+        return SUCCESS;
+    }
+    if (length != 1 + sizeof(OverflowPointer) || field[0] != OVERFLOW_CHAINED)
+        return RBFM_OVERFLOW_FAILED;
+
+    OverflowPointer pointer;
+    memcpy(&pointer, field + 1, sizeof(OverflowPointer));
+    buffer.resize(pointer.length);
+    RC rc;
+    if (pointer.codec == PAGE_CODEC_RAW)
+        rc = readChain(pointer.pageNum, pointer.length, buffer.data());
+    else
+    {
+        vector<char> compressed(pointer.storedLength);
+        rc = readChain(pointer.pageNum, pointer.storedLength, compressed.data());
+        if (rc == SUCCESS && !PageCodec::decompress(compressed.data(), pointer.storedLength, buffer.data(), pointer.length))
+            rc = RBFM_OVERFLOW_FAILED;
+    }
+    if (rc != SUCCESS)
+        return rc;
+    field = buffer.data();
+    length = pointer.length;
+    return SUCCESS;
+}
+
+RC OverflowFile::freeRecord(const vector<Attribute> &recordDescriptor, const void *stored)
+{
+    unsigned nullIndicatorSize = (recordDescriptor.size() + CHAR_BIT - 1) / CHAR_BIT;
+    const char *in = (const char *) stored;
+    unsigned offset = nullIndicatorSize;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        if (in[i / CHAR_BIT] & (1 << (CHAR_BIT - 1 - i % CHAR_BIT)))
+            continue;
+        if (recordDescriptor[i].type != TypeVarChar)
+        {
+            offset += INT_SIZE;
+            continue;
+        }
+        uint32_t length;
+        memcpy(&length, in + offset, VARCHAR_LENGTH_SIZE);
+        const char *field = in + offset + VARCHAR_LENGTH_SIZE;
+        if (isOutOfLine(i) && length == 1 + sizeof(OverflowPointer) && field[0] == OVERFLOW_CHAINED)
+        {
+            OverflowPointer pointer;
+            memcpy(&pointer, field + 1, sizeof(OverflowPointer));
+            RC rc = freeChain(pointer.pageNum);
+            if (rc != SUCCESS)
+                return rc;
+        }
+        offset += VARCHAR_LENGTH_SIZE + length;
+    }
+    return SUCCESS;
+}
+
+RC OverflowFile::writeChain(const char *bytes, uint32_t length, PageNum &firstPage)
+{
+    unsigned count = (length + OVERFLOW_PAGE_CAPACITY - 1) / OVERFLOW_PAGE_CAPACITY;
+    if (count == 0)
+        count = 1;
+
+    // Pages of the free list first, then new ones at the end of the file. Other handles of the
+    // file may have changed the free list, so the header is read again.
+    void *page = PageBufferPool::acquire();
+    if (fileHandle.readPage(0, page))
+    {
+        PageBufferPool::release(page);
+        return RBFM_READ_FAILED;
+    }
+    uint32_t *header = (uint32_t *) page;
+    uint32_t freeHead = header[0];
+    unsigned numPages = fileHandle.getNumberOfPages();
+    vector<PageNum> pages;
+    RC rc = SUCCESS;
+    while (rc == SUCCESS && pages.size() < count && freeHead != OVERFLOW_NO_PAGE)
+    {
+        pages.push_back(freeHead);
+        if (fileHandle.readPage(freeHead, page))
+            rc = RBFM_READ_FAILED;
+        else
+            memcpy(&freeHead, page, sizeof(uint32_t));
+    }
+    for (PageNum next = numPages; pages.size() < count; next++)
+        pages.push_back(next);
+    if (rc == SUCCESS && pages[0] < numPages)
+    {
+        if (fileHandle.readPage(0, page))
+            rc = RBFM_READ_FAILED;
+        header[0] = freeHead;
+        if (rc == SUCCESS && fileHandle.writePage(0, page))
+            rc = RBFM_WRITE_FAILED;
+    }
+
+    // The chain, in page order where it is appended
+    for (unsigned i = 0; rc == SUCCESS && i < count; i++)
+    {
+        uint32_t pageHeader[2];
+        pageHeader[0] = i + 1 < count ? pages[i + 1] : OVERFLOW_NO_PAGE;
+        pageHeader[1] = i + 1 < count ? OVERFLOW_PAGE_CAPACITY : length - i * OVERFLOW_PAGE_CAPACITY;
+        memset(page, 0, PAGE_SIZE);
+        memcpy(page, pageHeader, OVERFLOW_PAGE_HEADER_SIZE);
+        memcpy((char *) page + OVERFLOW_PAGE_HEADER_SIZE, bytes + i * OVERFLOW_PAGE_CAPACITY, pageHeader[1]);
+        if (pages[i] < numPages)
+            rc = fileHandle.writePage(pages[i], page) ? RBFM_WRITE_FAILED : SUCCESS;
+        else
+            rc = fileHandle.appendPage(page) ? RBFM_APPEND_FAILED : SUCCESS;
+    }
+    PageBufferPool::release(page);
+    firstPage = pages[0];
+    return rc;
+}
+
+RC OverflowFile::readChain(PageNum pageNum, uint32_t length, char *out)
+{
+    void *page = PageBufferPool::acquire();
+    uint32_t offset = 0;
+    while (offset < length && pageNum != OVERFLOW_NO_PAGE)
+    {
+        if (fileHandle.readPage(pageNum, page))
+        {
+            PageBufferPool::release(page);
+            return RBFM_READ_FAILED;
+        }
+        uint32_t pageHeader[2];
+        memcpy(pageHeader, page, OVERFLOW_PAGE_HEADER_SIZE);
+        uint32_t used = pageHeader[1] < length - offset ? pageHeader[1] : length - offset;
+        memcpy(out + offset, (char *) page + OVERFLOW_PAGE_HEADER_SIZE, used);
+        offset += used;
+        pageNum = pageHeader[0];
+    }
+    PageBufferPool::release(page);
+    return offset == length ? SUCCESS : RBFM_OVERFLOW_FAILED;
+}
+
+RC OverflowFile::freeChain(PageNum firstPage)
+{
+    // Find the last page of the chain, which goes in front of the free list
+    void *page = PageBufferPool::acquire();
+    PageNum last = firstPage;
+    uint32_t next = firstPage;
+    RC rc = SUCCESS;
+    while (rc == SUCCESS && next != OVERFLOW_NO_PAGE)
+    {
+        last = next;
+        if (fileHandle.readPage(last, page))
+            rc = RBFM_READ_FAILED;
+        else
+            memcpy(&next, page, sizeof(uint32_t));
+    }
+
+    uint32_t freeHead = OVERFLOW_NO_PAGE;
+    void *headerPage = PageBufferPool::acquire();
+    if (rc == SUCCESS && fileHandle.readPage(0, headerPage))
+        rc = RBFM_READ_FAILED;
+    if (rc == SUCCESS)
+    {
+        uint32_t *header = (uint32_t *) headerPage;
+        freeHead = header[0];
+        header[0] = firstPage;
+        memcpy(page, &freeHead, sizeof(uint32_t));
+        if (fileHandle.writePage(last, page) || fileHandle.writePage(0, headerPage))
+            rc = RBFM_WRITE_FAILED;
+    }
+    PageBufferPool::release(headerPage);
+    PageBufferPool::release(page);
+    return rc;
+}
@@ -0,0 +1,86 @@
+#ifndef _overflow_h_
+#define _overflow_h_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../rbf/pfm.h"
+#include "../rbf/rbfm.h"
+
+using namespace std;
+
+// The first byte of the stored value of an out-of-line attribute: the value follows, or an OverflowPointer to it
+#define OVERFLOW_INLINE         0
+#define OVERFLOW_CHAINED        1
+// Attributes one overflow file can hold the values of
+#define OVERFLOW_MAX_ATTRIBUTES 32
+// The next page of the last page of a chain: page 0 is the header
+#define OVERFLOW_NO_PAGE        0
+
+// Where a value stored out of line is
+typedef struct OverflowPointer
+{
+    uint32_t pageNum;           // first page of its chain
+    uint32_t length;            // bytes of the value
+    uint32_t storedLength;      // bytes in the chain, fewer than length when compressed
+    uint32_t codec;             // PAGE_CODEC_RAW or PAGE_CODEC_LZ
+} OverflowPointer;
+
+// An out-of-line attribute, as listed by the header page
+typedef struct OverflowAttribute
+{
+    uint32_t attrIndex;         // in the record descriptor
+    uint32_t threshold;         // longest value kept in the record
+    uint32_t compress;          // whether chains are compressed when that makes them shorter
+} OverflowAttribute;
+
+// The out-of-line varchar attributes of a record file. Records store the value of such an attribute
+// as a varchar that starts with a tag: OVERFLOW_INLINE and the value if it is no longer than the
+// attribute's threshold, OVERFLOW_CHAINED and an OverflowPointer otherwise. The longer values live
+// in the paged file "<record file>.ovf": page 0 has the first free page, the number of attributes
+// and an OverflowAttribute each; every other page starts with the next page of its chain (or of the
+// free list) and the bytes of the value it holds, then has them.
+class OverflowFile
+{
+public:
+    static string getFileName(const string &recordFileName);
+
+    // Store one more attribute out of line, creating the overflow file if there is none
+    static RC addAttribute(const string &recordFileName, unsigned attrIndex, unsigned threshold, bool compress);
+    static RC destroy(const string &recordFileName);
+    // The overflow file of the record file, NULL if it has none. Fails if the overflow file exists
+    // but can't be read.
+    static RC open(const string &recordFileName, OverflowFile *&overflow);
+    ~OverflowFile();
+
+    bool isOutOfLine(unsigned attrIndex) const;
+
+    // Copy a record in API format, tagging the values of the out-of-line attributes and moving the
+    // long ones to chains, and the other way around
+    RC storeRecord(const vector<Attribute> &recordDescriptor, const void *data, vector<char> &stored);
+    RC fetchRecord(const vector<Attribute> &recordDescriptor, const void *stored, void *data);
+    // The same for one attribute of a record stored before it was out of line, keeping the others as they are
+    RC storeAttribute(const vector<Attribute> &recordDescriptor, const void *data, unsigned attrIndex, vector<char> &stored);
+    // Point field and length at the value of a stored field: in the field itself, or read into buffer
+    RC fetchValue(const char *&field, uint32_t &length, vector<char> &buffer);
+    // Put the pages of the chains of a stored record on the free list
+    RC freeRecord(const vector<Attribute> &recordDescriptor, const void *stored);
+
+private:
+    OverflowFile();
+
+    int findAttribute(unsigned attrIndex) const;
+    // storeRecord of the out-of-line attribute attrIndex only, or of all of them if it is negative
+    RC storeFields(const vector<Attribute> &recordDescriptor, const void *data, int attrIndex, vector<char> &stored);
+    // Append the stored field of a value of the i-th out-of-line attribute
+    RC storeValue(unsigned i, const char *value, uint32_t length, vector<char> &stored);
+    RC writeChain(const char *bytes, uint32_t length, PageNum &firstPage);
+    RC readChain(PageNum pageNum, uint32_t length, char *out);
+    RC freeChain(PageNum firstPage);
+
+    FileHandle fileHandle;
+    vector<OverflowAttribute> attributes;
+};
+
+#endif
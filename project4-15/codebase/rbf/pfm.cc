@@ -1,10 +1,106 @@
+#include <algorithm>
+#include <cerrno>
 #include <cstdio>
+#include <cstring>
+#include <ctime>
 #include <string>
 
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include "pfm.h"
+#include "arena.h"
+#include "compression.h"
+
+// Block 0 of a file whose pages are larger than PAGE_SIZE
+#define FILE_HEADER_MAGIC "PFMPAGES"
+typedef struct FileHeader
+{
+    char magic[8];
+    uint32_t pageSize;
+} FileHeader;
+
+
+// A file of the device whose pages take pageSize / PAGE_SIZE consecutive blocks after its header
+class SizedPageFile : public PageFile
+{
+public:
+    SizedPageFile(PageFile *file, unsigned pageSize)
+    {
+        this->file = file;
+        this->pageSize = pageSize;
+        blocks = pageSize / PAGE_SIZE;
+    }
+
+    ~SizedPageFile() { delete file; };
+
+    RC readPage(PageNum pageNum, void *data)
+    {
+        if (pageNum >= getNumberOfPages())
+            return FH_PAGE_DN_EXIST;
+        return file->readPages(1 + pageNum * blocks, blocks, data);
+    }
+
+    RC writePage(PageNum pageNum, const void *data)
+    {
+        if (pageNum > getNumberOfPages())
+            return FH_PAGE_DN_EXIST;
+        return file->writePages(1 + pageNum * blocks, blocks, data);
+    }
+
+    RC appendPage(const void *data)
+    {
+        return writePage(getNumberOfPages(), data);
+    }
+
+    unsigned getNumberOfPages()
+    {
+        unsigned fileBlocks = file->getNumberOfPages();
+        return fileBlocks ? (fileBlocks - 1) / blocks : 0;
+    }
+
+    unsigned long getStoredBytes() { return file->getStoredBytes(); };
+    unsigned getPageSize() { return pageSize; };
+
+    RC truncate(unsigned numPages)
+    {
+        if (numPages > getNumberOfPages())
+            return FH_PAGE_DN_EXIST;
+        return file->truncate(1 + numPages * blocks);
+    }
+
+private:
+    PageFile *file;
+    unsigned pageSize;
+    unsigned blocks;
+};
+
+
+RC PageFile::readPages(PageNum pageNum, unsigned count, void *data)
+{
+    for (unsigned i = 0; i < count; i++)
+    {
+        RC rc = readPage(pageNum + i, (char *) data + (size_t) PAGE_SIZE * i);
+        if (rc)
+            return rc;
+    }
+    return SUCCESS;
+}
+
+
+RC PageFile::writePages(PageNum pageNum, unsigned count, const void *data)
+{
+    for (unsigned i = 0; i < count; i++)
+    {
+        RC rc = writePage(pageNum + i, (const char *) data + (size_t) PAGE_SIZE * i);
+        if (rc)
+            return rc;
+    }
+    return SUCCESS;
+}
+
 
 PagedFileManager* PagedFileManager::_pf_manager = NULL;
 
@@ -19,6 +115,7 @@ PagedFileManager* PagedFileManager::instance()
 
 PagedFileManager::PagedFileManager()
 {
+    device = &posixDevice;
 }
 
 
@@ -29,86 +126,195 @@ PagedFileManager::~PagedFileManager()
 
 RC PagedFileManager::createFile(const string &fileName)
 {
+    return createFile(fileName, false);
+}
+
+
+RC PagedFileManager::createFile(const string &fileName, bool compressed, unsigned pageSize)
+{
+    if (!isValidPageSize(pageSize) || (compressed && pageSize != PAGE_SIZE))
+        return PFM_BAD_PAGE_SIZE;
     // If the file already exists, error
-    if (fileExists(fileName))
+    if (device->fileExists(fileName))
         return PFM_FILE_EXISTS;
 
-    // Attempt to open the file for writing
-    FILE *pFile = fopen(fileName.c_str(), "wb");
-    // Return an error if we fail
-    if (pFile == NULL)
-        return PFM_OPEN_FAILED;
+    RC rc = device->createFile(fileName);
+    if (rc || (!compressed && pageSize == PAGE_SIZE))
+        return rc;
+    if (compressed)
+        rc = CompressedFile::create(device, fileName);
+    else
+    {
+        PageFile *file;
+        rc = device->openFile(fileName, file);
+        if (rc == SUCCESS)
+        {
+            void *block = PageBufferPool::acquire();
+            memset(block, 0, PAGE_SIZE);
+            FileHeader header;
+            memcpy(header.magic, FILE_HEADER_MAGIC, sizeof(header.magic));
+            header.pageSize = pageSize;
+            memcpy(block, &header, sizeof(FileHeader));
+            rc = file->appendPage(block);
+            PageBufferPool::release(block);
+            delete file;
+        }
+    }
+    if (rc)
+        device->destroyFile(fileName);
+    return rc;
+}
 
-    fclose (pFile);
-    return SUCCESS;
+
+bool PagedFileManager::isValidPageSize(unsigned pageSize)
+{
+    for (unsigned size = PAGE_SIZE; size <= MAX_PAGE_SIZE; size *= 2)
+    {
+        if (pageSize == size)
+            return true;
+    }
+    return false;
 }
 
 
 RC PagedFileManager::destroyFile(const string &fileName)
 {
-    // If file cannot be successfully removed, error
-    if (remove(fileName.c_str()) != 0)
-        return PFM_REMOVE_FAILED;
+    if (isCompressed(fileName))
+        CompressedFile::destroy(device, fileName);
+    return device->destroyFile(fileName);
+}
 
-    return SUCCESS;
+
+RC PagedFileManager::compressFile(const string &fileName)
+{
+    FileHandle fileHandle;
+    RC rc = openFile(fileName, fileHandle);
+    if (rc)
+        return rc;
+    if (fileHandle.getPageSize() != PAGE_SIZE)
+    {
+        closeFile(fileHandle);
+        return PFM_BAD_PAGE_SIZE;
+    }
+    unsigned numPages = fileHandle.getNumberOfPages();
+    vector<char> pages((size_t) numPages * PAGE_SIZE);
+    for (PageNum pageNum = 0; rc == SUCCESS && pageNum < numPages; pageNum++)
+        rc = fileHandle.readPage(pageNum, pages.data() + (size_t) PAGE_SIZE * pageNum);
+    closeFile(fileHandle);
+    if (rc)
+        return rc;
+
+    // Written back in order, the pages end up packed in the sectors
+    if ((rc = destroyFile(fileName)) || (rc = createFile(fileName, true)) || (rc = openFile(fileName, fileHandle)))
+        return rc;
+    for (PageNum pageNum = 0; rc == SUCCESS && pageNum < numPages; pageNum++)
+        rc = fileHandle.appendPage(pages.data() + (size_t) PAGE_SIZE * pageNum);
+    closeFile(fileHandle);
+    return rc;
+}
+
+
+bool PagedFileManager::isCompressed(const string &fileName)
+{
+    return device->fileExists(CompressedFile::getTableFileName(fileName));
 }
 
 
 RC PagedFileManager::openFile(const string &fileName, FileHandle &fileHandle)
 {
     // If this handle already has an open file, error
-    if (fileHandle.getfd() != NULL)
+    if (fileHandle.file != NULL)
         return PFM_HANDLE_IN_USE;
 
     // If the file doesn't exist, error
-    if (!fileExists(fileName.c_str()))
+    if (!device->fileExists(fileName))
         return PFM_FILE_DN_EXIST;
 
-    // Open the file for reading/writing in binary mode
-    FILE *pFile;
-    pFile = fopen(fileName.c_str(), "rb+");
-    // If we fail, error
-    if (pFile == NULL)
-        return PFM_OPEN_FAILED;
-
-    fileHandle.setfd(pFile);
+    RC rc;
+    if (isCompressed(fileName))
+        rc = CompressedFile::open(device, fileName, fileHandle.file);
+    else
+        rc = device->openFile(fileName, fileHandle.file);
+    if (rc)
+        return rc;
 
+    // Files with a header have larger pages
+    if (fileHandle.file->getNumberOfPages() > 0 && !isCompressed(fileName))
+    {
+        void *block = PageBufferPool::acquire();
+        FileHeader header;
+        rc = fileHandle.file->readPage(0, block);
+        memcpy(&header, block, sizeof(FileHeader));
+        PageBufferPool::release(block);
+        if (rc == SUCCESS && memcmp(header.magic, FILE_HEADER_MAGIC, sizeof(header.magic)) == 0)
+        {
+            if (!isValidPageSize(header.pageSize))
+                rc = PFM_BAD_PAGE_SIZE;
+            else
+                fileHandle.file = new SizedPageFile(fileHandle.file, header.pageSize);
+        }
+        if (rc)
+        {
+            delete fileHandle.file;
+            fileHandle.file = NULL;
+            return rc;
+        }
+    }
+    fileHandle.stats = StatsRegistry::instance()->getFileStats(fileName);
     return SUCCESS;
 }
 
 
 RC PagedFileManager::closeFile(FileHandle &fileHandle)
 {
-    FILE *pFile = fileHandle.getfd();
-
     // If not an open file, error
-    if (pFile == NULL)
+    if (fileHandle.file == NULL)
         return 1;
 
-    // Flush and close the file
-    fclose(pFile);
-
-    fileHandle.setfd(NULL);
+    delete fileHandle.file;
+    fileHandle.file = NULL;
+    fileHandle.stats = NULL;
 
     return SUCCESS;
 }
 
-// Check if a file already exists
-bool PagedFileManager::fileExists(const string &fileName)
+
+void PagedFileManager::setDevice(PageDevice *device)
 {
-    // If stat fails, we can safely assume the file doesn't exist
-    struct stat sb;
-    return stat(fileName.c_str(), &sb) == 0;
+    this->device = device ? device : &posixDevice;
+}
+
+
+PageDevice *PagedFileManager::getDevice()
+{
+    return device;
 }
 
 
+static uint64_t monotonicNanos()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+
+unsigned long FileHandle::totalReadPageCounter = 0;
+unsigned long FileHandle::totalWritePageCounter = 0;
+unsigned long FileHandle::totalAppendPageCounter = 0;
+
 FileHandle::FileHandle()
 {
     readPageCounter = 0;
     writePageCounter = 0;
     appendPageCounter = 0;
 
-    _fd = NULL;
+    file = NULL;
+    stats = NULL;
+    zoneMap = NULL;
+    dictionary = NULL;
+    overflow = NULL;
+    fillFactor = DEFAULT_FILL_FACTOR;
 }
 
 
@@ -119,80 +325,90 @@ FileHandle::~FileHandle()
 
 RC FileHandle::readPage(PageNum pageNum, void *data)
 {
-    if (_fd == NULL)
+    if (file == NULL)
         return -1;
-    // If pageNum doesn't exist, error
-    if (getNumberOfPages() < pageNum)
-        return FH_PAGE_DN_EXIST;
 
-    // Try to seek to the specified page
-    if (fseek(_fd, PAGE_SIZE * pageNum, SEEK_SET))
-        return FH_SEEK_FAILED;
-
-    // Try to read the specified page
-    if (fread(data, 1, PAGE_SIZE, _fd) != PAGE_SIZE)
-        return FH_READ_FAILED;
+    uint64_t start = monotonicNanos();
+    RC rc = file->readPage(pageNum, data);
+    if (rc)
+        return rc;
+    stats->readLatency.record(monotonicNanos() - start);
 
     readPageCounter++;
+    totalReadPageCounter++;
+    stats->reads++;
+    stats->bytesRead += file->getPageSize();
     return SUCCESS;
 }
 
 
 RC FileHandle::writePage(PageNum pageNum, const void *data)
 {
-    if (_fd == NULL)
+    if (file == NULL)
         return -1;
-    // Check if the page exists
-    if (getNumberOfPages() < pageNum)
-        return FH_PAGE_DN_EXIST;
 
-    // Seek to the start of the page
-    if (fseek(_fd, PAGE_SIZE * pageNum, SEEK_SET))
-        return FH_SEEK_FAILED;
+    uint64_t start = monotonicNanos();
+    RC rc = file->writePage(pageNum, data);
+    if (rc)
+        return rc;
+    stats->writeLatency.record(monotonicNanos() - start);
 
-    // Write the page
-    if (fwrite(data, 1, PAGE_SIZE, _fd) == PAGE_SIZE)
-    {
-        // Immediately commit changes to disk
-        fflush(_fd);
-        writePageCounter++;
-        return SUCCESS;
-    }
-    
-    return FH_WRITE_FAILED;
+    writePageCounter++;
+    totalWritePageCounter++;
+    stats->writes++;
+    stats->bytesWritten += file->getPageSize();
+    return SUCCESS;
 }
 
 
 RC FileHandle::appendPage(const void *data)
 {
-    if (_fd == NULL)
+    if (file == NULL)
         return -1;
-    // Seek to the end of the file
-    if (fseek(_fd, 0, SEEK_END))
-        return FH_SEEK_FAILED;
 
-    // Write the new page
-    if (fwrite(data, 1, PAGE_SIZE, _fd) == PAGE_SIZE)
-    {
-        fflush(_fd);
-        appendPageCounter++;
-        return SUCCESS;
-    }
-    return FH_WRITE_FAILED;
+    uint64_t start = monotonicNanos();
+    RC rc = file->appendPage(data);
+    if (rc)
+        return rc;
+    stats->appendLatency.record(monotonicNanos() - start);
+
+    appendPageCounter++;
+    totalAppendPageCounter++;
+    stats->appends++;
+    stats->bytesWritten += file->getPageSize();
+    return SUCCESS;
 }
 
 
 unsigned FileHandle::getNumberOfPages()
 {
-    if (_fd == NULL)
+    if (file == NULL)
         return 0;
-    // Use stat to get the file size
-    struct stat sb;
-    if (fstat(fileno(_fd), &sb) != 0)
-        // On error, return 0
+    return file->getNumberOfPages();
+}
+
+
+unsigned long FileHandle::getStoredBytes()
+{
+    if (file == NULL)
         return 0;
-    // Filesize is always PAGE_SIZE * number of pages
-    return sb.st_size / PAGE_SIZE;
+    return file->getStoredBytes();
+}
+
+
+unsigned FileHandle::getPageSize()
+{
+    if (file == NULL)
+        return PAGE_SIZE;
+    return file->getPageSize();
+}
+
+
+RC FileHandle::truncate(unsigned numPages)
+{
+    if (file == NULL)
+        return -1;
+    return file->truncate(numPages);
 }
 
 
@@ -204,12 +420,403 @@ RC FileHandle::collectCounterValues(unsigned &readPageCount, unsigned &writePage
     return SUCCESS;
 }
 
-void FileHandle::setfd(FILE *fd)
+
+// A file descriptor. The size isn't cached: other handles on the same file may append to it.
+class PosixPageFile : public PageFile
+{
+public:
+    PosixPageFile(int fd, bool direct) { this->fd = fd; this->direct = direct; };
+    ~PosixPageFile() { close(fd); };
+
+    RC readPage(PageNum pageNum, void *data)
+    {
+        if (direct && !isAligned(data))
+        {
+            void *page = PageBufferPool::acquire();
+            RC rc = readPage(pageNum, page);
+            memcpy(data, page, PAGE_SIZE);
+            PageBufferPool::release(page);
+            return rc;
+        }
+
+        ssize_t bytes = pread(fd, data, PAGE_SIZE, (off_t) PAGE_SIZE * pageNum);
+        // Nothing at all past the end of the file
+        if (bytes == 0)
+            return FH_PAGE_DN_EXIST;
+        if (bytes != PAGE_SIZE)
+            return FH_READ_FAILED;
+        return SUCCESS;
+    }
+
+    RC writePage(PageNum pageNum, const void *data)
+    {
+        if (direct && !isAligned(data))
+        {
+            void *page = PageBufferPool::acquire();
+            memcpy(page, data, PAGE_SIZE);
+            RC rc = writePage(pageNum, page);
+            PageBufferPool::release(page);
+            return rc;
+        }
+
+        // Check if the page exists
+        if (getNumberOfPages() < pageNum)
+            return FH_PAGE_DN_EXIST;
+        if (pwrite(fd, data, PAGE_SIZE, (off_t) PAGE_SIZE * pageNum) != PAGE_SIZE)
+            return FH_WRITE_FAILED;
+        return SUCCESS;
+    }
+
+    RC appendPage(const void *data)
+    {
+        return writePage(getNumberOfPages(), data);
+    }
+
+    RC readPages(PageNum pageNum, unsigned count, void *data)
+    {
+        if (direct && !isAligned(data))
+            return PageFile::readPages(pageNum, count, data);
+        ssize_t bytes = pread(fd, data, (size_t) PAGE_SIZE * count, (off_t) PAGE_SIZE * pageNum);
+        if (bytes == 0)
+            return FH_PAGE_DN_EXIST;
+        if (bytes != (ssize_t) PAGE_SIZE * count)
+            return FH_READ_FAILED;
+        return SUCCESS;
+    }
+
+    RC writePages(PageNum pageNum, unsigned count, const void *data)
+    {
+        if (direct && !isAligned(data))
+            return PageFile::writePages(pageNum, count, data);
+        if (getNumberOfPages() < pageNum)
+            return FH_PAGE_DN_EXIST;
+        if (pwrite(fd, data, (size_t) PAGE_SIZE * count, (off_t) PAGE_SIZE * pageNum) != (ssize_t) PAGE_SIZE * count)
+            return FH_WRITE_FAILED;
+        return SUCCESS;
+    }
+
+    unsigned getNumberOfPages()
+    {
+        // Use stat to get the file size
+        struct stat sb;
+        if (fstat(fd, &sb) != 0)
+            // On error, return 0
+            return 0;
+        // Filesize is always PAGE_SIZE * number of pages
+        return sb.st_size / PAGE_SIZE;
+    }
+
+    RC truncate(unsigned numPages)
+    {
+        if (numPages > getNumberOfPages())
+            return FH_PAGE_DN_EXIST;
+        if (ftruncate(fd, (off_t) PAGE_SIZE * numPages) != 0)
+            return FH_TRUNCATE_FAILED;
+        return SUCCESS;
+    }
+
+private:
+    int fd;
+    bool direct;
+
+    // Direct I/O transfers straight from and to the buffer, which has to be aligned
+    static bool isAligned(const void *data) { return (uintptr_t) data % PAGE_SIZE == 0; };
+};
+
+
+PosixPageDevice::PosixPageDevice(bool directIO)
+{
+    this->directIO = directIO;
+    bufferedFallbacks = 0;
+}
+
+
+RC PosixPageDevice::createFile(const string &fileName)
+{
+    // Attempt to create the file, failing if it exists
+    int fd = open(fileName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    // Return an error if we fail
+    if (fd < 0)
+        return PFM_OPEN_FAILED;
+
+    close(fd);
+    return SUCCESS;
+}
+
+
+RC PosixPageDevice::destroyFile(const string &fileName)
 {
-    _fd = fd;
+    // If file cannot be successfully removed, error
+    if (unlink(fileName.c_str()) != 0)
+        return PFM_REMOVE_FAILED;
+
+    return SUCCESS;
 }
 
-FILE *FileHandle::getfd()
+
+bool PosixPageDevice::fileExists(const string &fileName)
 {
-    return _fd;
-}
\ No newline at end of file
+    // If stat fails, we can safely assume the file doesn't exist
+    struct stat sb;
+    return stat(fileName.c_str(), &sb) == 0;
+}
+
+
+RC PosixPageDevice::openFile(const string &fileName, PageFile *&file)
+{
+    int fd = -1;
+    bool direct = false;
+#ifdef O_DIRECT
+    if (directIO)
+    {
+        fd = open(fileName.c_str(), O_RDWR | O_DIRECT);
+        // File systems without direct I/O reject the flag
+        if (fd < 0 && errno != EINVAL)
+            return PFM_OPEN_FAILED;
+        direct = fd >= 0;
+    }
+#endif
+
+    // Open the file for reading/writing
+    if (fd < 0)
+        fd = open(fileName.c_str(), O_RDWR);
+    // If we fail, error
+    if (fd < 0)
+        return PFM_OPEN_FAILED;
+
+#if !defined(O_DIRECT) && defined(F_NOCACHE)
+    if (directIO)
+        direct = fcntl(fd, F_NOCACHE, 1) == 0;
+#endif
+    if (directIO && !direct)
+        bufferedFallbacks++;
+
+    file = new PosixPageFile(fd, direct);
+    return SUCCESS;
+}
+
+
+bool PosixPageDevice::isDirectIO() const
+{
+    return directIO;
+}
+
+
+unsigned PosixPageDevice::getBufferedFallbacks() const
+{
+    return bufferedFallbacks;
+}
+
+
+// The pages of a file in one buffer, shared with the device and the other handles on it
+class MemoryPageFile : public PageFile
+{
+public:
+    MemoryPageFile(const shared_ptr<vector<char> > &pages) : pages(pages) {};
+
+    RC readPage(PageNum pageNum, void *data)
+    {
+        if (pageNum >= getNumberOfPages())
+            return FH_PAGE_DN_EXIST;
+        memcpy(data, pages->data() + (size_t) PAGE_SIZE * pageNum, PAGE_SIZE);
+        return SUCCESS;
+    }
+
+    RC writePage(PageNum pageNum, const void *data)
+    {
+        if (pageNum > getNumberOfPages())
+            return FH_PAGE_DN_EXIST;
+        if (pageNum == getNumberOfPages())
+            pages->resize(pages->size() + PAGE_SIZE);
+        memcpy(pages->data() + (size_t) PAGE_SIZE * pageNum, data, PAGE_SIZE);
+        return SUCCESS;
+    }
+
+    RC appendPage(const void *data)
+    {
+        return writePage(getNumberOfPages(), data);
+    }
+
+    RC readPages(PageNum pageNum, unsigned count, void *data)
+    {
+        if (pageNum + count > getNumberOfPages())
+            return FH_PAGE_DN_EXIST;
+        memcpy(data, pages->data() + (size_t) PAGE_SIZE * pageNum, (size_t) PAGE_SIZE * count);
+        return SUCCESS;
+    }
+
+    RC writePages(PageNum pageNum, unsigned count, const void *data)
+    {
+        if (pageNum > getNumberOfPages())
+            return FH_PAGE_DN_EXIST;
+        if (pageNum + count > getNumberOfPages())
+            pages->resize((size_t) PAGE_SIZE * (pageNum + count));
+        memcpy(pages->data() + (size_t) PAGE_SIZE * pageNum, data, (size_t) PAGE_SIZE * count);
+        return SUCCESS;
+    }
+
+    unsigned getNumberOfPages()
+    {
+        return pages->size() / PAGE_SIZE;
+    }
+
+    RC truncate(unsigned numPages)
+    {
+        if (numPages > getNumberOfPages())
+            return FH_PAGE_DN_EXIST;
+        pages->resize((size_t) PAGE_SIZE * numPages);
+        return SUCCESS;
+    }
+
+private:
+    shared_ptr<vector<char> > pages;
+};
+
+
+RC MemoryPageDevice::createFile(const string &fileName)
+{
+    if (fileExists(fileName))
+        return PFM_FILE_EXISTS;
+    files[fileName] = make_shared<vector<char> >();
+    return SUCCESS;
+}
+
+
+RC MemoryPageDevice::destroyFile(const string &fileName)
+{
+    if (files.erase(fileName) == 0)
+        return PFM_REMOVE_FAILED;
+    return SUCCESS;
+}
+
+
+bool MemoryPageDevice::fileExists(const string &fileName)
+{
+    return files.find(fileName) != files.end();
+}
+
+
+RC MemoryPageDevice::openFile(const string &fileName, PageFile *&file)
+{
+    auto found = files.find(fileName);
+    if (found == files.end())
+        return PFM_FILE_DN_EXIST;
+    file = new MemoryPageFile(found->second);
+    return SUCCESS;
+}
+
+
+// A file of the underlying device that waits on the LatencyPageDevice before every page transfer
+class LatencyPageFile : public PageFile
+{
+public:
+    LatencyPageFile(LatencyPageDevice *device, PageFile *file, unsigned readLatencyMicros, unsigned writeLatencyMicros)
+    {
+        this->device = device;
+        this->file = file;
+        this->readLatencyMicros = readLatencyMicros;
+        this->writeLatencyMicros = writeLatencyMicros;
+    }
+
+    ~LatencyPageFile() { delete file; };
+
+    RC readPage(PageNum pageNum, void *data)
+    {
+        device->wait(readLatencyMicros);
+        return file->readPage(pageNum, data);
+    }
+
+    RC writePage(PageNum pageNum, const void *data)
+    {
+        device->wait(writeLatencyMicros);
+        return file->writePage(pageNum, data);
+    }
+
+    RC appendPage(const void *data)
+    {
+        device->wait(writeLatencyMicros);
+        return file->appendPage(data);
+    }
+
+    RC readPages(PageNum pageNum, unsigned count, void *data)
+    {
+        device->wait(readLatencyMicros, count);
+        return file->readPages(pageNum, count, data);
+    }
+
+    RC writePages(PageNum pageNum, unsigned count, const void *data)
+    {
+        device->wait(writeLatencyMicros, count);
+        return file->writePages(pageNum, count, data);
+    }
+
+    unsigned getNumberOfPages()
+    {
+        return file->getNumberOfPages();
+    }
+
+    RC truncate(unsigned numPages)
+    {
+        device->wait(writeLatencyMicros);
+        return file->truncate(numPages);
+    }
+
+private:
+    LatencyPageDevice *device;
+    PageFile *file;
+    unsigned readLatencyMicros;
+    unsigned writeLatencyMicros;
+};
+
+
+LatencyPageDevice::LatencyPageDevice(PageDevice *device, unsigned readLatencyMicros, unsigned writeLatencyMicros, unsigned long bandwidth)
+{
+    this->device = device;
+    this->readLatencyMicros = readLatencyMicros;
+    this->writeLatencyMicros = writeLatencyMicros;
+    this->bandwidth = bandwidth;
+    busyUntil = 0;
+}
+
+
+RC LatencyPageDevice::createFile(const string &fileName)
+{
+    return device->createFile(fileName);
+}
+
+
+RC LatencyPageDevice::destroyFile(const string &fileName)
+{
+    return device->destroyFile(fileName);
+}
+
+
+bool LatencyPageDevice::fileExists(const string &fileName)
+{
+    return device->fileExists(fileName);
+}
+
+
+RC LatencyPageDevice::openFile(const string &fileName, PageFile *&file)
+{
+    PageFile *deviceFile;
+    RC rc = device->openFile(fileName, deviceFile);
+    if (rc)
+        return rc;
+    file = new LatencyPageFile(this, deviceFile, readLatencyMicros, writeLatencyMicros);
+    return SUCCESS;
+}
+
+
+// Requests queue behind each other like on a single disk, so the bandwidth holds across files
+void LatencyPageDevice::wait(unsigned latencyMicros, unsigned pages)
+{
+    uint64_t now = monotonicNanos();
+    uint64_t transfer = bandwidth ? (uint64_t) PAGE_SIZE * pages * 1000000000 / bandwidth : 0;
+    busyUntil = max(busyUntil, now) + (uint64_t) latencyMicros * 1000 + transfer;
+
+    struct timespec delay;
+    delay.tv_sec = (busyUntil - now) / 1000000000;
+    delay.tv_nsec = (busyUntil - now) % 1000000000;
+    while (nanosleep(&delay, &delay) != 0);
+}
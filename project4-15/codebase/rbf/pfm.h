@@ -9,23 +9,138 @@
 #define PFM_HANDLE_IN_USE 4
 #define PFM_FILE_DN_EXIST 5
 #define PFM_FILE_NOT_OPEN 6
+#define PFM_BAD_PAGE_SIZE 7
 
 #define FH_PAGE_DN_EXIST  1
 #define FH_SEEK_FAILED    2
 #define FH_READ_FAILED    3
 #define FH_WRITE_FAILED   4
+#define FH_TRUNCATE_FAILED 5
 
 typedef unsigned PageNum;
 typedef int RC;
 typedef char byte;
 
 #define PAGE_SIZE 4096
+// Files have pages of PAGE_SIZE times a power of 2, up to MAX_PAGE_SIZE. Devices store PAGE_SIZE blocks.
+#define MAX_PAGE_SIZE 65536
+// Inserts fill pages up to 100% by default
+#define DEFAULT_FILL_FACTOR 100
 #include <string>
 #include <climits>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "stats.h"
+
+class ZoneMap;
+class Dictionary;
+class OverflowFile;
+
 using namespace std;
 
 class FileHandle;
 
+
+// An open file of a PageDevice
+class PageFile
+{
+public:
+    virtual ~PageFile() {};
+
+    virtual RC readPage(PageNum pageNum, void *data) = 0;
+    virtual RC writePage(PageNum pageNum, const void *data) = 0;        // pageNum may be the page after the last
+    virtual RC appendPage(const void *data) = 0;
+    virtual unsigned getNumberOfPages() = 0;
+    // Bytes the file takes on its device
+    virtual unsigned long getStoredBytes() { return (unsigned long) getNumberOfPages() * PAGE_SIZE; };
+    virtual unsigned getPageSize() { return PAGE_SIZE; };
+    // Drop the pages from numPages on
+    virtual RC truncate(unsigned numPages) = 0;
+
+    // count consecutive pages in one transfer, where the device can
+    virtual RC readPages(PageNum pageNum, unsigned count, void *data);
+    virtual RC writePages(PageNum pageNum, unsigned count, const void *data);
+};
+
+
+// Where the files of the PagedFileManager keep their pages
+class PageDevice
+{
+public:
+    virtual ~PageDevice() {};
+
+    virtual RC createFile(const string &fileName) = 0;
+    virtual RC destroyFile(const string &fileName) = 0;
+    virtual bool fileExists(const string &fileName) = 0;
+    virtual RC openFile(const string &fileName, PageFile *&file) = 0;  // the caller deletes the file to close it
+};
+
+
+// Files in the file system, read and written with pread/pwrite.
+// With directIO, files are opened with O_DIRECT (F_NOCACHE where there is no O_DIRECT) so pages
+// bypass the OS page cache. Buffers that aren't PAGE_SIZE aligned are copied through an aligned one.
+// Files on file systems that reject direct I/O are opened buffered instead.
+class PosixPageDevice : public PageDevice
+{
+public:
+    PosixPageDevice(bool directIO = false);
+    RC createFile(const string &fileName);
+    RC destroyFile(const string &fileName);
+    bool fileExists(const string &fileName);
+    RC openFile(const string &fileName, PageFile *&file);
+
+    bool isDirectIO() const;
+    unsigned getBufferedFallbacks() const;              // files opened buffered although directIO is set
+
+private:
+    bool directIO;
+    unsigned bufferedFallbacks;
+};
+
+
+// Files in memory, gone with the device: for temporary tables and fast tests.
+// A destroyed file stays readable through the handles still open on it.
+class MemoryPageDevice : public PageDevice
+{
+public:
+    RC createFile(const string &fileName);
+    RC destroyFile(const string &fileName);
+    bool fileExists(const string &fileName);
+    RC openFile(const string &fileName, PageFile *&file);
+
+private:
+    map<string, shared_ptr<vector<char> > > files;
+};
+
+
+// Another device slowed down like a disk: every page read or write waits for the latency and its
+// transfer at the bandwidth, one request at a time
+class LatencyPageDevice : public PageDevice
+{
+public:
+    LatencyPageDevice(PageDevice *device,               // device holding the data
+                      unsigned readLatencyMicros,
+                      unsigned writeLatencyMicros,
+                      unsigned long bandwidth);         // bytes per second, 0 for unlimited
+    RC createFile(const string &fileName);
+    RC destroyFile(const string &fileName);
+    bool fileExists(const string &fileName);
+    RC openFile(const string &fileName, PageFile *&file);
+
+    // Hold the caller until a transfer of pages with the given latency would be done
+    void wait(unsigned latencyMicros, unsigned pages = 1);
+
+private:
+    PageDevice *device;
+    unsigned readLatencyMicros;
+    unsigned writeLatencyMicros;
+    unsigned long bandwidth;
+    uint64_t busyUntil;                                 // when the current request is done, in ns
+};
+
 class PagedFileManager
 {
 public:
@@ -36,6 +151,20 @@ public:
     RC openFile      (const string &fileName, FileHandle &fileHandle);  // Open a file
     RC closeFile     (FileHandle &fileHandle);                          // Close a file
 
+    // A file whose pages are compressed on the device (see CompressedFile), read and written like any
+    // other, or whose pages are pageSize bytes. A file with larger pages than PAGE_SIZE records its page
+    // size in a header block in front of them. Compressed files have PAGE_SIZE pages.
+    RC createFile    (const string &fileName, bool compressed, unsigned pageSize = PAGE_SIZE);
+    static bool isValidPageSize(unsigned pageSize);
+    // Rewrite a file that isn't open as a compressed file, packing its pages again if it already is one
+    RC compressFile  (const string &fileName);
+    bool isCompressed(const string &fileName);
+
+    // The device files are created on and opened from: the file system by default or after
+    // setDevice(NULL). Files opened before keep their device. The caller keeps ownership of the device.
+    void setDevice(PageDevice *device);
+    PageDevice *getDevice();
+
 protected:
     PagedFileManager();                                                 // Constructor
     ~PagedFileManager();                                                // Destructor
@@ -43,8 +172,8 @@ protected:
 private:
     static PagedFileManager *_pf_manager;
 
-    // Private helper methods
-    bool fileExists(const string &fileName);
+    PosixPageDevice posixDevice;
+    PageDevice *device;
 };
 
 
@@ -55,6 +184,22 @@ public:
     unsigned readPageCounter;
     unsigned writePageCounter;
     unsigned appendPageCounter;
+
+    // The same counters summed over every file handle, to attribute page I/O to the code that caused it
+    static unsigned long totalReadPageCounter;
+    static unsigned long totalWritePageCounter;
+    static unsigned long totalAppendPageCounter;
+
+    // The file's entry in the StatsRegistry while it is open, NULL otherwise
+    FileStats *stats;
+    // The zone map of a record file opened through RecordBasedFileManager, NULL if it has none
+    ZoneMap *zoneMap;
+    // Its dictionary of encoded varchar attributes, NULL if it has none
+    Dictionary *dictionary;
+    // Its out-of-line varchar attributes and their values, NULL if it has none
+    OverflowFile *overflow;
+    // Percentage of each page inserts fill, the rest is left for records to grow into
+    unsigned fillFactor;
     
     FileHandle();                                                       // Default constructor
     ~FileHandle();                                                      // Destructor
@@ -64,16 +209,15 @@ public:
     RC appendPage(const void *data);                                    // Append a specific page
     unsigned getNumberOfPages();                                        // Get the number of pages in the file
     RC collectCounterValues(unsigned &readPageCount, unsigned &writePageCount, unsigned &appendPageCount);  // Put the current counter values into variables
+    unsigned long getStoredBytes();                                     // Bytes the file takes on its device, less than its pages when compressed
+    unsigned getPageSize();                                             // Bytes of every page of the file
+    RC truncate(unsigned numPages);                                     // Drop the pages from numPages on
 
     // Let PagedFileManager access our private helper methods
     friend class PagedFileManager;
 
 private:
-    FILE *_fd;
-
-    // Private helper methods
-    void setfd(FILE *fd);
-    FILE *getfd();
+    PageFile *file;
 }; 
 
 #endif
@@ -0,0 +1,366 @@
+#include <cstdint>
+#include <cstring>
+
+#include "predicate.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PREDICATE_X86
+#include <immintrin.h>
+#define SSE_TARGET  __attribute__((target("sse2")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+PredicateEvaluator* PredicateEvaluator::_evaluator = NULL;
+
+PredicateEvaluator* PredicateEvaluator::instance()
+{
+    if(!_evaluator)
+        _evaluator = new PredicateEvaluator();
+
+    return _evaluator;
+}
+
+PredicateEvaluator::PredicateEvaluator()
+{
+    // Pick the widest kernel this CPU supports
+    bestKernel = KERNEL_SCALAR;
+#ifdef PREDICATE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        bestKernel = KERNEL_AVX2;
+    else if (__builtin_cpu_supports("sse2"))
+        bestKernel = KERNEL_SSE;
+#endif
+    kernel = bestKernel;
+}
+
+PredicateEvaluator::~PredicateEvaluator()
+{
+}
+
+PredicateKernel PredicateEvaluator::getKernel() const
+{
+    return kernel;
+}
+
+const char *PredicateEvaluator::getKernelName() const
+{
+    switch (kernel)
+    {
+        case KERNEL_AVX2: return "avx2";
+        case KERNEL_SSE:  return "sse";
+        default:          return "scalar";
+    }
+}
+
+bool PredicateEvaluator::kernelSupported(PredicateKernel k) const
+{
+    return k <= bestKernel;
+}
+
+RC PredicateEvaluator::setKernel(PredicateKernel k)
+{
+    if (!kernelSupported(k))
+        return -1;
+    kernel = k;
+    return SUCCESS;
+}
+
+unsigned PredicateEvaluator::getBitmapSize(unsigned n)
+{
+    return (n + CHAR_BIT - 1) / CHAR_BIT;
+}
+
+bool PredicateEvaluator::bitIsSet(const uint8_t *bitmap, unsigned i)
+{
+    return (bitmap[i / CHAR_BIT] >> (i % CHAR_BIT)) & 1;
+}
+
+bool PredicateEvaluator::compare(int32_t lhs, CompOp compOp, int32_t rhs)
+{
+    switch (compOp)
+    {
+        case EQ_OP: return lhs == rhs;
+        case LT_OP: return lhs < rhs;
+        case GT_OP: return lhs > rhs;
+        case LE_OP: return lhs <= rhs;
+        case GE_OP: return lhs >= rhs;
+        case NE_OP: return lhs != rhs;
+        case NO_OP: return true;
+        // Should never happen
+        default: return false;
+    }
+}
+
+bool PredicateEvaluator::compare(float lhs, CompOp compOp, float rhs)
+{
+    switch (compOp)
+    {
+        case EQ_OP: return lhs == rhs;
+        case LT_OP: return lhs < rhs;
+        case GT_OP: return lhs > rhs;
+        case LE_OP: return lhs <= rhs;
+        case GE_OP: return lhs >= rhs;
+        case NE_OP: return lhs != rhs;
+        case NO_OP: return true;
+        // Should never happen
+        default: return false;
+    }
+}
+
+// Lexicographic comparison on raw bytes; a proper prefix sorts first
+bool PredicateEvaluator::compareVarChar(const char *lhs, uint32_t lhsLength, CompOp compOp, const char *rhs, uint32_t rhsLength)
+{
+    if (compOp == NO_OP)
+        return true;
+
+    int cmp = memcmp(lhs, rhs, lhsLength < rhsLength ? lhsLength : rhsLength);
+    if (cmp == 0)
+        cmp = lhsLength < rhsLength ? -1 : (lhsLength > rhsLength ? 1 : 0);
+
+    switch (compOp)
+    {
+        case EQ_OP: return cmp == 0;
+        case LT_OP: return cmp <  0;
+        case GT_OP: return cmp >  0;
+        case LE_OP: return cmp <= 0;
+        case GE_OP: return cmp >= 0;
+        case NE_OP: return cmp != 0;
+        // Should never happen
+        default: return false;
+    }
+}
+
+// Scalar kernels ///////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+static unsigned evalScalar(const T *values, unsigned start, unsigned n, CompOp compOp, T value, uint8_t *bitmap)
+{
+    unsigned matches = 0;
+    for (unsigned i = start; i < n; i++)
+    {
+        if (PredicateEvaluator::compare(values[i], compOp, value))
+        {
+            bitmap[i / CHAR_BIT] |= 1 << (i % CHAR_BIT);
+            matches++;
+        }
+    }
+    return matches;
+}
+
+static bool bytesEqualScalar(const char *a, const char *b, uint32_t length)
+{
+    return memcmp(a, b, length) == 0;
+}
+
+#ifdef PREDICATE_X86
+
+// SSE kernels (4 lanes) ////////////////////////////////////////////////////////////////////
+
+// Set 4 bits of the bitmap starting at bit i (i is a multiple of 4)
+static inline void setNibble(uint8_t *bitmap, unsigned i, int mask)
+{
+    bitmap[i / CHAR_BIT] |= mask << (i % CHAR_BIT);
+}
+
+SSE_TARGET static unsigned evalIntSSE(const int32_t *values, unsigned n, CompOp compOp, int32_t value, uint8_t *bitmap)
+{
+    const __m128i constant = _mm_set1_epi32(value);
+    unsigned matches = 0;
+    unsigned i;
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*) (values + i));
+        __m128i cmp;
+        bool invert = false;
+        switch (compOp)
+        {
+            case EQ_OP: cmp = _mm_cmpeq_epi32(v, constant); break;
+            case NE_OP: cmp = _mm_cmpeq_epi32(v, constant); invert = true; break;
+            case LT_OP: cmp = _mm_cmplt_epi32(v, constant); break;
+            case GE_OP: cmp = _mm_cmplt_epi32(v, constant); invert = true; break;
+            case GT_OP: cmp = _mm_cmpgt_epi32(v, constant); break;
+            case LE_OP: cmp = _mm_cmpgt_epi32(v, constant); invert = true; break;
+            case NO_OP: cmp = _mm_set1_epi32(-1); break;
+            default:    cmp = _mm_setzero_si128(); break;
+        }
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(cmp));
+        if (invert)
+            mask = ~mask & 0xF;
+        setNibble(bitmap, i, mask);
+        matches += __builtin_popcount(mask);
+    }
+    return matches + evalScalar(values, i, n, compOp, value, bitmap);
+}
+
+SSE_TARGET static unsigned evalRealSSE(const float *values, unsigned n, CompOp compOp, float value, uint8_t *bitmap)
+{
+    const __m128 constant = _mm_set1_ps(value);
+    unsigned matches = 0;
+    unsigned i;
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        __m128 v = _mm_loadu_ps(values + i);
+        __m128 cmp;
+        switch (compOp)
+        {
+            case EQ_OP: cmp = _mm_cmpeq_ps(v, constant); break;
+            case NE_OP: cmp = _mm_cmpneq_ps(v, constant); break;
+            case LT_OP: cmp = _mm_cmplt_ps(v, constant); break;
+            case LE_OP: cmp = _mm_cmple_ps(v, constant); break;
+            case GT_OP: cmp = _mm_cmpgt_ps(v, constant); break;
+            case GE_OP: cmp = _mm_cmpge_ps(v, constant); break;
+            case NO_OP: cmp = _mm_castsi128_ps(_mm_set1_epi32(-1)); break;
+            default:    cmp = _mm_setzero_ps(); break;
+        }
+        int mask = _mm_movemask_ps(cmp);
+        setNibble(bitmap, i, mask);
+        matches += __builtin_popcount(mask);
+    }
+    return matches + evalScalar(values, i, n, compOp, value, bitmap);
+}
+
+SSE_TARGET static bool bytesEqualSSE(const char *a, const char *b, uint32_t length)
+{
+    uint32_t i;
+    for (i = 0; i + 16 <= length; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*) (a + i));
+        __m128i y = _mm_loadu_si128((const __m128i*) (b + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xFFFF)
+            return false;
+    }
+    return memcmp(a + i, b + i, length - i) == 0;
+}
+
+// AVX2 kernels (8 lanes, one bitmap byte per iteration) ////////////////////////////////////
+
+AVX2_TARGET static unsigned evalIntAVX2(const int32_t *values, unsigned n, CompOp compOp, int32_t value, uint8_t *bitmap)
+{
+    const __m256i constant = _mm256_set1_epi32(value);
+    unsigned matches = 0;
+    unsigned i;
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (values + i));
+        __m256i cmp;
+        bool invert = false;
+        switch (compOp)
+        {
+            case EQ_OP: cmp = _mm256_cmpeq_epi32(v, constant); break;
+            case NE_OP: cmp = _mm256_cmpeq_epi32(v, constant); invert = true; break;
+            case LT_OP: cmp = _mm256_cmpgt_epi32(constant, v); break;
+            case GE_OP: cmp = _mm256_cmpgt_epi32(constant, v); invert = true; break;
+            case GT_OP: cmp = _mm256_cmpgt_epi32(v, constant); break;
+            case LE_OP: cmp = _mm256_cmpgt_epi32(v, constant); invert = true; break;
+            case NO_OP: cmp = _mm256_set1_epi32(-1); break;
+            default:    cmp = _mm256_setzero_si256(); break;
+        }
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(cmp));
+        if (invert)
+            mask = ~mask & 0xFF;
+        bitmap[i / CHAR_BIT] = mask;
+        matches += __builtin_popcount(mask);
+    }
+    return matches + evalScalar(values, i, n, compOp, value, bitmap);
+}
+
+AVX2_TARGET static unsigned evalRealAVX2(const float *values, unsigned n, CompOp compOp, float value, uint8_t *bitmap)
+{
+    const __m256 constant = _mm256_set1_ps(value);
+    unsigned matches = 0;
+    unsigned i;
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m256 v = _mm256_loadu_ps(values + i);
+        __m256 cmp;
+        switch (compOp)
+        {
+            case EQ_OP: cmp = _mm256_cmp_ps(v, constant, _CMP_EQ_OQ); break;
+            case NE_OP: cmp = _mm256_cmp_ps(v, constant, _CMP_NEQ_UQ); break;
+            case LT_OP: cmp = _mm256_cmp_ps(v, constant, _CMP_LT_OQ); break;
+            case LE_OP: cmp = _mm256_cmp_ps(v, constant, _CMP_LE_OQ); break;
+            case GT_OP: cmp = _mm256_cmp_ps(v, constant, _CMP_GT_OQ); break;
+            case GE_OP: cmp = _mm256_cmp_ps(v, constant, _CMP_GE_OQ); break;
+            case NO_OP: cmp = _mm256_castsi256_ps(_mm256_set1_epi32(-1)); break;
+            default:    cmp = _mm256_setzero_ps(); break;
+        }
+        int mask = _mm256_movemask_ps(cmp);
+        bitmap[i / CHAR_BIT] = mask;
+        matches += __builtin_popcount(mask);
+    }
+    return matches + evalScalar(values, i, n, compOp, value, bitmap);
+}
+
+AVX2_TARGET static bool bytesEqualAVX2(const char *a, const char *b, uint32_t length)
+{
+    uint32_t i;
+    for (i = 0; i + 32 <= length; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i*) (a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*) (b + i));
+        if ((unsigned) _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)) != 0xFFFFFFFFu)
+            return false;
+    }
+    return bytesEqualSSE(a + i, b + i, length - i);
+}
+
+#endif
+
+// Dispatch /////////////////////////////////////////////////////////////////////////////////
+
+unsigned PredicateEvaluator::evalInt(const int32_t *values, unsigned n, CompOp compOp, int32_t value, uint8_t *bitmap)
+{
+    memset(bitmap, 0, getBitmapSize(n));
+#ifdef PREDICATE_X86
+    if (kernel == KERNEL_AVX2)
+        return evalIntAVX2(values, n, compOp, value, bitmap);
+    if (kernel == KERNEL_SSE)
+        return evalIntSSE(values, n, compOp, value, bitmap);
+#endif
+    return evalScalar(values, 0, n, compOp, value, bitmap);
+}
+
+unsigned PredicateEvaluator::evalReal(const float *values, unsigned n, CompOp compOp, float value, uint8_t *bitmap)
+{
+    memset(bitmap, 0, getBitmapSize(n));
+#ifdef PREDICATE_X86
+    if (kernel == KERNEL_AVX2)
+        return evalRealAVX2(values, n, compOp, value, bitmap);
+    if (kernel == KERNEL_SSE)
+        return evalRealSSE(values, n, compOp, value, bitmap);
+#endif
+    return evalScalar(values, 0, n, compOp, value, bitmap);
+}
+
+unsigned PredicateEvaluator::evalVarCharEq(const char * const *strings, const uint32_t *lengths, unsigned n,
+        CompOp compOp, const void *value, uint8_t *bitmap)
+{
+    memset(bitmap, 0, getBitmapSize(n));
+
+    uint32_t valueLength;
+    memcpy(&valueLength, value, VARCHAR_LENGTH_SIZE);
+    const char *valueString = (const char*) value + VARCHAR_LENGTH_SIZE;
+
+    bool (*bytesEqual)(const char*, const char*, uint32_t) = bytesEqualScalar;
+#ifdef PREDICATE_X86
+    if (kernel == KERNEL_AVX2)
+        bytesEqual = bytesEqualAVX2;
+    else if (kernel == KERNEL_SSE)
+        bytesEqual = bytesEqualSSE;
+#endif
+
+    bool wantEqual = compOp != NE_OP;
+    unsigned matches = 0;
+    for (unsigned i = 0; i < n; i++)
+    {
+        // Lengths differ => strings differ, no need to look at the bytes
+        bool equal = lengths[i] == valueLength && bytesEqual(strings[i], valueString, valueLength);
+        if (equal == wantEqual)
+        {
+            bitmap[i / CHAR_BIT] |= 1 << (i % CHAR_BIT);
+            matches++;
+        }
+    }
+    return matches;
+}
@@ -0,0 +1,56 @@
+#ifndef _predicate_h_
+#define _predicate_h_
+
+#include <cstdint>
+
+#include "../rbf/rbfm.h"
+
+// Batch predicate evaluation.
+// Each kernel compares n values against a constant and writes a selection bitmap with
+// one bit per value: bit (i % 8) of byte (i / 8) is set when value i satisfies the predicate.
+// The best kernel supported by the CPU is picked once at startup (via CPUID), but can be
+// overridden with setKernel() for testing and benchmarking.
+
+typedef enum { KERNEL_SCALAR = 0, KERNEL_SSE, KERNEL_AVX2 } PredicateKernel;
+
+class PredicateEvaluator
+{
+public:
+    static PredicateEvaluator* instance();
+
+    // Evaluate (values[i] compOp value) for i in [0, n). Returns the number of matches.
+    unsigned evalInt(const int32_t *values, unsigned n, CompOp compOp, int32_t value, uint8_t *bitmap);
+    unsigned evalReal(const float *values, unsigned n, CompOp compOp, float value, uint8_t *bitmap);
+
+    // Evaluate (strings[i] == value) (or != when compOp is NE_OP). strings[i] points to lengths[i] bytes,
+    // value is in API format (4 byte length followed by the characters).
+    unsigned evalVarCharEq(const char * const *strings, const uint32_t *lengths, unsigned n,
+            CompOp compOp, const void *value, uint8_t *bitmap);
+
+    // Kernel selection
+    PredicateKernel getKernel() const;
+    const char *getKernelName() const;
+    bool kernelSupported(PredicateKernel kernel) const;
+    RC setKernel(PredicateKernel kernel);
+
+    // Single value comparisons, shared by the scan iterators and QE operators
+    static bool compare(int32_t lhs, CompOp compOp, int32_t rhs);
+    static bool compare(float lhs, CompOp compOp, float rhs);
+    static bool compareVarChar(const char *lhs, uint32_t lhsLength, CompOp compOp, const char *rhs, uint32_t rhsLength);
+
+    // Bitmap helpers
+    static unsigned getBitmapSize(unsigned n);
+    static bool bitIsSet(const uint8_t *bitmap, unsigned i);
+
+protected:
+    PredicateEvaluator();
+    ~PredicateEvaluator();
+
+private:
+    static PredicateEvaluator *_evaluator;
+
+    PredicateKernel kernel;
+    PredicateKernel bestKernel;
+};
+
+#endif
@@ -0,0 +1,115 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cassert>
+#include <stdlib.h>
+#include <string.h>
+
+#include "predicate.h"
+
+using namespace std;
+
+// Microbenchmark for the batch predicate kernels.
+// For every kernel the CPU supports, evaluates each operator over a column of values
+// and reports tuples/sec. The scalar kernel's bitmap is used to check the others.
+
+#define BENCH_TUPLES 4096
+#define BENCH_ROUNDS 2000
+#define BENCH_VARCHAR_LENGTH 24
+
+static const CompOp ops[] = { EQ_OP, LT_OP, LE_OP, GT_OP, GE_OP, NE_OP, NO_OP };
+static const char *opNames[] = { "EQ", "LT", "LE", "GT", "GE", "NE", "NO" };
+static const char *kernelNames[] = { "scalar", "sse", "avx2" };
+
+static double tuplesPerSec(chrono::steady_clock::time_point start, unsigned rounds)
+{
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return (double) BENCH_TUPLES * rounds / secs;
+}
+
+static void report(PredicateKernel kernel, const char *type, const char *op, double rate, unsigned matches)
+{
+    cout << left << setw(8) << kernelNames[kernel] << setw(9) << type << setw(4) << op
+         << right << setw(16) << fixed << setprecision(0) << rate << " tuples/sec"
+         << setw(8) << matches << " matches" << endl;
+}
+
+int main()
+{
+    PredicateEvaluator *pe = PredicateEvaluator::instance();
+    cout << "Default kernel: " << pe->getKernelName() << endl;
+
+    vector<int32_t> ints(BENCH_TUPLES);
+    vector<float> reals(BENCH_TUPLES);
+    vector<string> strings(BENCH_TUPLES);
+    srand(181);
+    for (unsigned i = 0; i < BENCH_TUPLES; i++)
+    {
+        ints[i] = rand() % 1000;
+        reals[i] = (rand() % 1000) / 10.0f;
+        strings[i] = string(BENCH_VARCHAR_LENGTH, 'a' + rand() % 4);
+    }
+    vector<const char*> varcharValues(BENCH_TUPLES);
+    vector<uint32_t> varcharLengths(BENCH_TUPLES);
+    for (unsigned i = 0; i < BENCH_TUPLES; i++)
+    {
+        varcharValues[i] = strings[i].c_str();
+        varcharLengths[i] = strings[i].length();
+    }
+
+    int32_t intValue = 500;
+    float realValue = 50.0f;
+    char varcharValue[VARCHAR_LENGTH_SIZE + BENCH_VARCHAR_LENGTH];
+    uint32_t varcharLength = BENCH_VARCHAR_LENGTH;
+    memcpy(varcharValue, &varcharLength, VARCHAR_LENGTH_SIZE);
+    memset(varcharValue + VARCHAR_LENGTH_SIZE, 'b', BENCH_VARCHAR_LENGTH);
+
+    unsigned bitmapSize = PredicateEvaluator::getBitmapSize(BENCH_TUPLES);
+    vector<uint8_t> bitmap(bitmapSize);
+    vector<uint8_t> expected(bitmapSize);
+
+    for (int k = KERNEL_SCALAR; k <= KERNEL_AVX2; k++)
+    {
+        PredicateKernel kernel = (PredicateKernel) k;
+        if (!pe->kernelSupported(kernel))
+            continue;
+
+        for (unsigned o = 0; o < sizeof(ops) / sizeof(ops[0]); o++)
+        {
+            unsigned matches = 0;
+
+            pe->setKernel(KERNEL_SCALAR);
+            pe->evalInt(ints.data(), BENCH_TUPLES, ops[o], intValue, expected.data());
+            pe->setKernel(kernel);
+            auto start = chrono::steady_clock::now();
+            for (unsigned r = 0; r < BENCH_ROUNDS; r++)
+                matches = pe->evalInt(ints.data(), BENCH_TUPLES, ops[o], intValue, bitmap.data());
+            assert(bitmap == expected && "Kernel disagrees with the scalar kernel.");
+            report(kernel, "int", opNames[o], tuplesPerSec(start, BENCH_ROUNDS), matches);
+
+            pe->setKernel(KERNEL_SCALAR);
+            pe->evalReal(reals.data(), BENCH_TUPLES, ops[o], realValue, expected.data());
+            pe->setKernel(kernel);
+            start = chrono::steady_clock::now();
+            for (unsigned r = 0; r < BENCH_ROUNDS; r++)
+                matches = pe->evalReal(reals.data(), BENCH_TUPLES, ops[o], realValue, bitmap.data());
+            assert(bitmap == expected && "Kernel disagrees with the scalar kernel.");
+            report(kernel, "real", opNames[o], tuplesPerSec(start, BENCH_ROUNDS), matches);
+
+            if (ops[o] != EQ_OP && ops[o] != NE_OP)
+                continue;
+
+            pe->setKernel(KERNEL_SCALAR);
+            pe->evalVarCharEq(varcharValues.data(), varcharLengths.data(), BENCH_TUPLES, ops[o], varcharValue, expected.data());
+            pe->setKernel(kernel);
+            start = chrono::steady_clock::now();
+            for (unsigned r = 0; r < BENCH_ROUNDS; r++)
+                matches = pe->evalVarCharEq(varcharValues.data(), varcharLengths.data(), BENCH_TUPLES, ops[o], varcharValue, bitmap.data());
+            assert(bitmap == expected && "Kernel disagrees with the scalar kernel.");
+            report(kernel, "varchar", opNames[o], tuplesPerSec(start, BENCH_ROUNDS), matches);
+        }
+    }
+    return 0;
+}
@@ -8,6 +8,11 @@
 #include <string>
 
 #include "rbfm.h"
+#include "arena.h"
+#include "predicate.h"
+#include "zonemap.h"
+#include "dictionary.h"
+#include "overflow.h"
 
 RecordBasedFileManager* RecordBasedFileManager::_rbf_manager = NULL;
 PagedFileManager *RecordBasedFileManager::_pf_manager = NULL;
@@ -30,17 +35,21 @@ RecordBasedFileManager::~RecordBasedFileManager()
 {
 }
 
-RC RecordBasedFileManager::createFile(const string &fileName) 
+RC RecordBasedFileManager::createFile(const string &fileName, FileFormat format, unsigned pageSize)
 {
     // Creating a new paged file.
-    if (_pf_manager->createFile(fileName))
+    if (_pf_manager->createFile(fileName, false, pageSize))
         return RBFM_CREATE_FAILED;
 
     // Setting up the first page.
-    void * firstPageData = calloc(PAGE_SIZE, 1);
+    void * firstPageData = PageBufferPool::acquire();
     if (firstPageData == NULL)
         return RBFM_MALLOC_FAILED;
-    newRecordBasedPage(firstPageData);
+    // Pages added later take the format of the pages before them
+    if (format == FormatPax)
+        newPaxPage(firstPageData, pageSize);
+    else
+        newRecordBasedPage(firstPageData, pageSize);
 
     // Adds the first record based page.
     FileHandle handle;
@@ -50,45 +59,559 @@ RC RecordBasedFileManager::createFile(const string &fileName)
         return RBFM_APPEND_FAILED;
     _pf_manager->closeFile(handle);
 
-    free(firstPageData);
+    PageBufferPool::release(firstPageData);
 
     return SUCCESS;
 }
 
 RC RecordBasedFileManager::destroyFile(const string &fileName) 
 {
+    ZoneMap::destroy(fileName);
+    Dictionary::destroy(fileName);
+    OverflowFile::destroy(fileName);
     return _pf_manager->destroyFile(fileName);
 }
 
 RC RecordBasedFileManager::openFile(const string &fileName, FileHandle &fileHandle) 
 {
-    return _pf_manager->openFile(fileName.c_str(), fileHandle);
+    RC rc = _pf_manager->openFile(fileName.c_str(), fileHandle);
+    if (rc != SUCCESS)
+        return rc;
+
+    // Records of a file with a dictionary or an overflow file can't be read without them
+    fileHandle.zoneMap = ZoneMap::open(fileName);
+    rc = Dictionary::open(fileName, fileHandle.dictionary);
+    if (rc == SUCCESS)
+        rc = OverflowFile::open(fileName, fileHandle.overflow);
+    if (rc != SUCCESS)
+        closeFile(fileHandle);
+    return rc;
 }
 
 RC RecordBasedFileManager::closeFile(FileHandle &fileHandle) 
 {
+    delete fileHandle.zoneMap;
+    fileHandle.zoneMap = NULL;
+    Dictionary::release(fileHandle.dictionary);
+    fileHandle.dictionary = NULL;
+    delete fileHandle.overflow;
+    fileHandle.overflow = NULL;
     return _pf_manager->closeFile(fileHandle);
 }
 
+RC RecordBasedFileManager::createZoneMap(const string &fileName, const vector<Attribute> &recordDescriptor, const vector<string> &attributeNames)
+{
+    vector<unsigned> attrIndexes;
+    vector<AttrType> types;
+    for (const string &name : attributeNames)
+    {
+        auto pred = [&](Attribute a) {return a.name == name;};
+        auto iterPos = find_if(recordDescriptor.begin(), recordDescriptor.end(), pred);
+        if (iterPos == recordDescriptor.end())
+            return RBFM_NO_SUCH_ATTR;
+        attrIndexes.push_back(distance(recordDescriptor.begin(), iterPos));
+        types.push_back(iterPos->type);
+    }
+
+    // Records only have pointers to out-of-line values
+    OverflowFile *overflow;
+    RC rc = OverflowFile::open(fileName, overflow);
+    if (rc != SUCCESS)
+        return rc;
+    bool outOfLine = false;
+    for (unsigned i = 0; overflow != NULL && i < attrIndexes.size(); i++)
+        outOfLine = outOfLine || overflow->isOutOfLine(attrIndexes[i]);
+    delete overflow;
+    if (outOfLine)
+        return RBFM_ZONE_MAP_FAILED;
+
+    rc = ZoneMap::create(fileName, attrIndexes, types);
+    if (rc != SUCCESS)
+        return rc;
+
+    // Summarize the records already in the file
+    FileHandle fileHandle;
+    rc = openFile(fileName, fileHandle);
+    if (rc == SUCCESS && fileHandle.zoneMap == NULL)
+        rc = RBFM_ZONE_MAP_FAILED;
+    void *pageData = PageBufferPool::acquire();
+    for (unsigned i = 0; rc == SUCCESS && i < fileHandle.getNumberOfPages(); i++)
+    {
+        rc = readRecordPage(fileHandle, i, pageData);
+        if (rc == SUCCESS)
+            rc = summarizePage(fileHandle, i, pageData);
+    }
+    PageBufferPool::release(pageData);
+    closeFile(fileHandle);
+
+    if (rc != SUCCESS)
+        ZoneMap::destroy(fileName);
+    return rc;
+}
+
+RC RecordBasedFileManager::destroyZoneMap(const string &fileName)
+{
+    return ZoneMap::destroy(fileName);
+}
+
+RC RecordBasedFileManager::createDictionary(const string &fileName, const vector<Attribute> &recordDescriptor, const string &attributeName)
+{
+    auto pred = [&](Attribute a) {return a.name == attributeName;};
+    unsigned index = distance(recordDescriptor.begin(), find_if(recordDescriptor.begin(), recordDescriptor.end(), pred));
+    if (index == recordDescriptor.size())
+        return RBFM_NO_SUCH_ATTR;
+    if (recordDescriptor[index].type != TypeVarChar)
+        return RBFM_DICTIONARY_FAILED;
+
+    // Find the records while the attribute still holds values
+    FileHandle plainHandle;
+    RC rc = openFile(fileName, plainHandle);
+    if (rc != SUCCESS)
+        return rc;
+    if ((plainHandle.dictionary != NULL && plainHandle.dictionary->isEncoded(index)) ||
+            (plainHandle.overflow != NULL && plainHandle.overflow->isOutOfLine(index)))
+    {
+        closeFile(plainHandle);
+        return RBFM_DICTIONARY_FAILED;
+    }
+    vector<RID> rids;
+    RID rid;
+    RBFM_ScanIterator scanIterator;
+    vector<string> noAttributes;
+    rc = scan(plainHandle, recordDescriptor, "", NO_OP, NULL, noAttributes, scanIterator);
+    while (rc == SUCCESS && (rc = scanIterator.getNextRecord(rid, NULL)) == SUCCESS)
+        rids.push_back(rid);
+    scanIterator.close();
+    if (rc == RBFM_EOF)
+        rc = Dictionary::addAttribute(fileName, index);
+
+    // Then decode every record with the dictionary that knows no codes for it, and encode it back
+    // with one that does. Out-of-line values stay where they are. Records that grow move to RIDs
+    // that aren't in the list.
+    FileHandle encodedHandle;
+    if (rc == SUCCESS)
+        rc = openFile(fileName, encodedHandle);
+    if (rc == SUCCESS && encodedHandle.dictionary == NULL)
+        rc = RBFM_DICTIONARY_FAILED;
+    void *stored = PageBufferPool::acquire();
+    void *record = PageBufferPool::acquire();
+    for (unsigned i = 0; rc == SUCCESS && i < rids.size(); i++)
+    {
+        rc = readStoredRecord(plainHandle, recordDescriptor, rids[i], stored);
+        const void *plain = stored;
+        if (rc == SUCCESS && plainHandle.dictionary != NULL)
+        {
+            rc = plainHandle.dictionary->decodeRecord(recordDescriptor, stored, record);
+            plain = record;
+        }
+        vector<char> encoded;
+        if (rc == SUCCESS)
+            rc = encodedHandle.dictionary->encodeRecord(recordDescriptor, plain, encoded);
+        if (rc == SUCCESS)
+            rc = updateStoredRecord(encodedHandle, recordDescriptor, encoded.data(), rids[i]);
+    }
+    PageBufferPool::release(record);
+    PageBufferPool::release(stored);
+    closeFile(encodedHandle);
+    closeFile(plainHandle);
+    return rc;
+}
+
+RC RecordBasedFileManager::createOverflow(const string &fileName, const vector<Attribute> &recordDescriptor, const string &attributeName,
+        unsigned threshold, bool compress)
+{
+    auto pred = [&](Attribute a) {return a.name == attributeName;};
+    unsigned index = distance(recordDescriptor.begin(), find_if(recordDescriptor.begin(), recordDescriptor.end(), pred));
+    if (index == recordDescriptor.size())
+        return RBFM_NO_SUCH_ATTR;
+    if (recordDescriptor[index].type != TypeVarChar)
+        return RBFM_OVERFLOW_FAILED;
+
+    // Find the records while the attribute still holds values
+    FileHandle plainHandle;
+    RC rc = openFile(fileName, plainHandle);
+    if (rc != SUCCESS)
+        return rc;
+    if ((plainHandle.overflow != NULL && plainHandle.overflow->isOutOfLine(index)) ||
+            (plainHandle.dictionary != NULL && plainHandle.dictionary->isEncoded(index)) ||
+            (plainHandle.zoneMap != NULL && plainHandle.zoneMap->findAttribute(index) >= 0))
+    {
+        closeFile(plainHandle);
+        return RBFM_OVERFLOW_FAILED;
+    }
+    vector<RID> rids;
+    RID rid;
+    RBFM_ScanIterator scanIterator;
+    vector<string> noAttributes;
+    rc = scan(plainHandle, recordDescriptor, "", NO_OP, NULL, noAttributes, scanIterator);
+    while (rc == SUCCESS && (rc = scanIterator.getNextRecord(rid, NULL)) == SUCCESS)
+        rids.push_back(rid);
+    scanIterator.close();
+    closeFile(plainHandle);
+    if (rc == RBFM_EOF)
+        rc = OverflowFile::addAttribute(fileName, index, threshold, compress);
+
+    // Then tag the value of the attribute in every record, moving the long ones out. The rest of
+    // the record stays as stored. Records that grow move to RIDs that aren't in the list.
+    FileHandle overflowHandle;
+    if (rc == SUCCESS)
+        rc = openFile(fileName, overflowHandle);
+    if (rc == SUCCESS && overflowHandle.overflow == NULL)
+        rc = RBFM_OVERFLOW_FAILED;
+    void *record = PageBufferPool::acquire();
+    for (unsigned i = 0; rc == SUCCESS && i < rids.size(); i++)
+    {
+        rc = readStoredRecord(overflowHandle, recordDescriptor, rids[i], record);
+        vector<char> stored;
+        if (rc == SUCCESS)
+            rc = overflowHandle.overflow->storeAttribute(recordDescriptor, record, index, stored);
+        if (rc == SUCCESS)
+            rc = updateStoredRecord(overflowHandle, recordDescriptor, stored.data(), rids[i]);
+    }
+    PageBufferPool::release(record);
+    closeFile(overflowHandle);
+    return rc;
+}
+
+RC RecordBasedFileManager::dropForwarding(FileHandle &fileHandle, PageNum pageNum, vector<RecordMove> &moves)
+{
+    void *pageData = PageBufferPool::acquire();
+    void *targetData = PageBufferPool::acquire();
+    RC rc = readRecordPage(fileHandle, pageNum, pageData);
+    for (unsigned slot = 0; rc == SUCCESS && slot < getSlotDirectoryHeader(pageData).recordEntriesNumber; slot++)
+    {
+        // Slots other slots forward to go with the slot the chain starts from
+        SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, slot);
+        if (getSlotStatus(recordEntry) != MOVED || isMovedIn(pageData, recordEntry))
+            continue;
+
+        RecordMove move;
+        move.oldRid.pageNum = pageNum;
+        move.oldRid.slotNum = slot;
+        move.newRid = getForwardingAddress(pageData, recordEntry);
+        markSlotDeleted(pageData, slot);
+        if (!isPaxPage(pageData))
+        {
+            reorganizePage(pageData);
+            fileHandle.stats->pageReorganizations++;
+        }
+        trimSlotDirectory(pageData);
+        rc = fileHandle.writePage(pageNum, pageData) ? RBFM_WRITE_FAILED : SUCCESS;
+
+        // Follow the chain to the record, which is at home where it is from now on
+        bool found = false;
+        while (rc == SUCCESS && !found)
+        {
+            rc = readRecordPage(fileHandle, move.newRid.pageNum, targetData);
+            if (rc != SUCCESS)
+                break;
+            // Deleted through the RID it moved to
+            if (getSlotDirectoryHeader(targetData).recordEntriesNumber <= move.newRid.slotNum)
+                break;
+            SlotDirectoryRecordEntry targetEntry = getSlotDirectoryRecordEntry(targetData, move.newRid.slotNum);
+            SlotStatus status = getSlotStatus(targetEntry);
+            if (status == DEAD)
+                break;
+            RID next = move.newRid;
+            if (status == MOVED)
+            {
+                next = getForwardingAddress(targetData, targetEntry);
+                markSlotDeleted(targetData, move.newRid.slotNum);
+                if (!isPaxPage(targetData))
+                {
+                    reorganizePage(targetData);
+                    fileHandle.stats->pageReorganizations++;
+                }
+            }
+            else
+            {
+                setMovedIn(targetData, move.newRid.slotNum, false);
+                found = true;
+            }
+            rc = fileHandle.writePage(move.newRid.pageNum, targetData) ? RBFM_WRITE_FAILED : SUCCESS;
+            if (!found)
+                move.newRid = next;
+        }
+        if (rc == SUCCESS && found)
+            moves.push_back(move);
+
+        // The chain may have gone through this page
+        if (rc == SUCCESS)
+            rc = readRecordPage(fileHandle, pageNum, pageData);
+    }
+    if (rc == SUCCESS && isPaxPage(pageData))
+    {
+        compactPaxHeap(pageData);
+        rc = fileHandle.writePage(pageNum, pageData) ? RBFM_WRITE_FAILED : SUCCESS;
+    }
+    if (rc == SUCCESS)
+        rc = summarizePage(fileHandle, pageNum, pageData);
+    PageBufferPool::release(targetData);
+    PageBufferPool::release(pageData);
+    return rc;
+}
+
+RC RecordBasedFileManager::relocateRecords(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, PageNum pageNum,
+        PageNum &firstPage, vector<RecordMove> &moves)
+{
+    void *pageData = PageBufferPool::acquire();
+    void *targetData = PageBufferPool::acquire();
+    void *record = PageBufferPool::acquire();
+    RC rc = readRecordPage(fileHandle, pageNum, pageData);
+    bool pax = isPaxPage(pageData);
+    bool targetLoaded = false;
+    bool targetChanged = false;
+    bool changed = false;
+
+    unsigned numSlots = rc == SUCCESS ? getSlotDirectoryHeader(pageData).recordEntriesNumber : 0;
+    for (unsigned slot = 0; rc == SUCCESS && slot < numSlots && firstPage < pageNum; slot++)
+    {
+        // A slot forwarding to the record would lose it
+        SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, slot);
+        if (getSlotStatus(recordEntry) != VALID || isMovedIn(pageData, recordEntry))
+            continue;
+
+        // The record as stored, with the codes of its encoded attributes
+        if (pax)
+            getPaxRecord(pageData, slot, recordDescriptor, record);
+        else
+            getRecordAtOffset(pageData, recordEntry.offset, recordDescriptor, record);
+
+        // The first page from firstPage with room for it
+        unsigned newSlot = 0;
+        bool inserted = false;
+        while (rc == SUCCESS && !inserted && firstPage < pageNum)
+        {
+            if (!targetLoaded)
+            {
+                rc = readRecordPage(fileHandle, firstPage, targetData);
+                targetLoaded = rc == SUCCESS;
+                continue;
+            }
+            if (isPaxPage(targetData) != pax)
+                inserted = false;
+            else if (pax)
+                inserted = insertPaxRecord(targetData, recordDescriptor, record, newSlot);
+            else
+            {
+                newSlot = getOpenSlot(targetData);
+                inserted = insertSlottedRecord(targetData, recordDescriptor, record, getFillReserve(fileHandle), newSlot);
+            }
+            if (inserted)
+                break;
+            if (targetChanged)
+                rc = fileHandle.writePage(firstPage, targetData) ? RBFM_WRITE_FAILED : SUCCESS;
+            if (rc == SUCCESS && targetChanged)
+                rc = summarizePage(fileHandle, firstPage, targetData);
+            firstPage++;
+            targetLoaded = false;
+            targetChanged = false;
+        }
+        if (!inserted)
+            break;
+
+        RecordMove move;
+        move.oldRid.pageNum = pageNum;
+        move.oldRid.slotNum = slot;
+        move.newRid.pageNum = firstPage;
+        move.newRid.slotNum = newSlot;
+        moves.push_back(move);
+        markSlotDeleted(pageData, slot);
+        targetChanged = true;
+        changed = true;
+    }
+
+    if (rc == SUCCESS && targetChanged)
+        rc = fileHandle.writePage(firstPage, targetData) ? RBFM_WRITE_FAILED : SUCCESS;
+    if (rc == SUCCESS && targetChanged)
+        rc = summarizePage(fileHandle, firstPage, targetData);
+    if (rc == SUCCESS && changed)
+    {
+        if (pax)
+            compactPaxHeap(pageData);
+        else
+            reorganizePage(pageData);
+        trimSlotDirectory(pageData);
+        rc = fileHandle.writePage(pageNum, pageData) ? RBFM_WRITE_FAILED : SUCCESS;
+        if (rc == SUCCESS)
+            rc = summarizePage(fileHandle, pageNum, pageData);
+    }
+    PageBufferPool::release(record);
+    PageBufferPool::release(targetData);
+    PageBufferPool::release(pageData);
+    return rc;
+}
+
+RC RecordBasedFileManager::truncateFile(FileHandle &fileHandle)
+{
+    unsigned numPages = fileHandle.getNumberOfPages();
+    void *pageData = PageBufferPool::acquire();
+    RC rc = SUCCESS;
+    bool empty = true;
+    while (numPages > 0 && empty)
+    {
+        rc = readRecordPage(fileHandle, numPages - 1, pageData);
+        if (rc != SUCCESS)
+            break;
+        SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
+        for (unsigned slot = 0; empty && slot < slotHeader.recordEntriesNumber; slot++)
+            empty = getSlotStatus(getSlotDirectoryRecordEntry(pageData, slot)) == DEAD;
+        if (empty)
+            numPages--;
+    }
+    PageBufferPool::release(pageData);
+    if (rc == SUCCESS && numPages < fileHandle.getNumberOfPages() && fileHandle.truncate(numPages))
+        rc = RBFM_WRITE_FAILED;
+    return rc;
+}
+
 RC RecordBasedFileManager::insertRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, RID &rid) 
+{
+    vector<char> buffer;
+    const void *stored;
+    RC rc = encodeRecord(fileHandle, recordDescriptor, data, buffer, stored);
+    if (rc != SUCCESS)
+        return rc;
+    rc = insertRecordFrom(fileHandle, recordDescriptor, stored, rid, 0, false);
+    if (rc != SUCCESS && fileHandle.overflow != NULL)
+        fileHandle.overflow->freeRecord(recordDescriptor, stored);
+    return rc;
+}
+
+RC RecordBasedFileManager::appendRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, RID &rid)
+{
+    // Only the last page is considered, so a scan returns records in the order they were appended
+    unsigned numPages = fileHandle.getNumberOfPages();
+    unsigned firstPage = numPages > 0 ? numPages - 1 : 0;
+    vector<char> buffer;
+    const void *stored;
+    RC rc = encodeRecord(fileHandle, recordDescriptor, data, buffer, stored);
+    if (rc != SUCCESS)
+        return rc;
+    rc = insertRecordFrom(fileHandle, recordDescriptor, stored, rid, firstPage, false);
+    if (rc != SUCCESS && fileHandle.overflow != NULL)
+        fileHandle.overflow->freeRecord(recordDescriptor, stored);
+    return rc;
+}
+
+RC RecordBasedFileManager::appendRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, TailPage &tail, RID &rid)
+{
+    vector<char> buffer;
+    const void *stored;
+    RC rc = encodeRecord(fileHandle, recordDescriptor, data, buffer, stored);
+    if (rc != SUCCESS)
+        return rc;
+    rc = appendStoredRecord(fileHandle, recordDescriptor, stored, tail, rid);
+    if (rc != SUCCESS && fileHandle.overflow != NULL)
+        fileHandle.overflow->freeRecord(recordDescriptor, stored);
+    return rc;
+}
+
+RC RecordBasedFileManager::appendStoredRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, TailPage &tail, RID &rid)
+{
+    // The first record goes to the last page of the file, read once
+    if (tail.page.empty())
+    {
+        unsigned numPages = fileHandle.getNumberOfPages();
+        tail.page.resize(fileHandle.getPageSize());
+        tail.dirty = false;
+        tail.pageNum = numPages > 0 ? numPages - 1 : 0;
+        RC rc = SUCCESS;
+        if (numPages > 0)
+            rc = readRecordPage(fileHandle, tail.pageNum, tail.page.data());
+        else
+            newRecordBasedPage(tail.page.data(), fileHandle.getPageSize());
+        if (rc != SUCCESS)
+        {
+            tail.page.clear();
+            return rc;
+        }
+    }
+
+    unsigned slot;
+    if (!appendToPage(tail.page.data(), recordDescriptor, data, slot))
+    {
+        // Full: write it and go on with a new page of the same format
+        RC rc = flushTail(fileHandle, tail);
+        if (rc != SUCCESS)
+            return rc;
+        if (isPaxPage(tail.page.data()))
+            newPaxPage(tail.page.data(), fileHandle.getPageSize());
+        else
+            newRecordBasedPage(tail.page.data(), fileHandle.getPageSize());
+        tail.pageNum = fileHandle.getNumberOfPages();
+        // Too large for a page of its own
+        if (!appendToPage(tail.page.data(), recordDescriptor, data, slot))
+            return RBFM_APPEND_FAILED;
+    }
+    tail.dirty = true;
+
+    rid.pageNum = tail.pageNum;
+    rid.slotNum = slot;
+    return widenZoneMap(fileHandle, tail.pageNum, tail.page.data(), slot);
+}
+
+bool RecordBasedFileManager::appendToPage(void *page, const vector<Attribute> &recordDescriptor, const void *data, unsigned &slot)
+{
+    // PAX pages only have free slots after the last one unless records were deleted
+    if (isPaxPage(page))
+        return insertPaxRecord(page, recordDescriptor, data, slot);
+    slot = getSlotDirectoryHeader(page).recordEntriesNumber;
+    return insertSlottedRecord(page, recordDescriptor, data, 0, slot);
+}
+
+RC RecordBasedFileManager::flushTail(FileHandle &fileHandle, TailPage &tail)
+{
+    if (tail.page.empty() || !tail.dirty)
+        return SUCCESS;
+    if (tail.pageNum < fileHandle.getNumberOfPages())
+    {
+        if (fileHandle.writePage(tail.pageNum, tail.page.data()))
+            return RBFM_WRITE_FAILED;
+    }
+    else if (fileHandle.appendPage(tail.page.data()))
+        return RBFM_APPEND_FAILED;
+    tail.dirty = false;
+    return SUCCESS;
+}
+
+RC RecordBasedFileManager::insertRecordFrom(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, RID &rid,
+        unsigned firstPage, bool movedIn)
 {
     // Gets the size of the record.
     unsigned recordSize = getRecordSize(recordDescriptor, data);
+    unsigned reserve = getFillReserve(fileHandle);
 
     // Cycles through pages looking for enough free space for the new entry.
-    void *pageData = malloc(PAGE_SIZE);
+    void *pageData = PageBufferPool::acquire();
     if (pageData == NULL)
         return RBFM_MALLOC_FAILED;
     bool pageFound = false;
+    bool pax = false;
     unsigned i;
+    unsigned slot = 0;
     unsigned numPages = fileHandle.getNumberOfPages();
-    for (i = 0; i < numPages; i++)
+    for (i = firstPage; i < numPages; i++)
     {
-        if (fileHandle.readPage(i, pageData))
-            return RBFM_READ_FAILED;
+        RC rc = readRecordPage(fileHandle, i, pageData);
+        if (rc != SUCCESS)
+        {
+            PageBufferPool::release(pageData);
+            return rc;
+        }
+        fileHandle.stats->insertPagesScanned++;
+
+        // PAX pages are filled as they are tested
+        pax = isPaxPage(pageData);
+        if (pax && insertPaxRecord(pageData, recordDescriptor, data, slot))
+        {
+            pageFound = true;
+            break;
+        }
 
         // When we find a page with enough space (accounting also for the size that will be added to the slot directory), we stop the loop.
-        if (getPageFreeSpaceSize(pageData) >= sizeof(SlotDirectoryRecordEntry) + recordSize)
+        // The space the fill factor reserves is for updates; a new page takes the record anyway.
+        if (!pax && getPageFreeSpaceSize(pageData) >= sizeof(SlotDirectoryRecordEntry) + recordSize + reserve)
         {
             pageFound = true;
             break;
@@ -96,31 +619,35 @@ RC RecordBasedFileManager::insertRecord(FileHandle &fileHandle, const vector<Att
     }
 
     // If we can't find a page with enough space, we create a new one
-    if(!pageFound)
+    if(!pageFound && pax)
+    {
+        newPaxPage(pageData, fileHandle.getPageSize());
+        // Too large for a page of its own
+        if (!insertPaxRecord(pageData, recordDescriptor, data, slot))
+        {
+            PageBufferPool::release(pageData);
+            return RBFM_APPEND_FAILED;
+        }
+    }
+    else if (!pageFound)
     {
-        newRecordBasedPage(pageData);
+        newRecordBasedPage(pageData, fileHandle.getPageSize());
     }
 
-    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
+    // Too large for a page of its own
+    if (!pax)
+        slot = getOpenSlot(pageData);
+    if (!pax && !insertSlottedRecord(pageData, recordDescriptor, data, 0, slot))
+    {
+        PageBufferPool::release(pageData);
+        return RBFM_APPEND_FAILED;
+    }
+    if (movedIn)
+        setMovedIn(pageData, slot, true);
 
     // Setting the return RID.
     rid.pageNum = i;
-    rid.slotNum = getOpenSlot(pageData);
-
-    // Adding the new record reference in the slot directory.
-    SlotDirectoryRecordEntry newRecordEntry;
-    newRecordEntry.length = recordSize;
-    newRecordEntry.offset = slotHeader.freeSpaceOffset - recordSize;
-    setSlotDirectoryRecordEntry(pageData, rid.slotNum, newRecordEntry);
-
-    // Updating the slot directory header.
-    slotHeader.freeSpaceOffset = newRecordEntry.offset;
-    if (rid.slotNum == slotHeader.recordEntriesNumber)
-        slotHeader.recordEntriesNumber += 1;
-    setSlotDirectoryHeader(pageData, slotHeader);
-
-    // Adding the record data.
-    setRecordAtOffset (pageData, newRecordEntry.offset, recordDescriptor, data);
+    rid.slotNum = slot;
 
     // Writing the page to disk.
     if (pageFound)
@@ -134,23 +661,78 @@ RC RecordBasedFileManager::insertRecord(FileHandle &fileHandle, const vector<Att
             return RBFM_APPEND_FAILED;
     }
 
-    free(pageData);
-    return SUCCESS;
+    RC rc = widenZoneMap(fileHandle, i, pageData, rid.slotNum);
+    PageBufferPool::release(pageData);
+    return rc;
+}
+
+// Put the record in a slot of the slotted page: a dead one or the one after the last. Returns false if it doesn't fit.
+bool RecordBasedFileManager::insertSlottedRecord(void *page, const vector<Attribute> &recordDescriptor, const void *data, unsigned reserve,
+        unsigned slot)
+{
+    unsigned recordSize = getRecordSize(recordDescriptor, data);
+    if (getPageFreeSpaceSize(page) < sizeof(SlotDirectoryRecordEntry) + recordSize + reserve)
+        return false;
+    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(page);
+
+    // Adding the new record reference in the slot directory.
+    SlotDirectoryRecordEntry newRecordEntry;
+    newRecordEntry.length = recordSize;
+    newRecordEntry.offset = slotHeader.freeSpaceOffset - recordSize;
+    setSlotDirectoryRecordEntry(page, slot, newRecordEntry);
+
+    // Updating the slot directory header.
+    slotHeader.freeSpaceOffset = newRecordEntry.offset;
+    if (slot == slotHeader.recordEntriesNumber)
+        slotHeader.recordEntriesNumber += 1;
+    setSlotDirectoryHeader(page, slotHeader);
+
+    // Adding the record data.
+    setRecordAtOffset (page, newRecordEntry.offset, recordDescriptor, data);
+    return true;
+}
+
+unsigned RecordBasedFileManager::getFillReserve(FileHandle &fileHandle)
+{
+    if (fileHandle.fillFactor >= 100)
+        return 0;
+    return fileHandle.getPageSize() * (100 - fileHandle.fillFactor) / 100;
 }
 
 RC RecordBasedFileManager::readRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid, void *data) 
+{
+    if (fileHandle.dictionary == NULL && fileHandle.overflow == NULL)
+        return readStoredRecord(fileHandle, recordDescriptor, rid, data);
+
+    // Records with codes or pointers are read into a buffer of their own and decoded into data
+    void *record = PageBufferPool::acquire();
+    RC rc = readStoredRecord(fileHandle, recordDescriptor, rid, record);
+    if (rc == SUCCESS)
+        rc = decodeRecord(fileHandle, recordDescriptor, record, data);
+    PageBufferPool::release(record);
+    return rc;
+}
+
+RC RecordBasedFileManager::readStoredRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid, void *data)
 {
     // Retrieve the specific page
-    void *pageData = malloc(PAGE_SIZE);
+    void *pageData = PageBufferPool::acquire();
     if (pageData == NULL)
         return RBFM_MALLOC_FAILED;
-    if (fileHandle.readPage(rid.pageNum, pageData))
-        return RBFM_READ_FAILED;
+    RC rc = readRecordPage(fileHandle, rid.pageNum, pageData);
+    if (rc != SUCCESS)
+    {
+        PageBufferPool::release(pageData);
+        return rc;
+    }
 
     // Checks if the specific slot id exists in the page
     SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
     if(slotHeader.recordEntriesNumber <= rid.slotNum)
+    {
+        PageBufferPool::release(pageData);
         return RBFM_SLOT_DN_EXIST;
+    }
 
     // Gets the slot directory record entry data
     SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, rid.slotNum);
@@ -160,20 +742,24 @@ RC RecordBasedFileManager::readRecord(FileHandle &fileHandle, const vector<Attri
     {
         // Error to read a deleted record
         case DEAD:
-            free(pageData);
+            PageBufferPool::release(pageData);
             return RBFM_READ_AFTER_DEL;
         // Get the forwarding address from the record entry and recurse
         case MOVED:
-            free(pageData);
-            RID newRid;
-            newRid.pageNum = recordEntry.length;
-            newRid.slotNum = -recordEntry.offset;
-            return readRecord(fileHandle, recordDescriptor, newRid, data);
+        {
+            RID newRid = getForwardingAddress(pageData, recordEntry);
+            PageBufferPool::release(pageData);
+            fileHandle.stats->forwardHops++;
+            return readStoredRecord(fileHandle, recordDescriptor, newRid, data);
+        }
         // Retrieve the actual entry data
         case VALID:
             int32_t offset = recordEntry.offset;
-            getRecordAtOffset(pageData, offset, recordDescriptor, data);
-            free(pageData);
+            if (isPaxPage(pageData))
+                getPaxRecord(pageData, rid.slotNum, recordDescriptor, data);
+            else
+                getRecordAtOffset(pageData, offset, recordDescriptor, data);
+            PageBufferPool::release(pageData);
             return SUCCESS;
     }
     // Not possible to reach this point, but compiler doesn't know that
@@ -181,16 +767,39 @@ RC RecordBasedFileManager::readRecord(FileHandle &fileHandle, const vector<Attri
 }
 
 RC RecordBasedFileManager::deleteRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid)
+{
+    if (fileHandle.overflow == NULL)
+        return deleteStoredRecord(fileHandle, recordDescriptor, rid);
+
+    // The overflow pages of the record are freed once it is gone
+    void *record = PageBufferPool::acquire();
+    RC rc = readStoredRecord(fileHandle, recordDescriptor, rid, record);
+    if (rc == SUCCESS)
+        rc = deleteStoredRecord(fileHandle, recordDescriptor, rid);
+    if (rc == SUCCESS)
+        rc = fileHandle.overflow->freeRecord(recordDescriptor, record);
+    PageBufferPool::release(record);
+    return rc;
+}
+
+RC RecordBasedFileManager::deleteStoredRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid)
 {
     // Get page
-    void *pageData = malloc(PAGE_SIZE);
-    if (fileHandle.readPage(rid.pageNum, pageData) != SUCCESS)
-        return RBFM_READ_FAILED;
+    void *pageData = PageBufferPool::acquire();
+    RC rc = readRecordPage(fileHandle, rid.pageNum, pageData);
+    if (rc != SUCCESS)
+    {
+        PageBufferPool::release(pageData);
+        return rc;
+    }
 
     // Get page header
     SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
     if (slotHeader.recordEntriesNumber <= rid.slotNum)
+    {
+        PageBufferPool::release(pageData);
         return RBFM_SLOT_DN_EXIST;
+    }
 
     // Get slot record entry data
     SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, rid.slotNum);
@@ -198,32 +807,32 @@ RC RecordBasedFileManager::deleteRecord(FileHandle &fileHandle, const vector<Att
     // Cannot delete a deleted page
     if (status == DEAD)
     {
-        free(pageData);
+        PageBufferPool::release(pageData);
         return RBFM_SLOT_DN_EXIST;
     }
     // Recursively delete moved pages
     else if (status == MOVED)
     {
-        RID newRid;
-        newRid.pageNum = recordEntry.length;
-        newRid.slotNum = -recordEntry.offset;
-        RC rc = deleteRecord(fileHandle, recordDescriptor, newRid);
+        rc = deleteStoredRecord(fileHandle, recordDescriptor, getForwardingAddress(pageData, recordEntry));
         if (rc != SUCCESS)
         {
-            free(pageData);
+            PageBufferPool::release(pageData);
             return rc;
         }
-        markSlotDeleted(pageData, rid.slotNum);
     }
-    else if (status == VALID)
+    markSlotDeleted(pageData, rid.slotNum);
+    // The varchars and tombstones of PAX records are reclaimed once the heap runs out of space
+    if (!isPaxPage(pageData))
     {
-        markSlotDeleted(pageData, rid.slotNum);
         reorganizePage(pageData);
+        fileHandle.stats->pageReorganizations++;
     }
     
     // Once we've deleted the page(s), write changes to disk
-    RC rc = fileHandle.writePage(rid.pageNum, pageData);
-    free(pageData);
+    rc = fileHandle.writePage(rid.pageNum, pageData);
+    if (rc == SUCCESS)
+        rc = summarizePage(fileHandle, rid.pageNum, pageData);
+    PageBufferPool::release(pageData);
     return rc;
 }
 
@@ -233,20 +842,87 @@ RC RecordBasedFileManager::deleteRecord(FileHandle &fileHandle, const vector<Att
 // Larger dnf: remove, reorganize, insert into new page and update slot info
 // same: do nothing
 RC RecordBasedFileManager::updateRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, const RID &rid)
+{
+    // The overflow pages of the old values are freed once the new ones replaced them
+    void *oldRecord = NULL;
+    RC rc = SUCCESS;
+    if (fileHandle.overflow != NULL)
+    {
+        oldRecord = PageBufferPool::acquire();
+        rc = readStoredRecord(fileHandle, recordDescriptor, rid, oldRecord);
+    }
+
+    vector<char> buffer;
+    const void *stored;
+    if (rc == SUCCESS)
+        rc = encodeRecord(fileHandle, recordDescriptor, data, buffer, stored);
+    if (rc == SUCCESS)
+    {
+        rc = updateStoredRecord(fileHandle, recordDescriptor, stored, rid);
+        if (oldRecord != NULL)
+            fileHandle.overflow->freeRecord(recordDescriptor, rc == SUCCESS ? oldRecord : stored);
+    }
+    PageBufferPool::release(oldRecord);
+    return rc;
+}
+
+RC RecordBasedFileManager::encodeRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data,
+        vector<char> &buffer, const void *&stored)
+{
+    stored = data;
+    RC rc = SUCCESS;
+    if (fileHandle.overflow != NULL)
+    {
+        rc = fileHandle.overflow->storeRecord(recordDescriptor, data, buffer);
+        stored = buffer.data();
+    }
+    if (rc == SUCCESS && fileHandle.dictionary != NULL)
+    {
+        vector<char> encoded;
+        rc = fileHandle.dictionary->encodeRecord(recordDescriptor, stored, encoded);
+        if (rc == SUCCESS)
+        {
+            buffer.swap(encoded);
+            stored = buffer.data();
+        }
+        else if (fileHandle.overflow != NULL)
+            fileHandle.overflow->freeRecord(recordDescriptor, stored);
+    }
+    return rc;
+}
+
+RC RecordBasedFileManager::decodeRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *stored, void *data)
+{
+    if (fileHandle.overflow == NULL)
+        return fileHandle.dictionary->decodeRecord(recordDescriptor, stored, data);
+    if (fileHandle.dictionary == NULL)
+        return fileHandle.overflow->fetchRecord(recordDescriptor, stored, data);
+
+    // Codes first, the values out of line last: they may not fit a page
+    void *record = PageBufferPool::acquire();
+    RC rc = fileHandle.dictionary->decodeRecord(recordDescriptor, stored, record);
+    if (rc == SUCCESS)
+        rc = fileHandle.overflow->fetchRecord(recordDescriptor, record, data);
+    PageBufferPool::release(record);
+    return rc;
+}
+
+RC RecordBasedFileManager::updateStoredRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, const RID &rid)
 {
     // Retrieve the specific page
-    void *pageData = malloc(PAGE_SIZE);
-    if (fileHandle.readPage(rid.pageNum, pageData))
+    void *pageData = PageBufferPool::acquire();
+    RC readRc = readRecordPage(fileHandle, rid.pageNum, pageData);
+    if (readRc != SUCCESS)
     {
-        free(pageData);
-        return RBFM_READ_FAILED;
+        PageBufferPool::release(pageData);
+        return readRc;
     }
 
     // Checks if the specific slot id exists in the page
     SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
     if(slotHeader.recordEntriesNumber <= rid.slotNum)
     {
-        free(pageData);
+        PageBufferPool::release(pageData);
         return RBFM_SLOT_DN_EXIST;
     }
 
@@ -258,26 +934,70 @@ RC RecordBasedFileManager::updateRecord(FileHandle &fileHandle, const vector<Att
     {
         // Error to update a deleted record
         case DEAD:
-            free(pageData);
+            PageBufferPool::release(pageData);
             return RBFM_READ_AFTER_DEL;
         // Get the forwarding address from the record entry and recurse
         case MOVED:
-            free(pageData);
-            RID newRid;
-            newRid.pageNum = recordEntry.length;
-            newRid.slotNum = -recordEntry.offset;
-            return updateRecord(fileHandle, recordDescriptor, data, newRid);
+        {
+            RID newRid = getForwardingAddress(pageData, recordEntry);
+            PageBufferPool::release(pageData);
+            RC rc = updateStoredRecord(fileHandle, recordDescriptor, data, newRid);
+            if (rc != SUCCESS)
+                return rc;
+            return shortenForwarding(fileHandle, rid, newRid);
+        }
         default:
         break;
     }
+
+    // A record updated where it is stays marked as moved in
+    bool movedIn = isMovedIn(pageData, recordEntry);
+
+    // PAX pages: the values are replaced in place if they fit once the old ones are gone, otherwise
+    // the record moves like on slotted pages
+    if (isPaxPage(pageData))
+    {
+        markSlotDeleted(pageData, rid.slotNum);
+        if (paxLayoutMatches(pageData, recordDescriptor) && reservePaxHeap(pageData, getPaxHeapSize(recordDescriptor, data)))
+        {
+            setPaxRecord(pageData, rid.slotNum, recordDescriptor, data);
+            setMovedIn(pageData, rid.slotNum, movedIn);
+        }
+        else
+        {
+            RID newRid;
+            RC rc = insertRecordFrom(fileHandle, recordDescriptor, data, newRid, 0, true);
+            if (rc != SUCCESS)
+            {
+                PageBufferPool::release(pageData);
+                return rc;
+            }
+            // The heap is full even without the old values: the record stays where it was
+            if (!setForwardingAddress(pageData, rid.slotNum, newRid, movedIn))
+            {
+                deleteStoredRecord(fileHandle, recordDescriptor, newRid);
+                PageBufferPool::release(pageData);
+                return RBFM_WRITE_FAILED;
+            }
+        }
+        RC rc = fileHandle.writePage(rid.pageNum, pageData);
+        if (rc == SUCCESS)
+            rc = summarizePage(fileHandle, rid.pageNum, pageData);
+        PageBufferPool::release(pageData);
+        return rc;
+    }
+
     // Do actual work
     // Gets the size of the updated record
     unsigned recordSize = getRecordSize(recordDescriptor, data);
     if (recordSize  == recordEntry.length)
     {
         setRecordAtOffset(pageData, recordEntry.offset, recordDescriptor, data);
+        setMovedIn(pageData, rid.slotNum, movedIn);
         RC rc = fileHandle.writePage(rid.pageNum, pageData);
-        free(pageData);
+        if (rc == SUCCESS)
+            rc = summarizePage(fileHandle, rid.pageNum, pageData);
+        PageBufferPool::release(pageData);
         return rc;
     }
     else if (recordSize < recordEntry.length)
@@ -285,9 +1005,13 @@ RC RecordBasedFileManager::updateRecord(FileHandle &fileHandle, const vector<Att
         setRecordAtOffset(pageData, recordEntry.offset, recordDescriptor, data);
         recordEntry.length = recordSize;
         setSlotDirectoryRecordEntry(pageData, rid.slotNum, recordEntry);
+        setMovedIn(pageData, rid.slotNum, movedIn);
         reorganizePage(pageData);
+        fileHandle.stats->pageReorganizations++;
         RC rc = fileHandle.writePage(rid.pageNum, pageData);
-        free(pageData);
+        if (rc == SUCCESS)
+            rc = summarizePage(fileHandle, rid.pageNum, pageData);
+        PageBufferPool::release(pageData);
         return rc;
     }
     else if (recordSize > recordEntry.length)
@@ -295,26 +1019,26 @@ RC RecordBasedFileManager::updateRecord(FileHandle &fileHandle, const vector<Att
         unsigned space = getPageFreeSpaceSize(pageData) + recordEntry.length;
         if (recordSize > space)
         {
-            // Need to insert then set forward address then reorganize
+            // Need to insert, reorganize, then leave a tombstone in the freed space
             RID newRid;
-            RC rc = insertRecord(fileHandle, recordDescriptor, data, newRid);
+            RC rc = insertRecordFrom(fileHandle, recordDescriptor, data, newRid, 0, true);
             if (rc != SUCCESS)
             {
-                free(pageData);
+                PageBufferPool::release(pageData);
                 return rc;
             }
-            recordEntry.length = newRid.pageNum;
-            recordEntry.offset = -newRid.slotNum;
-            setSlotDirectoryRecordEntry(pageData, rid.slotNum, recordEntry);
+            markSlotDeleted(pageData, rid.slotNum);
             reorganizePage(pageData);
+            fileHandle.stats->pageReorganizations++;
+            // Records take at least the size of a tombstone, so it fits
+            setForwardingAddress(pageData, rid.slotNum, newRid, movedIn);
         }
         else
         {
             // Need to set header to DEAD and reorganize to consolidate free space
-            recordEntry.length = 0;
-            recordEntry.offset = 0;
-            setSlotDirectoryRecordEntry(pageData, rid.slotNum, recordEntry);
+            markSlotDeleted(pageData, rid.slotNum);
             reorganizePage(pageData);
+            fileHandle.stats->pageReorganizations++;
 
             // Get updated slotHeader with new free space pointer
             slotHeader = getSlotDirectoryHeader(pageData);
@@ -329,10 +1053,13 @@ RC RecordBasedFileManager::updateRecord(FileHandle &fileHandle, const vector<Att
 
             // Add new record data
             setRecordAtOffset (pageData, recordEntry.offset, recordDescriptor, data);
+            setMovedIn(pageData, rid.slotNum, movedIn);
         }
     }
     RC rc = fileHandle.writePage(rid.pageNum, pageData);
-    free(pageData);
+    if (rc == SUCCESS)
+        rc = summarizePage(fileHandle, rid.pageNum, pageData);
+    PageBufferPool::release(pageData);
     return rc;
 }
 
@@ -402,19 +1129,23 @@ RC RecordBasedFileManager::printRecord(const vector<Attribute> &recordDescriptor
 
 RC RecordBasedFileManager::readAttribute(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid, const string &attributeName, void *data)
 {
-    char *pageData = (char*)malloc(PAGE_SIZE);
+    char *pageData = (char*)PageBufferPool::acquire();
     if (pageData == NULL)
         return RBFM_MALLOC_FAILED;
-    if (fileHandle.readPage(rid.pageNum, pageData) != SUCCESS)
+    RC rc = readRecordPage(fileHandle, rid.pageNum, pageData);
+    if (rc != SUCCESS)
     {
-        free(pageData);
-        return RBFM_READ_FAILED;
+        PageBufferPool::release(pageData);
+        return rc;
     }
     // Get record header, recurse if forwarded
     // Checks if the specific slot id exists in the page
     SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
-    if(slotHeader.recordEntriesNumber < rid.slotNum)
+    if(slotHeader.recordEntriesNumber <= rid.slotNum)
+    {
+        PageBufferPool::release(pageData);
         return RBFM_SLOT_DN_EXIST;
+    }
 
     // Gets the slot directory record entry data
     SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, rid.slotNum);
@@ -424,15 +1155,16 @@ RC RecordBasedFileManager::readAttribute(FileHandle &fileHandle, const vector<At
     {
         // Error to get attribute of a deleted record
         case DEAD:
-            free(pageData);
+            PageBufferPool::release(pageData);
             return RBFM_READ_AFTER_DEL;
         // Get the forwarding address from the record entry and recurse
         case MOVED:
-            free(pageData);
-            RID newRid;
-            newRid.pageNum = recordEntry.length;
-            newRid.slotNum = -recordEntry.offset;
+        {
+            RID newRid = getForwardingAddress(pageData, recordEntry);
+            PageBufferPool::release(pageData);
+            fileHandle.stats->forwardHops++;
             return readAttribute(fileHandle, recordDescriptor, newRid, attributeName, data);
+        }
         default:
         break;
     }
@@ -447,8 +1179,40 @@ RC RecordBasedFileManager::readAttribute(FileHandle &fileHandle, const vector<At
         return RBFM_NO_SUCH_ATTR;
     AttrType type = recordDescriptor[index].type;
     // Write attribute to data
-    getAttributeFromRecord(pageData, offset, index, type, data);
-    free(pageData);
+    if (isPaxPage(pageData))
+        getPaxAttribute(pageData, rid.slotNum, index, type, data);
+    else
+        getAttributeFromRecord(pageData, offset, index, type, data);
+    PageBufferPool::release(pageData);
+
+    // Replace the code of an encoded attribute by its value
+    Dictionary *dictionary = fileHandle.dictionary;
+    if (dictionary != NULL && dictionary->isEncoded(index) && !(((char*) data)[0] & (1 << 7)))
+    {
+        uint16_t code;
+        memcpy(&code, (char*) data + 1 + VARCHAR_LENGTH_SIZE, DICTIONARY_CODE_SIZE);
+        const string *value = dictionary->decode(index, code);
+        if (value == NULL)
+            return RBFM_DICTIONARY_FAILED;
+        uint32_t length = value->size();
+        memcpy((char*) data + 1, &length, VARCHAR_LENGTH_SIZE);
+        memcpy((char*) data + 1 + VARCHAR_LENGTH_SIZE, value->data(), length);
+    }
+
+    // Replace the tagged value or pointer of an out-of-line attribute by the value
+    OverflowFile *overflow = fileHandle.overflow;
+    if (overflow != NULL && overflow->isOutOfLine(index) && !(((char*) data)[0] & (1 << 7)))
+    {
+        const char *field = (char*) data + 1 + VARCHAR_LENGTH_SIZE;
+        uint32_t length;
+        memcpy(&length, (char*) data + 1, VARCHAR_LENGTH_SIZE);
+        vector<char> buffer;
+        rc = overflow->fetchValue(field, length, buffer);
+        if (rc != SUCCESS)
+            return rc;
+        memcpy((char*) data + 1, &length, VARCHAR_LENGTH_SIZE);
+        memmove((char*) data + 1 + VARCHAR_LENGTH_SIZE, field, length);
+    }
     return SUCCESS;
 }
 
@@ -465,14 +1229,21 @@ RC RecordBasedFileManager::readAttribute(FileHandle &fileHandle, const vector<At
 }
 
 RBFM_ScanIterator::RBFM_ScanIterator()
-: currPage(0), currSlot(0), totalPage(0), totalSlot(0)
+: currPage(0), currSlot(0), totalPage(0), totalSlot(0), pageStride(1), pageData(NULL), paxPage(false)
 {
     rbfm = RecordBasedFileManager::instance();
 }
 
+unsigned RBFM_ScanIterator::samplePages(unsigned maxPages)
+{
+    pageStride = max(1u, (totalPage + maxPages - 1) / max(1u, maxPages));
+    return (totalPage + pageStride - 1) / pageStride;
+}
+
 RC RBFM_ScanIterator::close()
 {
-    free(pageData);
+    PageBufferPool::release(pageData);
+    pageData = NULL;
     return SUCCESS;
 }
 
@@ -489,8 +1260,9 @@ RC RBFM_ScanIterator::scanInit(FileHandle &fh,
     currSlot = 0;
     totalPage = 0;
     totalSlot = 0;
+    pageStride = 1;
     // Keep a buffer to hold the current page
-    pageData = malloc(PAGE_SIZE);
+    pageData = PageBufferPool::acquire();
 
     // Store the variables passed in to
     fileHandle = fh;
@@ -501,31 +1273,92 @@ RC RBFM_ScanIterator::scanInit(FileHandle &fh,
     attributeNames = an;
 
     skipList.clear();
+    batchEval = false;
+    decodeCondition = false;
+    fetchCondition = false;
+
+    // Resolve the projected attributes once, getNextRecord only uses their indexes
+    projection.clear();
+    for (const string &name : attributeNames)
+    {
+        auto pred = [&](Attribute a) {return a.name == name;};
+        auto iterPos = find_if(recordDescriptor.begin(), recordDescriptor.end(), pred);
+        projection.push_back(distance(recordDescriptor.begin(), iterPos));
+    }
 
     // Get total number of pages
     totalPage = fh.getNumberOfPages();
-    if (totalPage > 0)
+    pageSkips.clear();
+    if (totalPage == 0)
+        return SUCCESS;
+
+    // If we don't need to do any comparisons, we can ignore the condition attribute
+    if (co != NO_OP)
     {
-        if (fh.readPage(0, pageData))
-            return RBFM_READ_FAILED;
+        // Else, we need to find the condition attribute's index in the record descriptor
+        auto pred = [&](Attribute a) {return a.name == conditionAttribute;};
+        auto iterPos = find_if(recordDescriptor.begin(), recordDescriptor.end(), pred);
+        attrIndex = distance(recordDescriptor.begin(), iterPos);
+        if (attrIndex == recordDescriptor.size())
+            return RBFM_NO_SUCH_ATTR;
+
+        // Equality on an encoded attribute compares codes, which are equal if and only if the values are.
+        // A value without a code gets one no record has.
+        Dictionary *dictionary = fh.dictionary;
+        if (dictionary != NULL && value != NULL && dictionary->isEncoded(attrIndex))
+        {
+            if (co == EQ_OP || co == NE_OP)
+            {
+                uint32_t length;
+                memcpy(&length, value, VARCHAR_LENGTH_SIZE);
+                uint16_t code = dictionary->lookup(attrIndex, (const char*) value + VARCHAR_LENGTH_SIZE, length);
+                uint32_t codeLength = DICTIONARY_CODE_SIZE;
+                encodedValue.resize(VARCHAR_LENGTH_SIZE + DICTIONARY_CODE_SIZE);
+                memcpy(encodedValue.data(), &codeLength, VARCHAR_LENGTH_SIZE);
+                memcpy(encodedValue.data() + VARCHAR_LENGTH_SIZE, &code, DICTIONARY_CODE_SIZE);
+                value = encodedValue.data();
+            }
+            else
+                decodeCondition = true;
+        }
+
+        // The records only have pointers to the long values of an out-of-line attribute
+        fetchCondition = fh.overflow != NULL && fh.overflow->isOutOfLine(attrIndex);
+
+        // Fixed width attributes and varchar (in)equality can be tested a page at a time
+        AttrType condType = recordDescriptor[attrIndex].type;
+        batchEval = value != NULL && !fetchCondition && (condType != TypeVarChar || co == EQ_OP || co == NE_OP);
+
+        // Rule out pages with the zone map, one entry read at a time
+        ZoneMap *zoneMap = fh.zoneMap;
+        int zoneAttr = zoneMap ? zoneMap->findAttribute(attrIndex) : -1;
+        // Codes aren't ordered like the values, so only equality can use the zone map of an encoded attribute
+        if (zoneAttr >= 0 && value != NULL && !decodeCondition)
+        {
+            vector<ZoneMapEntry> entries;
+            pageSkips.resize(totalPage);
+            for (unsigned i = 0; i < totalPage; i++)
+            {
+                if (zoneMap->readEntries(i, entries))
+                    return RBFM_READ_FAILED;
+                pageSkips[i] = !ZoneMap::mayMatch(entries[zoneAttr], zoneMap->getAttributeType(zoneAttr), co, value);
+            }
+        }
     }
-    else
+
+    // Get the first page that may have results ready
+    skipPages();
+    if (currPage >= totalPage)
         return SUCCESS;
+    RC rc = rbfm->readRecordPage(fh, currPage, pageData);
+    if (rc != SUCCESS)
+        return rc;
 
     // Get number of slots on first page
     SlotDirectoryHeader header = rbfm->getSlotDirectoryHeader(pageData);
     totalSlot = header.recordEntriesNumber;
-
-    // If we don't need to do any comparisons, we can ignore the condition attribute
-    if (co == NO_OP)
-        return SUCCESS;
-
-    // Else, we need to find the condition attribute's index in the record descriptor
-    auto pred = [&](Attribute a) {return a.name == conditionAttribute;};
-    auto iterPos = find_if(recordDescriptor.begin(), recordDescriptor.end(), pred);
-    attrIndex = distance(recordDescriptor.begin(), iterPos);
-    if (attrIndex == recordDescriptor.size())
-        return RBFM_NO_SUCH_ATTR;
+    evaluatePage();
+    locateProjection();
 
     return SUCCESS;
 }
@@ -549,62 +1382,61 @@ RC RBFM_ScanIterator::getNextRecord(RID &rid, void *data)
     char nullIndicator[nullIndicatorSize];
     memset(nullIndicator, 0, nullIndicatorSize);
 
-    SlotDirectoryRecordEntry recordEntry = rbfm->getSlotDirectoryRecordEntry(pageData, currSlot);
-
-    // Unsure how large each attribute will be, set to size of page to be safe
-    void *buffer = malloc(PAGE_SIZE);
-    if (buffer == NULL)
-        return RBFM_MALLOC_FAILED;
-
     // Keep track of offset into data
     unsigned dataOffset = nullIndicatorSize;
 
-    for (unsigned i = 0; i < attributeNames.size(); i++)
+    for (unsigned i = 0; i < projection.size(); i++)
     {
-        // Get index and type of attribute in record
-        auto pred = [&](Attribute a) {return a.name == attributeNames[i];};
-        auto iterPos = find_if(recordDescriptor.begin(), recordDescriptor.end(), pred);
-        unsigned index = distance(recordDescriptor.begin(), iterPos);
+        unsigned index = projection[i];
         if (index == recordDescriptor.size())
             return RBFM_NO_SUCH_ATTR;
         AttrType type = recordDescriptor[index].type;
 
-        // Read attribute into buffer
-        rbfm->getAttributeFromRecord(pageData, recordEntry.offset, index, type, buffer);
-        // Determine if null
-        char null;
-        memcpy (&null, buffer, 1);
-        if (null)
+        // Copy the attribute straight out of the page
+        char *field;
+        uint32_t length;
+        if (!getProjectedLocation(i, field, length))
         {
             int indicatorIndex = i / CHAR_BIT;
             char indicatorMask  = 1 << (CHAR_BIT - 1 - (i % CHAR_BIT));
             nullIndicator[indicatorIndex] |= indicatorMask;
         }
-        // Read from buffer into data
-        else if (type == TypeInt)
-        {
-            memcpy ((char*)data + dataOffset, (char*)buffer + 1, INT_SIZE);
-            dataOffset += INT_SIZE;
-        }
-        else if (type == TypeReal)
-        {
-            memcpy ((char*)data + dataOffset, (char*)buffer + 1, REAL_SIZE);
-            dataOffset += REAL_SIZE;
-        }
         else if (type == TypeVarChar)
         {
-            uint32_t varcharSize;
-            memcpy(&varcharSize, (char*)buffer + 1, VARCHAR_LENGTH_SIZE);
-            memcpy((char*)data + dataOffset, &varcharSize, VARCHAR_LENGTH_SIZE);
+            // Encoded attributes hold a code
+            if (fileHandle.dictionary != NULL && fileHandle.dictionary->isEncoded(index))
+            {
+                uint16_t code;
+                memcpy(&code, field, DICTIONARY_CODE_SIZE);
+                const string *decoded = fileHandle.dictionary->decode(index, code);
+                if (decoded == NULL)
+                    return RBFM_DICTIONARY_FAILED;
+                field = (char*) decoded->data();
+                length = decoded->size();
+            }
+            // Out-of-line attributes are only read from their overflow pages when projected
+            else if (fileHandle.overflow != NULL && fileHandle.overflow->isOutOfLine(index))
+            {
+                const char *fetched = field;
+                RC rc = fileHandle.overflow->fetchValue(fetched, length, fetchedValue);
+                if (rc != SUCCESS)
+                    return rc;
+                field = (char*) fetched;
+            }
+            memcpy((char*)data + dataOffset, &length, VARCHAR_LENGTH_SIZE);
             dataOffset += VARCHAR_LENGTH_SIZE;
-            memcpy((char*)data + dataOffset, (char*)buffer + 1 + VARCHAR_LENGTH_SIZE, varcharSize);
-            dataOffset += varcharSize;
+            memcpy((char*)data + dataOffset, field, length);
+            dataOffset += length;
+        }
+        else
+        {
+            memcpy((char*)data + dataOffset, field, INT_SIZE);
+            dataOffset += INT_SIZE;
         }
     }
-    // Finally set null indicator of data, clean up and return
+    // Finally set null indicator of data and return
     memcpy((char*)data, nullIndicator, nullIndicatorSize);
 
-    free (buffer);
     rid.pageNum = currPage;
     rid.slotNum = currSlot++;
     return SUCCESS;
@@ -619,7 +1451,8 @@ RC RBFM_ScanIterator::getNextSlot()
     {
         // Reinitialize the current slot and increment page number
         currSlot = 0;
-        currPage++;
+        currPage += pageStride;
+        skipPages();
         // If we're done with last page, return EOF
         if (currPage >= totalPage)
             return RBFM_EOF;
@@ -641,139 +1474,264 @@ RC RBFM_ScanIterator::getNextSlot()
     return SUCCESS;
 }
 
+// Move past the pages the zone map rules out
+void RBFM_ScanIterator::skipPages()
+{
+    while (currPage < pageSkips.size() && pageSkips[currPage])
+    {
+        currPage++;
+        fileHandle.stats->zoneMapPagesSkipped++;
+    }
+}
+
 RC RBFM_ScanIterator::getNextPage()
 {
     // Read in page
-    if (fileHandle.readPage(currPage, pageData))
-        return RBFM_READ_FAILED;
+    RC rc = rbfm->readRecordPage(fileHandle, currPage, pageData);
+    if (rc != SUCCESS)
+        return rc;
 
     // Update slot total
     SlotDirectoryHeader header = rbfm->getSlotDirectoryHeader(pageData);
     totalSlot = header.recordEntriesNumber;
+    evaluatePage();
+    locateProjection();
     return SUCCESS;
 }
 
+// Find the minipages of the projected attributes once per page, so records are read from them
+// without going through the footer and minipage headers again
+void RBFM_ScanIterator::locateProjection()
+{
+    paxPage = rbfm->isPaxPage(pageData);
+    if (!paxPage)
+        return;
+    paxColumns.resize(projection.size());
+    for (unsigned i = 0; i < projection.size(); i++)
+    {
+        PaxColumn &column = paxColumns[i];
+        column.values = rbfm->getPaxValues(pageData, projection[i]);
+        if (column.values == NULL)
+            continue;
+        column.nulls = rbfm->getPaxNulls(pageData, projection[i]);
+        PaxMinipageHeader header;
+        memcpy(&header, column.nulls - sizeof(PaxMinipageHeader), sizeof(PaxMinipageHeader));
+        column.varChar = header.type == TypeVarChar;
+    }
+}
+
+// Where the i-th projected attribute of the current slot is, false if it is null
+bool RBFM_ScanIterator::getProjectedLocation(unsigned i, char *&field, uint32_t &length)
+{
+    if (!paxPage)
+        return rbfm->getSlotAttributeLocation(pageData, currSlot, projection[i], field, length);
+
+    // Attributes added after the page was laid out are null
+    const PaxColumn &column = paxColumns[i];
+    if (column.values == NULL || (column.nulls[currSlot / CHAR_BIT] & (1 << (currSlot % CHAR_BIT))))
+        return false;
+    const char *value = column.values + currSlot * PAX_VALUE_SIZE;
+    if (column.varChar)
+    {
+        uint16_t location[2];
+        memcpy(location, value, PAX_VALUE_SIZE);
+        field = (char*) pageData + location[0];
+        length = location[1];
+    }
+    else
+    {
+        field = (char*) value;
+        length = PAX_VALUE_SIZE;
+    }
+    return true;
+}
+
+// Gather the condition attribute of every slot on the current page and test them all at once
+// Dead, moved and null slots get a 0 bit
+void RBFM_ScanIterator::evaluatePage()
+{
+    if (!batchEval)
+        return;
+
+    AttrType condType = recordDescriptor[attrIndex].type;
+    // PAX pages keep the values of the attribute together: the kernels test them in place
+    const char *paxValues = condType != TypeVarChar ? rbfm->getPaxValues(pageData, attrIndex) : NULL;
+    if (paxValues != NULL)
+    {
+        evaluatePaxPage(paxValues);
+        return;
+    }
+    present.assign(totalSlot, false);
+    intValues.assign(totalSlot, 0);
+    realValues.assign(totalSlot, 0);
+    varcharValues.assign(totalSlot, NULL);
+    varcharLengths.assign(totalSlot, 0);
+
+    for (unsigned i = 0; i < totalSlot; i++)
+    {
+        SlotDirectoryRecordEntry recordEntry = rbfm->getSlotDirectoryRecordEntry(pageData, i);
+        if (rbfm->getSlotStatus(recordEntry) != VALID)
+            continue;
+
+        char *field;
+        uint32_t length;
+        if (!rbfm->getSlotAttributeLocation(pageData, i, attrIndex, field, length))
+            continue;
+
+        present[i] = true;
+        if (condType == TypeInt)
+            memcpy(&intValues[i], field, INT_SIZE);
+        else if (condType == TypeReal)
+            memcpy(&realValues[i], field, REAL_SIZE);
+        else
+        {
+            varcharValues[i] = field;
+            varcharLengths[i] = length;
+        }
+    }
+
+    PredicateEvaluator *pe = PredicateEvaluator::instance();
+    pageMatches.resize(PredicateEvaluator::getBitmapSize(totalSlot) + 1);
+    if (condType == TypeInt)
+    {
+        int32_t intValue;
+        memcpy(&intValue, value, INT_SIZE);
+        pe->evalInt(intValues.data(), totalSlot, compOp, intValue, pageMatches.data());
+    }
+    else if (condType == TypeReal)
+    {
+        float realValue;
+        memcpy(&realValue, value, REAL_SIZE);
+        pe->evalReal(realValues.data(), totalSlot, compOp, realValue, pageMatches.data());
+    }
+    else
+    {
+        pe->evalVarCharEq(varcharValues.data(), varcharLengths.data(), totalSlot, compOp, value, pageMatches.data());
+    }
+
+    // Clear the bits of slots without a value
+    for (unsigned i = 0; i < totalSlot; i++)
+    {
+        if (!present[i])
+            pageMatches[i / CHAR_BIT] &= ~(1 << (i % CHAR_BIT));
+    }
+}
+
+// The condition attribute of a PAX page is tested straight out of its minipage, whose null
+// bitmap tells the slots without a value
+void RBFM_ScanIterator::evaluatePaxPage(const char *values)
+{
+    PredicateEvaluator *pe = PredicateEvaluator::instance();
+    pageMatches.resize(PredicateEvaluator::getBitmapSize(totalSlot) + 1);
+    if (recordDescriptor[attrIndex].type == TypeInt)
+    {
+        int32_t intValue;
+        memcpy(&intValue, value, INT_SIZE);
+        pe->evalInt((const int32_t*) values, totalSlot, compOp, intValue, pageMatches.data());
+    }
+    else
+    {
+        float realValue;
+        memcpy(&realValue, value, REAL_SIZE);
+        pe->evalReal((const float*) values, totalSlot, compOp, realValue, pageMatches.data());
+    }
+
+    const char *nulls = rbfm->getPaxNulls(pageData, attrIndex);
+    for (unsigned i = 0; i < totalSlot; i += CHAR_BIT)
+        pageMatches[i / CHAR_BIT] &= ~nulls[i / CHAR_BIT];
+    for (unsigned i = 0; i < totalSlot; i++)
+    {
+        if (rbfm->getSlotStatus(rbfm->getSlotDirectoryRecordEntry(pageData, i)) != VALID)
+            pageMatches[i / CHAR_BIT] &= ~(1 << (i % CHAR_BIT));
+    }
+}
+
 bool RBFM_ScanIterator::checkScanCondition()
 {
     if (compOp == NO_OP) return true;
     if (value == NULL) return false;
+    if (batchEval)
+        return PredicateEvaluator::bitIsSet(pageMatches.data(), currSlot);
+
     Attribute attr = recordDescriptor[attrIndex];
-    // Allocate enough memory to hold attribute and 1 byte null indicator
-    void *data = malloc(1 + attr.length);
-    // Get record entry to get offset
-    SlotDirectoryRecordEntry recordEntry = rbfm->getSlotDirectoryRecordEntry(pageData, currSlot);
-    // Grab the given attribute and store it in data
-    rbfm->getAttributeFromRecord(pageData, recordEntry.offset, attrIndex, attr.type, data);
+    // Find the given attribute inside the page
+    char *field;
+    uint32_t length;
+    if (!rbfm->getSlotAttributeLocation(pageData, currSlot, attrIndex, field, length))
+        return false;
 
-    char null;
-    memcpy(&null, data, 1);
+    if (decodeCondition)
+    {
+        uint16_t code;
+        memcpy(&code, field, DICTIONARY_CODE_SIZE);
+        const string *decoded = fileHandle.dictionary->decode(attrIndex, code);
+        return decoded != NULL && checkScanCondition(decoded->data(), decoded->size(), compOp, value);
+    }
 
-    bool result = false;
-    if (null)
+    if (fetchCondition)
     {
-        result = false;
+        const char *fetched = field;
+        if (fileHandle.overflow->fetchValue(fetched, length, fetchedValue) != SUCCESS)
+            return false;
+        return checkScanCondition(fetched, length, compOp, value);
     }
+
     // Checkscan condition on record data and scan value
-    else if (attr.type == TypeInt)
+    if (attr.type == TypeInt)
     {
         int32_t recordInt;
-        memcpy(&recordInt, (char*)data + 1, INT_SIZE);
-        result = checkScanCondition(recordInt, compOp, value);
+        memcpy(&recordInt, field, INT_SIZE);
+        return checkScanCondition(recordInt, compOp, value);
     }
     else if (attr.type == TypeReal)
     {
         float recordReal;
-        memcpy(&recordReal, (char*)data + 1, REAL_SIZE);
-        result = checkScanCondition(recordReal, compOp, value);
+        memcpy(&recordReal, field, REAL_SIZE);
+        return checkScanCondition(recordReal, compOp, value);
     }
-    else if (attr.type == TypeVarChar)
-    {
-        uint32_t varcharSize;
-        memcpy(&varcharSize, (char*)data + 1, VARCHAR_LENGTH_SIZE);
-        char recordString[varcharSize + 1];
-        memcpy(recordString, (char*)data + 1 + VARCHAR_LENGTH_SIZE, varcharSize);
-        recordString[varcharSize] = '\0';
-
-        result = checkScanCondition(recordString, compOp, value);
-    }
-    free (data);
-    return result;
+    return checkScanCondition(field, length, compOp, value);
 }
 
 bool RBFM_ScanIterator::checkScanCondition(int recordInt, CompOp compOp, const void *value)
 {
     int32_t intValue;
     memcpy (&intValue, value, INT_SIZE);
-
-    switch (compOp)
-    {
-        case EQ_OP: return recordInt == intValue;
-        case LT_OP: return recordInt < intValue;
-        case GT_OP: return recordInt > intValue;
-        case LE_OP: return recordInt <= intValue;
-        case GE_OP: return recordInt >= intValue;
-        case NE_OP: return recordInt != intValue;
-        case NO_OP: return true;
-        // Should never happen
-        default: return false;
-    }
+    return PredicateEvaluator::compare(recordInt, compOp, intValue);
 }
 
 bool RBFM_ScanIterator::checkScanCondition(float recordReal, CompOp compOp, const void *value)
 {
     float realValue;
-    memcpy (&realValue, value, REAL_SIZE);
-
-    switch (compOp)
-    {
-        case EQ_OP: return recordReal == realValue;
-        case LT_OP: return recordReal < realValue;
-        case GT_OP: return recordReal > realValue;
-        case LE_OP: return recordReal <= realValue;
-        case GE_OP: return recordReal >= realValue;
-        case NE_OP: return recordReal != realValue;
-        case NO_OP: return true;
-        // Should never happen
-        default: return false;
-    }
+    memcpy (&realValue, value, REAL_SIZE);
+    return PredicateEvaluator::compare(recordReal, compOp, realValue);
 }
 
-bool RBFM_ScanIterator::checkScanCondition(char *recordString, CompOp compOp, const void *value)
+bool RBFM_ScanIterator::checkScanCondition(const char *recordString, uint32_t recordLength, CompOp compOp, const void *value)
 {
-    if (compOp == NO_OP)
-        return true;
-
-    int32_t valueSize;
+    uint32_t valueSize;
     memcpy(&valueSize, value, VARCHAR_LENGTH_SIZE);
-    char valueStr[valueSize + 1];
-    valueStr[valueSize] = '\0';
-    memcpy(valueStr, (char*) value + VARCHAR_LENGTH_SIZE, valueSize);
-
-    int cmp = strcmp(recordString, valueStr);
-    switch (compOp)
-    {
-        case EQ_OP: return cmp == 0;
-        case LT_OP: return cmp <  0;
-        case GT_OP: return cmp >  0;
-        case LE_OP: return cmp <= 0;
-        case GE_OP: return cmp >= 0;
-        case NE_OP: return cmp != 0;
-        // Should never happen
-        default: return false;
-    }
+    return PredicateEvaluator::compareVarChar(recordString, recordLength, compOp,
+            (const char*) value + VARCHAR_LENGTH_SIZE, valueSize);
 }
 
 // Configures a new record based page, and puts it in "page".
-void RecordBasedFileManager::newRecordBasedPage(void * page)
+void RecordBasedFileManager::newRecordBasedPage(void * page, unsigned pageSize)
 {
-    memset(page, 0, PAGE_SIZE);
+    memset(page, 0, pageSize);
     // Writes the slot directory header.
     SlotDirectoryHeader slotHeader;
-    slotHeader.freeSpaceOffset = PAGE_SIZE;
+    slotHeader.freeSpaceOffset = pageSize;
     slotHeader.recordEntriesNumber = 0;
+    slotHeader.pageBlocks = pageSize / PAGE_SIZE;
+    slotHeader.version = SLOT_DIRECTORY_VERSION;
     setSlotDirectoryHeader(page, slotHeader);
 }
 
+unsigned RecordBasedFileManager::getPageSize(void *page)
+{
+    return getSlotDirectoryHeader(page).pageBlocks * PAGE_SIZE;
+}
+
 SlotDirectoryHeader RecordBasedFileManager::getSlotDirectoryHeader(void * page)
 {
     // Getting the slot directory header.
@@ -856,7 +1814,8 @@ unsigned RecordBasedFileManager::getRecordSize(const vector<Attribute> &recordDe
         }
     }
 
-    return size;
+    // A record leaves room for the tombstone that replaces it when it moves
+    return size < sizeof(RecordTombstone) ? sizeof(RecordTombstone) : size;
 }
 
 // Calculate actual bytes for nulls-indicator for the given field counts
@@ -950,8 +1909,7 @@ void RecordBasedFileManager::getRecordAtOffset(void *page, int32_t offset, const
     memset(nullIndicator, 0, nullIndicatorSize);
 
     // Get number of columns and size of the null indicator for this record
-    RecordLength len = 0;
-    memcpy (&len, (char*)page + offset, sizeof(RecordLength));
+    unsigned len = getRecordFieldCount(page, offset);
     int recordNullIndicatorSize = getNullIndicatorSize(len);
 
     // Read in the existing null indicator
@@ -1004,11 +1962,150 @@ SlotStatus RecordBasedFileManager::getSlotStatus(SlotDirectoryRecordEntry slot)
 {
     if (slot.length == 0 && slot.offset == 0)
         return DEAD;
-    if (slot.offset <= 0)
+    if (slot.length == SLOT_FORWARDED)
         return MOVED;
     return VALID;
 }
 
+unsigned RecordBasedFileManager::getSlotSize(SlotDirectoryRecordEntry recordEntry)
+{
+    return getSlotStatus(recordEntry) == MOVED ? sizeof(RecordTombstone) : recordEntry.length;
+}
+
+RC RecordBasedFileManager::readRecordPage(FileHandle &fileHandle, PageNum pageNum, void *page)
+{
+    if (fileHandle.readPage(pageNum, page))
+        return RBFM_READ_FAILED;
+    if (getSlotDirectoryHeader(page).version != SLOT_DIRECTORY_VERSION)
+        return RBFM_PAGE_VERSION;
+    return SUCCESS;
+}
+
+RID RecordBasedFileManager::getForwardingAddress(void *page, SlotDirectoryRecordEntry recordEntry)
+{
+    RecordTombstone tombstone;
+    memcpy(&tombstone, (char*) page + recordEntry.offset, sizeof(RecordTombstone));
+    RID rid;
+    rid.pageNum = tombstone.pageNum;
+    rid.slotNum = tombstone.slotNum & ~TOMBSTONE_MOVED_IN;
+    return rid;
+}
+
+bool RecordBasedFileManager::setForwardingAddress(void *page, unsigned slotNum, const RID &newRid, bool movedIn)
+{
+    SlotDirectoryRecordEntry recordEntry;
+    if (isPaxPage(page))
+    {
+        if (!reservePaxHeap(page, sizeof(RecordTombstone)))
+            return false;
+        PaxPageFooter footer = getPaxPageFooter(page);
+        footer.heapOffset -= sizeof(RecordTombstone);
+        setPaxPageFooter(page, footer);
+        recordEntry.offset = footer.heapOffset;
+    }
+    else
+    {
+        if (getPageFreeSpaceSize(page) < sizeof(RecordTombstone))
+            return false;
+        SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(page);
+        slotHeader.freeSpaceOffset -= sizeof(RecordTombstone);
+        setSlotDirectoryHeader(page, slotHeader);
+        recordEntry.offset = slotHeader.freeSpaceOffset;
+    }
+    RecordTombstone tombstone;
+    tombstone.pageNum = newRid.pageNum;
+    tombstone.slotNum = movedIn ? newRid.slotNum | TOMBSTONE_MOVED_IN : newRid.slotNum;
+    memcpy((char*) page + recordEntry.offset, &tombstone, sizeof(RecordTombstone));
+    recordEntry.length = SLOT_FORWARDED;
+    setSlotDirectoryRecordEntry(page, slotNum, recordEntry);
+    return true;
+}
+
+RC RecordBasedFileManager::shortenForwarding(FileHandle &fileHandle, const RID &rid, const RID &target)
+{
+    void *pageData = PageBufferPool::acquire();
+    RC rc = readRecordPage(fileHandle, target.pageNum, pageData);
+    if (rc != SUCCESS || getSlotStatus(getSlotDirectoryRecordEntry(pageData, target.slotNum)) != MOVED)
+    {
+        PageBufferPool::release(pageData);
+        return rc;
+    }
+
+    // The slot the record moved to goes, its own slot forwards to where it is now
+    RID newRid = getForwardingAddress(pageData, getSlotDirectoryRecordEntry(pageData, target.slotNum));
+    markSlotDeleted(pageData, target.slotNum);
+    if (!isPaxPage(pageData))
+    {
+        reorganizePage(pageData);
+        fileHandle.stats->pageReorganizations++;
+    }
+    rc = fileHandle.writePage(target.pageNum, pageData) ? RBFM_WRITE_FAILED : SUCCESS;
+    if (rc == SUCCESS)
+        rc = readRecordPage(fileHandle, rid.pageNum, pageData);
+    if (rc == SUCCESS)
+    {
+        // The tombstone keeps its moved in flag
+        RecordTombstone tombstone;
+        SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, rid.slotNum);
+        memcpy(&tombstone, (char*) pageData + recordEntry.offset, sizeof(RecordTombstone));
+        tombstone.pageNum = newRid.pageNum;
+        tombstone.slotNum = (tombstone.slotNum & TOMBSTONE_MOVED_IN) | newRid.slotNum;
+        memcpy((char*) pageData + recordEntry.offset, &tombstone, sizeof(RecordTombstone));
+        rc = fileHandle.writePage(rid.pageNum, pageData) ? RBFM_WRITE_FAILED : SUCCESS;
+    }
+    PageBufferPool::release(pageData);
+    return rc;
+}
+
+bool RecordBasedFileManager::isMovedIn(void *page, SlotDirectoryRecordEntry recordEntry)
+{
+    SlotStatus status = getSlotStatus(recordEntry);
+    if (status == DEAD)
+        return false;
+    if (status == MOVED)
+    {
+        RecordTombstone tombstone;
+        memcpy(&tombstone, (char*) page + recordEntry.offset, sizeof(RecordTombstone));
+        return tombstone.slotNum & TOMBSTONE_MOVED_IN;
+    }
+    if (isPaxPage(page))
+        return recordEntry.offset == PAX_MOVED_IN_OFFSET;
+    RecordLength length;
+    memcpy(&length, (char*) page + recordEntry.offset, sizeof(RecordLength));
+    return length & RECORD_MOVED_IN;
+}
+
+void RecordBasedFileManager::setMovedIn(void *page, unsigned slotNum, bool movedIn)
+{
+    SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(page, slotNum);
+    if (isPaxPage(page))
+    {
+        recordEntry.offset = movedIn ? PAX_MOVED_IN_OFFSET : PAX_RECORD_OFFSET;
+        setSlotDirectoryRecordEntry(page, slotNum, recordEntry);
+        return;
+    }
+    RecordLength length;
+    memcpy(&length, (char*) page + recordEntry.offset, sizeof(RecordLength));
+    length = movedIn ? length | RECORD_MOVED_IN : length & ~RECORD_MOVED_IN;
+    memcpy((char*) page + recordEntry.offset, &length, sizeof(RecordLength));
+}
+
+unsigned RecordBasedFileManager::getRecordFieldCount(void *page, unsigned offset)
+{
+    RecordLength length;
+    memcpy(&length, (char*) page + offset, sizeof(RecordLength));
+    return length & ~RECORD_MOVED_IN;
+}
+
+void RecordBasedFileManager::trimSlotDirectory(void *page)
+{
+    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(page);
+    while (slotHeader.recordEntriesNumber > 0 &&
+            getSlotStatus(getSlotDirectoryRecordEntry(page, slotHeader.recordEntriesNumber - 1)) == DEAD)
+        slotHeader.recordEntriesNumber--;
+    setSlotDirectoryHeader(page, slotHeader);
+}
+
 // Get first unused slot in page. Slot is considered unused if dead
 // If not dead slots returns recordEntriesNumber
 unsigned RecordBasedFileManager::getOpenSlot(void *page)
@@ -1040,14 +2137,14 @@ void RecordBasedFileManager::reorganizePage(void *page)
 {
     SlotDirectoryHeader header = getSlotDirectoryHeader(page);
 
-    // Add all live records to vector, keeping track of slot numbers
+    // Add all live records and tombstones to vector, keeping track of slot numbers
     vector<IndexedRecordEntry> liveRecords;
     for (unsigned i = 0; i < header.recordEntriesNumber; i++)
     {
         IndexedRecordEntry entry;
         entry.slotNum = i;
         entry.recordEntry = getSlotDirectoryRecordEntry(page, i);
-        if (getSlotStatus(entry.recordEntry) == VALID)
+        if (getSlotStatus(entry.recordEntry) != DEAD)
             liveRecords.push_back(entry);
     }
     // Sort records by offset, descending
@@ -1056,15 +2153,16 @@ void RecordBasedFileManager::reorganizePage(void *page)
     sort(liveRecords.begin(), liveRecords.end(), comp);
 
     // Move each record back filling in any gap preceding the record
-    uint16_t pageOffset = PAGE_SIZE;
+    uint32_t pageOffset = getPageSize(page);
     SlotDirectoryRecordEntry current;
     for (unsigned i = 0; i < liveRecords.size(); i++)
     {
         current = liveRecords[i].recordEntry;
-        pageOffset -= current.length;
+        unsigned length = getSlotSize(current);
+        pageOffset -= length;
 
         // Use memmove rather than memcpy because locations may overlap
-        memmove((char*)page + pageOffset, (char*)page + current.offset, current.length);
+        memmove((char*)page + pageOffset, (char*)page + current.offset, length);
         current.offset = pageOffset;
         setSlotDirectoryRecordEntry(page, liveRecords[i].slotNum, current);
     }
@@ -1072,14 +2170,65 @@ void RecordBasedFileManager::reorganizePage(void *page)
     setSlotDirectoryHeader(page, header);
 }
 
+RC RecordBasedFileManager::widenZoneMap(FileHandle &fileHandle, PageNum pageNum, void *page, unsigned slot)
+{
+    ZoneMap *zoneMap = fileHandle.zoneMap;
+    if (zoneMap == NULL)
+        return SUCCESS;
+
+    vector<ZoneMapEntry> entries;
+    if (zoneMap->readEntries(pageNum, entries))
+        return RBFM_READ_FAILED;
+    bool changed = false;
+    for (unsigned i = 0; i < entries.size(); i++)
+    {
+        char *field;
+        uint32_t length;
+        if (getSlotAttributeLocation(page, slot, zoneMap->getAttributeIndex(i), field, length))
+            changed |= ZoneMap::widen(entries[i], zoneMap->getAttributeType(i), field, length);
+    }
+    // Most records fall inside the range already
+    return changed ? zoneMap->writeEntries(pageNum, entries) : SUCCESS;
+}
+
+RC RecordBasedFileManager::summarizePage(FileHandle &fileHandle, PageNum pageNum, void *page)
+{
+    ZoneMap *zoneMap = fileHandle.zoneMap;
+    if (zoneMap == NULL)
+        return SUCCESS;
+
+    // Recompute the entries from the valid records, so deletions and updates can narrow them
+    vector<ZoneMapEntry> entries(zoneMap->getAttributeCount(), ZoneMapEntry());
+    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(page);
+    for (unsigned slot = 0; slot < slotHeader.recordEntriesNumber; slot++)
+    {
+        SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(page, slot);
+        if (getSlotStatus(recordEntry) != VALID)
+            continue;
+        for (unsigned i = 0; i < entries.size(); i++)
+        {
+            char *field;
+            uint32_t length;
+            if (getSlotAttributeLocation(page, slot, zoneMap->getAttributeIndex(i), field, length))
+                ZoneMap::widen(entries[i], zoneMap->getAttributeType(i), field, length);
+        }
+    }
+
+    vector<ZoneMapEntry> current;
+    if (zoneMap->readEntries(pageNum, current))
+        return RBFM_READ_FAILED;
+    if (memcmp(current.data(), entries.data(), entries.size() * sizeof(ZoneMapEntry)) == 0)
+        return SUCCESS;
+    return zoneMap->writeEntries(pageNum, entries);
+}
+
 void RecordBasedFileManager::getAttributeFromRecord(void *page, unsigned offset, unsigned attrIndex, AttrType type, void *data)
 {
     char *start = (char*)page + offset;
     unsigned data_offset = 0;
 
     // Get number of columns
-    RecordLength n;
-    memcpy (&n, start, sizeof(RecordLength));
+    unsigned n = getRecordFieldCount(page, offset);
 
     // Get null indicator
     int recordNullIndicatorSize = getNullIndicatorSize(n);
@@ -1117,4 +2266,418 @@ void RecordBasedFileManager::getAttributeFromRecord(void *page, unsigned offset,
     }
     // For all types, we then copy the data into the result
     memcpy((char*)data + data_offset, start + attrStart, len);
-}
\ No newline at end of file
+}
+
+bool RecordBasedFileManager::getAttributeLocation(void *page, unsigned offset, unsigned attrIndex, char *&field, uint32_t &length)
+{
+    char *start = (char*)page + offset;
+
+    // Get number of columns. Fields added after this record was written are null
+    unsigned n = getRecordFieldCount(page, offset);
+    if (attrIndex >= n)
+        return false;
+
+    int recordNullIndicatorSize = getNullIndicatorSize(n);
+    if (fieldIsNull(start + sizeof(RecordLength), attrIndex))
+        return false;
+
+    // Same directory walk as getAttributeFromRecord, without copying the value out
+    unsigned header_offset = sizeof(RecordLength) + recordNullIndicatorSize;
+    ColumnOffset attrEnd, attrStart;
+    memcpy(&attrEnd, start + header_offset + attrIndex * sizeof(ColumnOffset), sizeof(ColumnOffset));
+    if (attrIndex > 0)
+        memcpy(&attrStart, start + header_offset + (attrIndex - 1) * sizeof(ColumnOffset), sizeof(ColumnOffset));
+    else
+        attrStart = header_offset + n * sizeof(ColumnOffset);
+
+    field = start + attrStart;
+    length = attrEnd - attrStart;
+    return true;
+}
+
+bool RecordBasedFileManager::getSlotAttributeLocation(void *page, unsigned slot, unsigned attrIndex, char *&field, uint32_t &length)
+{
+    if (isPaxPage(page))
+        return getPaxAttributeLocation(page, slot, attrIndex, field, length);
+    SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(page, slot);
+    return getAttributeLocation(page, recordEntry.offset, attrIndex, field, length);
+}
+
+// PAX pages /////////////////////////////////////////////////////////////////////////////////
+
+// Null bitmaps are rounded up to 4 bytes, so the values after them stay aligned
+static unsigned getPaxBitmapSize(unsigned capacity)
+{
+    return (capacity + 31) / 32 * 4;
+}
+
+static unsigned getPaxMinipageSize(unsigned capacity)
+{
+    return sizeof(PaxMinipageHeader) + getPaxBitmapSize(capacity) + capacity * PAX_VALUE_SIZE;
+}
+
+// Where the varchar heap may grow down to: the end of the minipages
+static unsigned getPaxMinipagesEnd(unsigned capacity, unsigned columnCount)
+{
+    return sizeof(SlotDirectoryHeader) + capacity * sizeof(SlotDirectoryRecordEntry) + columnCount * getPaxMinipageSize(capacity);
+}
+
+bool RecordBasedFileManager::isPaxPage(void *page)
+{
+    return getSlotDirectoryHeader(page).freeSpaceOffset == PAX_PAGE_MARKER;
+}
+
+// An empty PAX page, laid out by the first record put on it
+void RecordBasedFileManager::newPaxPage(void *page, unsigned pageSize)
+{
+    memset(page, 0, pageSize);
+    SlotDirectoryHeader slotHeader;
+    slotHeader.freeSpaceOffset = PAX_PAGE_MARKER;
+    slotHeader.recordEntriesNumber = 0;
+    slotHeader.pageBlocks = pageSize / PAGE_SIZE;
+    slotHeader.version = SLOT_DIRECTORY_VERSION;
+    setSlotDirectoryHeader(page, slotHeader);
+
+    PaxPageFooter footer;
+    footer.capacity = 0;
+    footer.columnCount = 0;
+    footer.heapOffset = pageSize - sizeof(PaxPageFooter);
+    footer.unused = 0;
+    setPaxPageFooter(page, footer);
+}
+
+PaxPageFooter RecordBasedFileManager::getPaxPageFooter(void *page)
+{
+    PaxPageFooter footer;
+    memcpy(&footer, (char*) page + getPageSize(page) - sizeof(PaxPageFooter), sizeof(PaxPageFooter));
+    return footer;
+}
+
+void RecordBasedFileManager::setPaxPageFooter(void *page, PaxPageFooter footer)
+{
+    memcpy((char*) page + getPageSize(page) - sizeof(PaxPageFooter), &footer, sizeof(PaxPageFooter));
+}
+
+char *RecordBasedFileManager::getPaxMinipage(void *page, unsigned attrIndex)
+{
+    PaxPageFooter footer = getPaxPageFooter(page);
+    return (char*) page + getPaxMinipagesEnd(footer.capacity, attrIndex);
+}
+
+const char *RecordBasedFileManager::getPaxValues(void *page, unsigned attrIndex)
+{
+    if (!isPaxPage(page) || attrIndex >= getPaxPageFooter(page).columnCount)
+        return NULL;
+    return getPaxNulls(page, attrIndex) + getPaxBitmapSize(getPaxPageFooter(page).capacity);
+}
+
+const char *RecordBasedFileManager::getPaxNulls(void *page, unsigned attrIndex)
+{
+    return getPaxMinipage(page, attrIndex) + sizeof(PaxMinipageHeader);
+}
+
+// Bytes the record's varchars take in the heap
+unsigned RecordBasedFileManager::getPaxHeapSize(const vector<Attribute> &recordDescriptor, const void *data)
+{
+    unsigned nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
+    unsigned offset = nullIndicatorSize;
+    unsigned size = 0;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        if (fieldIsNull((char*) data, i))
+            continue;
+        if (recordDescriptor[i].type == TypeVarChar)
+        {
+            uint32_t varcharSize;
+            memcpy(&varcharSize, (char*) data + offset, VARCHAR_LENGTH_SIZE);
+            size += varcharSize;
+            offset += VARCHAR_LENGTH_SIZE + varcharSize;
+        }
+        else
+            offset += INT_SIZE;
+    }
+    return size;
+}
+
+// Whether the page has a minipage of the right type for every attribute
+bool RecordBasedFileManager::paxLayoutMatches(void *page, const vector<Attribute> &recordDescriptor)
+{
+    PaxPageFooter footer = getPaxPageFooter(page);
+    if (footer.columnCount != recordDescriptor.size())
+        return false;
+    char *minipage = getPaxMinipage(page, 0);
+    unsigned minipageSize = getPaxMinipageSize(footer.capacity);
+    for (unsigned i = 0; i < recordDescriptor.size(); i++, minipage += minipageSize)
+    {
+        PaxMinipageHeader header;
+        memcpy(&header, minipage, sizeof(PaxMinipageHeader));
+        if (header.type != recordDescriptor[i].type)
+            return false;
+    }
+    return true;
+}
+
+// Lay out an empty PAX page for records like data: as many slots as records of its size would fill
+bool RecordBasedFileManager::formatPaxPage(void *page, const vector<Attribute> &recordDescriptor, const void *data)
+{
+    unsigned columnCount = recordDescriptor.size();
+    unsigned heapSize = getPaxHeapFootprint(getPaxHeapSize(recordDescriptor, data));
+    unsigned pageSize = getPageSize(page);
+    unsigned available = pageSize - sizeof(PaxPageFooter);
+    unsigned recordSize = sizeof(SlotDirectoryRecordEntry) + columnCount * PAX_VALUE_SIZE + heapSize;
+    unsigned capacity = available / recordSize;
+    while (capacity > 0 && getPaxMinipagesEnd(capacity, columnCount) + heapSize > available)
+        capacity--;
+    if (capacity == 0)
+        return false;
+
+    newPaxPage(page, pageSize);
+    PaxPageFooter footer = getPaxPageFooter(page);
+    footer.capacity = capacity;
+    footer.columnCount = columnCount;
+    setPaxPageFooter(page, footer);
+    for (unsigned i = 0; i < columnCount; i++)
+    {
+        PaxMinipageHeader header;
+        header.type = recordDescriptor[i].type;
+        header.unused = 0;
+        memcpy(getPaxMinipage(page, i), &header, sizeof(PaxMinipageHeader));
+    }
+    return true;
+}
+
+// Heap bytes held by a record with size bytes of varchars: enough for the tombstone it leaves if it moves
+unsigned RecordBasedFileManager::getPaxHeapFootprint(unsigned size)
+{
+    return size < sizeof(RecordTombstone) ? sizeof(RecordTombstone) : size;
+}
+
+// Make room for size bytes in the heap, compacting it if needed
+bool RecordBasedFileManager::reservePaxHeap(void *page, unsigned size)
+{
+    PaxPageFooter footer = getPaxPageFooter(page);
+    unsigned minipagesEnd = getPaxMinipagesEnd(footer.capacity, footer.columnCount);
+
+    // The records and tombstones already on the page keep their footprint, so that a moving record
+    // always finds room for its tombstone
+    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(page);
+    unsigned liveSize = 0;
+    for (unsigned i = 0; i < slotHeader.recordEntriesNumber; i++)
+    {
+        SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(page, i);
+        if (getSlotStatus(recordEntry) != DEAD)
+            liveSize += getPaxHeapFootprint(getSlotSize(recordEntry));
+    }
+    if (liveSize + getPaxHeapFootprint(size) > getPageSize(page) - sizeof(PaxPageFooter) - minipagesEnd)
+        return false;
+    if (footer.heapOffset - minipagesEnd >= size)
+        return true;
+
+    // Dropping the varchars of deleted and updated records makes enough room
+    compactPaxHeap(page);
+    footer = getPaxPageFooter(page);
+    return footer.heapOffset - minipagesEnd >= size;
+}
+
+// Move the varchars of the valid records and the tombstones of the moved ones to the end of the heap,
+// dropping the varchars of deleted and updated records
+void RecordBasedFileManager::compactPaxHeap(void *page)
+{
+    PaxPageFooter footer = getPaxPageFooter(page);
+    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(page);
+    char *heap = (char*) PageBufferPool::acquire();
+    unsigned heapEnd = getPageSize(page) - sizeof(PaxPageFooter);
+    unsigned heapOffset = heapEnd;
+
+    for (unsigned i = 0; i < footer.columnCount; i++)
+    {
+        PaxMinipageHeader header;
+        char *minipage = getPaxMinipage(page, i);
+        memcpy(&header, minipage, sizeof(PaxMinipageHeader));
+        if (header.type != TypeVarChar)
+            continue;
+
+        char *bitmap = minipage + sizeof(PaxMinipageHeader);
+        char *values = bitmap + getPaxBitmapSize(footer.capacity);
+        for (unsigned slot = 0; slot < slotHeader.recordEntriesNumber; slot++)
+        {
+            if (getSlotStatus(getSlotDirectoryRecordEntry(page, slot)) != VALID || (bitmap[slot / CHAR_BIT] & (1 << (slot % CHAR_BIT))))
+                continue;
+            uint16_t location[2];
+            memcpy(location, values + slot * PAX_VALUE_SIZE, PAX_VALUE_SIZE);
+            heapOffset -= location[1];
+            memcpy(heap + heapOffset, (char*) page + location[0], location[1]);
+            location[0] = heapOffset;
+            memcpy(values + slot * PAX_VALUE_SIZE, location, PAX_VALUE_SIZE);
+        }
+    }
+
+    for (unsigned slot = 0; slot < slotHeader.recordEntriesNumber; slot++)
+    {
+        SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(page, slot);
+        if (getSlotStatus(recordEntry) != MOVED)
+            continue;
+        heapOffset -= sizeof(RecordTombstone);
+        memcpy(heap + heapOffset, (char*) page + recordEntry.offset, sizeof(RecordTombstone));
+        recordEntry.offset = heapOffset;
+        setSlotDirectoryRecordEntry(page, slot, recordEntry);
+    }
+
+    memcpy((char*) page + heapOffset, heap + heapOffset, heapEnd - heapOffset);
+    footer.heapOffset = heapOffset;
+    setPaxPageFooter(page, footer);
+    PageBufferPool::release(heap);
+}
+
+// Put the record in a free slot of the PAX page. Returns false if it doesn't fit.
+bool RecordBasedFileManager::insertPaxRecord(void *page, const vector<Attribute> &recordDescriptor, const void *data, unsigned &slot)
+{
+    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(page);
+    // A page without records can be laid out again, for records of another descriptor
+    if (!paxLayoutMatches(page, recordDescriptor))
+    {
+        for (unsigned i = 0; i < slotHeader.recordEntriesNumber; i++)
+        {
+            if (getSlotStatus(getSlotDirectoryRecordEntry(page, i)) != DEAD)
+                return false;
+        }
+        if (!formatPaxPage(page, recordDescriptor, data))
+            return false;
+        slotHeader = getSlotDirectoryHeader(page);
+    }
+
+    slot = getOpenSlot(page);
+    if (slot >= getPaxPageFooter(page).capacity || !reservePaxHeap(page, getPaxHeapSize(recordDescriptor, data)))
+        return false;
+
+    setPaxRecord(page, slot, recordDescriptor, data);
+    if (slot == slotHeader.recordEntriesNumber)
+    {
+        slotHeader.recordEntriesNumber += 1;
+        setSlotDirectoryHeader(page, slotHeader);
+    }
+    return true;
+}
+
+// Write the record's values in the slot of each minipage. The heap must have room for its varchars.
+void RecordBasedFileManager::setPaxRecord(void *page, unsigned slot, const vector<Attribute> &recordDescriptor, const void *data)
+{
+    PaxPageFooter footer = getPaxPageFooter(page);
+    unsigned offset = getNullIndicatorSize(recordDescriptor.size());
+    unsigned heapSize = 0;
+
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        char *bitmap = getPaxMinipage(page, i) + sizeof(PaxMinipageHeader);
+        char *value = bitmap + getPaxBitmapSize(footer.capacity) + slot * PAX_VALUE_SIZE;
+        if (fieldIsNull((char*) data, i))
+        {
+            bitmap[slot / CHAR_BIT] |= 1 << (slot % CHAR_BIT);
+            memset(value, 0, PAX_VALUE_SIZE);
+            continue;
+        }
+        bitmap[slot / CHAR_BIT] &= ~(1 << (slot % CHAR_BIT));
+
+        if (recordDescriptor[i].type == TypeVarChar)
+        {
+            uint32_t varcharSize;
+            memcpy(&varcharSize, (char*) data + offset, VARCHAR_LENGTH_SIZE);
+            offset += VARCHAR_LENGTH_SIZE;
+            footer.heapOffset -= varcharSize;
+            memcpy((char*) page + footer.heapOffset, (char*) data + offset, varcharSize);
+            offset += varcharSize;
+            heapSize += varcharSize;
+
+            uint16_t location[2] = {footer.heapOffset, (uint16_t) varcharSize};
+            memcpy(value, location, PAX_VALUE_SIZE);
+        }
+        else
+        {
+            memcpy(value, (char*) data + offset, PAX_VALUE_SIZE);
+            offset += PAX_VALUE_SIZE;
+        }
+    }
+    setPaxPageFooter(page, footer);
+
+    SlotDirectoryRecordEntry recordEntry;
+    recordEntry.length = heapSize;
+    recordEntry.offset = PAX_RECORD_OFFSET;
+    setSlotDirectoryRecordEntry(page, slot, recordEntry);
+}
+
+void RecordBasedFileManager::getPaxRecord(void *page, unsigned slot, const vector<Attribute> &recordDescriptor, void *data)
+{
+    unsigned nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
+    memset(data, 0, nullIndicatorSize);
+    unsigned offset = nullIndicatorSize;
+
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        char *field;
+        uint32_t length;
+        if (!getPaxAttributeLocation(page, slot, i, field, length))
+        {
+            ((char*) data)[i / CHAR_BIT] |= 1 << (CHAR_BIT - 1 - (i % CHAR_BIT));
+            continue;
+        }
+        if (recordDescriptor[i].type == TypeVarChar)
+        {
+            memcpy((char*) data + offset, &length, VARCHAR_LENGTH_SIZE);
+            offset += VARCHAR_LENGTH_SIZE;
+        }
+        memcpy((char*) data + offset, field, length);
+        offset += length;
+    }
+}
+
+// One attribute in the format of readAttribute: a null indicator byte and the value
+void RecordBasedFileManager::getPaxAttribute(void *page, unsigned slot, unsigned attrIndex, AttrType type, void *data)
+{
+    char *field;
+    uint32_t length;
+    char nullIndicator = 0;
+    if (!getPaxAttributeLocation(page, slot, attrIndex, field, length))
+    {
+        nullIndicator |= 1 << 7;
+        memcpy(data, &nullIndicator, 1);
+        return;
+    }
+    memcpy(data, &nullIndicator, 1);
+    unsigned offset = 1;
+    if (type == TypeVarChar)
+    {
+        memcpy((char*) data + offset, &length, VARCHAR_LENGTH_SIZE);
+        offset += VARCHAR_LENGTH_SIZE;
+    }
+    memcpy((char*) data + offset, field, length);
+}
+
+bool RecordBasedFileManager::getPaxAttributeLocation(void *page, unsigned slot, unsigned attrIndex, char *&field, uint32_t &length)
+{
+    // Attributes added after the page was laid out are null
+    PaxPageFooter footer = getPaxPageFooter(page);
+    if (attrIndex >= footer.columnCount)
+        return false;
+
+    char *minipage = getPaxMinipage(page, attrIndex);
+    PaxMinipageHeader header;
+    memcpy(&header, minipage, sizeof(PaxMinipageHeader));
+    char *bitmap = minipage + sizeof(PaxMinipageHeader);
+    if (bitmap[slot / CHAR_BIT] & (1 << (slot % CHAR_BIT)))
+        return false;
+
+    char *value = bitmap + getPaxBitmapSize(footer.capacity) + slot * PAX_VALUE_SIZE;
+    if (header.type == TypeVarChar)
+    {
+        uint16_t location[2];
+        memcpy(location, value, PAX_VALUE_SIZE);
+        field = (char*) page + location[0];
+        length = location[1];
+    }
+    else
+    {
+        field = value;
+        length = PAX_VALUE_SIZE;
+    }
+    return true;
+}
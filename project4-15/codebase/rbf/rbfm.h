@@ -22,6 +22,14 @@
 #define RBFM_SLOT_DN_EXIST  7
 #define RBFM_READ_AFTER_DEL 8
 #define RBFM_NO_SUCH_ATTR   9
+#define RBFM_ZONE_MAP_FAILED 10
+#define RBFM_DICTIONARY_FAILED 11
+#define RBFM_DICTIONARY_FULL 12
+#define RBFM_PAGE_VERSION   13
+#define RBFM_OVERFLOW_FAILED 14
+
+// Longest value of an out-of-line attribute kept in its record, unless createOverflow is told otherwise
+#define OVERFLOW_DEFAULT_THRESHOLD 256
 
 using namespace std;
 
@@ -62,18 +70,48 @@ typedef enum
 // See chapter 9.6.2 of the cow book or lecture 3 slide 16 for more information
 typedef struct SlotDirectoryHeader
 {
-    uint16_t freeSpaceOffset;
+    uint32_t freeSpaceOffset;
     uint16_t recordEntriesNumber;
+    uint8_t pageBlocks;         // size of the page in PAGE_SIZE blocks
+    uint8_t version;            // SLOT_DIRECTORY_VERSION
 } SlotDirectoryHeader;
 
-// Assignment 2 tip: Make offset negative to represent a forwarding address
-// Negative offset => length = page #, offset = -slot #
+// Layout of the slot directory. Pages of another version are rejected when read.
+#define SLOT_DIRECTORY_VERSION 2
+
+// A slot is 4 bytes: the offset and length of its record, which fit 16 bits up to MAX_PAGE_SIZE.
+// A dead slot is all zeros. The slot of a record that moved to another page has length
+// SLOT_FORWARDED and the offset of a tombstone on the page holding the record's RID.
 typedef struct SlotDirectoryRecordEntry
 {
-    uint32_t length; 
-    int32_t offset;
+    uint16_t offset;
+    uint16_t length;
 } SlotDirectoryRecordEntry;
 
+#define SLOT_FORWARDED 0xFFFF
+
+typedef struct RecordTombstone
+{
+    uint32_t pageNum;
+    uint32_t slotNum;
+} RecordTombstone;
+
+// The last page of a file that appendRecord fills in memory. It is written when a record no longer
+// fits and by flushTail; records in it can't be read from the file before then.
+typedef struct TailPage
+{
+    PageNum pageNum;
+    bool dirty;                     // records were added since it was last written
+    vector<char> page;              // empty until the first record
+} TailPage;
+
+// A record that vacuum gave another RID
+typedef struct RecordMove
+{
+    RID oldRid;
+    RID newRid;
+} RecordMove;
+
 typedef struct IndexedRecordEntry
 {
     int32_t slotNum;
@@ -86,6 +124,40 @@ typedef uint16_t ColumnOffset;
 
 typedef uint16_t RecordLength;
 
+// Set in the RecordLength of a record that moved in from another page, whose slot forwards to it
+#define RECORD_MOVED_IN 0x8000
+// Set in the slot number of a tombstone left by such a record when it moved again
+#define TOMBSTONE_MOVED_IN 0x80000000
+
+// How a record file lays out its pages, chosen when it is created
+typedef enum { FormatSlotted = 0, FormatPax } FileFormat;
+
+// PAX pages keep the slot directory of slotted pages, with this marker in place of the free space offset.
+// A valid slot has offset PAX_RECORD_OFFSET and the bytes of the record's varchars as length. The
+// tombstones of moved records are in the varchar heap.
+#define PAX_PAGE_MARKER   0xFFFFFFFF
+#define PAX_RECORD_OFFSET 1
+// The offset of a valid slot whose record moved in from another page
+#define PAX_MOVED_IN_OFFSET 2
+// Bytes of each slot in a minipage: an int, a real, or the offset and length of a varchar
+#define PAX_VALUE_SIZE    4
+
+// The end of a PAX page
+typedef struct PaxPageFooter
+{
+    uint16_t capacity;          // slots the directory and the minipages have room for
+    uint16_t columnCount;       // minipages, 0 until the first record lays out the page
+    uint16_t heapOffset;        // start of the varchar heap, which grows down towards the minipages
+    uint16_t unused;
+} PaxPageFooter;
+
+// The start of each minipage of a PAX page, followed by its null bitmap and its values
+typedef struct PaxMinipageHeader
+{
+    uint16_t type;              // AttrType
+    uint16_t unused;
+} PaxMinipageHeader;
+
 
 /********************************************************************************
 The scan iterator is NOT required to be implemented for the part 1 of the project 
@@ -114,6 +186,10 @@ public:
   RC getNextRecord(RID &rid, void *data);
   RC close();
 
+  // Read at most maxPages pages, evenly spaced from the first one on, instead of every page.
+  // Call before the first getNextRecord. Returns the number of pages the scan reads.
+  unsigned samplePages(unsigned maxPages);
+
   friend class RecordBasedFileManager;
 
 private:
@@ -124,6 +200,8 @@ private:
 
   uint32_t totalPage;
   uint16_t totalSlot;
+  // Pages read are this far apart, see samplePages
+  uint32_t pageStride;
 
   void *pageData;
 
@@ -136,9 +214,43 @@ private:
   CompOp compOp;
   const void* value;
   vector<string> attributeNames;
+  // Index in recordDescriptor of each projected attribute
+  vector<unsigned> projection;
 
   vector<RID> skipList;
 
+  // Pages the zone map rules out for the condition
+  vector<bool> pageSkips;
+
+  // Condition on a dictionary encoded attribute: equality tests the code of value, kept here,
+  // other comparisons decode the value of every record
+  vector<char> encodedValue;
+  bool decodeCondition;
+
+  // Condition on an out-of-line attribute: every record's value is fetched to be tested
+  bool fetchCondition;
+  // Where fetched values of out-of-line attributes are read to
+  vector<char> fetchedValue;
+
+  // Selection bitmap for the current page, filled by a batch predicate kernel
+  bool batchEval;
+  vector<uint8_t> pageMatches;
+  vector<bool> present;
+  vector<int32_t> intValues;
+  vector<float> realValues;
+  vector<const char*> varcharValues;
+  vector<uint32_t> varcharLengths;
+
+  // Minipages of the projected attributes on the current page, if it is a PAX page
+  // (NULL values for attributes the page has no minipage for)
+  struct PaxColumn {
+    const char *nulls;
+    const char *values;
+    bool varChar;
+  };
+  bool paxPage;
+  vector<PaxColumn> paxColumns;
+
   RC scanInit(FileHandle &fh,
         const vector<Attribute> rd,
         const string &ca, 
@@ -148,12 +260,17 @@ private:
 
   RC getNextSlot();
   RC getNextPage();
+  void skipPages();
   RC handleMovedRecord(bool &status, const RID rid, void *data);
+  void evaluatePage();
+  void evaluatePaxPage(const char *values);
+  void locateProjection();
+  bool getProjectedLocation(unsigned i, char *&field, uint32_t &length);
   bool checkScanCondition();
   RC checkScanCondition(bool &result, const RID rid);
   bool checkScanCondition(int, CompOp, const void*);
   bool checkScanCondition(float, CompOp, const void*);
-  bool checkScanCondition(char*, CompOp, const void*);
+  bool checkScanCondition(const char*, uint32_t, CompOp, const void*);
 };
 
 
@@ -162,7 +279,10 @@ class RecordBasedFileManager
 public:
   static RecordBasedFileManager* instance();
 
-  RC createFile(const string &fileName);
+  // PAX files store each attribute of a page's records in a minipage of its own, so scans only touch
+  // the attributes they test and project. They support every operation slotted files do.
+  // Pages are pageSize bytes, see PagedFileManager::isValidPageSize
+  RC createFile(const string &fileName, FileFormat format = FormatSlotted, unsigned pageSize = PAGE_SIZE);
   
   RC destroyFile(const string &fileName);
   
@@ -184,8 +304,18 @@ public:
   //     For Varchar: use 4 bytes to store the length of characters, then store the actual characters.
   //  !!! The same format is used for updateRecord(), the returned data of readRecord(), and readAttribute().
   // For example, refer to the Q6 of Project 1 Environment document.
+  // Slotted pages are filled up to the fillFactor of the handle; updates grow records into the rest.
   RC insertRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, RID &rid);
 
+  // Insert a record on the last page (or a new one), never filling holes in earlier pages.
+  // Records appended to a file that is never deleted from are scanned back in append order.
+  RC appendRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, RID &rid);
+  // The same without a page read per record: records go to the tail page in memory, each in the
+  // slot after the last one, and a page is written once, when it is full. Holes are never filled.
+  RC appendRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, TailPage &tail, RID &rid);
+  // Write the tail page if it has records that aren't in the file yet
+  RC flushTail(FileHandle &fileHandle, TailPage &tail);
+
   RC readRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid, void *data);
   
   // This method will be mainly used for debugging/testing. 
@@ -214,6 +344,39 @@ IMPORTANT, PLEASE READ: All methods below this comment (other than the construct
       const vector<string> &attributeNames, // a list of projected attributes
       RBFM_ScanIterator &rbfm_ScanIterator);
 
+  // Zone maps keep the min and max of chosen int, real and varchar attributes for every page of a file.
+  // Once created, they are kept up to date by the insertions, updates and deletions of handles opened
+  // afterwards, and scans with a condition on one of the attributes skip the pages it can't match.
+  // Records added through a handle opened before the zone map existed aren't in it.
+  RC createZoneMap(const string &fileName, const vector<Attribute> &recordDescriptor, const vector<string> &attributeNames);
+  RC destroyZoneMap(const string &fileName);
+
+  // Dictionary encode a varchar attribute of a file: records store a 2 byte code in place of each
+  // value, and equality conditions on the attribute compare codes. The records already in the file
+  // are rewritten, so no handle of the file may be open. Values are encoded and decoded by handles
+  // opened afterwards; records keep the API format of the record descriptor.
+  RC createDictionary(const string &fileName, const vector<Attribute> &recordDescriptor, const string &attributeName);
+
+  // Store the values of a varchar attribute of a file that are longer than threshold out of line, in
+  // chains of overflow pages (compressed if compress and that makes them shorter), so that records
+  // only have a pointer to them. The values are fetched by readRecord, and by readAttribute and scans
+  // that project or test the attribute; the others never read them. Records longer than a page can
+  // then be inserted. The records already in the file are rewritten, so no handle of the file may be
+  // open. The attribute can't also be dictionary encoded or in the zone map.
+  RC createOverflow(const string &fileName, const vector<Attribute> &recordDescriptor, const string &attributeName,
+          unsigned threshold = OVERFLOW_DEFAULT_THRESHOLD, bool compress = false);
+
+  // Vacuum a file a page at a time (see RelationManager::vacuum). The records that change RID are
+  // added to moves.
+  // Drop the slots of the page that forward to other pages: their records keep the RID they moved to.
+  RC dropForwarding(FileHandle &fileHandle, PageNum pageNum, vector<RecordMove> &moves);
+  // Move the records of the page to free space of the pages from firstPage up to it, which is
+  // advanced past the pages found full. Records that moved in from another page stay.
+  RC relocateRecords(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, PageNum pageNum,
+          PageNum &firstPage, vector<RecordMove> &moves);
+  // Drop the pages without records at the end of the file
+  RC truncateFile(FileHandle &fileHandle);
+
 public:
   friend class RBFM_ScanIterator;
 
@@ -227,7 +390,34 @@ private:
 
   // Private helper methods
 
-  void newRecordBasedPage(void * page);
+  void newRecordBasedPage(void * page, unsigned pageSize);
+  // The size of a slotted or PAX page, from its slot directory header
+  unsigned getPageSize(void *page);
+
+  // movedIn: the record is moving from another page, whose slot will forward to it
+  RC insertRecordFrom(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, RID &rid,
+          unsigned firstPage, bool movedIn);
+  // Puts the record in slot, a dead one or the one after the last, leaving at least reserve bytes of the page free
+  bool insertSlottedRecord(void *page, const vector<Attribute> &recordDescriptor, const void *data, unsigned reserve, unsigned slot);
+  // Bytes inserts leave free on each page of the file (see FileHandle::fillFactor)
+  unsigned getFillReserve(FileHandle &fileHandle);
+  // The record as the file stores it: codes in place of the values of encoded attributes, and the
+  // values of out-of-line attributes tagged or moved to overflow pages. stored points to data itself
+  // when the file has neither, otherwise to buffer.
+  RC encodeRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data,
+          vector<char> &buffer, const void *&stored);
+  // The other way around: a record read from the file into data
+  RC decodeRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *stored, void *data);
+  // readRecord without decoding
+  RC readStoredRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid, void *data);
+  // deleteRecord, leaving the overflow pages of the record to the caller
+  RC deleteStoredRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid);
+  // appendRecord of a record whose encoded attributes hold codes
+  RC appendStoredRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, TailPage &tail, RID &rid);
+  // Put the record in the slot after the last one of the page, false if it doesn't fit
+  bool appendToPage(void *page, const vector<Attribute> &recordDescriptor, const void *data, unsigned &slot);
+  // updateRecord of a record whose encoded attributes hold codes
+  RC updateStoredRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, const RID &rid);
 
   SlotDirectoryHeader getSlotDirectoryHeader(void * page);
   void setSlotDirectoryHeader(void * page, SlotDirectoryHeader slotHeader);
@@ -249,9 +439,59 @@ private:
 
   void markSlotDeleted(void *page, unsigned i);
 
+  // Read a page of a record file, checking the version of its slot directory
+  RC readRecordPage(FileHandle &fileHandle, PageNum pageNum, void *page);
+  // The RID in the tombstone of a moved record
+  RID getForwardingAddress(void *page, SlotDirectoryRecordEntry recordEntry);
+  // Point a slot whose record is gone to newRid, with a tombstone from the free space or the PAX heap.
+  // movedIn: the record had moved in from another page. Returns false if the page has no room for it.
+  bool setForwardingAddress(void *page, unsigned slotNum, const RID &newRid, bool movedIn);
+  // Bytes a slot's record or tombstone takes on the page
+  unsigned getSlotSize(SlotDirectoryRecordEntry recordEntry);
+  // Once a record moved by an update moved again, point its slot straight to where it is now
+  RC shortenForwarding(FileHandle &fileHandle, const RID &rid, const RID &target);
+  // Whether another slot forwards to the record or tombstone of the slot
+  bool isMovedIn(void *page, SlotDirectoryRecordEntry recordEntry);
+  void setMovedIn(void *page, unsigned slotNum, bool movedIn);
+  // Number of fields of the record at offset
+  unsigned getRecordFieldCount(void *page, unsigned offset);
+  // Drop the dead slots at the end of the slot directory
+  void trimSlotDirectory(void *page);
+
   void reorganizePage(void *page);
 
+  // Bring the zone map entries of a page up to date after adding the record in slot, or after any change
+  RC widenZoneMap(FileHandle &fileHandle, PageNum pageNum, void *page, unsigned slot);
+  RC summarizePage(FileHandle &fileHandle, PageNum pageNum, void *page);
+
+  // The attribute of the valid record in the slot, on a slotted or a PAX page. Returns false if it is null
+  bool getSlotAttributeLocation(void *page, unsigned slot, unsigned attrIndex, char *&field, uint32_t &length);
+
+  // PAX pages: the slot directory, then a minipage per attribute, then the varchar heap and the footer
+  bool isPaxPage(void *page);
+  void newPaxPage(void *page, unsigned pageSize);
+  PaxPageFooter getPaxPageFooter(void *page);
+  void setPaxPageFooter(void *page, PaxPageFooter footer);
+  char *getPaxMinipage(void *page, unsigned attrIndex);
+  // The values of the attribute's minipage, NULL if the page isn't PAX or has no such minipage
+  const char *getPaxValues(void *page, unsigned attrIndex);
+  // Its null bitmap: bit slot % 8 of byte slot / 8 is set for a null value
+  const char *getPaxNulls(void *page, unsigned attrIndex);
+  unsigned getPaxHeapSize(const vector<Attribute> &recordDescriptor, const void *data);
+  bool paxLayoutMatches(void *page, const vector<Attribute> &recordDescriptor);
+  bool formatPaxPage(void *page, const vector<Attribute> &recordDescriptor, const void *data);
+  unsigned getPaxHeapFootprint(unsigned size);
+  bool reservePaxHeap(void *page, unsigned size);
+  void compactPaxHeap(void *page);
+  bool insertPaxRecord(void *page, const vector<Attribute> &recordDescriptor, const void *data, unsigned &slot);
+  void setPaxRecord(void *page, unsigned slot, const vector<Attribute> &recordDescriptor, const void *data);
+  void getPaxRecord(void *page, unsigned slot, const vector<Attribute> &recordDescriptor, void *data);
+  void getPaxAttribute(void *page, unsigned slot, unsigned attrIndex, AttrType type, void *data);
+  bool getPaxAttributeLocation(void *page, unsigned slot, unsigned attrIndex, char *&field, uint32_t &length);
+
   void getAttributeFromRecord(void *page, unsigned offset, unsigned attrIndex, AttrType type,void *data);
+  // Points field at the attribute's bytes inside the page. Returns false if the attribute is null
+  bool getAttributeLocation(void *page, unsigned offset, unsigned attrIndex, char *&field, uint32_t &length);
 };
 
 #endif
@@ -0,0 +1,151 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h> 
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h> 
+#include <time.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+static double elapsedSeconds(const struct timespec &start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int RBFTest_13(PagedFileManager *pfm, RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. Paged files and records on the in-memory device
+    // 2. Latency and bandwidth of the latency-injecting device
+    cout << endl << "***** In RBF Test Case 13 *****" << endl;
+
+    RC rc;
+    string fileName = "test13";
+    MemoryPageDevice memory;
+    pfm->setDevice(&memory);
+
+    rc = pfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+    rc = pfm->createFile(fileName);
+    assert(rc != success && "Creating an existing file should fail.");
+
+    // Nothing reaches the file system
+    struct stat sb;
+    assert(stat(fileName.c_str(), &sb) != 0 && "The in-memory file should not be on disk.");
+
+    FileHandle fileHandle;
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    char page[PAGE_SIZE];
+    char readBack[PAGE_SIZE];
+    for (int i = 0; i < 10; i++) {
+        memset(page, 'a' + i, PAGE_SIZE);
+        rc = fileHandle.appendPage(page);
+        assert(rc == success && "Appending a page should not fail.");
+    }
+    memset(page, 'z', PAGE_SIZE);
+    rc = fileHandle.writePage(3, page);
+    assert(rc == success && "Writing a page should not fail.");
+    rc = fileHandle.readPage(3, readBack);
+    assert(rc == success && "Reading a page should not fail.");
+    rc = fileHandle.readPage(10, readBack);
+    assert(rc != success && "Reading a page past the end should fail.");
+
+    unsigned readCount, writeCount, appendCount;
+    fileHandle.collectCounterValues(readCount, writeCount, appendCount);
+    if (fileHandle.getNumberOfPages() != 10 || memcmp(page, readBack, PAGE_SIZE) != 0 ||
+            readCount != 1 || writeCount != 1 || appendCount != 10) {
+        cout << "[FAIL] The in-memory pages or counters are not correct." << endl;
+        return -1;
+    }
+
+    // A destroyed file stays readable through the open handle
+    rc = pfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+    rc = fileHandle.readPage(3, readBack);
+    assert(rc == success && "Reading from the open handle should not fail.");
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc != success && "Opening a destroyed file should fail.");
+
+    // Records go through the same device
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+    void *record = malloc(100);
+    void *returnedData = malloc(100);
+    int recordSize = 0;
+    RID rid;
+    FileHandle recordHandle;
+    rc = rbfm->createFile(fileName + "records");
+    assert(rc == success && "Creating the record file should not fail.");
+    rc = rbfm->openFile(fileName + "records", recordHandle);
+    assert(rc == success && "Opening the record file should not fail.");
+    prepareRecord(recordDescriptor.size(), nullsIndicator, 8, "Anteater", 25, 177.8, 6200, record, &recordSize);
+    rc = rbfm->insertRecord(recordHandle, recordDescriptor, record, rid);
+    assert(rc == success && "Inserting a record should not fail.");
+    rc = rbfm->readRecord(recordHandle, recordDescriptor, rid, returnedData);
+    assert(rc == success && "Reading a record should not fail.");
+    if (memcmp(record, returnedData, recordSize) != 0) {
+        cout << "[FAIL] The record read back from memory is not the one inserted." << endl;
+        return -1;
+    }
+    rbfm->closeFile(recordHandle);
+    rbfm->destroyFile(fileName + "records");
+
+    // 1 ms per read and 4 MB/s, 1 ms per page, on top of the in-memory device
+    LatencyPageDevice slow(&memory, 1000, 0, PAGE_SIZE * 1000);
+    pfm->setDevice(&slow);
+    rc = pfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < 10; i++)
+        fileHandle.appendPage(page);
+    double writeSeconds = elapsedSeconds(start);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < 10; i++)
+        fileHandle.readPage(i, readBack);
+    double readSeconds = elapsedSeconds(start);
+    cout << "10 page writes: " << writeSeconds * 1000 << " ms, 10 page reads: " << readSeconds * 1000 << " ms" << endl;
+    if (writeSeconds < 0.010 || readSeconds < 0.020) {
+        cout << "[FAIL] The latency device was too fast." << endl;
+        return -1;
+    }
+
+    pfm->closeFile(fileHandle);
+    pfm->destroyFile(fileName);
+    pfm->setDevice(NULL);
+    free(nullsIndicator);
+    free(record);
+    free(returnedData);
+
+    cout << "RBF Test Case 13 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test the storage devices of the paged file manager
+    PagedFileManager *pfm = PagedFileManager::instance();
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    RC rcmain = RBFTest_13(pfm, rbfm);
+    return rcmain;
+}
@@ -0,0 +1,149 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cassert>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "stats.h"
+#include "test_util.h"
+
+using namespace std;
+
+int RBFTest_14(PagedFileManager *pfm, RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. Latency histogram percentiles
+    // 2. Per-file page I/O and record manager counters in the stats registry
+    // 3. JSON and Prometheus dumps
+    cout << endl << "***** In RBF Test Case 14 *****" << endl;
+
+    // Percentiles are within an eighth of the exact value
+    LatencyHistogram histogram;
+    for (uint64_t i = 1; i <= 1000; i++)
+        histogram.record(i * 1000);
+    uint64_t p50 = histogram.getPercentile(0.5);
+    uint64_t p99 = histogram.getPercentile(0.99);
+    cout << "p50: " << p50 << " ns, p99: " << p99 << " ns" << endl;
+    if (histogram.getCount() != 1000 || histogram.getMin() != 1000 || histogram.getMax() != 1000000 ||
+            p50 < 500000 || p50 > 500000 * 9 / 8 || p99 < 990000 || p99 > 1000000 ||
+            histogram.getPercentile(1) != 1000000) {
+        cout << "[FAIL] The histogram percentiles are not correct." << endl;
+        return -1;
+    }
+
+    RC rc;
+    string fileName = "test14";
+    StatsRegistry *registry = StatsRegistry::instance();
+    registry->reset();
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    // Leave out the first page, appended by createFile through another handle
+    registry->reset();
+
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+    void *record = malloc(100);
+    void *returnedData = malloc(100);
+    int recordSize = 0;
+
+    // Fill the first page with short records, so the first one can't grow in place
+    RID firstRid, rid;
+    prepareRecord(recordDescriptor.size(), nullsIndicator, 1, "a", 25, 177.8, 6200, record, &recordSize);
+    rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, firstRid);
+    assert(rc == success && "Inserting a record should not fail.");
+    do {
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+    } while (rid.pageNum == 0);
+
+    string longName(30, 'z');
+    prepareRecord(recordDescriptor.size(), nullsIndicator, 30, longName, 25, 177.8, 6200, record, &recordSize);
+    rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, firstRid);
+    assert(rc == success && "Updating a record should not fail.");
+    rc = rbfm->readRecord(fileHandle, recordDescriptor, firstRid, returnedData);
+    assert(rc == success && "Reading a record should not fail.");
+    assert(memcmp(record, returnedData, recordSize) == 0 && "The moved record should be read back.");
+
+    FileStats *stats = registry->getFileStats(fileName);
+    cout << "reads: " << stats->reads << ", appends: " << stats->appends << ", pages scanned: " << stats->insertPagesScanned
+         << ", forward hops: " << stats->forwardHops << ", reorganizations: " << stats->pageReorganizations << endl;
+    unsigned readCount, writeCount, appendCount;
+    fileHandle.collectCounterValues(readCount, writeCount, appendCount);
+    if (stats->reads != readCount || stats->writes != writeCount || stats->appends != appendCount ||
+            stats->bytesRead != (uint64_t) readCount * PAGE_SIZE ||
+            stats->bytesWritten != (uint64_t) (writeCount + appendCount) * PAGE_SIZE ||
+            stats->readLatency.getCount() != readCount || stats->appendLatency.getCount() != appendCount ||
+            stats->readLatency.getPercentile(0.5) > stats->readLatency.getMax()) {
+        cout << "[FAIL] The page I/O statistics don't match the file handle counters." << endl;
+        return -1;
+    }
+    if (stats->appends != 1 || stats->insertPagesScanned == 0 || stats->forwardHops != 1 || stats->pageReorganizations != 1) {
+        cout << "[FAIL] The record manager counters are not correct." << endl;
+        return -1;
+    }
+
+    // The registry keeps counting across handles
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    rc = rbfm->readRecord(fileHandle, recordDescriptor, firstRid, returnedData);
+    assert(rc == success && "Reading a record should not fail.");
+    if (stats->forwardHops != 2 || stats->reads != (uint64_t) readCount + 2) {
+        cout << "[FAIL] The statistics did not carry over to the new handle." << endl;
+        return -1;
+    }
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    ostringstream json, prometheus, expected;
+    registry->writeJson(json);
+    registry->writePrometheus(prometheus);
+    cout << json.str();
+    expected << "pfm_page_reads_total{file=\"" << fileName << "\"} " << stats->reads << "\n";
+    if (json.str().find("\"" + fileName + "\": {\"reads\": ") == string::npos ||
+            json.str().find("\"forward_hops\": 2") == string::npos ||
+            prometheus.str().find(expected.str()) == string::npos ||
+            prometheus.str().find("# TYPE pfm_page_read_seconds summary") == string::npos) {
+        cout << "[FAIL] The dumps are not correct." << endl;
+        return -1;
+    }
+
+    registry->reset();
+    if (stats->reads != 0 || stats->forwardHops != 0 || stats->readLatency.getCount() != 0) {
+        cout << "[FAIL] The statistics were not reset." << endl;
+        return -1;
+    }
+
+    rbfm->destroyFile(fileName);
+    free(nullsIndicator);
+    free(record);
+    free(returnedData);
+
+    cout << "RBF Test Case 14 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test the statistics registry
+    PagedFileManager *pfm = PagedFileManager::instance();
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test14");
+
+    RC rcmain = RBFTest_14(pfm, rbfm);
+    return rcmain;
+}
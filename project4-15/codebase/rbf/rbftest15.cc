@@ -0,0 +1,107 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "arena.h"
+#include "test_util.h"
+
+using namespace std;
+
+int RBFTest_15(RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. Arena allocation, alignment and accounting
+    // 2. Page buffers reused by the record manager
+    cout << endl << "***** In RBF Test Case 15 *****" << endl;
+
+    Arena arena(1024);
+    char *first = (char *) arena.allocate(10);
+    char *second = (char *) arena.allocate(100, 64);
+    char *large = (char *) arena.allocate(5000);
+    memset(first, 1, 10);
+    memset(second, 2, 100);
+    memset(large, 3, 5000);
+    if ((uintptr_t) second % 64 != 0 || second < first + 10 || arena.getAllocatedBytes() != 5110 ||
+            arena.getReservedBytes() < 5110 || arena.getReservedBytes() > 1024 + 5000 + alignof(max_align_t)) {
+        cout << "[FAIL] The arena allocations are not correct." << endl;
+        return -1;
+    }
+    {
+        ArenaScope scope(&arena);
+        assert(Arena::getCurrent() == &arena && "The arena should be current in its scope.");
+    }
+    assert(Arena::getCurrent() == NULL && "No arena should be current outside of any scope.");
+    arena.reset();
+    assert(arena.getAllocatedBytes() == 0 && arena.getReservedBytes() == 0 && "The arena should be empty after reset.");
+
+    // Released buffers come back aligned
+    void *page = PageBufferPool::acquire();
+    assert((uintptr_t) page % PAGE_SIZE == 0 && "Page buffers should be page aligned.");
+    PageBufferPool::release(page);
+    if (PageBufferPool::acquire() != page) {
+        cout << "[FAIL] The released page buffer was not reused." << endl;
+        return -1;
+    }
+    PageBufferPool::release(page);
+
+    // Reading records takes no more page buffers from the heap once the pool is warm
+    string fileName = "test15";
+    RC rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+    void *record = malloc(100);
+    void *returnedData = malloc(100);
+    int recordSize = 0;
+    RID rid;
+    prepareRecord(recordDescriptor.size(), nullsIndicator, 8, "Anteater", 25, 177.8, 6200, record, &recordSize);
+    rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+    assert(rc == success && "Inserting a record should not fail.");
+
+    unsigned long heapAllocations = PageBufferPool::getHeapAllocations();
+    for (int i = 0; i < 1000; i++) {
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, rid, returnedData);
+        assert(rc == success && "Reading a record should not fail.");
+        rc = rbfm->readAttribute(fileHandle, recordDescriptor, rid, "Age", returnedData);
+        assert(rc == success && "Reading an attribute should not fail.");
+    }
+    cout << "Page buffers taken from the heap: " << PageBufferPool::getHeapAllocations() << endl;
+    if (PageBufferPool::getHeapAllocations() != heapAllocations) {
+        cout << "[FAIL] Reading records allocated page buffers." << endl;
+        return -1;
+    }
+
+    rbfm->closeFile(fileHandle);
+    rbfm->destroyFile(fileName);
+    free(nullsIndicator);
+    free(record);
+    free(returnedData);
+
+    cout << "RBF Test Case 15 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test the arena and the page buffer pool
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test15");
+
+    RC rcmain = RBFTest_15(rbfm);
+    return rcmain;
+}
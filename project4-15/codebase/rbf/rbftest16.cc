@@ -0,0 +1,149 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "arena.h"
+#include "test_util.h"
+
+using namespace std;
+
+int RBFTest_16(PagedFileManager *pfm, RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. Page I/O with direct I/O, from aligned and unaligned buffers
+    // 2. Records through a file opened for direct I/O
+    cout << endl << "***** In RBF Test Case 16 *****" << endl;
+
+    RC rc;
+    string fileName = "test16";
+    PosixPageDevice directDevice(true);
+    pfm->setDevice(&directDevice);
+
+    rc = pfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+    FileHandle fileHandle;
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    cout << "Files opened buffered: " << directDevice.getBufferedFallbacks() << endl;
+
+    // One buffer from the pool and one a byte off any alignment
+    void *aligned = PageBufferPool::acquire();
+    char *unalignedStorage = (char *) malloc(PAGE_SIZE + 1);
+    char *unaligned = unalignedStorage + 1;
+    void *returned = PageBufferPool::acquire();
+
+    for (unsigned i = 0; i < PAGE_SIZE; i++)
+    {
+        ((char *) aligned)[i] = i % 97;
+        unaligned[i] = i % 89;
+    }
+    rc = fileHandle.appendPage(aligned);
+    assert(rc == success && "Appending a page should not fail.");
+    rc = fileHandle.appendPage(unaligned);
+    assert(rc == success && "Appending a page should not fail.");
+
+    rc = fileHandle.readPage(0, returned);
+    assert(rc == success && "Reading a page should not fail.");
+    if (memcmp(returned, aligned, PAGE_SIZE) != 0) {
+        cout << "[FAIL] The page written from an aligned buffer was not read back." << endl;
+        return -1;
+    }
+    rc = fileHandle.readPage(1, unaligned);
+    assert(rc == success && "Reading a page should not fail.");
+    rc = fileHandle.readPage(1, returned);
+    assert(rc == success && "Reading a page should not fail.");
+    if (memcmp(returned, unaligned, PAGE_SIZE) != 0) {
+        cout << "[FAIL] The page written from an unaligned buffer was not read back." << endl;
+        return -1;
+    }
+
+    // Overwrite in place from an unaligned buffer
+    memset(unaligned, 'x', PAGE_SIZE);
+    rc = fileHandle.writePage(0, unaligned);
+    assert(rc == success && "Writing a page should not fail.");
+    rc = fileHandle.readPage(0, returned);
+    assert(rc == success && "Reading a page should not fail.");
+    if (memcmp(returned, unaligned, PAGE_SIZE) != 0 || fileHandle.getNumberOfPages() != 2) {
+        cout << "[FAIL] The page was not overwritten." << endl;
+        return -1;
+    }
+    rc = fileHandle.readPage(2, returned);
+    assert(rc != success && "Reading a page past the end should fail.");
+
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = pfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    // Records
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+    void *record = malloc(100);
+    void *returnedData = malloc(100);
+    int recordSize = 0;
+
+    int numRecords = 500;
+    vector<RID> rids;
+    for (int i = 0; i < numRecords; i++)
+    {
+        RID rid;
+        string name = "Direct" + to_string(i % 100);
+        prepareRecord(recordDescriptor.size(), nullsIndicator, name.size(), name, i, i * 0.5, i * 3, record, &recordSize);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        rids.push_back(rid);
+    }
+    for (int i = 0; i < numRecords; i++)
+    {
+        string name = "Direct" + to_string(i % 100);
+        prepareRecord(recordDescriptor.size(), nullsIndicator, name.size(), name, i, i * 0.5, i * 3, record, &recordSize);
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returnedData);
+        assert(rc == success && "Reading a record should not fail.");
+        if (memcmp(record, returnedData, recordSize) != 0) {
+            cout << "[FAIL] Record " << i << " was not read back." << endl;
+            return -1;
+        }
+    }
+    cout << "Records in " << fileHandle.getNumberOfPages() << " pages read back." << endl;
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rbfm->destroyFile(fileName);
+    pfm->setDevice(NULL);
+
+    PageBufferPool::release(aligned);
+    PageBufferPool::release(returned);
+    free(unalignedStorage);
+    free(nullsIndicator);
+    free(record);
+    free(returnedData);
+
+    cout << "RBF Test Case 16 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test direct I/O
+    PagedFileManager *pfm = PagedFileManager::instance();
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test16");
+
+    RC rcmain = RBFTest_16(pfm, rbfm);
+    return rcmain;
+}
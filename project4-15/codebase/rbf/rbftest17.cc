@@ -0,0 +1,263 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cassert>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "zonemap.h"
+#include "test_util.h"
+
+using namespace std;
+
+// What the test expects to be in the file
+struct Employee {
+    string name;
+    int age;
+    bool ageNull;
+    float height;
+    RID rid;
+    bool live;
+};
+
+static void prepareEmployee(const vector<Attribute> &recordDescriptor, unsigned char *nullsIndicator, const Employee &employee, void *record, int *recordSize)
+{
+    nullsIndicator[0] = employee.ageNull ? 0x40 : 0;
+    prepareRecord(recordDescriptor.size(), nullsIndicator, employee.name.size(), employee.name, employee.age, employee.height, 100, record, recordSize);
+}
+
+static bool satisfies(const Employee &employee, const string &attribute, CompOp compOp, int intValue, float realValue, const string &stringValue)
+{
+    int cmp;
+    if (attribute == "Age") {
+        if (employee.ageNull)
+            return false;
+        cmp = employee.age < intValue ? -1 : employee.age > intValue;
+    } else if (attribute == "Height") {
+        cmp = employee.height < realValue ? -1 : employee.height > realValue;
+    } else {
+        cmp = employee.name.compare(stringValue);
+    }
+    switch (compOp) {
+        case EQ_OP: return cmp == 0;
+        case LT_OP: return cmp < 0;
+        case LE_OP: return cmp <= 0;
+        case GT_OP: return cmp > 0;
+        case GE_OP: return cmp >= 0;
+        case NE_OP: return cmp != 0;
+        default: return true;
+    }
+}
+
+// Scan with the condition and compare with the employees that satisfy it. Returns the pages skipped or -1.
+static int checkScan(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+        const vector<Employee> &employees, const string &attribute, CompOp compOp, int intValue, float realValue, const string &stringValue)
+{
+    char value[PAGE_SIZE];
+    if (attribute == "Age") {
+        memcpy(value, &intValue, sizeof(int));
+    } else if (attribute == "Height") {
+        memcpy(value, &realValue, sizeof(float));
+    } else {
+        int length = stringValue.size();
+        memcpy(value, &length, sizeof(int));
+        memcpy(value + sizeof(int), stringValue.c_str(), length);
+    }
+
+    unsigned expected = 0;
+    for (const Employee &employee : employees) {
+        if (employee.live && satisfies(employee, attribute, compOp, intValue, realValue, stringValue))
+            expected++;
+    }
+
+    uint64_t skippedBefore = fileHandle.stats->zoneMapPagesSkipped;
+    RBFM_ScanIterator scanIterator;
+    vector<string> attributes;
+    attributes.push_back("Age");
+    RC rc = rbfm->scan(fileHandle, recordDescriptor, attribute, compOp, value, attributes, scanIterator);
+    assert(rc == success && "Scanning a file should not fail.");
+    RID rid;
+    char returnedData[PAGE_SIZE];
+    unsigned found = 0;
+    while (scanIterator.getNextRecord(rid, returnedData) != RBFM_EOF)
+        found++;
+    scanIterator.close();
+    int skipped = fileHandle.stats->zoneMapPagesSkipped - skippedBefore;
+
+    cout << attribute << " op " << compOp << ": " << found << " records, " << skipped << " pages skipped" << endl;
+    if (found != expected) {
+        cout << "[FAIL] Expected " << expected << " records." << endl;
+        return -1;
+    }
+    return skipped;
+}
+
+int RBFTest_17(RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. Create a zone map on an empty file and keep it up to date with inserts, updates and deletes
+    // 2. Scans skipping pages, giving the same records as without the zone map
+    // 3. Create a zone map on a file with records
+    cout << endl << "***** In RBF Test Case 17 *****" << endl;
+
+    RC rc;
+    string fileName = "test17";
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+    vector<string> zoneAttributes;
+    zoneAttributes.push_back("EmpName");
+    zoneAttributes.push_back("Age");
+    zoneAttributes.push_back("Height");
+    rc = rbfm->createZoneMap(fileName, recordDescriptor, zoneAttributes);
+    assert(rc == success && "Creating a zone map should not fail.");
+    vector<string> unknown(1, "Unknown");
+    if (rbfm->createZoneMap(fileName, recordDescriptor, zoneAttributes) == success ||
+            rbfm->createZoneMap("test17b", recordDescriptor, unknown) == success) {
+        cout << "[FAIL] Creating a second zone map or one on an unknown attribute should fail." << endl;
+        return -1;
+    }
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+    void *record = malloc(200);
+    int recordSize = 0;
+
+    // Employees appended in the order they joined: ages and heights grow, names are longer than the varchar prefix
+    int numRecords = 3000;
+    vector<Employee> employees;
+    for (int i = 0; i < numRecords; i++) {
+        Employee employee;
+        employee.name = to_string(100000 + i) + "_employee";
+        employee.age = i;
+        employee.ageNull = i % 500 == 7;
+        employee.height = i * 0.5;
+        employee.live = true;
+        prepareEmployee(recordDescriptor, nullsIndicator, employee, record, &recordSize);
+        rc = rbfm->appendRecord(fileHandle, recordDescriptor, record, employee.rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        employees.push_back(employee);
+    }
+    int pages = fileHandle.getNumberOfPages();
+    cout << "Records in " << pages << " pages." << endl;
+
+    int skipped = checkScan(rbfm, fileHandle, recordDescriptor, employees, "Age", GT_OP, 2990, 0, "");
+    if (skipped < pages - 2)
+        return -1;
+    if (checkScan(rbfm, fileHandle, recordDescriptor, employees, "Age", EQ_OP, 1500, 0, "") < pages - 2 ||
+            checkScan(rbfm, fileHandle, recordDescriptor, employees, "Age", LT_OP, 10, 0, "") < pages - 2 ||
+            checkScan(rbfm, fileHandle, recordDescriptor, employees, "Age", LE_OP, 0, 0, "") < pages - 1 ||
+            checkScan(rbfm, fileHandle, recordDescriptor, employees, "Age", GE_OP, 2999, 0, "") < pages - 1 ||
+            checkScan(rbfm, fileHandle, recordDescriptor, employees, "Age", NE_OP, 7, 0, "") < 0 ||
+            checkScan(rbfm, fileHandle, recordDescriptor, employees, "Height", LT_OP, 0, 3.0, "") < pages - 1 ||
+            checkScan(rbfm, fileHandle, recordDescriptor, employees, "Height", GT_OP, 0, 5000.0, "") != pages ||
+            checkScan(rbfm, fileHandle, recordDescriptor, employees, "EmpName", EQ_OP, 0, 0, "101500_employee") < pages - 2 ||
+            checkScan(rbfm, fileHandle, recordDescriptor, employees, "EmpName", LT_OP, 0, 0, "100050") < pages - 2 ||
+            checkScan(rbfm, fileHandle, recordDescriptor, employees, "EmpName", GT_OP, 0, 0, "102990_employee") < pages - 2 ||
+            checkScan(rbfm, fileHandle, recordDescriptor, employees, "EmpName", GE_OP, 0, 0, "102999_employee") < pages - 1 ||
+            checkScan(rbfm, fileHandle, recordDescriptor, employees, "EmpName", GT_OP, 0, 0, "102999_employee") < 0 ||
+            checkScan(rbfm, fileHandle, recordDescriptor, employees, "EmpName", LE_OP, 0, 0, "100000_employee") < pages - 1) {
+        cout << "[FAIL] The zone map scans are not correct." << endl;
+        return -1;
+    }
+
+    // An update widens the range of the page the record is on
+    Employee &older = employees[10];
+    older.age = 100000;
+    prepareEmployee(recordDescriptor, nullsIndicator, older, record, &recordSize);
+    rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, older.rid);
+    assert(rc == success && "Updating a record should not fail.");
+    // A longer record moves to another page
+    Employee &renamed = employees[20];
+    renamed.name = "zzzzzzzzzzzzzzzzzzzzzzzzzzzzzz";
+    renamed.age = 200000;
+    prepareEmployee(recordDescriptor, nullsIndicator, renamed, record, &recordSize);
+    rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, renamed.rid);
+    assert(rc == success && "Updating a record should not fail.");
+    if (checkScan(rbfm, fileHandle, recordDescriptor, employees, "Age", GT_OP, 50000, 0, "") < pages - 3 ||
+            checkScan(rbfm, fileHandle, recordDescriptor, employees, "EmpName", GE_OP, 0, 0, "zzzz") < 0) {
+        cout << "[FAIL] The zone map scans after updates are not correct." << endl;
+        return -1;
+    }
+
+    // Deletions narrow the range again
+    rc = rbfm->deleteRecord(fileHandle, recordDescriptor, older.rid);
+    assert(rc == success && "Deleting a record should not fail.");
+    older.live = false;
+    rc = rbfm->deleteRecord(fileHandle, recordDescriptor, renamed.rid);
+    assert(rc == success && "Deleting a record should not fail.");
+    renamed.live = false;
+    pages = fileHandle.getNumberOfPages();
+    if (checkScan(rbfm, fileHandle, recordDescriptor, employees, "Age", GT_OP, 50000, 0, "") != pages) {
+        cout << "[FAIL] The zone map was not narrowed by the deletions." << endl;
+        return -1;
+    }
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    // A zone map of a file with records
+    rc = rbfm->destroyZoneMap(fileName);
+    assert(rc == success && "Destroying a zone map should not fail.");
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    if (checkScan(rbfm, fileHandle, recordDescriptor, employees, "Age", GT_OP, 2990, 0, "") != 0) {
+        cout << "[FAIL] Pages were skipped without a zone map." << endl;
+        return -1;
+    }
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    vector<string> ageOnly(1, "Age");
+    rc = rbfm->createZoneMap(fileName, recordDescriptor, ageOnly);
+    assert(rc == success && "Creating a zone map should not fail.");
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    if (checkScan(rbfm, fileHandle, recordDescriptor, employees, "Age", GT_OP, 2990, 0, "") < pages - 2 ||
+            checkScan(rbfm, fileHandle, recordDescriptor, employees, "Height", LT_OP, 0, 3.0, "") != 0) {
+        cout << "[FAIL] The zone map built from the records is not correct." << endl;
+        return -1;
+    }
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    // The zone map goes with the file
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+    FILE *zoneMapFile = fopen(ZoneMap::getFileName(fileName).c_str(), "r");
+    if (zoneMapFile != NULL) {
+        fclose(zoneMapFile);
+        cout << "[FAIL] The zone map was not destroyed with the file." << endl;
+        return -1;
+    }
+
+    free(nullsIndicator);
+    free(record);
+
+    cout << "RBF Test Case 17 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test zone maps
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test17");
+    remove("test17.zm");
+
+    RC rcmain = RBFTest_17(rbfm);
+    return rcmain;
+}
@@ -0,0 +1,275 @@
+#include <iostream>
+#include <string>
+#include <map>
+#include <set>
+#include <cassert>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "stats.h"
+#include "test_util.h"
+
+using namespace std;
+
+// What the test expects to be in the file
+struct Employee {
+    string name;
+    int age;
+    float height;
+    int salary;
+    unsigned char nulls;
+    RID rid;
+    bool live;
+};
+
+static Employee makeEmployee(int i, int version)
+{
+    Employee employee;
+    employee.name = string(1 + (i * 7 + version * 13) % 30, 'a' + (i + version) % 26);
+    employee.age = i;
+    employee.height = i * 0.25;
+    employee.salary = i * 10 + version;
+    // Null names and ages now and then
+    employee.nulls = (i + version) % 17 == 0 ? 0x80 : ((i + version) % 23 == 0 ? 0x40 : 0);
+    employee.live = true;
+    return employee;
+}
+
+static void prepareEmployee(const vector<Attribute> &recordDescriptor, const Employee &employee, void *record, int *recordSize)
+{
+    unsigned char nullsIndicator = employee.nulls;
+    prepareRecord(recordDescriptor.size(), &nullsIndicator, employee.name.size(), employee.name, employee.age, employee.height, employee.salary, record, recordSize);
+}
+
+// Read every live employee back, and check the deleted ones are gone
+static int checkRecords(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const vector<Employee> &employees)
+{
+    char record[200], returnedData[200];
+    int recordSize;
+    set<pair<unsigned, unsigned> > liveRids;
+    for (unsigned i = 0; i < employees.size(); i++) {
+        if (employees[i].live)
+            liveRids.insert(make_pair(employees[i].rid.pageNum, employees[i].rid.slotNum));
+    }
+    for (unsigned i = 0; i < employees.size(); i++) {
+        RC rc = rbfm->readRecord(fileHandle, recordDescriptor, employees[i].rid, returnedData);
+        if (!employees[i].live) {
+            // Unless a later insert took the slot
+            if (rc == success && liveRids.count(make_pair(employees[i].rid.pageNum, employees[i].rid.slotNum)) == 0) {
+                cout << "[FAIL] Deleted record " << i << " can still be read." << endl;
+                return -1;
+            }
+            continue;
+        }
+        prepareEmployee(recordDescriptor, employees[i], record, &recordSize);
+        if (rc != success || memcmp(record, returnedData, recordSize) != 0) {
+            cout << "[FAIL] Record " << i << " was not read back." << endl;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Scan for Age >= minAge projecting Salary and EmpName, and compare with the employees
+static int checkScan(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, vector<Employee> &employees, int minAge)
+{
+    map<pair<unsigned, unsigned>, unsigned> byRid;
+    unsigned expected = 0;
+    for (unsigned i = 0; i < employees.size(); i++) {
+        if (employees[i].live)
+            byRid[make_pair(employees[i].rid.pageNum, employees[i].rid.slotNum)] = i;
+        if (employees[i].live && !(employees[i].nulls & 0x40) && employees[i].age >= minAge)
+            expected++;
+    }
+
+    vector<string> attributes;
+    attributes.push_back("Salary");
+    attributes.push_back("EmpName");
+    RBFM_ScanIterator scanIterator;
+    RC rc = rbfm->scan(fileHandle, recordDescriptor, "Age", GE_OP, &minAge, attributes, scanIterator);
+    assert(rc == success && "Scanning a file should not fail.");
+
+    RID rid;
+    char returnedData[200];
+    unsigned found = 0;
+    while (scanIterator.getNextRecord(rid, returnedData) != RBFM_EOF) {
+        found++;
+        // Records that moved come back with the RID of their new place: find them by salary
+        unsigned char nullsIndicator = returnedData[0];
+        int salary;
+        memcpy(&salary, returnedData + 1, sizeof(int));
+        const Employee *employee = NULL;
+        auto it = byRid.find(make_pair(rid.pageNum, rid.slotNum));
+        if (it != byRid.end() && employees[it->second].salary == salary)
+            employee = &employees[it->second];
+        for (unsigned i = 0; employee == NULL && i < employees.size(); i++) {
+            if (employees[i].live && employees[i].salary == salary)
+                employee = &employees[i];
+        }
+        if (employee == NULL || employee->age < minAge || (nullsIndicator & 0x80) != 0) {
+            cout << "[FAIL] The scan returned a record it should not have." << endl;
+            return -1;
+        }
+        bool nameNull = employee->nulls & 0x80;
+        uint32_t length;
+        memcpy(&length, returnedData + 1 + sizeof(int), sizeof(uint32_t));
+        if (nameNull != ((nullsIndicator & 0x40) != 0) ||
+                (!nameNull && (length != employee->name.size() || memcmp(returnedData + 1 + 2 * sizeof(int), employee->name.c_str(), length) != 0))) {
+            cout << "[FAIL] The scan did not project the attributes." << endl;
+            return -1;
+        }
+    }
+    scanIterator.close();
+
+    if (found != expected) {
+        cout << "[FAIL] The scan returned " << found << " records, not " << expected << "." << endl;
+        return -1;
+    }
+    return 0;
+}
+
+int RBFTest_18(PagedFileManager *pfm, RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. Create a PAX file
+    // 2. Insert, read and read attributes of records with nulls and varchars of every length
+    // 3. Update records in place and onto other pages, delete records and reuse their slots
+    // 4. Scans with a condition and a projection, skipping pages by the zone map
+    cout << endl << "***** In RBF Test Case 18 *****" << endl;
+
+    RC rc;
+    string fileName = "test18";
+
+    rc = rbfm->createFile(fileName, FormatPax);
+    assert(rc == success && "Creating the file should not fail.");
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+    vector<string> zoneAttributes(1, "Age");
+    rc = rbfm->createZoneMap(fileName, recordDescriptor, zoneAttributes);
+    assert(rc == success && "Creating the zone map should not fail.");
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    char record[200], returnedData[200];
+    int recordSize;
+
+    int numRecords = 2000;
+    vector<Employee> employees;
+    for (int i = 0; i < numRecords; i++) {
+        Employee employee = makeEmployee(i, 0);
+        prepareEmployee(recordDescriptor, employee, record, &recordSize);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, employee.rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        employees.push_back(employee);
+    }
+    cout << "Records in " << fileHandle.getNumberOfPages() << " pages." << endl;
+
+    // Every page is laid out as PAX
+    void *page = malloc(PAGE_SIZE);
+    for (unsigned i = 0; i < fileHandle.getNumberOfPages(); i++) {
+        rc = fileHandle.readPage(i, page);
+        assert(rc == success && "Reading a page should not fail.");
+        if (*(uint32_t *) page != PAX_PAGE_MARKER) {
+            cout << "[FAIL] Page " << i << " is not a PAX page." << endl;
+            return -1;
+        }
+    }
+    free(page);
+
+    // The ages grow with the pages, so the first three quarters of the file are skipped
+    uint64_t skippedBefore = fileHandle.stats->zoneMapPagesSkipped;
+    if (checkRecords(rbfm, fileHandle, recordDescriptor, employees) != 0 ||
+            checkScan(rbfm, fileHandle, recordDescriptor, employees, 1500) != 0)
+        return -1;
+    uint64_t skipped = fileHandle.stats->zoneMapPagesSkipped - skippedBefore;
+    cout << "Pages skipped by the zone map: " << skipped << endl;
+    if (skipped < fileHandle.getNumberOfPages() / 2) {
+        cout << "[FAIL] The scan did not skip the pages the zone map rules out." << endl;
+        return -1;
+    }
+
+    // Attributes one at a time
+    for (int i = 0; i < numRecords; i += 97) {
+        rc = rbfm->readAttribute(fileHandle, recordDescriptor, employees[i].rid, "EmpName", returnedData);
+        assert(rc == success && "Reading an attribute should not fail.");
+        bool nameNull = employees[i].nulls & 0x80;
+        uint32_t length;
+        memcpy(&length, returnedData + 1, sizeof(uint32_t));
+        if (((returnedData[0] & 0x80) != 0) != nameNull ||
+                (!nameNull && (length != employees[i].name.size() || memcmp(returnedData + 5, employees[i].name.c_str(), length) != 0))) {
+            cout << "[FAIL] Attribute EmpName of record " << i << " is not correct." << endl;
+            return -1;
+        }
+        rc = rbfm->readAttribute(fileHandle, recordDescriptor, employees[i].rid, "Height", returnedData);
+        assert(rc == success && "Reading an attribute should not fail.");
+        if (returnedData[0] != 0 || memcmp(returnedData + 1, &employees[i].height, sizeof(float)) != 0) {
+            cout << "[FAIL] Attribute Height of record " << i << " is not correct." << endl;
+            return -1;
+        }
+    }
+
+    // Updates: every record gets a name of another length, the longer ones fill up the heaps and move
+    for (int round = 1; round <= 3; round++) {
+        for (int i = round; i < numRecords; i += 3) {
+            Employee employee = makeEmployee(i, round);
+            employee.name += string(round * 10, 'x');
+            employee.rid = employees[i].rid;
+            prepareEmployee(recordDescriptor, employee, record, &recordSize);
+            rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, employee.rid);
+            assert(rc == success && "Updating a record should not fail.");
+            employees[i] = employee;
+        }
+    }
+    cout << "Records in " << fileHandle.getNumberOfPages() << " pages after the updates." << endl;
+    if (checkRecords(rbfm, fileHandle, recordDescriptor, employees) != 0 ||
+            checkScan(rbfm, fileHandle, recordDescriptor, employees, 1000) != 0)
+        return -1;
+
+    // Deletes, then inserts that take the free slots
+    for (int i = 0; i < numRecords; i += 2) {
+        rc = rbfm->deleteRecord(fileHandle, recordDescriptor, employees[i].rid);
+        assert(rc == success && "Deleting a record should not fail.");
+        employees[i].live = false;
+    }
+    unsigned pages = fileHandle.getNumberOfPages();
+    for (int i = numRecords; i < numRecords + 500; i++) {
+        Employee employee = makeEmployee(i, 0);
+        prepareEmployee(recordDescriptor, employee, record, &recordSize);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, employee.rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        employees.push_back(employee);
+    }
+    if (fileHandle.getNumberOfPages() != pages) {
+        cout << "[FAIL] The inserts did not reuse the space of the deleted records." << endl;
+        return -1;
+    }
+    if (checkRecords(rbfm, fileHandle, recordDescriptor, employees) != 0 ||
+            checkScan(rbfm, fileHandle, recordDescriptor, employees, 0) != 0)
+        return -1;
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    cout << "RBF Test Case 18 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test PAX files
+    PagedFileManager *pfm = PagedFileManager::instance();
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test18");
+    remove("test18.zm");
+
+    RC rcmain = RBFTest_18(pfm, rbfm);
+    return rcmain;
+}
@@ -0,0 +1,266 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cassert>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "compression.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Page i of the test file, version v: every third page is noise, the others records and free space
+static void preparePage(unsigned i, unsigned v, char *page)
+{
+    memset(page, 0, PAGE_SIZE);
+    if ((i + v) % 3 == 2) {
+        srand(i * 31 + v);
+        for (unsigned j = 0; j < PAGE_SIZE; j++)
+            page[j] = rand() % 256;
+        return;
+    }
+    unsigned used = 500 + (i * 37 + v * 101) % 3000;
+    for (unsigned j = 0; j < used; j++)
+        page[j] = "record-" [j % 7] + (j / 64 + i + v) % 5;
+}
+
+static bool checkPages(FileHandle &fileHandle, const vector<unsigned> &versions, char *expected, char *page)
+{
+    if (fileHandle.getNumberOfPages() != versions.size()) {
+        cout << "[FAIL] The file has " << fileHandle.getNumberOfPages() << " pages, expected " << versions.size() << "." << endl;
+        return false;
+    }
+    for (unsigned i = 0; i < versions.size(); i++) {
+        preparePage(i, versions[i], expected);
+        if (fileHandle.readPage(i, page) != success || memcmp(page, expected, PAGE_SIZE) != 0) {
+            cout << "[FAIL] Page " << i << " was not read back." << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int RBFTest_19(PagedFileManager *pfm, RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. The page codec on empty, repetitive and random pages
+    // 2. Pages of a compressed file, rewritten larger and smaller, through two handles and after reopening
+    // 3. Records of a file compressed once it was loaded
+    cout << endl << "***** In RBF Test Case 19 *****" << endl;
+
+    RC rc;
+    char *page = (char *) malloc(PAGE_SIZE);
+    char *expected = (char *) malloc(PAGE_SIZE);
+    char *stored = (char *) malloc(PAGE_SIZE);
+
+    for (unsigned i = 0; i < 2; i++) {
+        preparePage(i, 0, expected);
+        unsigned length = PageCodec::compress(expected, PAGE_SIZE, stored, PAGE_SIZE);
+        if (length == 0 || length > PAGE_SIZE / 4) {
+            cout << "[FAIL] Page " << i << " compressed to " << length << " bytes." << endl;
+            return -1;
+        }
+        if (!PageCodec::decompress(stored, length, page, PAGE_SIZE) || memcmp(page, expected, PAGE_SIZE) != 0) {
+            cout << "[FAIL] Page " << i << " was not decompressed." << endl;
+            return -1;
+        }
+    }
+    // Random bytes don't fit in a page once compressed
+    preparePage(2, 0, expected);
+    if (PageCodec::compress(expected, PAGE_SIZE, stored, PAGE_SIZE) != 0) {
+        cout << "[FAIL] Random bytes should not compress." << endl;
+        return -1;
+    }
+    memset(expected, 0, PAGE_SIZE);
+    unsigned emptyLength = PageCodec::compress(expected, PAGE_SIZE, stored, PAGE_SIZE);
+    cout << "An empty page takes " << emptyLength << " bytes." << endl;
+    if (emptyLength == 0 || emptyLength > 32 || !PageCodec::decompress(stored, emptyLength, page, PAGE_SIZE) ||
+        memcmp(page, expected, PAGE_SIZE) != 0) {
+        cout << "[FAIL] The empty page did not round trip." << endl;
+        return -1;
+    }
+
+    string fileName = "test19";
+    rc = pfm->createFile(fileName, true);
+    assert(rc == success && "Creating a compressed file should not fail.");
+    if (!pfm->isCompressed(fileName)) {
+        cout << "[FAIL] The file is not compressed." << endl;
+        return -1;
+    }
+
+    FileHandle writer;
+    FileHandle reader;
+    rc = pfm->openFile(fileName, writer);
+    assert(rc == success && "Opening the file should not fail.");
+    rc = pfm->openFile(fileName, reader);
+    assert(rc == success && "Opening the file should not fail.");
+
+    const unsigned numPages = 60;
+    vector<unsigned> versions(numPages, 0);
+    for (unsigned i = 0; i < numPages; i++) {
+        preparePage(i, 0, expected);
+        rc = writer.appendPage(expected);
+        assert(rc == success && "Appending a page should not fail.");
+    }
+    if (!checkPages(reader, versions, expected, page))
+        return -1;
+    unsigned long storedBytes = writer.getStoredBytes();
+    cout << "Pages: " << numPages << ", stored KB: " << storedBytes / 1024 << endl;
+    if (storedBytes >= (unsigned long) numPages * PAGE_SIZE * 2 / 3) {
+        cout << "[FAIL] The file should take a lot less than its pages." << endl;
+        return -1;
+    }
+
+    // Noise pages turn into records and back: they move and give their sectors to others
+    for (unsigned v = 1; v <= 6; v++) {
+        for (unsigned i = v % 2; i < numPages; i += 2) {
+            versions[i] = v;
+            preparePage(i, v, expected);
+            rc = writer.writePage(i, expected);
+            assert(rc == success && "Writing a page should not fail.");
+        }
+        if (!checkPages(reader, versions, expected, page))
+            return -1;
+    }
+    cout << "Stored KB after rewriting: " << writer.getStoredBytes() / 1024 << endl;
+    if (writer.getStoredBytes() > storedBytes * 2) {
+        cout << "[FAIL] Rewritten pages should reuse the sectors they free." << endl;
+        return -1;
+    }
+    rc = reader.readPage(numPages, page);
+    assert(rc != success && "Reading a page past the end should fail.");
+
+    rc = pfm->closeFile(writer);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = pfm->closeFile(reader);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = pfm->openFile(fileName, reader);
+    assert(rc == success && "Opening the file should not fail.");
+    if (!checkPages(reader, versions, expected, page))
+        return -1;
+    rc = pfm->closeFile(reader);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = pfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+    FILE *tableFile = fopen(CompressedFile::getTableFileName(fileName).c_str(), "r");
+    if (tableFile != NULL) {
+        fclose(tableFile);
+        cout << "[FAIL] The page translation table was not destroyed with the file." << endl;
+        return -1;
+    }
+
+    // A record file loaded plain, then compressed
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+    void *record = malloc(200);
+    void *returnedRecord = malloc(200);
+    int recordSize = 0;
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    const int numRecords = 3000;
+    vector<RID> rids(numRecords);
+    for (int i = 0; i < numRecords; i++) {
+        string name = "Employee" + to_string(i % 40);
+        prepareRecord(recordDescriptor.size(), nullsIndicator, name.size(), name, 20 + i % 50, 150 + i % 40, 1000 + i % 7, record, &recordSize);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+    unsigned plainPages = fileHandle.getNumberOfPages();
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = pfm->compressFile(fileName);
+    assert(rc == success && "Compressing the file should not fail.");
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    cout << "Record pages: " << fileHandle.getNumberOfPages() << ", stored KB: " << fileHandle.getStoredBytes() / 1024 << endl;
+    if (!pfm->isCompressed(fileName) || fileHandle.getNumberOfPages() != plainPages ||
+        fileHandle.getStoredBytes() >= (unsigned long) plainPages * PAGE_SIZE) {
+        cout << "[FAIL] The record file was not compressed." << endl;
+        return -1;
+    }
+
+    for (int i = 0; i < numRecords; i++) {
+        string name = "Employee" + to_string(i % 40);
+        prepareRecord(recordDescriptor.size(), nullsIndicator, name.size(), name, 20 + i % 50, 150 + i % 40, 1000 + i % 7, record, &recordSize);
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returnedRecord);
+        assert(rc == success && "Reading a record should not fail.");
+        if (memcmp(record, returnedRecord, recordSize) != 0) {
+            cout << "[FAIL] Record " << i << " was not read back from the compressed file." << endl;
+            return -1;
+        }
+    }
+
+    // Still written like any file
+    string name = "Renamed";
+    prepareRecord(recordDescriptor.size(), nullsIndicator, name.size(), name, 99, 180, 5000, record, &recordSize);
+    rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[7]);
+    assert(rc == success && "Updating a record should not fail.");
+    RID rid;
+    rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+    assert(rc == success && "Inserting a record should not fail.");
+    rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[8]);
+    assert(rc == success && "Deleting a record should not fail.");
+
+    vector<string> attributeNames(1, "EmpName");
+    RBFM_ScanIterator scanIterator;
+    rc = rbfm->scan(fileHandle, recordDescriptor, "EmpName", EQ_OP, "\x07\0\0\0Renamed", attributeNames, scanIterator);
+    assert(rc == success && "Scanning should not fail.");
+    int renamed = 0;
+    int scanned = 0;
+    while (scanIterator.getNextRecord(rid, returnedRecord) != RBFM_EOF)
+        renamed++;
+    scanIterator.close();
+    rc = rbfm->scan(fileHandle, recordDescriptor, "", NO_OP, NULL, attributeNames, scanIterator);
+    assert(rc == success && "Scanning should not fail.");
+    while (scanIterator.getNextRecord(rid, returnedRecord) != RBFM_EOF)
+        scanned++;
+    scanIterator.close();
+    if (renamed != 2 || scanned != numRecords) {
+        cout << "[FAIL] The scan found " << renamed << " renamed records of " << scanned << "." << endl;
+        return -1;
+    }
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    free(page);
+    free(expected);
+    free(stored);
+    free(nullsIndicator);
+    free(record);
+    free(returnedRecord);
+
+    cout << "RBF Test Case 19 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test compressed files
+    PagedFileManager *pfm = PagedFileManager::instance();
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test19");
+    remove("test19.ptt");
+
+    RC rcmain = RBFTest_19(pfm, rbfm);
+    return rcmain;
+}
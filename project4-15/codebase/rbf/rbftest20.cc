@@ -0,0 +1,217 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cassert>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// An id and a text of length bytes
+static void prepareText(int id, unsigned length, char *record, int *recordSize)
+{
+    record[0] = 0;
+    memcpy(record + 1, &id, sizeof(int));
+    memcpy(record + 1 + sizeof(int), &length, sizeof(int));
+    for (unsigned i = 0; i < length; i++)
+        record[1 + 2 * sizeof(int) + i] = 'a' + (id + i) % 26;
+    *recordSize = 1 + 2 * sizeof(int) + length;
+}
+
+// Records of every length up to maxLength, updated, deleted and read back, in a file of pageSize pages
+static int testRecords(RecordBasedFileManager *rbfm, const string &fileName, FileFormat format, unsigned pageSize, unsigned maxLength)
+{
+    vector<Attribute> recordDescriptor(2);
+    recordDescriptor[0].name = "Id";
+    recordDescriptor[0].type = TypeInt;
+    recordDescriptor[0].length = 4;
+    recordDescriptor[1].name = "Text";
+    recordDescriptor[1].type = TypeVarChar;
+    recordDescriptor[1].length = MAX_PAGE_SIZE;
+
+    RC rc = rbfm->createFile(fileName, format, pageSize);
+    assert(rc == success && "Creating the file should not fail.");
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    if (fileHandle.getPageSize() != pageSize) {
+        cout << "[FAIL] The file has pages of " << fileHandle.getPageSize() << " bytes, not " << pageSize << "." << endl;
+        return -1;
+    }
+
+    char *record = (char *) malloc(MAX_PAGE_SIZE);
+    char *returnedRecord = (char *) malloc(MAX_PAGE_SIZE);
+    int recordSize = 0;
+    const int numRecords = 2000;
+    vector<RID> rids(numRecords);
+    vector<unsigned> lengths(numRecords);
+    unsigned long totalSize = 0;
+    for (int i = 0; i < numRecords; i++) {
+        lengths[i] = (i * 37) % (i % 50 == 0 ? maxLength : 200);
+        prepareText(i, lengths[i], record, &recordSize);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Inserting a record should not fail.");
+        totalSize += recordSize;
+    }
+    unsigned numPages = fileHandle.getNumberOfPages();
+    cout << "Pages of " << pageSize / 1024 << " KB: " << numPages << endl;
+    if ((unsigned long) numPages * pageSize > totalSize * 2 + pageSize) {
+        cout << "[FAIL] The records should fill the pages." << endl;
+        return -1;
+    }
+
+    // Grow every third record, delete every fifth, so pages reorganize and records move
+    for (int i = 0; i < numRecords; i++) {
+        if (i % 5 == 0) {
+            rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[i]);
+            assert(rc == success && "Deleting a record should not fail.");
+        } else if (i % 3 == 0) {
+            lengths[i] += 150;
+            prepareText(i, lengths[i], record, &recordSize);
+            rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[i]);
+            assert(rc == success && "Updating a record should not fail.");
+        }
+    }
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    int expected = 0;
+    for (int i = 0; i < numRecords; i++) {
+        if (i % 5 == 0)
+            continue;
+        expected++;
+        prepareText(i, lengths[i], record, &recordSize);
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returnedRecord);
+        if (rc != success || memcmp(record, returnedRecord, recordSize) != 0) {
+            cout << "[FAIL] Record " << i << " was not read back." << endl;
+            return -1;
+        }
+    }
+
+    vector<string> attributeNames(1, "Id");
+    RBFM_ScanIterator scanIterator;
+    rc = rbfm->scan(fileHandle, recordDescriptor, "", NO_OP, NULL, attributeNames, scanIterator);
+    assert(rc == success && "Scanning should not fail.");
+    RID rid;
+    int scanned = 0;
+    while (scanIterator.getNextRecord(rid, returnedRecord) != RBFM_EOF)
+        scanned++;
+    scanIterator.close();
+    if (scanned != expected) {
+        cout << "[FAIL] The scan returned " << scanned << " records, not " << expected << "." << endl;
+        return -1;
+    }
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+    free(record);
+    free(returnedRecord);
+    return 0;
+}
+
+int RBFTest_20(PagedFileManager *pfm, RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. Page sizes a file can have
+    // 2. Pages of a 16 KB file, after reopening
+    // 3. Slotted and PAX records larger than a 4 KB page, in 16 KB and 64 KB pages
+    cout << endl << "***** In RBF Test Case 20 *****" << endl;
+
+    RC rc;
+    string fileName = "test20";
+    if (!PagedFileManager::isValidPageSize(PAGE_SIZE) || !PagedFileManager::isValidPageSize(MAX_PAGE_SIZE) ||
+        PagedFileManager::isValidPageSize(3 * PAGE_SIZE) || PagedFileManager::isValidPageSize(2 * MAX_PAGE_SIZE)) {
+        cout << "[FAIL] The valid page sizes are PAGE_SIZE times a power of 2, up to MAX_PAGE_SIZE." << endl;
+        return -1;
+    }
+    rc = pfm->createFile(fileName, false, 5000);
+    assert(rc == PFM_BAD_PAGE_SIZE && "Creating a file of 5000 byte pages should fail.");
+    rc = pfm->createFile(fileName, true, 4 * PAGE_SIZE);
+    assert(rc == PFM_BAD_PAGE_SIZE && "Compressed files only have PAGE_SIZE pages.");
+
+    const unsigned pageSize = 4 * PAGE_SIZE;
+    rc = pfm->createFile(fileName, false, pageSize);
+    assert(rc == success && "Creating a file of 16 KB pages should not fail.");
+    FileHandle fileHandle;
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    if (fileHandle.getNumberOfPages() != 0) {
+        cout << "[FAIL] A new file has no pages." << endl;
+        return -1;
+    }
+
+    char *page = (char *) malloc(pageSize);
+    char *returnedPage = (char *) malloc(pageSize);
+    const unsigned numPages = 10;
+    for (unsigned i = 0; i < numPages; i++) {
+        for (unsigned j = 0; j < pageSize; j++)
+            page[j] = (i + j / 1000) % 96 + 32;
+        rc = fileHandle.appendPage(page);
+        assert(rc == success && "Appending a page should not fail.");
+    }
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    if (fileHandle.getPageSize() != pageSize || fileHandle.getNumberOfPages() != numPages) {
+        cout << "[FAIL] The file has " << fileHandle.getNumberOfPages() << " pages of " << fileHandle.getPageSize() << " bytes." << endl;
+        return -1;
+    }
+    for (unsigned i = 0; i < numPages; i++) {
+        for (unsigned j = 0; j < pageSize; j++)
+            page[j] = (i + j / 1000) % 96 + 32;
+        rc = fileHandle.readPage(i, returnedPage);
+        if (rc != success || memcmp(page, returnedPage, pageSize) != 0) {
+            cout << "[FAIL] Page " << i << " was not read back." << endl;
+            return -1;
+        }
+    }
+    rc = fileHandle.readPage(numPages, returnedPage);
+    assert(rc != success && "Reading a page past the end should fail.");
+    unsigned readPageCount, writePageCount, appendPageCount;
+    fileHandle.collectCounterValues(readPageCount, writePageCount, appendPageCount);
+    if (readPageCount != numPages) {
+        cout << "[FAIL] A page of 16 KB is one read, not " << readPageCount << " for " << numPages << " pages." << endl;
+        return -1;
+    }
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = pfm->compressFile(fileName);
+    assert(rc == PFM_BAD_PAGE_SIZE && "Compressing a file of 16 KB pages should fail.");
+    rc = pfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+    free(page);
+    free(returnedPage);
+
+    if (testRecords(rbfm, fileName, FormatSlotted, 4 * PAGE_SIZE, 10000) != 0 ||
+        testRecords(rbfm, fileName, FormatSlotted, MAX_PAGE_SIZE, 40000) != 0 ||
+        testRecords(rbfm, fileName, FormatPax, 4 * PAGE_SIZE, 10000) != 0 ||
+        testRecords(rbfm, fileName, FormatPax, MAX_PAGE_SIZE, 40000) != 0)
+        return -1;
+
+    cout << "RBF Test Case 20 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test files with pages larger than PAGE_SIZE
+    PagedFileManager *pfm = PagedFileManager::instance();
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test20");
+
+    RC rcmain = RBFTest_20(pfm, rbfm);
+    return rcmain;
+}
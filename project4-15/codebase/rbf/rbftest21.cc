@@ -0,0 +1,214 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cassert>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// An id and a text of length bytes
+static void prepareText(int id, unsigned length, char *record, int *recordSize)
+{
+    record[0] = 0;
+    memcpy(record + 1, &id, sizeof(int));
+    memcpy(record + 1 + sizeof(int), &length, sizeof(int));
+    for (unsigned i = 0; i < length; i++)
+        record[1 + 2 * sizeof(int) + i] = 'a' + (id + i) % 26;
+    *recordSize = 1 + 2 * sizeof(int) + length;
+}
+
+static int readBack(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                    const RID &rid, int id, unsigned length)
+{
+    char record[PAGE_SIZE];
+    char returnedRecord[PAGE_SIZE];
+    int recordSize;
+    prepareText(id, length, record, &recordSize);
+    memset(returnedRecord, 0, PAGE_SIZE);
+    RC rc = rbfm->readRecord(fileHandle, recordDescriptor, rid, returnedRecord);
+    if (rc != success || memcmp(record, returnedRecord, recordSize) != 0) {
+        cout << "[FAIL] Record " << id << " at " << rid.pageNum << ":" << rid.slotNum << " was not read back." << endl;
+        return -1;
+    }
+    return 0;
+}
+
+int RBFTest_21(RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. Slots of 4 bytes: records of a narrow table per page
+    // 2. A record moved to RID 0:0, read, scanned and deleted through its tombstone
+    // 3. Pages of another slot directory version are rejected
+    cout << endl << "***** In RBF Test Case 21 *****" << endl;
+
+    RC rc;
+    string fileName = "test21";
+    if (sizeof(SlotDirectoryRecordEntry) != 4) {
+        cout << "[FAIL] A slot takes " << sizeof(SlotDirectoryRecordEntry) << " bytes, not 4." << endl;
+        return -1;
+    }
+
+    // A table of one int
+    vector<Attribute> narrowDescriptor(1);
+    narrowDescriptor[0].name = "Id";
+    narrowDescriptor[0].type = TypeInt;
+    narrowDescriptor[0].length = 4;
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    char record[PAGE_SIZE];
+    unsigned recordSize = 1 + sizeof(int);
+    unsigned storedSize = sizeof(RecordLength) + sizeof(ColumnOffset) + 1 + sizeof(int);
+    unsigned perPage = (PAGE_SIZE - sizeof(SlotDirectoryHeader)) / (storedSize + sizeof(SlotDirectoryRecordEntry));
+    RID rid;
+    for (unsigned i = 0; i <= perPage; i++) {
+        record[0] = 0;
+        memcpy(record + 1, &i, sizeof(int));
+        rc = rbfm->insertRecord(fileHandle, narrowDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        if (rid.pageNum != (i < perPage ? 0 : 1)) {
+            cout << "[FAIL] Record " << i << " is on page " << rid.pageNum << ", a page holds " << perPage << " records." << endl;
+            return -1;
+        }
+    }
+    cout << "Records of " << recordSize << " bytes per page: " << perPage << endl;
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    // Records of an id and a text
+    vector<Attribute> recordDescriptor(2);
+    recordDescriptor[0].name = "Id";
+    recordDescriptor[0].type = TypeInt;
+    recordDescriptor[0].length = 4;
+    recordDescriptor[1].name = "Text";
+    recordDescriptor[1].type = TypeVarChar;
+    recordDescriptor[1].length = PAGE_SIZE;
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    // Two records fill page 0, two more page 1
+    const int numRecords = 4;
+    unsigned lengths[numRecords] = {1500, 1500, 2000, 1900};
+    RID rids[numRecords];
+    int size;
+    for (int i = 0; i < numRecords; i++) {
+        prepareText(i, lengths[i], record, &size);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+    if (rids[0].pageNum != 0 || rids[0].slotNum != 0 || rids[2].pageNum != 1) {
+        cout << "[FAIL] The records are not on the expected pages." << endl;
+        return -1;
+    }
+
+    // Record 2 outgrows page 1 and takes slot 0 of page 0, freed by record 0
+    rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[0]);
+    assert(rc == success && "Deleting a record should not fail.");
+    lengths[2] = 2400;
+    prepareText(2, lengths[2], record, &size);
+    rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[2]);
+    assert(rc == success && "Updating a record should not fail.");
+    if (readBack(rbfm, fileHandle, recordDescriptor, rids[2], 2, lengths[2]) != 0)
+        return -1;
+    RID movedRid;
+    movedRid.pageNum = 0;
+    movedRid.slotNum = 0;
+    if (readBack(rbfm, fileHandle, recordDescriptor, movedRid, 2, lengths[2]) != 0) {
+        cout << "[FAIL] Record 2 should have moved to 0:0." << endl;
+        return -1;
+    }
+    int id = 0;
+    rc = rbfm->readAttribute(fileHandle, recordDescriptor, rids[2], "Id", record);
+    memcpy(&id, record + 1, sizeof(int));
+    if (rc != success || id != 2) {
+        cout << "[FAIL] The id of record 2 was not read through its tombstone." << endl;
+        return -1;
+    }
+
+    // It is scanned once, from where it is now
+    vector<string> attributeNames(1, "Id");
+    RBFM_ScanIterator scanIterator;
+    rc = rbfm->scan(fileHandle, recordDescriptor, "", NO_OP, NULL, attributeNames, scanIterator);
+    assert(rc == success && "Scanning should not fail.");
+    int scanned = 0;
+    while (scanIterator.getNextRecord(rid, record) != RBFM_EOF)
+        scanned++;
+    scanIterator.close();
+    if (scanned != numRecords - 1) {
+        cout << "[FAIL] The scan returned " << scanned << " records, not " << numRecords - 1 << "." << endl;
+        return -1;
+    }
+
+    // Deleting it through the tombstone deletes both
+    rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[2]);
+    assert(rc == success && "Deleting a record should not fail.");
+    rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[2], record);
+    assert(rc != success && "Reading a deleted record should fail.");
+    rc = rbfm->readRecord(fileHandle, recordDescriptor, movedRid, record);
+    assert(rc != success && "Reading a deleted record should fail.");
+    if (readBack(rbfm, fileHandle, recordDescriptor, rids[1], 1, lengths[1]) != 0 ||
+        readBack(rbfm, fileHandle, recordDescriptor, rids[3], 3, lengths[3]) != 0)
+        return -1;
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    // Page 1 with another version of the slot directory
+    PagedFileManager *pfm = PagedFileManager::instance();
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    char page[PAGE_SIZE];
+    rc = fileHandle.readPage(1, page);
+    assert(rc == success && "Reading a page should not fail.");
+    SlotDirectoryHeader slotHeader;
+    memcpy(&slotHeader, page, sizeof(SlotDirectoryHeader));
+    slotHeader.version = SLOT_DIRECTORY_VERSION + 1;
+    memcpy(page, &slotHeader, sizeof(SlotDirectoryHeader));
+    rc = fileHandle.writePage(1, page);
+    assert(rc == success && "Writing a page should not fail.");
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[3], record);
+    if (rc != RBFM_PAGE_VERSION) {
+        cout << "[FAIL] A page of another version should be rejected." << endl;
+        return -1;
+    }
+    if (readBack(rbfm, fileHandle, recordDescriptor, rids[1], 1, lengths[1]) != 0)
+        return -1;
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    cout << "RBF Test Case 21 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test the slot directory: 4 byte slots, tombstones and versions
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test21");
+
+    RC rcmain = RBFTest_21(rbfm);
+    return rcmain;
+}
@@ -0,0 +1,260 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cassert>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "stats.h"
+#include "test_util.h"
+
+using namespace std;
+
+const int numRecords = 200;
+const unsigned longLength = 10000;
+
+// An id, a text of length bytes and a short tag
+static void prepareText(int id, unsigned length, char *record, int *recordSize)
+{
+    unsigned offset = 0;
+    record[offset] = 0;
+    offset += 1;
+    memcpy(record + offset, &id, sizeof(int));
+    offset += sizeof(int);
+    memcpy(record + offset, &length, sizeof(int));
+    offset += sizeof(int);
+    for (unsigned i = 0; i < length; i++)
+        record[offset + i] = 'a' + (id + i) % 26;
+    // Texts of ids 26 apart differ in their first bytes
+    memcpy(record + offset, &id, sizeof(int));
+    offset += length;
+    unsigned tagLength = 4;
+    memcpy(record + offset, &tagLength, sizeof(int));
+    offset += sizeof(int);
+    memcpy(record + offset, "tag", tagLength);
+    record[offset + 3] = '0' + id % 10;
+    offset += tagLength;
+    *recordSize = offset;
+}
+
+static unsigned textLength(int i)
+{
+    return i % 4 == 0 ? longLength : 50 + i % 7;
+}
+
+static int testOverflow(RecordBasedFileManager *rbfm, const string &fileName, FileFormat format, bool compress)
+{
+    vector<Attribute> recordDescriptor(3);
+    recordDescriptor[0].name = "Id";
+    recordDescriptor[0].type = TypeInt;
+    recordDescriptor[0].length = 4;
+    recordDescriptor[1].name = "Text";
+    recordDescriptor[1].type = TypeVarChar;
+    recordDescriptor[1].length = 4 * PAGE_SIZE;
+    recordDescriptor[2].name = "Tag";
+    recordDescriptor[2].type = TypeVarChar;
+    recordDescriptor[2].length = 4;
+
+    char *record = (char *) malloc(4 * PAGE_SIZE);
+    char *returnedRecord = (char *) malloc(4 * PAGE_SIZE);
+    int recordSize = 0;
+    vector<RID> rids(numRecords);
+
+    // The records of the file before its text is out of line are rewritten
+    RC rc = rbfm->createFile(fileName, format);
+    assert(rc == success && "Creating the file should not fail.");
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    const int numEarly = 20;
+    for (int i = 0; i < numEarly; i++) {
+        prepareText(i, 100 + i, record, &recordSize);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+    prepareText(0, longLength, record, &recordSize);
+    rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rids[0]);
+    assert(rc != success && "A record larger than a page should not fit in a file without overflow pages.");
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    // An overflow file that can't be read fails the open, the long values can't be read without it
+    FILE *brokenOverflow = fopen((fileName + ".ovf").c_str(), "w");
+    fclose(brokenOverflow);
+    rc = rbfm->openFile(fileName, fileHandle);
+    remove((fileName + ".ovf").c_str());
+    if (rc == success) {
+        cout << "[FAIL] The file was opened without its overflow file." << endl;
+        return -1;
+    }
+
+    rc = rbfm->createOverflow(fileName, recordDescriptor, "Text", 80, compress);
+    assert(rc == success && "Storing an attribute out of line should not fail.");
+    if (rbfm->createOverflow(fileName, recordDescriptor, "Text", 80, compress) == success ||
+        rbfm->createOverflow(fileName, recordDescriptor, "Id", 80, compress) == success ||
+        rbfm->createDictionary(fileName, recordDescriptor, "Text") == success ||
+        rbfm->createZoneMap(fileName, recordDescriptor, vector<string>(1, "Text")) == success) {
+        cout << "[FAIL] An out-of-line attribute is a varchar that is stored out of line once, without codes or a zone map." << endl;
+        return -1;
+    }
+
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    for (int i = 0; i < numEarly; i++) {
+        prepareText(i, 100 + i, record, &recordSize);
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returnedRecord);
+        if (rc != success || memcmp(record, returnedRecord, recordSize) != 0) {
+            cout << "[FAIL] Record " << i << " was not rewritten." << endl;
+            return -1;
+        }
+        rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[i]);
+        assert(rc == success && "Deleting a record should not fail.");
+    }
+
+    // A long text in every fourth record, each longer than a page
+    for (int i = 0; i < numRecords; i++) {
+        prepareText(i, textLength(i), record, &recordSize);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+    unsigned heapPages = fileHandle.getNumberOfPages();
+    FileStats *overflowStats = StatsRegistry::instance()->getFileStats(fileName + ".ovf");
+    unsigned overflowPages = overflowStats->appends;
+    cout << "Heap pages: " << heapPages << ", overflow pages: " << overflowPages << endl;
+    if (heapPages > 6) {
+        cout << "[FAIL] The records should only have pointers to the long texts." << endl;
+        return -1;
+    }
+    unsigned rawPages = (numRecords / 4) * ((longLength + PAGE_SIZE - 1) / PAGE_SIZE);
+    if (compress ? overflowPages >= rawPages / 2 : overflowPages < rawPages) {
+        cout << "[FAIL] The long texts should take " << (compress ? "fewer" : "all of their") << " pages." << endl;
+        return -1;
+    }
+
+    for (int i = 0; i < numRecords; i++) {
+        prepareText(i, textLength(i), record, &recordSize);
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returnedRecord);
+        if (rc != success || memcmp(record, returnedRecord, recordSize) != 0) {
+            cout << "[FAIL] Record " << i << " was not read back." << endl;
+            return -1;
+        }
+    }
+    prepareText(8, textLength(8), record, &recordSize);
+    rc = rbfm->readAttribute(fileHandle, recordDescriptor, rids[8], "Text", returnedRecord);
+    if (rc != success || returnedRecord[0] != 0 || memcmp(record + 1 + sizeof(int), returnedRecord + 1, sizeof(int) + longLength) != 0) {
+        cout << "[FAIL] The text of record 8 was not read." << endl;
+        return -1;
+    }
+
+    // Scans that don't touch the text never read the overflow pages
+    uint64_t overflowReads = overflowStats->reads;
+    vector<string> attributeNames;
+    attributeNames.push_back("Id");
+    attributeNames.push_back("Tag");
+    RBFM_ScanIterator scanIterator;
+    rc = rbfm->scan(fileHandle, recordDescriptor, "Id", GE_OP, &numEarly, attributeNames, scanIterator);
+    assert(rc == success && "Scanning should not fail.");
+    RID rid;
+    int scanned = 0;
+    while (scanIterator.getNextRecord(rid, returnedRecord) != RBFM_EOF)
+        scanned++;
+    scanIterator.close();
+    if (scanned != numRecords - numEarly || overflowStats->reads != overflowReads) {
+        cout << "[FAIL] The scan returned " << scanned << " records and read " << overflowStats->reads - overflowReads
+             << " overflow pages." << endl;
+        return -1;
+    }
+
+    // A condition on the text reads it
+    prepareText(12, textLength(12), record, &recordSize);
+    attributeNames.assign(1, "Text");
+    rc = rbfm->scan(fileHandle, recordDescriptor, "Text", EQ_OP, record + 1 + sizeof(int), attributeNames, scanIterator);
+    assert(rc == success && "Scanning should not fail.");
+    scanned = 0;
+    while (scanIterator.getNextRecord(rid, returnedRecord) != RBFM_EOF) {
+        if (rid.pageNum != rids[12].pageNum || rid.slotNum != rids[12].slotNum ||
+            memcmp(record + 1 + sizeof(int), returnedRecord + 1, sizeof(int) + longLength) != 0) {
+            cout << "[FAIL] The scan returned the wrong record." << endl;
+            return -1;
+        }
+        scanned++;
+    }
+    scanIterator.close();
+    if (scanned != 1) {
+        cout << "[FAIL] The scan returned " << scanned << " records, not 1." << endl;
+        return -1;
+    }
+
+    // Long texts that get short, short ones that get long and deleted ones give their pages back
+    for (int i = 0; i < numRecords; i++) {
+        if (i % 4 == 0 && i % 8 != 0) {
+            rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[i]);
+            assert(rc == success && "Deleting a record should not fail.");
+        } else if (i % 8 == 0 || i % 8 == 1) {
+            prepareText(i, textLength(i + 1), record, &recordSize);
+            rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[i]);
+            assert(rc == success && "Updating a record should not fail.");
+        }
+    }
+    for (int i = 0; i < numRecords; i++) {
+        if (i % 4 == 0 && i % 8 != 0)
+            continue;
+        unsigned length = i % 8 == 0 || i % 8 == 1 ? textLength(i + 1) : textLength(i);
+        prepareText(i, length, record, &recordSize);
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returnedRecord);
+        if (rc != success || memcmp(record, returnedRecord, recordSize) != 0) {
+            cout << "[FAIL] Record " << i << " was not read back after the updates." << endl;
+            return -1;
+        }
+    }
+    if (overflowStats->appends != overflowPages) {
+        cout << "[FAIL] The updates should reuse the overflow pages freed by the deletes, not add "
+             << overflowStats->appends - overflowPages << "." << endl;
+        return -1;
+    }
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+    free(record);
+    free(returnedRecord);
+    return 0;
+}
+
+int RBFTest_22(RecordBasedFileManager *rbfm)
+{
+    // Functions Tested:
+    // 1. createOverflow on a file with records
+    // 2. Records with texts longer than a page, slotted and PAX, compressed and not
+    // 3. readRecord, readAttribute and scans of out-of-line texts
+    // 4. Updates and deletes freeing overflow pages
+    cout << endl << "***** In RBF Test Case 22 *****" << endl;
+
+    string fileName = "test22";
+    StatsRegistry::instance()->reset();
+    if (testOverflow(rbfm, fileName, FormatSlotted, true) != 0)
+        return -1;
+    StatsRegistry::instance()->reset();
+    if (testOverflow(rbfm, fileName, FormatPax, false) != 0)
+        return -1;
+
+    cout << "RBF Test Case 22 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main()
+{
+    // To test out-of-line storage of long varchars
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test22");
+    remove("test22.ovf");
+
+    RC rcmain = RBFTest_22(rbfm);
+    return rcmain;
+}
@@ -0,0 +1,247 @@
+#include <cstring>
+#include <functional>
+
+#include "stats.h"
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::reset()
+{
+    memset(counts, 0, sizeof(counts));
+    count = 0;
+    sum = 0;
+    min = 0;
+    max = 0;
+}
+
+// Values below STATS_SUB_BUCKETS get a bucket each. Above, the magnitude picks a group of
+// STATS_SUB_BUCKETS buckets and the bits right after the leading one pick the bucket in it.
+unsigned LatencyHistogram::getBucket(uint64_t nanos)
+{
+    if (nanos < STATS_SUB_BUCKETS)
+        return nanos;
+    unsigned magnitude = 63 - __builtin_clzll(nanos);
+    unsigned shift = magnitude - STATS_SUB_BUCKET_BITS;
+    return (shift + 1) * STATS_SUB_BUCKETS + (nanos >> shift) - STATS_SUB_BUCKETS;
+}
+
+uint64_t LatencyHistogram::getBucketBound(unsigned bucket)
+{
+    if (bucket < STATS_SUB_BUCKETS)
+        return bucket;
+    unsigned shift = bucket / STATS_SUB_BUCKETS - 1;
+    uint64_t lower = (uint64_t) (STATS_SUB_BUCKETS + bucket % STATS_SUB_BUCKETS) << shift;
+    return lower + ((uint64_t) 1 << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t nanos)
+{
+    counts[getBucket(nanos)]++;
+    if (count == 0 || nanos < min)
+        min = nanos;
+    if (nanos > max)
+        max = nanos;
+    count++;
+    sum += nanos;
+}
+
+uint64_t LatencyHistogram::getCount() const
+{
+    return count;
+}
+
+uint64_t LatencyHistogram::getSum() const
+{
+    return sum;
+}
+
+uint64_t LatencyHistogram::getMin() const
+{
+    return min;
+}
+
+uint64_t LatencyHistogram::getMax() const
+{
+    return max;
+}
+
+uint64_t LatencyHistogram::getPercentile(double fraction) const
+{
+    if (count == 0)
+        return 0;
+    uint64_t rank = (uint64_t) (fraction * count + 0.999999);
+    if (rank < 1)
+        rank = 1;
+
+    uint64_t seen = 0;
+    for (unsigned bucket = 0; bucket < STATS_BUCKETS; bucket++)
+    {
+        seen += counts[bucket];
+        if (seen >= rank)
+            return getBucketBound(bucket) < max ? getBucketBound(bucket) : max;
+    }
+    return max;
+}
+
+
+FileStats::FileStats()
+{
+    reads = 0;
+    writes = 0;
+    appends = 0;
+    bytesRead = 0;
+    bytesWritten = 0;
+
+    forwardHops = 0;
+    pageReorganizations = 0;
+    insertPagesScanned = 0;
+    zoneMapPagesSkipped = 0;
+
+    nodeVisits = 0;
+    leafSplits = 0;
+    internalSplits = 0;
+    rootSplits = 0;
+    treeHeight = 0;
+}
+
+
+StatsRegistry* StatsRegistry::_stats_registry = NULL;
+
+StatsRegistry* StatsRegistry::instance()
+{
+    if(!_stats_registry)
+        _stats_registry = new StatsRegistry();
+
+    return _stats_registry;
+}
+
+StatsRegistry::StatsRegistry()
+{
+}
+
+StatsRegistry::~StatsRegistry()
+{
+}
+
+FileStats *StatsRegistry::getFileStats(const string &fileName)
+{
+    return &files[fileName];
+}
+
+const map<string, FileStats> &StatsRegistry::getAllFileStats() const
+{
+    return files;
+}
+
+void StatsRegistry::reset()
+{
+    // Keep the entries: open handles point to them
+    for (auto &file : files)
+        file.second = FileStats();
+}
+
+// File names go into JSON strings and Prometheus label values, which escape the same characters
+static string escape(const string &name)
+{
+    string escaped;
+    for (char c : name)
+    {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        if (c == '\n')
+            escaped += "\\n";
+        else
+            escaped += c;
+    }
+    return escaped;
+}
+
+static void writeJsonLatency(ostream &out, const char *name, const LatencyHistogram &histogram)
+{
+    out << ", \"" << name << "\": {\"count\": " << histogram.getCount()
+        << ", \"sum\": " << histogram.getSum()
+        << ", \"min\": " << histogram.getMin()
+        << ", \"p50\": " << histogram.getPercentile(0.5)
+        << ", \"p90\": " << histogram.getPercentile(0.9)
+        << ", \"p99\": " << histogram.getPercentile(0.99)
+        << ", \"p999\": " << histogram.getPercentile(0.999)
+        << ", \"max\": " << histogram.getMax() << "}";
+}
+
+void StatsRegistry::writeJson(ostream &out) const
+{
+    out << "{\n  \"files\": {";
+    bool first = true;
+    for (auto &file : files)
+    {
+        const FileStats &stats = file.second;
+        out << (first ? "\n" : ",\n") << "    \"" << escape(file.first) << "\": {"
+            << "\"reads\": " << stats.reads
+            << ", \"writes\": " << stats.writes
+            << ", \"appends\": " << stats.appends
+            << ", \"bytes_read\": " << stats.bytesRead
+            << ", \"bytes_written\": " << stats.bytesWritten;
+        writeJsonLatency(out, "read_latency_ns", stats.readLatency);
+        writeJsonLatency(out, "write_latency_ns", stats.writeLatency);
+        writeJsonLatency(out, "append_latency_ns", stats.appendLatency);
+        out << ", \"forward_hops\": " << stats.forwardHops
+            << ", \"page_reorganizations\": " << stats.pageReorganizations
+            << ", \"insert_pages_scanned\": " << stats.insertPagesScanned
+            << ", \"zone_map_pages_skipped\": " << stats.zoneMapPagesSkipped
+            << ", \"node_visits\": " << stats.nodeVisits
+            << ", \"leaf_splits\": " << stats.leafSplits
+            << ", \"internal_splits\": " << stats.internalSplits
+            << ", \"root_splits\": " << stats.rootSplits
+            << ", \"tree_height\": " << stats.treeHeight << "}";
+        first = false;
+    }
+    out << "\n  }\n}\n";
+}
+
+void StatsRegistry::writePrometheus(ostream &out) const
+{
+    // One metric at a time, with a sample per file
+    auto writeMetric = [&](const char *name, const char *type, const char *help, function<uint64_t(const FileStats &)> value)
+    {
+        out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+        for (auto &file : files)
+            out << name << "{file=\"" << escape(file.first) << "\"} " << value(file.second) << "\n";
+    };
+
+    // Latencies as summaries in seconds, the Prometheus base unit
+    auto writeLatency = [&](const char *name, const char *help, function<const LatencyHistogram &(const FileStats &)> histogram)
+    {
+        const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+        out << "# HELP " << name << " " << help << "\n# TYPE " << name << " summary\n";
+        for (auto &file : files)
+        {
+            const LatencyHistogram &h = histogram(file.second);
+            string label = "file=\"" + escape(file.first) + "\"";
+            for (double quantile : quantiles)
+                out << name << "{" << label << ",quantile=\"" << quantile << "\"} " << h.getPercentile(quantile) / 1e9 << "\n";
+            out << name << "_sum{" << label << "} " << h.getSum() / 1e9 << "\n";
+            out << name << "_count{" << label << "} " << h.getCount() << "\n";
+        }
+    };
+
+    writeMetric("pfm_page_reads_total", "counter", "Pages read.", [](const FileStats &s) { return s.reads; });
+    writeMetric("pfm_page_writes_total", "counter", "Pages written in place.", [](const FileStats &s) { return s.writes; });
+    writeMetric("pfm_page_appends_total", "counter", "Pages appended.", [](const FileStats &s) { return s.appends; });
+    writeMetric("pfm_read_bytes_total", "counter", "Bytes read.", [](const FileStats &s) { return s.bytesRead; });
+    writeMetric("pfm_written_bytes_total", "counter", "Bytes written or appended.", [](const FileStats &s) { return s.bytesWritten; });
+    writeLatency("pfm_page_read_seconds", "Page read latency.", [](const FileStats &s) -> const LatencyHistogram & { return s.readLatency; });
+    writeLatency("pfm_page_write_seconds", "Page write latency.", [](const FileStats &s) -> const LatencyHistogram & { return s.writeLatency; });
+    writeLatency("pfm_page_append_seconds", "Page append latency.", [](const FileStats &s) -> const LatencyHistogram & { return s.appendLatency; });
+    writeMetric("rbfm_forward_hops_total", "counter", "Forwarding addresses followed to read records.", [](const FileStats &s) { return s.forwardHops; });
+    writeMetric("rbfm_page_reorganizations_total", "counter", "Pages compacted.", [](const FileStats &s) { return s.pageReorganizations; });
+    writeMetric("rbfm_insert_pages_scanned_total", "counter", "Pages read by inserts looking for free space.", [](const FileStats &s) { return s.insertPagesScanned; });
+    writeMetric("rbfm_zone_map_pages_skipped_total", "counter", "Pages scans skipped because of the zone map.", [](const FileStats &s) { return s.zoneMapPagesSkipped; });
+    writeMetric("ix_node_visits_total", "counter", "Index nodes read descending from the root.", [](const FileStats &s) { return s.nodeVisits; });
+    writeMetric("ix_leaf_splits_total", "counter", "Leaf nodes split.", [](const FileStats &s) { return s.leafSplits; });
+    writeMetric("ix_internal_splits_total", "counter", "Internal nodes split.", [](const FileStats &s) { return s.internalSplits; });
+    writeMetric("ix_root_splits_total", "counter", "Root splits that added a level to the tree.", [](const FileStats &s) { return s.rootSplits; });
+    writeMetric("ix_tree_height", "gauge", "Levels of the tree, leaves included.", [](const FileStats &s) { return (uint64_t) s.treeHeight; });
+}
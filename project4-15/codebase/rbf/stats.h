@@ -0,0 +1,103 @@
+#ifndef _stats_h_
+#define _stats_h_
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+
+using namespace std;
+
+// Each power of two of a LatencyHistogram is split in 2^STATS_SUB_BUCKET_BITS buckets
+#define STATS_SUB_BUCKET_BITS 3
+#define STATS_SUB_BUCKETS     (1 << STATS_SUB_BUCKET_BITS)
+#define STATS_BUCKETS         (STATS_SUB_BUCKETS * (64 - STATS_SUB_BUCKET_BITS + 1))
+
+// Latencies in ns, bucketed like an HDR histogram: values below STATS_SUB_BUCKETS are exact, larger
+// ones are kept with STATS_SUB_BUCKET_BITS significant bits, so a percentile is off by at most 12.5%
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(uint64_t nanos);
+    void reset();
+
+    uint64_t getCount() const;
+    uint64_t getSum() const;
+    uint64_t getMin() const;
+    uint64_t getMax() const;
+    // The upper bound of the bucket holding the value at the given fraction (0 to 1) of all values
+    uint64_t getPercentile(double fraction) const;
+
+private:
+    static unsigned getBucket(uint64_t nanos);
+    static uint64_t getBucketBound(unsigned bucket);        // largest value that falls in the bucket
+
+    uint64_t counts[STATS_BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+};
+
+
+// Everything recorded about one file. Fields that don't apply to the kind of file stay 0.
+struct FileStats
+{
+    FileStats();
+
+    // Page I/O through FileHandle
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t appends;
+    uint64_t bytesRead;
+    uint64_t bytesWritten;
+    LatencyHistogram readLatency;
+    LatencyHistogram writeLatency;
+    LatencyHistogram appendLatency;
+
+    // RecordBasedFileManager
+    uint64_t forwardHops;               // forwarding addresses followed to read a record or attribute
+    uint64_t pageReorganizations;       // reorganizePage calls
+    uint64_t insertPagesScanned;        // pages read by insertRecord looking for free space
+    uint64_t zoneMapPagesSkipped;       // pages scans left unread because of the zone map
+
+    // IndexManager
+    uint64_t nodeVisits;                // nodes read descending from the root
+    uint64_t leafSplits;
+    uint64_t internalSplits;
+    uint64_t rootSplits;                // internal splits that added a level
+    unsigned treeHeight;                // levels seen by the last descent, 0 before any
+};
+
+
+// Process-wide statistics keyed by file name. Entries outlive the handles (and files) they were
+// recorded through, so counts add up over reopening and recreating a file until reset().
+class StatsRegistry
+{
+public:
+    static StatsRegistry* instance();
+
+    // The entry of the file, created on first use. It stays at the same address.
+    FileStats *getFileStats(const string &fileName);
+    const map<string, FileStats> &getAllFileStats() const;
+
+    // Zero every entry
+    void reset();
+
+    // Dump every entry as a JSON object, or as Prometheus text exposition with a file label
+    void writeJson(ostream &out) const;
+    void writePrometheus(ostream &out) const;
+
+protected:
+    StatsRegistry();
+    ~StatsRegistry();
+
+private:
+    static StatsRegistry *_stats_registry;
+
+    map<string, FileStats> files;
+};
+
+#endif
@@ -0,0 +1,305 @@
+#include <cstring>
+
+#include "zonemap.h"
+#include "arena.h"
+
+string ZoneMap::getFileName(const string &recordFileName)
+{
+    return recordFileName + ".zm";
+}
+
+RC ZoneMap::create(const string &recordFileName, const vector<unsigned> &attrIndexes, const vector<AttrType> &types)
+{
+    if (attrIndexes.empty() || attrIndexes.size() > ZONE_MAP_MAX_ATTRIBUTES || attrIndexes.size() != types.size())
+        return RBFM_ZONE_MAP_FAILED;
+
+    PagedFileManager *pfm = PagedFileManager::instance();
+    string fileName = getFileName(recordFileName);
+    if (pfm->createFile(fileName))
+        return RBFM_CREATE_FAILED;
+
+    // The header page
+    void *page = PageBufferPool::acquire();
+    memset(page, 0, PAGE_SIZE);
+    uint32_t *header = (uint32_t *) page;
+    header[0] = attrIndexes.size();
+    for (unsigned i = 0; i < attrIndexes.size(); i++)
+    {
+        header[1 + 2 * i] = attrIndexes[i];
+        header[2 + 2 * i] = types[i];
+    }
+
+    FileHandle fileHandle;
+    RC rc = pfm->openFile(fileName, fileHandle);
+    if (rc == SUCCESS)
+    {
+        rc = fileHandle.appendPage(page) ? RBFM_APPEND_FAILED : SUCCESS;
+        pfm->closeFile(fileHandle);
+    }
+    PageBufferPool::release(page);
+    if (rc != SUCCESS)
+        pfm->destroyFile(fileName);
+    return rc;
+}
+
+RC ZoneMap::destroy(const string &recordFileName)
+{
+    return PagedFileManager::instance()->destroyFile(getFileName(recordFileName));
+}
+
+ZoneMap *ZoneMap::open(const string &recordFileName)
+{
+    ZoneMap *zoneMap = new ZoneMap();
+    if (PagedFileManager::instance()->openFile(getFileName(recordFileName), zoneMap->fileHandle))
+    {
+        delete zoneMap;
+        return NULL;
+    }
+
+    void *page = PageBufferPool::acquire();
+    if (zoneMap->fileHandle.readPage(0, page))
+    {
+        PageBufferPool::release(page);
+        delete zoneMap;
+        return NULL;
+    }
+    uint32_t *header = (uint32_t *) page;
+    for (unsigned i = 0; i < header[0] && i < ZONE_MAP_MAX_ATTRIBUTES; i++)
+    {
+        zoneMap->attrIndexes.push_back(header[1 + 2 * i]);
+        zoneMap->types.push_back((AttrType) header[2 + 2 * i]);
+    }
+    PageBufferPool::release(page);
+
+    if (zoneMap->attrIndexes.empty())
+    {
+        delete zoneMap;
+        return NULL;
+    }
+    zoneMap->pagesPerZonePage = PAGE_SIZE / (zoneMap->attrIndexes.size() * sizeof(ZoneMapEntry));
+    return zoneMap;
+}
+
+ZoneMap::ZoneMap()
+{
+    pagesPerZonePage = 0;
+}
+
+ZoneMap::~ZoneMap()
+{
+    PagedFileManager::instance()->closeFile(fileHandle);
+}
+
+unsigned ZoneMap::getAttributeCount() const
+{
+    return attrIndexes.size();
+}
+
+unsigned ZoneMap::getAttributeIndex(unsigned i) const
+{
+    return attrIndexes[i];
+}
+
+AttrType ZoneMap::getAttributeType(unsigned i) const
+{
+    return types[i];
+}
+
+int ZoneMap::findAttribute(unsigned attrIndex) const
+{
+    for (unsigned i = 0; i < attrIndexes.size(); i++)
+    {
+        if (attrIndexes[i] == attrIndex)
+            return i;
+    }
+    return -1;
+}
+
+void ZoneMap::locate(PageNum pageNum, PageNum &zonePage, unsigned &offset) const
+{
+    zonePage = 1 + pageNum / pagesPerZonePage;
+    offset = (pageNum % pagesPerZonePage) * attrIndexes.size() * sizeof(ZoneMapEntry);
+}
+
+RC ZoneMap::readEntries(PageNum pageNum, vector<ZoneMapEntry> &entries)
+{
+    PageNum zonePage;
+    unsigned offset;
+    locate(pageNum, zonePage, offset);
+
+    entries.assign(attrIndexes.size(), ZoneMapEntry());
+    if (zonePage >= fileHandle.getNumberOfPages())
+        return SUCCESS;
+
+    void *page = PageBufferPool::acquire();
+    if (fileHandle.readPage(zonePage, page))
+    {
+        PageBufferPool::release(page);
+        return RBFM_READ_FAILED;
+    }
+    memcpy(entries.data(), (char *) page + offset, entries.size() * sizeof(ZoneMapEntry));
+    PageBufferPool::release(page);
+    return SUCCESS;
+}
+
+RC ZoneMap::writeEntries(PageNum pageNum, const vector<ZoneMapEntry> &entries)
+{
+    PageNum zonePage;
+    unsigned offset;
+    locate(pageNum, zonePage, offset);
+
+    void *page = PageBufferPool::acquire();
+    RC rc = SUCCESS;
+    // Pages of entries up to this one, all empty
+    memset(page, 0, PAGE_SIZE);
+    while (rc == SUCCESS && fileHandle.getNumberOfPages() <= zonePage)
+        rc = fileHandle.appendPage(page) ? RBFM_APPEND_FAILED : SUCCESS;
+
+    if (rc == SUCCESS && fileHandle.readPage(zonePage, page))
+        rc = RBFM_READ_FAILED;
+    if (rc == SUCCESS)
+    {
+        memcpy((char *) page + offset, entries.data(), entries.size() * sizeof(ZoneMapEntry));
+        if (fileHandle.writePage(zonePage, page))
+            rc = RBFM_WRITE_FAILED;
+    }
+    PageBufferPool::release(page);
+    return rc;
+}
+
+// Like PredicateEvaluator::compareVarChar: bytes first, then the shorter string is smaller
+static int compareBytes(const char *lhs, uint32_t lhsLength, const char *rhs, uint32_t rhsLength)
+{
+    int cmp = memcmp(lhs, rhs, lhsLength < rhsLength ? lhsLength : rhsLength);
+    if (cmp == 0)
+        cmp = lhsLength < rhsLength ? -1 : (lhsLength > rhsLength ? 1 : 0);
+    return cmp;
+}
+
+bool ZoneMap::widen(ZoneMapEntry &entry, AttrType type, const char *field, uint32_t length)
+{
+    bool empty = !(entry.flags & ZONE_MAP_HAS_VALUES);
+    bool changed = empty;
+    if (type == TypeInt)
+    {
+        int32_t value, min, max;
+        memcpy(&value, field, INT_SIZE);
+        memcpy(&min, entry.min, INT_SIZE);
+        memcpy(&max, entry.max, INT_SIZE);
+        if (empty || value < min)
+        {
+            memcpy(entry.min, &value, INT_SIZE);
+            changed = true;
+        }
+        if (empty || value > max)
+        {
+            memcpy(entry.max, &value, INT_SIZE);
+            changed = true;
+        }
+    }
+    else if (type == TypeReal)
+    {
+        float value, min, max;
+        memcpy(&value, field, REAL_SIZE);
+        memcpy(&min, entry.min, REAL_SIZE);
+        memcpy(&max, entry.max, REAL_SIZE);
+        if (empty || value < min)
+        {
+            memcpy(entry.min, &value, REAL_SIZE);
+            changed = true;
+        }
+        if (empty || value > max)
+        {
+            memcpy(entry.max, &value, REAL_SIZE);
+            changed = true;
+        }
+    }
+    else
+    {
+        // The prefix of the smallest string is the smallest prefix, so min stays a lower bound.
+        // max is only an upper bound for strings it doesn't prefix when a longer one was cut.
+        uint32_t prefixLength = length < ZONE_MAP_PREFIX_SIZE ? length : ZONE_MAP_PREFIX_SIZE;
+        bool truncated = length > ZONE_MAP_PREFIX_SIZE;
+        if (empty || compareBytes(field, prefixLength, entry.min, entry.minLength) < 0)
+        {
+            memcpy(entry.min, field, prefixLength);
+            entry.minLength = prefixLength;
+            changed = true;
+        }
+        int cmp = empty ? 1 : compareBytes(field, prefixLength, entry.max, entry.maxLength);
+        if (cmp > 0)
+        {
+            memcpy(entry.max, field, prefixLength);
+            entry.maxLength = prefixLength;
+            entry.flags &= ~ZONE_MAP_MAX_TRUNCATED;
+            changed = true;
+        }
+        if (cmp >= 0 && truncated && !(entry.flags & ZONE_MAP_MAX_TRUNCATED))
+        {
+            entry.flags |= ZONE_MAP_MAX_TRUNCATED;
+            changed = true;
+        }
+    }
+    entry.flags |= ZONE_MAP_HAS_VALUES;
+    return changed;
+}
+
+// Whether a value in the range may satisfy (value compOp constant), given how the constant compares
+// to the stored min and max. aboveMax: the constant is larger than every value. A bound that isn't
+// exact is a prefix of the actual one.
+static bool rangeMayMatch(CompOp compOp, int cmpMin, int cmpMax, bool aboveMax, bool minExact, bool maxExact)
+{
+    switch (compOp)
+    {
+        case EQ_OP: return cmpMin >= 0 && !aboveMax;
+        case LT_OP: return cmpMin > 0;
+        case LE_OP: return cmpMin >= 0;
+        case GT_OP: return !aboveMax && (!maxExact || cmpMax < 0);
+        case GE_OP: return !aboveMax;
+        // Only a page holding nothing but the constant is ruled out
+        case NE_OP: return !minExact || !maxExact || cmpMin != 0 || cmpMax != 0;
+        default: return true;
+    }
+}
+
+bool ZoneMap::mayMatch(const ZoneMapEntry &entry, AttrType type, CompOp compOp, const void *constant)
+{
+    if (compOp == NO_OP || constant == NULL)
+        return true;
+    // Null values satisfy no comparison
+    if (!(entry.flags & ZONE_MAP_HAS_VALUES))
+        return false;
+
+    if (type == TypeInt)
+    {
+        int32_t value, min, max;
+        memcpy(&value, constant, INT_SIZE);
+        memcpy(&min, entry.min, INT_SIZE);
+        memcpy(&max, entry.max, INT_SIZE);
+        int cmpMin = value < min ? -1 : value > min;
+        int cmpMax = value < max ? -1 : value > max;
+        return rangeMayMatch(compOp, cmpMin, cmpMax, cmpMax > 0, true, true);
+    }
+    if (type == TypeReal)
+    {
+        float value, min, max;
+        memcpy(&value, constant, REAL_SIZE);
+        memcpy(&min, entry.min, REAL_SIZE);
+        memcpy(&max, entry.max, REAL_SIZE);
+        int cmpMin = value < min ? -1 : value > min;
+        int cmpMax = value < max ? -1 : value > max;
+        return rangeMayMatch(compOp, cmpMin, cmpMax, cmpMax > 0, true, true);
+    }
+
+    uint32_t length;
+    memcpy(&length, constant, VARCHAR_LENGTH_SIZE);
+    const char *value = (const char *) constant + VARCHAR_LENGTH_SIZE;
+    int cmpMin = compareBytes(value, length, entry.min, entry.minLength);
+    int cmpMax = compareBytes(value, length, entry.max, entry.maxLength);
+    bool maxExact = !(entry.flags & ZONE_MAP_MAX_TRUNCATED);
+    // Strings that max prefixes may be larger than the constant. Any other larger one is larger than them all.
+    bool aboveMax = cmpMax > 0 && (maxExact || length < entry.maxLength || memcmp(value, entry.max, entry.maxLength) != 0);
+    // A min that fills the prefix may have been cut
+    bool minExact = entry.minLength < ZONE_MAP_PREFIX_SIZE;
+    return rangeMayMatch(compOp, cmpMin, cmpMax, aboveMax, minExact, maxExact);
+}
@@ -0,0 +1,76 @@
+#ifndef _zonemap_h_
+#define _zonemap_h_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../rbf/pfm.h"
+#include "../rbf/rbfm.h"
+
+using namespace std;
+
+// Leading bytes of a varchar kept as its min or max
+#define ZONE_MAP_PREFIX_SIZE    12
+// Attributes one zone map can summarize
+#define ZONE_MAP_MAX_ATTRIBUTES 32
+
+// ZoneMapEntry flags
+#define ZONE_MAP_HAS_VALUES     0x1     // some record on the page has a non null value
+#define ZONE_MAP_MAX_TRUNCATED  0x2     // the largest varchar is longer than max
+
+// The range of one attribute over the valid records of one page.
+// Ints and reals use the first 4 bytes of min and max, varchars minLength and maxLength bytes.
+typedef struct ZoneMapEntry
+{
+    uint8_t flags;
+    uint8_t minLength;
+    uint8_t maxLength;
+    uint8_t unused;
+    char min[ZONE_MAP_PREFIX_SIZE];
+    char max[ZONE_MAP_PREFIX_SIZE];
+} ZoneMapEntry;
+
+// The zone map of a record file: for every page, an entry per summarized attribute. It lives in
+// the paged file "<record file>.zm". Page 0 lists the attributes (count, then index in the record
+// descriptor and type of each), the following pages hold the entries of consecutive record pages.
+// Entries of pages the zone map hasn't seen yet read as empty.
+class ZoneMap
+{
+public:
+    static string getFileName(const string &recordFileName);
+
+    static RC create(const string &recordFileName, const vector<unsigned> &attrIndexes, const vector<AttrType> &types);
+    static RC destroy(const string &recordFileName);
+    // The zone map of the record file, NULL if it has none
+    static ZoneMap *open(const string &recordFileName);
+    ~ZoneMap();
+
+    unsigned getAttributeCount() const;
+    unsigned getAttributeIndex(unsigned i) const;
+    AttrType getAttributeType(unsigned i) const;
+    // Position among the summarized attributes of the record descriptor's attribute, -1 if not summarized
+    int findAttribute(unsigned attrIndex) const;
+
+    // The entries of a record page, one per summarized attribute
+    RC readEntries(PageNum pageNum, vector<ZoneMapEntry> &entries);
+    RC writeEntries(PageNum pageNum, const vector<ZoneMapEntry> &entries);
+
+    // Extend the entry to cover a value given as its bytes in the record. Returns whether it changed.
+    static bool widen(ZoneMapEntry &entry, AttrType type, const char *field, uint32_t length);
+    // Whether a value in the entry's range may satisfy (value compOp constant), constant in API format
+    static bool mayMatch(const ZoneMapEntry &entry, AttrType type, CompOp compOp, const void *constant);
+
+private:
+    ZoneMap();
+
+    // Where the entries of a record page are: page of the zone map file and offset in it
+    void locate(PageNum pageNum, PageNum &zonePage, unsigned &offset) const;
+
+    FileHandle fileHandle;
+    vector<unsigned> attrIndexes;
+    vector<AttrType> types;
+    unsigned pagesPerZonePage;
+};
+
+#endif
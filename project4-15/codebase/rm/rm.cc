@@ -2,13 +2,18 @@
 #include "rm.h"
 #include <string.h>
 #include <algorithm>
+#include <random>
 
 RelationManager* RelationManager::_rm = 0;
 
 RelationManager* RelationManager::instance()
 {
     if(!_rm)
+    {
         _rm = new RelationManager();
+        // Tail pages of append-only tables are written when the process exits
+        atexit([] { delete _rm; _rm = 0; });
+    }
 
     return _rm;
 }
@@ -16,12 +21,14 @@ RelationManager* RelationManager::instance()
 RelationManager::RelationManager():
     tableDescriptor(createTableDescriptor()),
     columnDescriptor(createColumnDescriptor()),
-    indexDescriptor(createIndexDescriptor())
+    indexDescriptor(createIndexDescriptor()),
+    statisticsDescriptor(createStatisticsDescriptor())
 {
 }
 
 RelationManager::~RelationManager()
 {
+    closeTailPages();
 }
 
 RC RelationManager::createCatalog()
@@ -36,17 +43,23 @@ RC RelationManager::createCatalog()
     if (rc)
         return rc;
     rc = rbfm->createFile(getFileName(INDEXES_TABLE_NAME));
+    if (rc)
+        return rc;
+    rc = rbfm->createFile(getFileName(STATISTICS_TABLE_NAME));
     if (rc)
         return rc;
 
     // Add table entries for both Tables and Columns
-    rc = insertTable(TABLES_TABLE_ID, 1, TABLES_TABLE_NAME);
+    rc = insertTable(TABLES_TABLE_ID, 1, TABLES_TABLE_NAME, DEFAULT_FILL_FACTOR, false);
     if (rc)
         return rc;
-    rc = insertTable(COLUMNS_TABLE_ID, 1, COLUMNS_TABLE_NAME);
+    rc = insertTable(COLUMNS_TABLE_ID, 1, COLUMNS_TABLE_NAME, DEFAULT_FILL_FACTOR, false);
     if (rc)
         return rc;
-    rc = insertTable(INDEXES_TABLE_ID, 1, INDEXES_TABLE_NAME);
+    rc = insertTable(INDEXES_TABLE_ID, 1, INDEXES_TABLE_NAME, DEFAULT_FILL_FACTOR, false);
+    if (rc)
+        return rc;
+    rc = insertTable(STATISTICS_TABLE_ID, 1, STATISTICS_TABLE_NAME, DEFAULT_FILL_FACTOR, false);
     if (rc)
         return rc;
 
@@ -58,6 +71,9 @@ RC RelationManager::createCatalog()
     if (rc)
         return rc;
     rc = insertColumns(INDEXES_TABLE_ID, indexDescriptor);
+    if (rc)
+        return rc;
+    rc = insertColumns(STATISTICS_TABLE_ID, statisticsDescriptor);
     if (rc)
         return rc;
 
@@ -69,7 +85,10 @@ RC RelationManager::deleteCatalog()
 {
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
 
-    RC rc;
+    // The tables outlive the catalog, with the tuples of their tail pages
+    RC rc = closeTailPages();
+    if (rc)
+        return rc;
 
     rc = rbfm->destroyFile(getFileName(TABLES_TABLE_NAME));
     if (rc)
@@ -83,16 +102,26 @@ RC RelationManager::deleteCatalog()
     if (rc)
         return rc;
 
+    rc = rbfm->destroyFile(getFileName(STATISTICS_TABLE_NAME));
+    if (rc)
+        return rc;
+
+    statisticsDelta.clear();
+    tableOptions.clear();
     return SUCCESS;
 }
 
-RC RelationManager::createTable(const string &tableName, const vector<Attribute> &attrs)
+RC RelationManager::createTable(const string &tableName, const vector<Attribute> &attrs, FileFormat format, unsigned pageSize,
+        unsigned fillFactor, bool appendOnly)
 {
     RC rc;
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
 
+    if (fillFactor < 1 || fillFactor > 100)
+        return RM_BAD_FILL_FACTOR;
+
     // Create the rbfm file to store the table
-    if ((rc = rbfm->createFile(getFileName(tableName))))
+    if ((rc = rbfm->createFile(getFileName(tableName), format, pageSize)))
         return rc;
 
     // Get the table's ID
@@ -102,9 +131,11 @@ RC RelationManager::createTable(const string &tableName, const vector<Attribute>
         return rc;
 
     // Insert the table into the Tables table (0 means this is not a system table)
-    rc = insertTable(id, 0, tableName);
+    rc = insertTable(id, 0, tableName, fillFactor, appendOnly);
     if (rc)
         return rc;
+    tableOptions[tableName].fillFactor = fillFactor;
+    tableOptions[tableName].appendOnly = appendOnly;
 
     // Insert the table's columns into the Columns table
     rc = insertColumns(id, attrs);
@@ -135,6 +166,18 @@ RC RelationManager::deleteTable(const string &tableName)
         destroyIndex(tableName, attr.name);
     }
 
+    // and its statistics, if it was ever analyzed
+    deleteStatistics(tableName);
+    statisticsDelta.erase(tableName);
+    tableOptions.erase(tableName);
+    // Its last tuples go with it
+    auto tail = tailPages.find(tableName);
+    if (tail != tailPages.end())
+    {
+        rbfm->closeFile(tail->second.fileHandle);
+        tailPages.erase(tail);
+    }
+
     // Delete the rbfm file holding this table's entries
     rc = rbfm->destroyFile(getFileName(tableName));
     if (rc)
@@ -303,6 +346,19 @@ RC RelationManager::insertTuple(const string &tableName, const void *data, RID &
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
     RC rc;
 
+    // Append-only tables fill the tail page we keep for them, with their file open
+    auto tail = tailPages.find(tableName);
+    if (tail != tailPages.end())
+    {
+        TableTail &t = tail->second;
+        rc = rbfm->appendRecord(t.fileHandle, t.recordDescriptor, data, t.page, rid);
+        if (rc)
+            return rc;
+        statisticsDelta[tableName].first++;
+        statisticsDelta[tableName].second++;
+        return insertIndexEntries(t.recordDescriptor, t.indexes, data, rid);
+    }
+
     // If this is a system table, we cannot modify it
     bool isSystem;
     rc = isSystemTable(isSystem, tableName);
@@ -317,16 +373,38 @@ RC RelationManager::insertTuple(const string &tableName, const void *data, RID &
     if (rc)
         return rc;
 
+    TableOptions options;
+    rc = getTableOptions(tableName, options);
+    if (rc)
+        return rc;
+
+    // The first insert into an append-only table since its tail page was dropped
+    if (options.appendOnly)
+    {
+        rc = openTailPage(tableName, recordDescriptor, options.fillFactor);
+        if (rc)
+            return rc;
+        return insertTuple(tableName, data, rid);
+    }
+
     // And get fileHandle
     FileHandle fileHandle;
     rc = rbfm->openFile(getFileName(tableName), fileHandle);
     if (rc)
         return rc;
+    fileHandle.fillFactor = options.fillFactor;
 
     // Let rbfm do all the work
     rc = rbfm->insertRecord(fileHandle, recordDescriptor, data, rid);
     rbfm->closeFile(fileHandle);
 
+    // Keep the row count current until the next analyze
+    if (rc == SUCCESS)
+    {
+        statisticsDelta[tableName].first++;
+        statisticsDelta[tableName].second++;
+    }
+
     rc = updateIndexes(tableName, data, rid);
 
     return rc;
@@ -351,6 +429,11 @@ RC RelationManager::deleteTuple(const string &tableName, const RID &rid)
     if (rc)
         return rc;
 
+    // The record may be on the tail page
+    rc = dropTailPage(tableName);
+    if (rc)
+        return rc;
+
     // And get fileHandle
     FileHandle fileHandle;
     rc = rbfm->openFile(getFileName(tableName), fileHandle);
@@ -361,6 +444,12 @@ RC RelationManager::deleteTuple(const string &tableName, const RID &rid)
     rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rid);
     rbfm->closeFile(fileHandle);
 
+    if (rc == SUCCESS)
+    {
+        statisticsDelta[tableName].first--;
+        statisticsDelta[tableName].second++;
+    }
+
     return rc;
 }
 
@@ -383,16 +472,31 @@ RC RelationManager::updateTuple(const string &tableName, const void *data, const
     if (rc)
         return rc;
 
+    // Tuples that no longer fit move to a page with room under the fill factor
+    unsigned fillFactor;
+    rc = getFillFactor(tableName, fillFactor);
+    if (rc)
+        return rc;
+
+    // The record may be on the tail page, or move to it
+    rc = dropTailPage(tableName);
+    if (rc)
+        return rc;
+
     // And get fileHandle
     FileHandle fileHandle;
     rc = rbfm->openFile(getFileName(tableName), fileHandle);
     if (rc)
         return rc;
+    fileHandle.fillFactor = fillFactor;
 
     // Let rbfm do all the work
     rc = rbfm->updateRecord(fileHandle, recordDescriptor, data, rid);
     rbfm->closeFile(fileHandle);
 
+    if (rc == SUCCESS)
+        statisticsDelta[tableName].second++;
+
     return rc;
 }
 
@@ -407,6 +511,11 @@ RC RelationManager::readTuple(const string &tableName, const RID &rid, void *dat
     if (rc)
         return rc;
 
+    // The tuple may still be on the tail page
+    rc = flush(tableName);
+    if (rc)
+        return rc;
+
     // And get fileHandle
     FileHandle fileHandle;
     rc = rbfm->openFile(getFileName(tableName), fileHandle);
@@ -436,6 +545,10 @@ RC RelationManager::readAttribute(const string &tableName, const RID &rid, const
     if (rc)
         return rc;
 
+    rc = flush(tableName);
+    if (rc)
+        return rc;
+
     FileHandle fileHandle;
     rc = rbfm->openFile(getFileName(tableName), fileHandle);
     if (rc)
@@ -481,6 +594,16 @@ vector<Attribute> RelationManager::createTableDescriptor()
     attr.length = (AttrLength)INT_SIZE;
     td.push_back(attr);
 
+    attr.name = TABLES_COL_FILL_FACTOR;
+    attr.type = TypeInt;
+    attr.length = (AttrLength)INT_SIZE;
+    td.push_back(attr);
+
+    attr.name = TABLES_COL_APPEND_ONLY;
+    attr.type = TypeInt;
+    attr.length = (AttrLength)INT_SIZE;
+    td.push_back(attr);
+
     return td;
 }
 
@@ -514,6 +637,11 @@ vector<Attribute> RelationManager::createColumnDescriptor()
     attr.length = (AttrLength)INT_SIZE;
     cd.push_back(attr);
 
+    attr.name = COLUMNS_COL_COLUMN_ENCODING;
+    attr.type = TypeInt;
+    attr.length = (AttrLength)INT_SIZE;
+    cd.push_back(attr);
+
     return cd;
 }
 
@@ -539,9 +667,72 @@ vector<Attribute> RelationManager::createIndexDescriptor() {
     return id;
 }
 
+vector<Attribute> RelationManager::createStatisticsDescriptor() {
+    vector<Attribute> sd;
+    Attribute attr;
+
+    attr.name = STATISTICS_COL_TABLE_NAME;
+    attr.type = TypeVarChar;
+    attr.length = (AttrLength) STATISTICS_COL_TABLE_NAME_SIZE;
+    sd.push_back(attr);
+
+    attr.name = STATISTICS_COL_COLUMN_NAME;
+    attr.type = TypeVarChar;
+    attr.length = (AttrLength) STATISTICS_COL_COLUMN_NAME_SIZE;
+    sd.push_back(attr);
+
+    attr.name = STATISTICS_COL_ROW_COUNT;
+    attr.type = TypeInt;
+    attr.length = (AttrLength) INT_SIZE;
+    sd.push_back(attr);
+
+    attr.name = STATISTICS_COL_PAGE_COUNT;
+    attr.type = TypeInt;
+    attr.length = (AttrLength) INT_SIZE;
+    sd.push_back(attr);
+
+    attr.name = STATISTICS_COL_NULL_COUNT;
+    attr.type = TypeInt;
+    attr.length = (AttrLength) INT_SIZE;
+    sd.push_back(attr);
+
+    attr.name = STATISTICS_COL_DISTINCT_COUNT;
+    attr.type = TypeInt;
+    attr.length = (AttrLength) INT_SIZE;
+    sd.push_back(attr);
+
+    attr.name = STATISTICS_COL_MIN_VALUE;
+    attr.type = TypeVarChar;
+    attr.length = (AttrLength) STATISTICS_COL_VALUE_SIZE;
+    sd.push_back(attr);
+
+    attr.name = STATISTICS_COL_MAX_VALUE;
+    attr.type = TypeVarChar;
+    attr.length = (AttrLength) STATISTICS_COL_VALUE_SIZE;
+    sd.push_back(attr);
+
+    attr.name = STATISTICS_COL_HISTOGRAM;
+    attr.type = TypeVarChar;
+    attr.length = (AttrLength) STATISTICS_COL_HISTOGRAM_SIZE;
+    sd.push_back(attr);
+
+    attr.name = STATISTICS_COL_INDEX_HEIGHT;
+    attr.type = TypeInt;
+    attr.length = (AttrLength) INT_SIZE;
+    sd.push_back(attr);
+
+    attr.name = STATISTICS_COL_INDEX_LEAVES;
+    attr.type = TypeInt;
+    attr.length = (AttrLength) INT_SIZE;
+    sd.push_back(attr);
+
+    return sd;
+}
+
 // Creates the Tables table entry for the given id and tableName
 // Assumes fileName is just tableName + file extension
-void RelationManager::prepareTablesRecordData(int32_t id, bool system, const string &tableName, void *data)
+void RelationManager::prepareTablesRecordData(int32_t id, bool system, const string &tableName, int32_t fillFactor, bool appendOnly,
+        void *data)
 {
     unsigned offset = 0;
 
@@ -572,11 +763,18 @@ void RelationManager::prepareTablesRecordData(int32_t id, bool system, const str
     offset += file_name_len; 
     // Copy in system indicator
     memcpy((char*) data + offset, &is_system, INT_SIZE);
+    offset += INT_SIZE;
+    // Copy in fill factor
+    memcpy((char*) data + offset, &fillFactor, INT_SIZE);
+    offset += INT_SIZE;
+    // Copy in append-only indicator
+    int32_t is_append_only = appendOnly ? 1 : 0;
+    memcpy((char*) data + offset, &is_append_only, INT_SIZE);
     offset += INT_SIZE; // not necessary because we return here, but what if we didn't?
 }
 
 // Prepares the Columns table entry for the given id and attribute list
-void RelationManager::prepareColumnsRecordData(int32_t id, int32_t pos, Attribute attr, void *data)
+void RelationManager::prepareColumnsRecordData(int32_t id, int32_t pos, Attribute attr, int32_t encoding, void *data)
 {
     unsigned offset = 0;
     int32_t name_len = attr.name.length();
@@ -605,6 +803,9 @@ void RelationManager::prepareColumnsRecordData(int32_t id, int32_t pos, Attribut
 
     memcpy((char*) data + offset, &pos, INT_SIZE);
     offset += INT_SIZE;
+
+    memcpy((char*) data + offset, &encoding, INT_SIZE);
+    offset += INT_SIZE;
 }
 
 void RelationManager::prepareIndexRecordData(const string &table_name, const string &attr_name, const string &index_filename, void *data) {
@@ -634,6 +835,76 @@ void RelationManager::prepareIndexRecordData(const string &table_name, const str
     memcpy((char*) data + offset, index_filename.c_str(), index_filename_len);
 }
 
+// Prepares the Statistics entry for one column of the table, or for the table itself if column is -1
+void RelationManager::prepareStatisticsRecordData(const string &tableName, const TableStatistics &stats, int column, void *data)
+{
+    unsigned offset = 2;
+    unsigned field = 0;
+    memset(data, 0, 2);
+
+    // Each helper appends the next field, or marks it null
+    auto appendInt = [&](int32_t value, bool null) {
+        if (null)
+            ((char*) data)[field / CHAR_BIT] |= 1 << (CHAR_BIT - 1 - field % CHAR_BIT);
+        else
+        {
+            memcpy((char*) data + offset, &value, INT_SIZE);
+            offset += INT_SIZE;
+        }
+        field++;
+    };
+    auto appendVarChar = [&](const string &value, bool null) {
+        if (null)
+            ((char*) data)[field / CHAR_BIT] |= 1 << (CHAR_BIT - 1 - field % CHAR_BIT);
+        else
+        {
+            int32_t len = value.length();
+            memcpy((char*) data + offset, &len, VARCHAR_LENGTH_SIZE);
+            offset += VARCHAR_LENGTH_SIZE;
+            memcpy((char*) data + offset, value.data(), len);
+            offset += len;
+        }
+        field++;
+    };
+
+    appendVarChar(tableName, false);
+    if (column < 0)
+    {
+        appendVarChar("", false);
+        appendInt(stats.rowCount, false);
+        appendInt(stats.pageCount, false);
+        for (unsigned i = 0; i < 2; i++)
+            appendInt(0, true);
+        for (unsigned i = 0; i < 3; i++)
+            appendVarChar("", true);
+        for (unsigned i = 0; i < 2; i++)
+            appendInt(0, true);
+        return;
+    }
+
+    const ColumnStatistics &cs = stats.columns[column];
+    appendVarChar(cs.name, false);
+    appendInt(0, true);
+    appendInt(0, true);
+    appendInt(cs.nullCount, false);
+    appendInt(cs.distinctCount, false);
+    appendVarChar(cs.minValue, !cs.hasRange);
+    appendVarChar(cs.maxValue, !cs.hasRange);
+
+    // Histogram bounds are stored back to back, each with its length in front
+    string histogram;
+    for (const string &bound: cs.histogram)
+    {
+        uint32_t len = bound.length();
+        histogram.append((char*) &len, VARCHAR_LENGTH_SIZE);
+        histogram.append(bound);
+    }
+    appendVarChar(histogram, !cs.hasRange);
+
+    appendInt(cs.indexHeight, cs.indexHeight < 0);
+    appendInt(cs.indexLeaves, cs.indexHeight < 0);
+}
+
 // Insert the given columns into the Columns table
 RC RelationManager::insertColumns(int32_t id, const vector<Attribute> &recordDescriptor)
 {
@@ -651,7 +922,7 @@ RC RelationManager::insertColumns(int32_t id, const vector<Attribute> &recordDes
     for (unsigned i = 0; i < recordDescriptor.size(); i++)
     {
         int32_t pos = i+1;
-        prepareColumnsRecordData(id, pos, recordDescriptor[i], columnData);
+        prepareColumnsRecordData(id, pos, recordDescriptor[i], COLUMN_ENCODING_PLAIN, columnData);
         rc = rbfm->insertRecord(fileHandle, columnDescriptor, columnData, rid);
         if (rc)
             return rc;
@@ -662,7 +933,7 @@ RC RelationManager::insertColumns(int32_t id, const vector<Attribute> &recordDes
     return SUCCESS;
 }
 
-RC RelationManager::insertTable(int32_t id, int32_t system, const string &tableName)
+RC RelationManager::insertTable(int32_t id, int32_t system, const string &tableName, int32_t fillFactor, bool appendOnly)
 {
     FileHandle fileHandle;
     RID rid;
@@ -674,7 +945,7 @@ RC RelationManager::insertTable(int32_t id, int32_t system, const string &tableN
         return rc;
 
     void *tableData = malloc (TABLES_RECORD_DATA_SIZE);
-    prepareTablesRecordData(id, system, tableName, tableData);
+    prepareTablesRecordData(id, system, tableName, fillFactor, appendOnly, tableData);
     rc = rbfm->insertRecord(fileHandle, tableDescriptor, tableData, rid);
 
     rbfm->closeFile(fileHandle);
@@ -682,6 +953,63 @@ RC RelationManager::insertTable(int32_t id, int32_t system, const string &tableN
     return rc;
 }
 
+RC RelationManager::setColumnEncoding(const string &tableName, const string &attributeName, int32_t encoding)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    RC rc;
+
+    int32_t id;
+    rc = getTableID(tableName, id);
+    if (rc)
+        return rc;
+    vector<Attribute> attrs;
+    rc = getAttributes(tableName, attrs);
+    if (rc)
+        return rc;
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(getFileName(COLUMNS_TABLE_NAME), fileHandle);
+    if (rc)
+        return rc;
+
+    // Find the column's entry by name among the table's, then write it again with the new encoding
+    RBFM_ScanIterator rbfm_si;
+    vector<string> projection;
+    projection.push_back(COLUMNS_COL_COLUMN_NAME);
+    rc = rbfm->scan(fileHandle, columnDescriptor, COLUMNS_COL_TABLE_ID, EQ_OP, &id, projection, rbfm_si);
+
+    RID rid;
+    void *data = malloc(COLUMNS_RECORD_DATA_SIZE);
+    bool found = false;
+    while (rc == SUCCESS && (rc = rbfm_si.getNextRecord(rid, data)) == SUCCESS)
+    {
+        string name;
+        fromAPI(name, data);
+        if (name == attributeName)
+        {
+            found = true;
+            break;
+        }
+    }
+    rbfm_si.close();
+
+    if (found)
+    {
+        for (unsigned i = 0; i < attrs.size(); i++)
+        {
+            if (attrs[i].name == attributeName)
+                prepareColumnsRecordData(id, i + 1, attrs[i], encoding, data);
+        }
+        rc = rbfm->updateRecord(fileHandle, columnDescriptor, data, rid);
+    }
+    else if (rc == RBFM_EOF)
+        rc = RM_ATTR_NOT_FOUND;
+
+    free(data);
+    rbfm->closeFile(fileHandle);
+    return rc;
+}
+
 // Get the next table ID for creating a table
 RC RelationManager::getNextTableID(int32_t &table_id)
 {
@@ -810,6 +1138,128 @@ RC RelationManager::isSystemTable(bool &system, const string &tableName)
     return rc;   
 }
 
+RC RelationManager::getFillFactor(const string &tableName, unsigned &fillFactor)
+{
+    TableOptions options;
+    RC rc = getTableOptions(tableName, options);
+    if (rc == SUCCESS)
+        fillFactor = options.fillFactor;
+    return rc;
+}
+
+RC RelationManager::getTableOptions(const string &tableName, TableOptions &options)
+{
+    auto cached = tableOptions.find(tableName);
+    if (cached != tableOptions.end())
+    {
+        options = cached->second;
+        return SUCCESS;
+    }
+
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    FileHandle fileHandle;
+    RC rc;
+
+    rc = rbfm->openFile(getFileName(TABLES_TABLE_NAME), fileHandle);
+    if (rc)
+        return rc;
+
+    vector<string> projection;
+    projection.push_back(TABLES_COL_FILL_FACTOR);
+    projection.push_back(TABLES_COL_APPEND_ONLY);
+
+    // Set up value to be tableName in API format (without null indicator)
+    void *value = malloc(5 + TABLES_COL_TABLE_NAME_SIZE);
+    int32_t name_len = tableName.length();
+    memcpy(value, &name_len, INT_SIZE);
+    memcpy((char*)value + INT_SIZE, tableName.c_str(), name_len);
+
+    RBFM_ScanIterator rbfm_si;
+    rc = rbfm->scan(fileHandle, tableDescriptor, TABLES_COL_TABLE_NAME, EQ_OP, value, projection, rbfm_si);
+
+    RID rid;
+    void *data = malloc (1 + 2 * INT_SIZE);
+    if ((rc = rbfm_si.getNextRecord(rid, data)) == SUCCESS)
+    {
+        int32_t fillFactor, appendOnly;
+        memcpy(&fillFactor, (char*) data + 1, INT_SIZE);
+        memcpy(&appendOnly, (char*) data + 1 + INT_SIZE, INT_SIZE);
+        options.fillFactor = fillFactor;
+        options.appendOnly = appendOnly != 0;
+        tableOptions[tableName] = options;
+    }
+
+    free(data);
+    free(value);
+    rbfm_si.close();
+    rbfm->closeFile(fileHandle);
+    return rc;
+}
+
+RC RelationManager::flush(const string &tableName)
+{
+    auto tail = tailPages.find(tableName);
+    if (tail == tailPages.end())
+        return SUCCESS;
+    return RecordBasedFileManager::instance()->flushTail(tail->second.fileHandle, tail->second.page);
+}
+
+RC RelationManager::flushAll()
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    RC rc = SUCCESS;
+    for (auto &tail : tailPages)
+    {
+        RC tailRC = rbfm->flushTail(tail.second.fileHandle, tail.second.page);
+        if (rc == SUCCESS)
+            rc = tailRC;
+    }
+    return rc;
+}
+
+RC RelationManager::openTailPage(const string &tableName, const vector<Attribute> &recordDescriptor, unsigned fillFactor)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    TableTail &tail = tailPages[tableName];
+    tail.recordDescriptor = recordDescriptor;
+    RC rc = getIndexes(tableName, recordDescriptor, tail.indexes);
+    if (rc == SUCCESS)
+        rc = rbfm->openFile(getFileName(tableName), tail.fileHandle);
+    if (rc)
+    {
+        tailPages.erase(tableName);
+        return rc;
+    }
+    tail.fileHandle.fillFactor = fillFactor;
+    return SUCCESS;
+}
+
+RC RelationManager::dropTailPage(const string &tableName)
+{
+    // Write it out, the next append reads the last page again
+    auto tail = tailPages.find(tableName);
+    if (tail == tailPages.end())
+        return SUCCESS;
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    RC rc = rbfm->flushTail(tail->second.fileHandle, tail->second.page);
+    if (rc == SUCCESS)
+    {
+        rbfm->closeFile(tail->second.fileHandle);
+        tailPages.erase(tail);
+    }
+    return rc;
+}
+
+RC RelationManager::closeTailPages()
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    RC rc = flushAll();
+    for (auto &tail : tailPages)
+        rbfm->closeFile(tail.second.fileHandle);
+    tailPages.clear();
+    return rc;
+}
+
 void RelationManager::toAPI(const string &str, void *data)
 {
     int32_t len = str.length();
@@ -884,7 +1334,7 @@ void RelationManager::fromAPI(float &real, void *data)
 
 // Standardized way of getting attribute from tuple
 // returns void * corresponding value w/o null indicator
-RC RelationManager::getAttrFromTuple(const vector<Attribute> attrs, int index, const void *tuple, void *key) {
+RC RelationManager::getAttrFromTuple(const vector<Attribute> &attrs, int index, const void *tuple, void *key) {
     // set key to point to first attr in tuple
     // skip null bytes
     int nullIndicatorSize = int(ceil((double) attrs.size() / CHAR_BIT));
@@ -924,8 +1374,20 @@ RC RelationManager::getAttrFromTuple(const vector<Attribute> attrs, int index, c
 }
 
 RC RelationManager::updateIndexes(const string &tableName, const void *data, const RID &rid) {
+    // get attributes for this table
+    vector<Attribute> tableAttrs;
+    getAttributes(tableName, tableAttrs);
+
+    vector<TableIndex> indexes;
+    RC rc = getIndexes(tableName, tableAttrs, indexes);
+    if (rc)
+        return rc;
+    return insertIndexEntries(tableAttrs, indexes, data, rid);
+}
+
+RC RelationManager::getIndexes(const string &tableName, const vector<Attribute> &tableAttrs, vector<TableIndex> &indexes) {
     RM_ScanIterator scanner;
-    IndexManager *im = IndexManager::instance();
+    indexes.clear();
 
     // turn tableName into API format
     void *value = malloc(tableName.length() + VARCHAR_LENGTH_SIZE);
@@ -933,10 +1395,6 @@ RC RelationManager::updateIndexes(const string &tableName, const void *data, con
     memcpy(value, &tableNameLength, VARCHAR_LENGTH_SIZE);
     memcpy((char*) value + VARCHAR_LENGTH_SIZE, tableName.c_str(), tableNameLength);
 
-    // get attributes for this table
-    vector<Attribute> tableAttrs;
-    getAttributes(tableName, tableAttrs);
-
     // just need attribute name and filename
     vector<string> projection;
     projection.push_back(INDEXES_COL_ATTR_NAME);
@@ -972,7 +1430,7 @@ RC RelationManager::updateIndexes(const string &tableName, const void *data, con
 
         // get attribute matching attribute-name from vector of attributes for this table
         auto pred = [&](Attribute a) { return a.name == attrName; };
-        vector<Attribute>::iterator attr = find_if(tableAttrs.begin(), tableAttrs.end(), pred);
+        vector<Attribute>::const_iterator attr = find_if(tableAttrs.begin(), tableAttrs.end(), pred);
         if (attr == tableAttrs.end()) {
             free(value);
             free(returnedData);
@@ -980,20 +1438,34 @@ RC RelationManager::updateIndexes(const string &tableName, const void *data, con
             return RM_ATTR_NOT_FOUND;
         }
 
+        TableIndex index;
+        index.pos = attr - tableAttrs.begin();
+        index.fileName = fileName;
+        indexes.push_back(index);
+    }
+
+    free(value);
+    free(returnedData);
+    scanner.close();
+    return SUCCESS;
+}
+
+RC RelationManager::insertIndexEntries(const vector<Attribute> &tableAttrs, const vector<TableIndex> &indexes, const void *data, const RID &rid) {
+    IndexManager *im = IndexManager::instance();
+    for (const TableIndex &index : indexes) {
+        const Attribute &attr = tableAttrs[index.pos];
+
         // key is now malloc'd and has value when getAttrFromtuple runs
-        void *key = malloc(attr->length);
-        getAttrFromTuple(tableAttrs, attr - tableAttrs.begin(), data, key);
+        void *key = malloc(attr.length + VARCHAR_LENGTH_SIZE);
+        getAttrFromTuple(tableAttrs, index.pos, data, key);
 
         // open index file and insert
         IXFileHandle ixFileHandle;
-        im->openFile(fileName, ixFileHandle);
-        im->insertEntry(ixFileHandle, *attr, key, rid);
+        im->openFile(index.fileName, ixFileHandle);
+        im->insertEntry(ixFileHandle, attr, key, rid);
         im->closeFile(ixFileHandle);
+        free(key);
     }
-
-    free(value);
-    free(returnedData);
-    scanner.close();
     return SUCCESS;
 }
 
@@ -1052,14 +1524,19 @@ RC RelationManager::getIndexFilename(const string &tableName, const string &attr
     return RM_NO_MATCHING_INDEX;
 }
 
-RC RelationManager::createIndex(const string &tableName, const string &attributeName)
+RC RelationManager::createIndex(const string &tableName, const string &attributeName, unsigned pageSize)
 {
     IndexManager *im = IndexManager::instance();
     RC rc;
 
+    // Inserts into the table look up its indexes again
+    rc = dropTailPage(tableName);
+    if (rc)
+        return rc;
+
     // create a file for the new index
     string index_filename = tableName + "_" + attributeName + INDEX_FILE_EXTENSION;
-    rc = im->createFile(index_filename);
+    rc = im->createFile(index_filename, pageSize);
     if (rc)
         return rc;
     
@@ -1103,6 +1580,8 @@ RC RelationManager::createIndex(const string &tableName, const string &attribute
     uint32_t tupleSize = int(ceil((double) recordDescriptor.size() / CHAR_BIT));;
     for(unsigned i = 0; i < recordDescriptor.size(); i++){
         tupleSize += recordDescriptor[i].length;
+        if (recordDescriptor[i].type == TypeVarChar)
+            tupleSize += VARCHAR_LENGTH_SIZE;
     }
 
     // tableData is tuple returned from scan of existing table, to input into newly
@@ -1124,35 +1603,87 @@ RC RelationManager::createIndex(const string &tableName, const string &attribute
         vector<Attribute>::iterator attr = find_if(recordDescriptor.begin(), recordDescriptor.end(), pred);
 
         // extract just the attribute we want from tuple
-        void *key = malloc(attr->length);
+        void *key = malloc(attr->length + VARCHAR_LENGTH_SIZE);
         getAttrFromTuple(recordDescriptor, attr - recordDescriptor.begin(), tableData, key);
 
         im->insertEntry(ixfileHandle, *attr, key, rid);
+        free(key);
     }
     im->closeFile(ixfileHandle);
 
     scanner.close();
     
     free(data);
+    free(tableData);
     return SUCCESS;
 }
 
-RC RelationManager::destroyIndex(const string &tableName, const string &attributeName)
+RC RelationManager::getIndexedAttributes(const string &tableName, vector<string> &attributeNames)
 {
-    IndexManager *im = IndexManager::instance();
-    RC rc;
+    attributeNames.clear();
+
+    // copy table name to API format without null indicator
+    void *value = malloc(VARCHAR_LENGTH_SIZE + tableName.length());
+    uint32_t nameLength = tableName.length();
+    memcpy(value, &nameLength, VARCHAR_LENGTH_SIZE);
+    memcpy((char*) value + VARCHAR_LENGTH_SIZE, tableName.c_str(), nameLength);
+
+    vector<string> projection;
+    projection.push_back(INDEXES_COL_ATTR_NAME);
+
+    RM_ScanIterator scanner;
+    RC rc = scan(INDEXES_TABLE_NAME, INDEXES_COL_TABLE_NAME, EQ_OP, value, projection, scanner);
+    if (rc)
+    {
+        free(value);
+        return rc;
+    }
 
-    string fileName;
+    RID rid;
+    void *data = malloc(1 + VARCHAR_LENGTH_SIZE + INDEXES_COL_ATTR_NAME_SIZE);
+    while ((rc = scanner.getNextTuple(rid, data)) == SUCCESS)
+    {
+        string attrName;
+        fromAPI(attrName, data);
+        attributeNames.push_back(attrName);
+    }
+    if (rc == RM_EOF)
+        rc = SUCCESS;
+
+    free(value);
+    free(data);
+    scanner.close();
+    return rc;
+}
+
+RC RelationManager::destroyIndex(const string &tableName, const string &attributeName)
+{
+    IndexManager *im = IndexManager::instance();
+    RC rc;
+
+    string fileName;
     RID rid;
     rc = getIndexFilename(tableName, attributeName, fileName, rid);
     if (rc)
         return rc;
 
+    // Inserts into the table look up its indexes again
+    rc = dropTailPage(tableName);
+    if (rc)
+        return rc;
+
     rc = im->destroyFile(fileName);
     if (rc)
         return rc;
     
-    rc = deleteTuple(INDEXES_TABLE_NAME, rid);
+    // Indexes is a system table, so deleteTuple would refuse
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    FileHandle fileHandle;
+    rc = rbfm->openFile(getFileName(INDEXES_TABLE_NAME), fileHandle);
+    if (rc)
+        return rc;
+    rc = rbfm->deleteRecord(fileHandle, indexDescriptor, rid);
+    rbfm->closeFile(fileHandle);
     if (rc)
         return rc;
     
@@ -1169,9 +1700,14 @@ RC RelationManager::scan(const string &tableName,
       const vector<string> &attributeNames,
       RM_ScanIterator &rm_ScanIterator)
 {
+    // Scan the tuples still on the tail page too
+    RC rc = flush(tableName);
+    if (rc)
+        return rc;
+
     // Open the file for the given tableName
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
-    RC rc = rbfm->openFile(getFileName(tableName), rm_ScanIterator.fileHandle);
+    rc = rbfm->openFile(getFileName(tableName), rm_ScanIterator.fileHandle);
     if (rc)
         return rc;
 
@@ -1216,7 +1752,13 @@ RC RelationManager::indexScan(const string &tableName,
     IndexManager *im = IndexManager::instance();
     RC rc;
 
-    rc = im->openFile(getFileName(tableName), rm_IndexScanIterator.ixfileHandle);
+    string fileName;
+    RID rid;
+    rc = getIndexFilename(tableName, attributeName, fileName, rid);
+    if (rc)
+        return rc;
+
+    rc = im->openFile(fileName, rm_IndexScanIterator.ixfileHandle);
     if (rc)
         return rc;
     
@@ -1254,3 +1796,763 @@ RC RM_IndexScanIterator::close() {
     im->closeFile(ixfileHandle);
     return SUCCESS;
 }
+
+// Statistics ///////////////
+
+// 64-bit hash of a value for the distinct count sketch: FNV-1a, then the murmur3 finalizer to mix the high bits
+static uint64_t hashValue(const string &value)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c: value)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// HyperLogLog estimate, with linear counting while registers are still empty
+static double estimateDistinct(const vector<uint8_t> &registers)
+{
+    double m = registers.size();
+    double sum = 0;
+    unsigned zeros = 0;
+    for (uint8_t r: registers)
+    {
+        sum += ldexp(1.0, -r);
+        if (r == 0)
+            zeros++;
+    }
+    double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0)
+        estimate = m * log(m / zeros);
+    return estimate;
+}
+
+// Orders raw values the way the rest of the system compares them
+static bool valueLess(AttrType type, const string &a, const string &b)
+{
+    switch (type)
+    {
+        case TypeInt:
+        {
+            int32_t x, y;
+            memcpy(&x, a.data(), INT_SIZE);
+            memcpy(&y, b.data(), INT_SIZE);
+            return x < y;
+        }
+        case TypeReal:
+        {
+            float x, y;
+            memcpy(&x, a.data(), REAL_SIZE);
+            memcpy(&y, b.data(), REAL_SIZE);
+            return x < y;
+        }
+        case TypeVarChar:
+            return a < b;
+    }
+    return false;
+}
+
+// Distinct values of a column from a sorted sample of total values with Haas and Stokes' Duj1
+// estimator: values seen once in the sample are the ones that may have more like them unseen.
+static int32_t scaleDistinct(const vector<string> &sample, int32_t total)
+{
+    unsigned distinct = 0;
+    unsigned once = 0;
+    for (unsigned i = 0, j; i < sample.size(); i = j)
+    {
+        for (j = i + 1; j < sample.size() && sample[j] == sample[i]; j++);
+        distinct++;
+        if (j - i == 1)
+            once++;
+    }
+    if (distinct == 0)
+        return 0;
+    double n = sample.size();
+    double estimate = n * distinct / (n - once + once * n / max((double) total, n));
+    return llround(max((double) distinct, min(estimate, (double) max(total, (int32_t) distinct))));
+}
+
+// Scans the whole table once, or every few pages for a sample. min/max and null counts are exact
+// for the pages read, distinct counts come from a HyperLogLog sketch and histograms from a
+// reservoir sample, so memory stays bounded.
+RC RelationManager::collectStatistics(const string &tableName, unsigned maxPages, TableStatistics &stats)
+{
+    RC rc;
+
+    vector<Attribute> attrs;
+    rc = getAttributes(tableName, attrs);
+    if (rc)
+        return rc;
+
+    stats.rowCount = 0;
+    stats.modifications = 0;
+    stats.columns.resize(attrs.size());
+    vector<string> projection;
+    for (unsigned i = 0; i < attrs.size(); i++)
+    {
+        ColumnStatistics &cs = stats.columns[i];
+        cs.name = attrs[i].name;
+        cs.type = attrs[i].type;
+        cs.nullCount = 0;
+        cs.hasRange = false;
+        cs.indexHeight = -1;
+        cs.indexLeaves = -1;
+        projection.push_back(attrs[i].name);
+    }
+
+    // One sketch and one sample per column
+    const unsigned registerCount = 1 << STATISTICS_HLL_PRECISION;
+    vector<vector<uint8_t> > registers(attrs.size(), vector<uint8_t>(registerCount, 0));
+    vector<vector<string> > samples(attrs.size());
+    vector<unsigned> seen(attrs.size(), 0);
+    minstd_rand random(181);
+
+    RM_ScanIterator scanner;
+    rc = scan(tableName, "", NO_OP, NULL, projection, scanner);
+    if (rc)
+        return rc;
+    stats.pageCount = scanner.fileHandle.getNumberOfPages();
+    unsigned sampledPages = maxPages ? scanner.rbfm_iter.samplePages(maxPages) : stats.pageCount;
+
+    unsigned nullIndicatorSize = int(ceil((double) attrs.size() / CHAR_BIT));
+    unsigned tupleSize = nullIndicatorSize;
+    for (Attribute &attr: attrs)
+        tupleSize += attr.length + (attr.type == TypeVarChar ? VARCHAR_LENGTH_SIZE : 0);
+    char *data = (char*) malloc(tupleSize);
+
+    RID rid;
+    while ((rc = scanner.getNextTuple(rid, data)) == SUCCESS)
+    {
+        stats.rowCount++;
+        unsigned offset = nullIndicatorSize;
+        for (unsigned i = 0; i < attrs.size(); i++)
+        {
+            ColumnStatistics &cs = stats.columns[i];
+            if (data[i / CHAR_BIT] & (1 << (CHAR_BIT - 1 - i % CHAR_BIT)))
+            {
+                cs.nullCount++;
+                continue;
+            }
+
+            string value;
+            if (attrs[i].type == TypeVarChar)
+            {
+                uint32_t len;
+                memcpy(&len, data + offset, VARCHAR_LENGTH_SIZE);
+                value.assign(data + offset + VARCHAR_LENGTH_SIZE, len);
+                offset += VARCHAR_LENGTH_SIZE + len;
+            }
+            else
+            {
+                value.assign(data + offset, INT_SIZE);
+                offset += INT_SIZE;
+            }
+
+            if (!cs.hasRange || valueLess(cs.type, value, cs.minValue))
+                cs.minValue = value;
+            if (!cs.hasRange || valueLess(cs.type, cs.maxValue, value))
+                cs.maxValue = value;
+            cs.hasRange = true;
+
+            // The low bits of the hash pick a register, which keeps the longest run of zeros seen in the rest
+            uint64_t hash = hashValue(value);
+            uint64_t rest = hash >> STATISTICS_HLL_PRECISION;
+            uint8_t rank = rest ? __builtin_ctzll(rest) + 1 : 64 - STATISTICS_HLL_PRECISION + 1;
+            uint8_t &reg = registers[i][hash & (registerCount - 1)];
+            reg = max(reg, rank);
+
+            // Reservoir sampling keeps every value with equal probability
+            seen[i]++;
+            if (samples[i].size() < STATISTICS_SAMPLE_SIZE)
+                samples[i].push_back(value);
+            else
+            {
+                unsigned j = random() % seen[i];
+                if (j < STATISTICS_SAMPLE_SIZE)
+                    samples[i][j] = value;
+            }
+        }
+    }
+    free(data);
+    scanner.close();
+    if (rc != RM_EOF)
+        return rc;
+
+    // The pages read stand for the whole table
+    bool sampled = sampledPages < (unsigned) stats.pageCount;
+    double scale = sampled ? (double) stats.pageCount / sampledPages : 1.0;
+    int32_t rowsRead = stats.rowCount;
+    stats.rowCount = llround(rowsRead * scale);
+
+    for (unsigned i = 0; i < attrs.size(); i++)
+    {
+        ColumnStatistics &cs = stats.columns[i];
+        int32_t nonNull = rowsRead - cs.nullCount;
+        vector<string> &sample = samples[i];
+        AttrType type = cs.type;
+        sort(sample.begin(), sample.end(), [type](const string &a, const string &b) { return valueLess(type, a, b); });
+        if (sampled)
+        {
+            cs.nullCount = llround(cs.nullCount * scale);
+            cs.distinctCount = scaleDistinct(sample, stats.rowCount - cs.nullCount);
+        }
+        else
+            cs.distinctCount = min(nonNull, (int32_t) llround(estimateDistinct(registers[i])));
+
+        // Equi-depth bounds: the values at evenly spaced ranks of the sorted sample
+        unsigned buckets = min((size_t) STATISTICS_HISTOGRAM_BUCKETS, sample.size());
+        for (unsigned b = 0; buckets && b <= buckets; b++)
+            cs.histogram.push_back(sample[b * (sample.size() - 1) / buckets].substr(0, STATISTICS_BOUND_SIZE));
+
+        // Long varchars only keep a prefix
+        cs.minValue = cs.minValue.substr(0, STATISTICS_COL_VALUE_SIZE);
+        cs.maxValue = cs.maxValue.substr(0, STATISTICS_COL_VALUE_SIZE);
+
+        unsigned height, leaves;
+        rc = getIndexStatistics(tableName, cs.name, height, leaves);
+        if (rc == RM_NO_MATCHING_INDEX)
+            continue;
+        if (rc)
+            return rc;
+        cs.indexHeight = height;
+        cs.indexLeaves = leaves;
+    }
+    return SUCCESS;
+}
+
+RC RelationManager::analyze(const string &tableName)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    TableStatistics stats;
+    RC rc = collectStatistics(tableName, 0, stats);
+    if (rc)
+        return rc;
+
+    // Replace the old entries
+    rc = deleteStatistics(tableName);
+    if (rc)
+        return rc;
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(getFileName(STATISTICS_TABLE_NAME), fileHandle);
+    if (rc)
+        return rc;
+
+    RID rid;
+    void *statisticsData = malloc(STATISTICS_RECORD_DATA_SIZE);
+    for (int column = -1; column < (int) stats.columns.size(); column++)
+    {
+        prepareStatisticsRecordData(tableName, stats, column, statisticsData);
+        rc = rbfm->insertRecord(fileHandle, statisticsDescriptor, statisticsData, rid);
+        if (rc)
+            break;
+    }
+    free(statisticsData);
+    rbfm->closeFile(fileHandle);
+    if (rc)
+        return rc;
+
+    statisticsDelta.erase(tableName);
+    return SUCCESS;
+}
+
+RC RelationManager::sampleStatistics(const string &tableName, unsigned maxPages, TableStatistics &stats)
+{
+    return collectStatistics(tableName, max(1u, maxPages), stats);
+}
+
+RC RelationManager::getIndexStatistics(const string &tableName, const string &attributeName, unsigned &height, unsigned &leafCount)
+{
+    IndexManager *im = IndexManager::instance();
+    string fileName;
+    RID indexRID;
+    RC rc = getIndexFilename(tableName, attributeName, fileName, indexRID);
+    if (rc)
+        return rc;
+
+    // destroyIndex can leave a catalog entry behind, so a missing file just means no index
+    IXFileHandle ixFileHandle;
+    if (im->openFile(fileName, ixFileHandle) != SUCCESS)
+        return RM_NO_MATCHING_INDEX;
+    unsigned entries;
+    rc = im->getTreeStatistics(ixFileHandle, height, leafCount, entries);
+    im->closeFile(ixFileHandle);
+    return rc;
+}
+
+RC RelationManager::getStatistics(const string &tableName, TableStatistics &stats)
+{
+    RC rc;
+
+    vector<Attribute> attrs;
+    rc = getAttributes(tableName, attrs);
+    if (rc)
+        return rc;
+
+    // table-name in API format without null indicator
+    void *value = malloc(VARCHAR_LENGTH_SIZE + tableName.length());
+    uint32_t nameLength = tableName.length();
+    memcpy(value, &nameLength, VARCHAR_LENGTH_SIZE);
+    memcpy((char*) value + VARCHAR_LENGTH_SIZE, tableName.c_str(), nameLength);
+
+    // everything but the table name
+    vector<string> projection;
+    for (unsigned i = 1; i < statisticsDescriptor.size(); i++)
+        projection.push_back(statisticsDescriptor[i].name);
+
+    RM_ScanIterator scanner;
+    rc = scan(STATISTICS_TABLE_NAME, STATISTICS_COL_TABLE_NAME, EQ_OP, value, projection, scanner);
+    if (rc)
+    {
+        free(value);
+        return rc;
+    }
+
+    bool found = false;
+    map<string, ColumnStatistics> columns;
+    RID rid;
+    char *data = (char*) malloc(STATISTICS_RECORD_DATA_SIZE);
+    while ((rc = scanner.getNextTuple(rid, data)) == SUCCESS)
+    {
+        // Each helper reads the next field, -1 or empty if it is null
+        unsigned offset = 2;
+        unsigned field = 0;
+        auto isNull = [&]() { return data[field / CHAR_BIT] & (1 << (CHAR_BIT - 1 - field % CHAR_BIT)); };
+        auto nextInt = [&]() {
+            int32_t result = -1;
+            if (!isNull())
+            {
+                memcpy(&result, data + offset, INT_SIZE);
+                offset += INT_SIZE;
+            }
+            field++;
+            return result;
+        };
+        auto nextVarChar = [&]() {
+            string result;
+            if (!isNull())
+            {
+                uint32_t len;
+                memcpy(&len, data + offset, VARCHAR_LENGTH_SIZE);
+                result.assign(data + offset + VARCHAR_LENGTH_SIZE, len);
+                offset += VARCHAR_LENGTH_SIZE + len;
+            }
+            field++;
+            return result;
+        };
+
+        string columnName = nextVarChar();
+        if (columnName.empty())
+        {
+            stats.rowCount = nextInt();
+            stats.pageCount = nextInt();
+            found = true;
+            continue;
+        }
+
+        ColumnStatistics &cs = columns[columnName];
+        cs.name = columnName;
+        nextInt();
+        nextInt();
+        cs.nullCount = nextInt();
+        cs.distinctCount = nextInt();
+        cs.hasRange = !isNull();
+        cs.minValue = nextVarChar();
+        cs.maxValue = nextVarChar();
+        string histogram = nextVarChar();
+        cs.indexHeight = nextInt();
+        cs.indexLeaves = nextInt();
+
+        cs.histogram.clear();
+        for (unsigned pos = 0; pos < histogram.length(); )
+        {
+            uint32_t len;
+            memcpy(&len, histogram.data() + pos, VARCHAR_LENGTH_SIZE);
+            cs.histogram.push_back(histogram.substr(pos + VARCHAR_LENGTH_SIZE, len));
+            pos += VARCHAR_LENGTH_SIZE + len;
+        }
+    }
+    free(data);
+    free(value);
+    scanner.close();
+    if (rc != RM_EOF)
+        return rc;
+    if (!found)
+        return RM_NO_STATISTICS;
+
+    // Columns in table order. A column added since the last analyze has no entry.
+    stats.columns.clear();
+    for (Attribute &attr: attrs)
+    {
+        auto column = columns.find(attr.name);
+        if (column == columns.end())
+            continue;
+        column->second.type = attr.type;
+        stats.columns.push_back(column->second);
+    }
+
+    // Account for changes made since the last analyze
+    stats.modifications = 0;
+    auto delta = statisticsDelta.find(tableName);
+    if (delta != statisticsDelta.end())
+    {
+        stats.rowCount += delta->second.first;
+        stats.modifications = delta->second.second;
+    }
+    return SUCCESS;
+}
+
+RC RelationManager::deleteStatistics(const string &tableName)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    RC rc;
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(getFileName(STATISTICS_TABLE_NAME), fileHandle);
+    if (rc)
+        return rc;
+
+    // table-name in API format without null indicator
+    void *value = malloc(VARCHAR_LENGTH_SIZE + tableName.length());
+    uint32_t nameLength = tableName.length();
+    memcpy(value, &nameLength, VARCHAR_LENGTH_SIZE);
+    memcpy((char*) value + VARCHAR_LENGTH_SIZE, tableName.c_str(), nameLength);
+
+    // Only the RIDs are needed
+    RBFM_ScanIterator rbfm_si;
+    vector<string> projection;
+    rc = rbfm->scan(fileHandle, statisticsDescriptor, STATISTICS_COL_TABLE_NAME, EQ_OP, value, projection, rbfm_si);
+
+    RID rid;
+    while (rc == SUCCESS && (rc = rbfm_si.getNextRecord(rid, NULL)) == SUCCESS)
+        rc = rbfm->deleteRecord(fileHandle, statisticsDescriptor, rid);
+    if (rc == RBFM_EOF)
+        rc = SUCCESS;
+
+    free(value);
+    rbfm_si.close();
+    rbfm->closeFile(fileHandle);
+    return rc;
+}
+
+RC RelationManager::encodeColumn(const string &tableName, const string &attributeName)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    RC rc;
+
+    bool isSystem;
+    rc = isSystemTable(isSystem, tableName);
+    if (rc)
+        return rc;
+    if (isSystem)
+        return RM_CANNOT_MOD_SYS_TBL;
+
+    vector<Attribute> attrs;
+    rc = getAttributes(tableName, attrs);
+    if (rc)
+        return rc;
+
+    rc = dropTailPage(tableName);
+    if (rc)
+        return rc;
+
+    // rbfm rewrites the tuples, the catalog records that it did
+    rc = rbfm->createDictionary(getFileName(tableName), attrs, attributeName);
+    if (rc)
+        return rc;
+    return setColumnEncoding(tableName, attributeName, COLUMN_ENCODING_DICTIONARY);
+}
+
+RC RelationManager::storeOutOfLine(const string &tableName, const string &attributeName, unsigned threshold, bool compress)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    RC rc;
+
+    bool isSystem;
+    rc = isSystemTable(isSystem, tableName);
+    if (rc)
+        return rc;
+    if (isSystem)
+        return RM_CANNOT_MOD_SYS_TBL;
+
+    vector<Attribute> attrs;
+    rc = getAttributes(tableName, attrs);
+    if (rc)
+        return rc;
+
+    rc = dropTailPage(tableName);
+    if (rc)
+        return rc;
+
+    rc = rbfm->createOverflow(getFileName(tableName), attrs, attributeName, threshold, compress);
+    if (rc)
+        return rc;
+    return setColumnEncoding(tableName, attributeName, COLUMN_ENCODING_OUT_OF_LINE);
+}
+
+RC RelationManager::getEncodedAttributes(const string &tableName, vector<string> &attributeNames)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    attributeNames.clear();
+    RC rc;
+
+    int32_t id;
+    rc = getTableID(tableName, id);
+    if (rc)
+        return rc;
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(getFileName(COLUMNS_TABLE_NAME), fileHandle);
+    if (rc)
+        return rc;
+
+    RBFM_ScanIterator rbfm_si;
+    vector<string> projection;
+    projection.push_back(COLUMNS_COL_COLUMN_NAME);
+    projection.push_back(COLUMNS_COL_COLUMN_ENCODING);
+    rc = rbfm->scan(fileHandle, columnDescriptor, COLUMNS_COL_TABLE_ID, EQ_OP, &id, projection, rbfm_si);
+
+    RID rid;
+    void *data = malloc(COLUMNS_RECORD_DATA_SIZE);
+    while (rc == SUCCESS && (rc = rbfm_si.getNextRecord(rid, data)) == SUCCESS)
+    {
+        string name;
+        fromAPI(name, data);
+        int32_t encoding;
+        memcpy(&encoding, (char*) data + 1 + VARCHAR_LENGTH_SIZE + name.length(), INT_SIZE);
+        if (encoding == COLUMN_ENCODING_DICTIONARY)
+            attributeNames.push_back(name);
+    }
+    if (rc == RBFM_EOF)
+        rc = SUCCESS;
+
+    free(data);
+    rbfm_si.close();
+    rbfm->closeFile(fileHandle);
+    return rc;
+}
+
+RC RelationManager::compressTable(const string &tableName)
+{
+    PagedFileManager *pfm = PagedFileManager::instance();
+    RC rc;
+
+    bool isSystem;
+    rc = isSystemTable(isSystem, tableName);
+    if (rc)
+        return rc;
+    if (isSystem)
+        return RM_CANNOT_MOD_SYS_TBL;
+
+    vector<string> indexedAttributes;
+    rc = getIndexedAttributes(tableName, indexedAttributes);
+    if (rc)
+        return rc;
+
+    rc = dropTailPage(tableName);
+    if (rc)
+        return rc;
+
+    rc = pfm->compressFile(getFileName(tableName));
+    for (unsigned i = 0; rc == SUCCESS && i < indexedAttributes.size(); i++)
+    {
+        string indexFileName;
+        RID rid;
+        rc = getIndexFilename(tableName, indexedAttributes[i], indexFileName, rid);
+        if (rc == SUCCESS)
+            rc = pfm->compressFile(indexFileName);
+    }
+    return rc;
+}
+
+RC RelationManager::vacuum(const string &tableName)
+{
+    RM_VacuumIterator rm_VacuumIterator;
+    RC rc = vacuum(tableName, rm_VacuumIterator);
+    if (rc)
+        return rc;
+
+    // All of it in one go
+    while ((rc = rm_VacuumIterator.vacuumPages(UINT_MAX)) == SUCCESS);
+    rm_VacuumIterator.close();
+    return rc == RM_EOF ? SUCCESS : rc;
+}
+
+RC RelationManager::vacuum(const string &tableName, RM_VacuumIterator &rm_VacuumIterator)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    RC rc;
+
+    bool isSystem;
+    rc = isSystemTable(isSystem, tableName);
+    if (rc)
+        return rc;
+    if (isSystem)
+        return RM_CANNOT_MOD_SYS_TBL;
+
+    rc = getAttributes(tableName, rm_VacuumIterator.recordDescriptor);
+    if (rc)
+        return rc;
+
+    // Relocated tuples fill the first pages up to the fill factor only
+    unsigned fillFactor;
+    rc = getFillFactor(tableName, fillFactor);
+    if (rc)
+        return rc;
+
+    // Records move out of the tail page and it may be truncated away
+    rc = dropTailPage(tableName);
+    if (rc)
+        return rc;
+
+    rc = rbfm->openFile(getFileName(tableName), rm_VacuumIterator.fileHandle);
+    if (rc)
+        return rc;
+    rm_VacuumIterator.fileHandle.fillFactor = fillFactor;
+
+    rm_VacuumIterator.tableName = tableName;
+    rm_VacuumIterator.phase = VacuumForwarding;
+    rm_VacuumIterator.nextPage = 0;
+    rm_VacuumIterator.firstPage = 0;
+    return SUCCESS;
+}
+
+RC RelationManager::moveIndexEntries(const string &tableName, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+        const vector<RecordMove> &moves)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    IndexManager *im = IndexManager::instance();
+
+    vector<string> indexedAttributes;
+    RC rc = getIndexedAttributes(tableName, indexedAttributes);
+    if (rc)
+        return rc;
+
+    unsigned tupleSize = int(ceil((double) recordDescriptor.size() / CHAR_BIT));
+    for (const Attribute &attr: recordDescriptor)
+        tupleSize += attr.length + (attr.type == TypeVarChar ? VARCHAR_LENGTH_SIZE : 0);
+    void *tuple = malloc(tupleSize);
+
+    for (unsigned i = 0; rc == SUCCESS && i < indexedAttributes.size(); i++)
+    {
+        auto pred = [&](Attribute a) { return a.name == indexedAttributes[i]; };
+        vector<Attribute>::const_iterator attr = find_if(recordDescriptor.begin(), recordDescriptor.end(), pred);
+        if (attr == recordDescriptor.end())
+        {
+            rc = RM_ATTR_NOT_FOUND;
+            break;
+        }
+
+        string indexFileName;
+        RID indexRID;
+        rc = getIndexFilename(tableName, indexedAttributes[i], indexFileName, indexRID);
+        IXFileHandle ixFileHandle;
+        if (rc == SUCCESS)
+            rc = im->openFile(indexFileName, ixFileHandle);
+        if (rc)
+            break;
+
+        void *key = malloc(attr->length + VARCHAR_LENGTH_SIZE);
+        for (unsigned j = 0; rc == SUCCESS && j < moves.size(); j++)
+        {
+            rc = rbfm->readRecord(fileHandle, recordDescriptor, moves[j].newRid, tuple);
+            if (rc)
+                break;
+            getAttrFromTuple(recordDescriptor, attr - recordDescriptor.begin(), tuple, key);
+            // The entry may be missing if the tuple was updated since it was indexed
+            im->deleteEntry(ixFileHandle, *attr, key, moves[j].oldRid);
+            rc = im->insertEntry(ixFileHandle, *attr, key, moves[j].newRid);
+        }
+        free(key);
+        im->closeFile(ixFileHandle);
+    }
+    free(tuple);
+    return rc;
+}
+
+// A record forwarded by the first phase can be relocated again by the second one in the same batch.
+// Its index entries go from its first RID straight to its last, the only one still holding it.
+static void mergeMoves(vector<RecordMove> &moves)
+{
+    vector<RecordMove> merged;
+    map<uint64_t, unsigned> movedTo;    // new RID of each merged move, to its position
+    for (const RecordMove &move: moves)
+    {
+        uint64_t from = (uint64_t) move.oldRid.pageNum << 32 | move.oldRid.slotNum;
+        uint64_t to = (uint64_t) move.newRid.pageNum << 32 | move.newRid.slotNum;
+        map<uint64_t, unsigned>::iterator chain = movedTo.find(from);
+        if (chain == movedTo.end())
+        {
+            movedTo[to] = merged.size();
+            merged.push_back(move);
+            continue;
+        }
+        unsigned i = chain->second;
+        movedTo.erase(chain);
+        merged[i].newRid = move.newRid;
+        movedTo[to] = i;
+    }
+    moves.swap(merged);
+}
+
+RM_VacuumIterator::RM_VacuumIterator()
+{
+    phase = VacuumDone;
+    nextPage = 0;
+    firstPage = 0;
+}
+
+RC RM_VacuumIterator::vacuumPages(unsigned numPages)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    if (phase == VacuumDone)
+        return RM_EOF;
+
+    vector<RecordMove> moves;
+    RC rc = SUCCESS;
+    unsigned done = 0;
+    while (rc == SUCCESS && done < numPages && phase != VacuumDone)
+    {
+        if (phase == VacuumForwarding && nextPage < fileHandle.getNumberOfPages())
+        {
+            rc = rbfm->dropForwarding(fileHandle, nextPage++, moves);
+            done++;
+        }
+        else if (phase == VacuumForwarding)
+        {
+            // Empty the last pages into the first ones, until the two meet
+            phase = VacuumRelocation;
+            nextPage = fileHandle.getNumberOfPages();
+            firstPage = 0;
+        }
+        else if (firstPage + 1 < nextPage)
+        {
+            rc = rbfm->relocateRecords(fileHandle, recordDescriptor, --nextPage, firstPage, moves);
+            done++;
+        }
+        else
+        {
+            rc = rbfm->truncateFile(fileHandle);
+            phase = VacuumDone;
+        }
+    }
+
+    // The moves so far are on disk, so the indexes follow them even if the rest failed
+    mergeMoves(moves);
+    RC indexRC = moves.empty() ? SUCCESS : RelationManager::instance()->moveIndexEntries(tableName, fileHandle, recordDescriptor, moves);
+    return rc ? rc : indexRC;
+}
+
+RC RM_VacuumIterator::close()
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    phase = VacuumDone;
+    return rbfm->closeFile(fileHandle);
+}
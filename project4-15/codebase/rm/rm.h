@@ -4,6 +4,7 @@
 
 #include <string>
 #include <vector>
+#include <map>
 #include <cmath>
 
 #include "../rbf/rbfm.h"
@@ -18,18 +19,22 @@ using namespace std;
 #define TABLES_TABLE_ID             1
 
 // Format for Tables table:
-// (table-id:int, table-name:varchar(50), file-name:varchar(50), system:int)
+// (table-id:int, table-name:varchar(50), file-name:varchar(50), system:int, fill-factor:int, append-only:int)
 // system will be 1 if the table is a system table, 0 otherwise
+// fill-factor is the percentage of each page inserts fill (see RelationManager::createTable)
+// append-only will be 1 if inserts go to an in-memory tail page, 0 otherwise
 
 #define TABLES_COL_TABLE_ID         "table-id"
 #define TABLES_COL_TABLE_NAME       "table-name"
 #define TABLES_COL_FILE_NAME        "file-name"
 #define TABLES_COL_SYSTEM           "system"
+#define TABLES_COL_FILL_FACTOR      "fill-factor"
+#define TABLES_COL_APPEND_ONLY      "append-only"
 #define TABLES_COL_TABLE_NAME_SIZE  50
 #define TABLES_COL_FILE_NAME_SIZE   50
 
-// 1 null byte, 2 integer and 2 varchars
-#define TABLES_RECORD_DATA_SIZE 1 + 4 * INT_SIZE + TABLES_COL_TABLE_NAME_SIZE + TABLES_COL_FILE_NAME_SIZE
+// 1 null byte, 4 integer and 2 varchars
+#define TABLES_RECORD_DATA_SIZE 1 + 6 * INT_SIZE + TABLES_COL_TABLE_NAME_SIZE + TABLES_COL_FILE_NAME_SIZE
 
 #define COLUMNS_TABLE_NAME           "Columns"
 #define COLUMNS_TABLE_ID             2
@@ -39,10 +44,16 @@ using namespace std;
 #define COLUMNS_COL_COLUMN_TYPE      "column-type"
 #define COLUMNS_COL_COLUMN_LENGTH    "column-length"
 #define COLUMNS_COL_COLUMN_POSITION  "column-position"
+#define COLUMNS_COL_COLUMN_ENCODING  "column-encoding"
 #define COLUMNS_COL_COLUMN_NAME_SIZE 50
 
-// 1 null byte, 4 integer fields and a varchar
-#define COLUMNS_RECORD_DATA_SIZE 1 + 5 * INT_SIZE + COLUMNS_COL_COLUMN_NAME_SIZE
+// column-encoding: how the table's file stores the column
+#define COLUMN_ENCODING_PLAIN        0
+#define COLUMN_ENCODING_DICTIONARY   1      // codes of a dictionary next to the file (see RecordBasedFileManager::createDictionary)
+#define COLUMN_ENCODING_OUT_OF_LINE  2      // long values in overflow pages next to the file (see RecordBasedFileManager::createOverflow)
+
+// 1 null byte, 5 integer fields and a varchar
+#define COLUMNS_RECORD_DATA_SIZE 1 + 6 * INT_SIZE + COLUMNS_COL_COLUMN_NAME_SIZE
 
 #define INDEXES_TABLE_NAME           "Indexes"
 #define INDEXES_TABLE_ID             3
@@ -57,12 +68,81 @@ using namespace std;
 // 3 varchars
 #define INDEXES_RECORD_DATA_SIZE 1 + INDEXES_COL_TABLE_NAME_SIZE + INDEXES_COL_ATTR_NAME_SIZE + INDEXES_COL_INDEX_FILENAME_SIZE
 
+#define STATISTICS_TABLE_NAME           "Statistics"
+#define STATISTICS_TABLE_ID             4
+
+// Format for Statistics table:
+// (table-name:varchar(50), column-name:varchar(50), row-count:int, page-count:int,
+//  null-count:int, distinct-count:int, min-value:varchar(50), max-value:varchar(50),
+//  histogram:varchar(600), index-height:int, index-leaves:int)
+// One row per table with an empty column-name holds row-count and page-count,
+// the column rows hold the rest. Fields that don't apply are null.
+
+#define STATISTICS_COL_TABLE_NAME       "table-name"
+#define STATISTICS_COL_COLUMN_NAME      "column-name"
+#define STATISTICS_COL_ROW_COUNT        "row-count"
+#define STATISTICS_COL_PAGE_COUNT       "page-count"
+#define STATISTICS_COL_NULL_COUNT       "null-count"
+#define STATISTICS_COL_DISTINCT_COUNT   "distinct-count"
+#define STATISTICS_COL_MIN_VALUE        "min-value"
+#define STATISTICS_COL_MAX_VALUE        "max-value"
+#define STATISTICS_COL_HISTOGRAM        "histogram"
+#define STATISTICS_COL_INDEX_HEIGHT     "index-height"
+#define STATISTICS_COL_INDEX_LEAVES     "index-leaves"
+#define STATISTICS_COL_TABLE_NAME_SIZE  50
+#define STATISTICS_COL_COLUMN_NAME_SIZE 50
+#define STATISTICS_COL_VALUE_SIZE       50
+#define STATISTICS_COL_HISTOGRAM_SIZE   600
+
+// 2 null bytes, 6 integers and 5 varchars
+#define STATISTICS_RECORD_DATA_SIZE 2 + 11 * INT_SIZE + STATISTICS_COL_TABLE_NAME_SIZE + STATISTICS_COL_COLUMN_NAME_SIZE + 2 * STATISTICS_COL_VALUE_SIZE + STATISTICS_COL_HISTOGRAM_SIZE
+
+// Equi-depth histograms are built from a reservoir sample of at most this many values
+#define STATISTICS_SAMPLE_SIZE          10000
+#define STATISTICS_HISTOGRAM_BUCKETS    10
+// Varchar histogram bounds are truncated to this many characters
+#define STATISTICS_BOUND_SIZE           32
+// log2 of the number of HyperLogLog registers used to estimate distinct counts
+#define STATISTICS_HLL_PRECISION        10
+
 # define RM_EOF (-1)  // end of a scan operator
 
 #define RM_CANNOT_MOD_SYS_TBL 1
 #define RM_NULL_COLUMN        2
 #define RM_NO_MATCHING_INDEX  3
 #define RM_ATTR_NOT_FOUND     4
+#define RM_NO_STATISTICS      5
+#define RM_BAD_FILL_FACTOR    6
+
+// Values are kept as their raw bytes: 4 bytes for int and real, the characters for varchar
+typedef struct ColumnStatistics
+{
+    string name;
+    AttrType type;
+    int32_t nullCount;
+    int32_t distinctCount;
+    bool hasRange;                  // false if every value is null
+    string minValue;
+    string maxValue;
+    vector<string> histogram;       // equi-depth bucket bounds, lowest first
+    int32_t indexHeight;            // -1 if the column has no index
+    int32_t indexLeaves;
+} ColumnStatistics;
+
+typedef struct TableStatistics
+{
+    int32_t rowCount;               // includes inserts and deletes since the last analyze
+    int32_t pageCount;
+    int32_t modifications;          // tuples changed since the last analyze
+    vector<ColumnStatistics> columns;
+} TableStatistics;
+
+// How inserts fill a table, from its Tables entry
+typedef struct TableOptions
+{
+    unsigned fillFactor;
+    bool appendOnly;
+} TableOptions;
 
 typedef struct IndexedAttr
 {
@@ -70,6 +150,23 @@ typedef struct IndexedAttr
     Attribute attr;
 } IndexedAttr;
 
+// An index of a table: the position of its attribute and its file
+typedef struct TableIndex
+{
+    int32_t pos;
+    string fileName;
+} TableIndex;
+
+// The tail page of an append-only table, with what inserts into it need from the catalog and the
+// table's file kept open, so that they don't look them up or open the file again
+typedef struct TableTail
+{
+    TailPage page;
+    vector<Attribute> recordDescriptor;
+    vector<TableIndex> indexes;
+    FileHandle fileHandle;
+} TableTail;
+
 // RM_ScanIterator is an iterator to go through tuples
 class RM_ScanIterator {
 public:
@@ -102,6 +199,29 @@ class RM_IndexScanIterator {
   IXFileHandle ixfileHandle;
 };
 
+// The passes of a vacuum, in order
+typedef enum { VacuumForwarding = 0, VacuumRelocation, VacuumDone } VacuumPhase;
+
+// RM_VacuumIterator vacuums a table a range of pages at a time (see RelationManager::vacuum)
+class RM_VacuumIterator {
+public:
+  RM_VacuumIterator();
+  ~RM_VacuumIterator() {};
+
+  // Vacuum up to numPages more pages of the table. RM_EOF once it is done.
+  RC vacuumPages(unsigned numPages);
+  RC close();
+
+  friend class RelationManager;
+private:
+  string tableName;
+  vector<Attribute> recordDescriptor;
+  FileHandle fileHandle;
+  VacuumPhase phase;
+  PageNum nextPage;       // forwarding: the next page to go through; relocation: one past the next page to empty
+  PageNum firstPage;      // relocation: the first page that may have room for tuples
+};
+
 // Relation Manager
 class RelationManager
 {
@@ -112,12 +232,28 @@ public:
 
   RC deleteCatalog();
 
-  RC createTable(const string &tableName, const vector<Attribute> &attrs);
+  // The table's file is laid out in the given format and page size (see RecordBasedFileManager::createFile).
+  // Inserts fill fillFactor percent (1 to 100) of each slotted page, leaving the rest for updates
+  // to grow tuples in place rather than forward them to another page.
+  // Inserts into an appendOnly table go to a tail page kept in memory, in the slot after the last
+  // tuple, without looking for free space; the page is written when it is full or flushed. Reading,
+  // changing or scanning the table flushes it first, as do flushAll, deleteCatalog and the end of
+  // the process.
+  RC createTable(const string &tableName, const vector<Attribute> &attrs, FileFormat format = FormatSlotted, unsigned pageSize = PAGE_SIZE,
+      unsigned fillFactor = DEFAULT_FILL_FACTOR, bool appendOnly = false);
 
   RC deleteTable(const string &tableName);
 
   RC getAttributes(const string &tableName, vector<Attribute> &attrs);
 
+  // The fill factor tableName was created with
+  RC getFillFactor(const string &tableName, unsigned &fillFactor);
+
+  // Write the tail page of an append-only table, nothing for other tables
+  RC flush(const string &tableName);
+  // The same for every table. Also done by deleteCatalog and when the process exits.
+  RC flushAll();
+
   RC insertTuple(const string &tableName, const void *data, RID &rid);
 
   RC deleteTuple(const string &tableName, const RID &rid);
@@ -141,10 +277,14 @@ public:
       const vector<string> &attributeNames, // a list of projected attributes
       RM_ScanIterator &rm_ScanIterator);
 
-  RC createIndex(const string &tableName, const string &attributeName);
+  // The index file has pages of pageSize bytes, whatever those of the table
+  RC createIndex(const string &tableName, const string &attributeName, unsigned pageSize = PAGE_SIZE);
 
   RC destroyIndex(const string &tableName, const string &attributeName);
 
+  // Names of the attributes of tableName that have an index
+  RC getIndexedAttributes(const string &tableName, vector<string> &attributeNames);
+
   // indexScan returns an iterator to allow the caller to go through qualified entries in index
   RC indexScan(const string &tableName,
                         const string &attributeName,
@@ -154,6 +294,46 @@ public:
                         bool highKeyInclusive,
                         RM_IndexScanIterator &rm_IndexScanIterator);
 
+  // Recompute the Statistics entries of tableName and its indexes
+  RC analyze(const string &tableName);
+
+  // Read the Statistics entries of tableName. Fails with RM_NO_STATISTICS if it was never analyzed.
+  RC getStatistics(const string &tableName, TableStatistics &stats);
+
+  // Estimate the statistics of tableName from at most maxPages of its pages, spread over the file,
+  // without storing them. Row, null and distinct counts are scaled up to the whole table.
+  RC sampleStatistics(const string &tableName, unsigned maxPages, TableStatistics &stats);
+
+  // Height and leaf count of the index on attributeName, read from the tree.
+  // Fails with RM_NO_MATCHING_INDEX if there is no such index.
+  RC getIndexStatistics(const string &tableName, const string &attributeName, unsigned &height, unsigned &leafCount);
+
+  // Dictionary encode a varchar column of tableName, rewriting the tuples already in the table.
+  // Tuples keep their format; equality conditions on the column compare codes.
+  RC encodeColumn(const string &tableName, const string &attributeName);
+
+  // Names of the attributes of tableName that are dictionary encoded
+  RC getEncodedAttributes(const string &tableName, vector<string> &attributeNames);
+
+  // Store the values of a varchar column of tableName longer than threshold bytes in overflow
+  // pages, compressed if asked, rewriting the tuples already in the table. Tuples may then be
+  // larger than a page; scans and reads that don't project the column don't read those pages.
+  RC storeOutOfLine(const string &tableName, const string &attributeName,
+                    unsigned threshold = OVERFLOW_DEFAULT_THRESHOLD, bool compress = false);
+
+  // Rewrite the file of a cold table and its index files as compressed files (see
+  // PagedFileManager::compressFile). The table stays readable and writable as before.
+  RC compressTable(const string &tableName);
+
+  // Rewrite a table compactly: tuples that were forwarded by an update move back into a slot of
+  // their own, tuples of the last pages fill the free space of the first ones and the empty pages
+  // at the end of the file are dropped. The entries of the table's indexes follow the tuples.
+  RC vacuum(const string &tableName);
+  // The same, a range of pages at a time through the iterator, so that it can be spread out
+  RC vacuum(const string &tableName, RM_VacuumIterator &rm_VacuumIterator);
+
+  friend class RM_VacuumIterator;
+
 protected:
   RelationManager();
   ~RelationManager();
@@ -163,6 +343,14 @@ private:
   const vector<Attribute> tableDescriptor;
   const vector<Attribute> columnDescriptor;
   const vector<Attribute> indexDescriptor;
+  const vector<Attribute> statisticsDescriptor;
+
+  // Row count change and number of modified tuples since the last analyze, per table
+  map<string, pair<int32_t, int32_t> > statisticsDelta;
+  // Options per table, read from the catalog on first use
+  map<string, TableOptions> tableOptions;
+  // Tail page of each append-only table inserted into
+  map<string, TableTail> tailPages;
 
   // Convert tableName to file name (append extension)
   static string getFileName(const char *tableName);
@@ -172,16 +360,28 @@ private:
   static vector<Attribute> createTableDescriptor();
   static vector<Attribute> createColumnDescriptor();
   static vector<Attribute> createIndexDescriptor();
+  static vector<Attribute> createStatisticsDescriptor();
 
   // Prepare an entry for the Table/Column table
-  void prepareTablesRecordData(int32_t id, bool system, const string &tableName, void *data);
-  void prepareColumnsRecordData(int32_t id, int32_t pos, Attribute attr, void *data);
+  void prepareTablesRecordData(int32_t id, bool system, const string &tableName, int32_t fillFactor, bool appendOnly, void *data);
+  void prepareColumnsRecordData(int32_t id, int32_t pos, Attribute attr, int32_t encoding, void *data);
   void prepareIndexRecordData(const string &table_name, const string &attr_name, const string &index_filename, void *data);
+  // column is an index into stats.columns, or -1 for the table entry
+  void prepareStatisticsRecordData(const string &tableName, const TableStatistics &stats, int column, void *data);
 
   // Given a table ID and recordDescriptor, creates entries in Column table
   RC insertColumns(int32_t id, const vector<Attribute> &recordDescriptor);
-  // Given table ID, system flag, and table name, creates entry in Table table
-  RC insertTable(int32_t id, int32_t system, const string &tableName);
+  // Given table ID, system flag, table name, fill factor and append-only flag, creates entry in Table table
+  RC insertTable(int32_t id, int32_t system, const string &tableName, int32_t fillFactor, bool appendOnly);
+  RC getTableOptions(const string &tableName, TableOptions &options);
+  // Start a tail page for tableName, reading its indexes and opening its file
+  RC openTailPage(const string &tableName, const vector<Attribute> &recordDescriptor, unsigned fillFactor);
+  // Flush the tail page of tableName and forget it, before the table's pages are changed another way
+  RC dropTailPage(const string &tableName);
+  // Write every tail page and forget them
+  RC closeTailPages();
+  // Set the column-encoding of an attribute of tableName in the Columns table
+  RC setColumnEncoding(const string &tableName, const string &attributeName, int32_t encoding);
 
   // Get next table ID for creating table
   RC getNextTableID(int32_t &table_id);
@@ -194,8 +394,19 @@ private:
   RC getIndexFilename(const string &tableName, const string &attributeName, string &fileName, RID &rid);
   // update all indexes for the given table
   RC updateIndexes(const string &tableName, const void *data, const RID &rid);
+  // The indexes of the given table, from the Indexes table
+  RC getIndexes(const string &tableName, const vector<Attribute> &recordDescriptor, vector<TableIndex> &indexes);
+  // insert the entries of a tuple into the given indexes
+  RC insertIndexEntries(const vector<Attribute> &recordDescriptor, const vector<TableIndex> &indexes, const void *data, const RID &rid);
+  // delete every Statistics entry of the given table
+  RC deleteStatistics(const string &tableName);
+  // statistics of tableName from every page, or at most maxPages of them if it isn't 0
+  RC collectStatistics(const string &tableName, unsigned maxPages, TableStatistics &stats);
+  // point the entries of the table's indexes at the RIDs the tuples moved to
+  RC moveIndexEntries(const string &tableName, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+      const vector<RecordMove> &moves);
   // get the index'th attribute from a tuple
-  RC getAttrFromTuple(const vector<Attribute> attrs, int index, const void *tuple, void *key);
+  RC getAttrFromTuple(const vector<Attribute> &attrs, int index, const void *tuple, void *key);
 
   // Utility functions for converting single values to/from api format
   // Useful when using ScanIterators
@@ -371,6 +371,57 @@ RC createLargeTable(const string &tableName)
     return 0;
 }
 
+// Create a table of (id int, textName varchar(textLength)), replacing any table of that name
+RC createIdTextTable(const string &tableName, const string &textName, int textLength,
+        unsigned fillFactor = DEFAULT_FILL_FACTOR, bool appendOnly = false)
+{
+    vector<Attribute> attrs;
+    Attribute attr;
+
+    attr.name = "id";
+    attr.type = TypeInt;
+    attr.length = (AttrLength)4;
+    attrs.push_back(attr);
+
+    attr.name = textName;
+    attr.type = TypeVarChar;
+    attr.length = (AttrLength)textLength;
+    attrs.push_back(attr);
+
+    rm->deleteTable(tableName);
+    return rm->createTable(tableName, attrs, FormatSlotted, PAGE_SIZE, fillFactor, appendOnly);
+}
+
+// A tuple of an id/text table: id, then textLength letters from 'a' + id % 26 on. The letter
+// moves on every runLength letters, or never if runLength is 0. Returns the size of the tuple.
+int prepareIdTextTuple(int id, int textLength, void *buffer, int runLength = 0)
+{
+    char nulls = 0;
+    int offset = 0;
+    memcpy((char *)buffer + offset, &nulls, 1);
+    offset += 1;
+    memcpy((char *)buffer + offset, &id, sizeof(int));
+    offset += sizeof(int);
+    memcpy((char *)buffer + offset, &textLength, sizeof(int));
+    offset += sizeof(int);
+    for (int i = 0; i < textLength; i++)
+        ((char *)buffer)[offset + i] = 'a' + (id + (runLength ? i / runLength : 0)) % 26;
+    offset += textLength;
+    return offset;
+}
+
+// Number of pages in the file of a table
+int getTablePageCount(const string &tableName)
+{
+    PagedFileManager *pfm = PagedFileManager::instance();
+    FileHandle fileHandle;
+    RC rc = pfm->openFile(tableName + TABLE_FILE_EXTENSION, fileHandle);
+    assert(rc == success && "PagedFileManager::openFile() should not fail.");
+    int pages = fileHandle.getNumberOfPages();
+    pfm->closeFile(fileHandle);
+    return pages;
+}
+
 // Write RIDs to a disk - do not use this code.
 //This is not a page-based operation. For test purpose only.
 void writeRIDsToDisk(vector<RID> &rids)
@@ -0,0 +1,173 @@
+#include "rm_test_util.h"
+
+const int statsTupleCount = 3000;
+
+RC createStatsTable(const string &tableName)
+{
+    vector<Attribute> attrs;
+    Attribute attr;
+
+    attr.name = "id";
+    attr.type = TypeInt;
+    attr.length = (AttrLength)4;
+    attrs.push_back(attr);
+
+    attr.name = "score";
+    attr.type = TypeReal;
+    attr.length = (AttrLength)4;
+    attrs.push_back(attr);
+
+    attr.name = "grade";
+    attr.type = TypeVarChar;
+    attr.length = (AttrLength)20;
+    attrs.push_back(attr);
+
+    rm->deleteTable(tableName);
+    return rm->createTable(tableName, attrs);
+}
+
+// id is i, score is i % 100 / 2 and grade is one of 26 strings, null for every fifth tuple
+void prepareStatsTuple(int i, void *buffer)
+{
+    char nulls = (i % 5 == 0) ? (1 << 5) : 0;
+    float score = (i % 100) / 2.0f;
+    string grade(i % 26 + 1, 'a' + i % 26);
+    int length = grade.length();
+
+    int offset = 0;
+    memcpy((char *)buffer + offset, &nulls, 1);
+    offset += 1;
+    memcpy((char *)buffer + offset, &i, sizeof(int));
+    offset += sizeof(int);
+    memcpy((char *)buffer + offset, &score, sizeof(float));
+    offset += sizeof(float);
+    if (!nulls) {
+        memcpy((char *)buffer + offset, &length, sizeof(int));
+        offset += sizeof(int);
+        memcpy((char *)buffer + offset, grade.c_str(), length);
+    }
+}
+
+RC TEST_RM_16(const string &tableName)
+{
+    // Functions Tested:
+    // 1. analyze
+    // 2. getStatistics
+    cout << endl << "***** In RM Test Case 16 *****" << endl;
+
+    RC rc = createStatsTable(tableName);
+    assert(rc == success && "RelationManager::createTable() should not fail.");
+
+    // Never analyzed
+    TableStatistics stats;
+    rc = rm->getStatistics(tableName, stats);
+    assert(rc != success && "RelationManager::getStatistics() should fail before analyze.");
+
+    RID rid;
+    char buffer[100];
+    for (int i = 0; i < statsTupleCount; i++) {
+        prepareStatsTuple(i, buffer);
+        rc = rm->insertTuple(tableName, buffer, rid);
+        assert(rc == success && "RelationManager::insertTuple() should not fail.");
+    }
+    rc = rm->createIndex(tableName, "id");
+    assert(rc == success && "RelationManager::createIndex() should not fail.");
+
+    rc = rm->analyze(tableName);
+    assert(rc == success && "RelationManager::analyze() should not fail.");
+    rc = rm->getStatistics(tableName, stats);
+    assert(rc == success && "RelationManager::getStatistics() should not fail.");
+
+    if (stats.rowCount != statsTupleCount || stats.pageCount < 1 || stats.modifications != 0 || stats.columns.size() != 3) {
+        cout << "The table statistics are not correct." << endl;
+        cout << "***** [FAIL] Test Case 16 failed *****" << endl;
+        return -1;
+    }
+
+    ColumnStatistics &id = stats.columns[0];
+    ColumnStatistics &score = stats.columns[1];
+    ColumnStatistics &grade = stats.columns[2];
+    int minId, maxId;
+    float minScore, maxScore;
+    memcpy(&minId, id.minValue.data(), sizeof(int));
+    memcpy(&maxId, id.maxValue.data(), sizeof(int));
+    memcpy(&minScore, score.minValue.data(), sizeof(float));
+    memcpy(&maxScore, score.maxValue.data(), sizeof(float));
+    cout << "id: " << id.distinctCount << " distinct, index height " << id.indexHeight << ", " << id.indexLeaves << " leaves" << endl;
+    cout << "score: " << score.distinctCount << " distinct" << endl;
+    cout << "grade: " << grade.distinctCount << " distinct, " << grade.nullCount << " nulls" << endl;
+
+    // min/max and nulls are exact, distinct counts are estimates
+    if (minId != 0 || maxId != statsTupleCount - 1 || minScore != 0.0f || maxScore != 49.5f ||
+            grade.minValue != "a" || grade.maxValue != string(26, 'z') || id.nullCount != 0 ||
+            grade.nullCount != statsTupleCount / 5) {
+        cout << "The column ranges or null counts are not correct." << endl;
+        cout << "***** [FAIL] Test Case 16 failed *****" << endl;
+        return -1;
+    }
+    if (abs(id.distinctCount - statsTupleCount) > statsTupleCount / 10 || abs(score.distinctCount - 100) > 10 ||
+            abs(grade.distinctCount - 26) > 3) {
+        cout << "The distinct counts are not close enough." << endl;
+        cout << "***** [FAIL] Test Case 16 failed *****" << endl;
+        return -1;
+    }
+
+    // The histogram spans the id range in equally deep buckets
+    if (id.histogram.size() != STATISTICS_HISTOGRAM_BUCKETS + 1) {
+        cout << "The histogram is not correct." << endl;
+        cout << "***** [FAIL] Test Case 16 failed *****" << endl;
+        return -1;
+    }
+    for (unsigned b = 0; b < id.histogram.size(); b++) {
+        int bound;
+        memcpy(&bound, id.histogram[b].data(), sizeof(int));
+        int expected = b * (statsTupleCount - 1) / STATISTICS_HISTOGRAM_BUCKETS;
+        if (bound != expected) {
+            cout << "Histogram bound " << b << " is " << bound << ", expected " << expected << endl;
+            cout << "***** [FAIL] Test Case 16 failed *****" << endl;
+            return -1;
+        }
+    }
+
+    if (id.indexHeight < 2 || id.indexLeaves < 2 || score.indexHeight != -1) {
+        cout << "The index statistics are not correct." << endl;
+        cout << "***** [FAIL] Test Case 16 failed *****" << endl;
+        return -1;
+    }
+
+    // The row count follows inserts and deletes until the next analyze
+    prepareStatsTuple(statsTupleCount, buffer);
+    rc = rm->insertTuple(tableName, buffer, rid);
+    assert(rc == success && "RelationManager::insertTuple() should not fail.");
+    prepareStatsTuple(statsTupleCount + 1, buffer);
+    rc = rm->insertTuple(tableName, buffer, rid);
+    assert(rc == success && "RelationManager::insertTuple() should not fail.");
+    rc = rm->deleteTuple(tableName, rid);
+    assert(rc == success && "RelationManager::deleteTuple() should not fail.");
+
+    rc = rm->getStatistics(tableName, stats);
+    assert(rc == success && "RelationManager::getStatistics() should not fail.");
+    if (stats.rowCount != statsTupleCount + 1 || stats.modifications != 3) {
+        cout << "The row count was not kept up to date." << endl;
+        cout << "***** [FAIL] Test Case 16 failed *****" << endl;
+        return -1;
+    }
+
+    // Dropping the table drops its statistics
+    rc = rm->deleteTable(tableName);
+    assert(rc == success && "RelationManager::deleteTable() should not fail.");
+    rc = createStatsTable(tableName);
+    assert(rc == success && "RelationManager::createTable() should not fail.");
+    rc = rm->getStatistics(tableName, stats);
+    assert(rc != success && "RelationManager::getStatistics() should fail after the table was recreated.");
+    rc = rm->deleteTable(tableName);
+    assert(rc == success && "RelationManager::deleteTable() should not fail.");
+
+    cout << "***** Test Case 16 Finished. The result will be examined. *****" << endl;
+    return 0;
+}
+
+int main()
+{
+    return TEST_RM_16("tbl_stats");
+}
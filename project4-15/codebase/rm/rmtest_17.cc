@@ -0,0 +1,241 @@
+#include "rm_test_util.h"
+
+const int dictTupleCount = 2000;
+const char *statuses[] = {"pending", "processing", "shipped", "delivered", "cancelled"};
+
+RC createDictTable(const string &tableName)
+{
+    vector<Attribute> attrs;
+    Attribute attr;
+
+    attr.name = "id";
+    attr.type = TypeInt;
+    attr.length = (AttrLength)4;
+    attrs.push_back(attr);
+
+    attr.name = "status";
+    attr.type = TypeVarChar;
+    attr.length = (AttrLength)20;
+    attrs.push_back(attr);
+
+    attr.name = "note";
+    attr.type = TypeVarChar;
+    attr.length = (AttrLength)30;
+    attrs.push_back(attr);
+
+    rm->deleteTable(tableName);
+    return rm->createTable(tableName, attrs);
+}
+
+// status is one of 5 strings, null for every seventh tuple. note is different for every tuple.
+int prepareDictTuple(int i, const string &status, void *buffer)
+{
+    char nulls = (i % 7 == 0) ? (1 << 6) : 0;
+    string note = "note " + to_string(i);
+
+    int offset = 0;
+    memcpy((char *)buffer + offset, &nulls, 1);
+    offset += 1;
+    memcpy((char *)buffer + offset, &i, sizeof(int));
+    offset += sizeof(int);
+    if (!nulls) {
+        int length = status.length();
+        memcpy((char *)buffer + offset, &length, sizeof(int));
+        offset += sizeof(int);
+        memcpy((char *)buffer + offset, status.c_str(), length);
+        offset += length;
+    }
+    int length = note.length();
+    memcpy((char *)buffer + offset, &length, sizeof(int));
+    offset += sizeof(int);
+    memcpy((char *)buffer + offset, note.c_str(), length);
+    offset += length;
+    return offset;
+}
+
+// Count the tuples a scan on status returns, checking each status it projects against the condition
+int countByStatus(const string &tableName, CompOp compOp, const string &status)
+{
+    char value[50];
+    int length = status.length();
+    memcpy(value, &length, sizeof(int));
+    memcpy(value + sizeof(int), status.c_str(), length);
+
+    vector<string> attributes;
+    attributes.push_back("status");
+    RM_ScanIterator rmsi;
+    RC rc = rm->scan(tableName, "status", compOp, value, attributes, rmsi);
+    assert(rc == success && "RelationManager::scan() should not fail.");
+
+    RID rid;
+    char returnedData[100];
+    int count = 0;
+    while (rmsi.getNextTuple(rid, returnedData) != RM_EOF) {
+        int returnedLength;
+        memcpy(&returnedLength, returnedData + 1, sizeof(int));
+        string returned(returnedData + 1 + sizeof(int), returnedLength);
+        if (returnedData[0] != 0 || (compOp == EQ_OP && returned != status) || (compOp == NE_OP && returned == status) ||
+                (compOp == LT_OP && returned >= status))
+            return -1;
+        count++;
+    }
+    rmsi.close();
+    return count;
+}
+
+int pageCount(const string &tableName)
+{
+    TableStatistics stats;
+    RC rc = rm->analyze(tableName);
+    assert(rc == success && "RelationManager::analyze() should not fail.");
+    rc = rm->getStatistics(tableName, stats);
+    assert(rc == success && "RelationManager::getStatistics() should not fail.");
+    return stats.pageCount;
+}
+
+RC TEST_RM_17(const string &tableName, const string &encodedTableName)
+{
+    // Functions Tested:
+    // 1. encodeColumn on a table with tuples and on an empty one
+    // 2. getEncodedAttributes
+    // 3. Tuples and scans of a dictionary encoded column
+    cout << endl << "***** In RM Test Case 17 *****" << endl;
+
+    RC rc = createDictTable(tableName);
+    assert(rc == success && "RelationManager::createTable() should not fail.");
+    rc = createDictTable(encodedTableName);
+    assert(rc == success && "RelationManager::createTable() should not fail.");
+    rc = rm->encodeColumn(encodedTableName, "status");
+    assert(rc == success && "RelationManager::encodeColumn() should not fail.");
+
+    vector<RID> rids;
+    RID rid;
+    char buffer[100];
+    for (int i = 0; i < dictTupleCount; i++) {
+        prepareDictTuple(i, statuses[i % 5], buffer);
+        rc = rm->insertTuple(tableName, buffer, rid);
+        assert(rc == success && "RelationManager::insertTuple() should not fail.");
+        rids.push_back(rid);
+        rc = rm->insertTuple(encodedTableName, buffer, rid);
+        assert(rc == success && "RelationManager::insertTuple() should not fail.");
+    }
+
+    // Codes take less room than the strings
+    int plainPages = pageCount(tableName);
+    int encodedPages = pageCount(encodedTableName);
+    cout << "Pages: " << plainPages << " plain, " << encodedPages << " encoded" << endl;
+    if (encodedPages >= plainPages) {
+        cout << "The encoded table is not smaller." << endl;
+        cout << "***** [FAIL] Test Case 17 failed *****" << endl;
+        return -1;
+    }
+
+    // A dictionary file that can't be read fails the tuple operations, the codes can't be decoded without it
+    FILE *brokenDictionary = fopen((tableName + ".t.dict").c_str(), "w");
+    fclose(brokenDictionary);
+    rc = rm->readTuple(tableName, rids[0], buffer);
+    remove((tableName + ".t.dict").c_str());
+    if (rc == success) {
+        cout << "The table was read without its dictionary." << endl;
+        cout << "***** [FAIL] Test Case 17 failed *****" << endl;
+        return -1;
+    }
+
+    // Migrate the table that has tuples
+    int expectedShipped = countByStatus(tableName, EQ_OP, "shipped");
+    rc = rm->encodeColumn(tableName, "status");
+    assert(rc == success && "RelationManager::encodeColumn() should not fail.");
+    vector<string> encoded;
+    rc = rm->getEncodedAttributes(tableName, encoded);
+    assert(rc == success && "RelationManager::getEncodedAttributes() should not fail.");
+    if (encoded.size() != 1 || encoded[0] != "status" ||
+            rm->encodeColumn(tableName, "status") == success || rm->encodeColumn(tableName, "id") == success) {
+        cout << "The catalog does not list the encoded column." << endl;
+        cout << "***** [FAIL] Test Case 17 failed *****" << endl;
+        return -1;
+    }
+
+    char returnedData[100];
+    for (int i = 0; i < dictTupleCount; i++) {
+        int size = prepareDictTuple(i, statuses[i % 5], buffer);
+        rc = rm->readTuple(tableName, rids[i], returnedData);
+        assert(rc == success && "RelationManager::readTuple() should not fail.");
+        if (memcmp(buffer, returnedData, size) != 0) {
+            cout << "Tuple " << i << " changed in the migration." << endl;
+            cout << "***** [FAIL] Test Case 17 failed *****" << endl;
+            return -1;
+        }
+    }
+    rc = rm->readAttribute(tableName, rids[3], "status", returnedData);
+    assert(rc == success && "RelationManager::readAttribute() should not fail.");
+    if (returnedData[0] != 0 || memcmp(returnedData + 1 + sizeof(int), statuses[3], strlen(statuses[3])) != 0) {
+        cout << "The attribute was not decoded." << endl;
+        cout << "***** [FAIL] Test Case 17 failed *****" << endl;
+        return -1;
+    }
+
+    // Equality compares codes, the other comparisons decode. Nulls match nothing.
+    int nonNull = dictTupleCount - (dictTupleCount + 6) / 7;
+    int shipped = countByStatus(tableName, EQ_OP, "shipped");
+    int notShipped = countByStatus(tableName, NE_OP, "shipped");
+    int below = countByStatus(tableName, LT_OP, "pending");
+    int unknown = countByStatus(tableName, EQ_OP, "lost");
+    int notUnknown = countByStatus(tableName, NE_OP, "lost");
+    cout << "shipped: " << shipped << ", not shipped: " << notShipped << ", below pending: " << below << endl;
+    if (shipped != expectedShipped || shipped + notShipped != nonNull || below <= 0 || unknown != 0 || notUnknown != nonNull ||
+            countByStatus(encodedTableName, EQ_OP, "shipped") != shipped) {
+        cout << "The scans on the encoded column are not correct." << endl;
+        cout << "***** [FAIL] Test Case 17 failed *****" << endl;
+        return -1;
+    }
+
+    // The dictionary is read when the table is first opened, not for every tuple
+    FileStats *dictionaryStats = StatsRegistry::instance()->getFileStats(tableName + ".t.dict");
+    uint64_t dictionaryReads = dictionaryStats->reads;
+    for (int i = 0; i < 100; i++) {
+        rc = rm->readTuple(tableName, rids[i], returnedData);
+        assert(rc == success && "RelationManager::readTuple() should not fail.");
+    }
+    if (dictionaryStats->reads != dictionaryReads) {
+        cout << "The dictionary was read " << dictionaryStats->reads - dictionaryReads << " times by 100 tuple reads." << endl;
+        cout << "***** [FAIL] Test Case 17 failed *****" << endl;
+        return -1;
+    }
+
+    // New values get codes as they come
+    prepareDictTuple(1, "returned", buffer);
+    rc = rm->updateTuple(tableName, buffer, rids[1]);
+    assert(rc == success && "RelationManager::updateTuple() should not fail.");
+    prepareDictTuple(dictTupleCount, "returned", buffer);
+    rc = rm->insertTuple(tableName, buffer, rid);
+    assert(rc == success && "RelationManager::insertTuple() should not fail.");
+    int size = prepareDictTuple(1, "returned", buffer);
+    rc = rm->readTuple(tableName, rids[1], returnedData);
+    assert(rc == success && "RelationManager::readTuple() should not fail.");
+    if (memcmp(buffer, returnedData, size) != 0 || countByStatus(tableName, EQ_OP, "returned") != 2) {
+        cout << "The new value was not encoded." << endl;
+        cout << "***** [FAIL] Test Case 17 failed *****" << endl;
+        return -1;
+    }
+
+    // The dictionary goes with the table
+    rc = rm->deleteTable(tableName);
+    assert(rc == success && "RelationManager::deleteTable() should not fail.");
+    rc = rm->deleteTable(encodedTableName);
+    assert(rc == success && "RelationManager::deleteTable() should not fail.");
+    FILE *dictionaryFile = fopen((tableName + ".t.dict").c_str(), "r");
+    if (dictionaryFile != NULL) {
+        fclose(dictionaryFile);
+        cout << "The dictionary was not deleted with the table." << endl;
+        cout << "***** [FAIL] Test Case 17 failed *****" << endl;
+        return -1;
+    }
+
+    cout << "***** Test Case 17 Finished. The result will be examined. *****" << endl;
+    return 0;
+}
+
+int main()
+{
+    return TEST_RM_17("tbl_dict", "tbl_dict_encoded");
+}
@@ -0,0 +1,168 @@
+#include "rm_test_util.h"
+
+const int vacuumTupleCount = 1000;
+
+// Every fourth tuple is grown by an update
+int vacuumPayloadLength(int id)
+{
+    return id % 4 == 0 ? 900 : 20;
+}
+
+// Half of the small tuples and half of the grown ones are deleted
+bool isVacuumSurvivor(int id)
+{
+    return id % 2 == 0 && id % 8 != 4;
+}
+
+// Fill, fragment and vacuum the table numPages at a time, or all at once if numPages is 0,
+// then check its tuples and its index. Returns the number of pages left, -1 on failure.
+int vacuumAndCheck(const string &tableName, unsigned numPages)
+{
+    RC rc = createIdTextTable(tableName, "payload", 1000);
+    assert(rc == success && "RelationManager::createTable() should not fail.");
+    rc = rm->createIndex(tableName, "id");
+    assert(rc == success && "RelationManager::createIndex() should not fail.");
+
+    vector<RID> rids;
+    RID rid;
+    char buffer[1100];
+    for (int i = 0; i < vacuumTupleCount; i++) {
+        prepareIdTextTuple(i, 20, buffer);
+        rc = rm->insertTuple(tableName, buffer, rid);
+        assert(rc == success && "RelationManager::insertTuple() should not fail.");
+        rids.push_back(rid);
+    }
+
+    // Grown tuples are forwarded to other pages, deleted ones leave holes
+    for (int i = 0; i < vacuumTupleCount; i += 4) {
+        prepareIdTextTuple(i, vacuumPayloadLength(i), buffer);
+        rc = rm->updateTuple(tableName, buffer, rids[i]);
+        assert(rc == success && "RelationManager::updateTuple() should not fail.");
+    }
+    for (int i = 0; i < vacuumTupleCount; i++) {
+        if (!isVacuumSurvivor(i)) {
+            rc = rm->deleteTuple(tableName, rids[i]);
+            assert(rc == success && "RelationManager::deleteTuple() should not fail.");
+        }
+    }
+    int pagesBefore = getTablePageCount(tableName);
+
+    // A record forwarded in the first phase can move again in the second, within one batch
+    int steps = 0;
+    if (numPages == 0) {
+        rc = rm->vacuum(tableName);
+        if (rc == success)
+            rc = RM_EOF;
+        steps = 1;
+    } else {
+        RM_VacuumIterator rmvi;
+        rc = rm->vacuum(tableName, rmvi);
+        assert(rc == success && "RelationManager::vacuum() should not fail.");
+        while ((rc = rmvi.vacuumPages(numPages)) == success)
+            steps++;
+        rmvi.close();
+    }
+    int pagesAfter = getTablePageCount(tableName);
+    cout << "Pages: " << pagesBefore << " before, " << pagesAfter << " after " << steps << " steps" << endl;
+    if (rc != RM_EOF || (numPages && steps < 2) || pagesAfter >= pagesBefore) {
+        cout << "The vacuum did not shrink the table: " << rc << endl;
+        cout << "***** [FAIL] Test Case 18 failed *****" << endl;
+        return -1;
+    }
+
+    // Every tuple is there once, as it was
+    vector<RID> vacuumedRids(vacuumTupleCount);
+    vector<int> seen(vacuumTupleCount, 0);
+    vector<string> attributes;
+    attributes.push_back("id");
+    attributes.push_back("payload");
+    RM_ScanIterator rmsi;
+    rc = rm->scan(tableName, "", NO_OP, NULL, attributes, rmsi);
+    assert(rc == success && "RelationManager::scan() should not fail.");
+    char returnedData[1100];
+    int count = 0;
+    while (rmsi.getNextTuple(rid, returnedData) != RM_EOF) {
+        int id;
+        memcpy(&id, returnedData + 1, sizeof(int));
+        int size = prepareIdTextTuple(id, vacuumPayloadLength(id), buffer);
+        if (id < 0 || id >= vacuumTupleCount || !isVacuumSurvivor(id) || memcmp(buffer, returnedData, size) != 0) {
+            cout << "The scan returned a tuple that changed." << endl;
+            cout << "***** [FAIL] Test Case 18 failed *****" << endl;
+            return -1;
+        }
+        seen[id]++;
+        vacuumedRids[id] = rid;
+        count++;
+    }
+    rmsi.close();
+    for (int i = 0; i < vacuumTupleCount; i++) {
+        if (isVacuumSurvivor(i) && seen[i] != 1) {
+            cout << "The scan returned tuple " << i << " " << seen[i] << " times." << endl;
+            cout << "***** [FAIL] Test Case 18 failed *****" << endl;
+            return -1;
+        }
+    }
+
+    // The index has the RIDs the tuples moved to
+    for (int i = 0; i < vacuumTupleCount; i++) {
+        if (!isVacuumSurvivor(i))
+            continue;
+        RM_IndexScanIterator rmisi;
+        rc = rm->indexScan(tableName, "id", &i, &i, true, true, rmisi);
+        assert(rc == success && "RelationManager::indexScan() should not fail.");
+        char key[sizeof(int)];
+        int matches = 0;
+        while (rmisi.getNextEntry(rid, key) != RM_EOF) {
+            if (rid.pageNum != vacuumedRids[i].pageNum || rid.slotNum != vacuumedRids[i].slotNum) {
+                cout << "The index entry of tuple " << i << " was not moved." << endl;
+                cout << "***** [FAIL] Test Case 18 failed *****" << endl;
+                return -1;
+            }
+            matches++;
+        }
+        rmisi.close();
+        int size = prepareIdTextTuple(i, vacuumPayloadLength(i), buffer);
+        rc = rm->readTuple(tableName, vacuumedRids[i], returnedData);
+        assert(rc == success && "RelationManager::readTuple() should not fail.");
+        if (matches != 1 || memcmp(buffer, returnedData, size) != 0) {
+            cout << "The index does not find tuple " << i << "." << endl;
+            cout << "***** [FAIL] Test Case 18 failed *****" << endl;
+            return -1;
+        }
+    }
+    return pagesAfter;
+}
+
+RC TEST_RM_18(const string &tableName)
+{
+    // Functions Tested:
+    // 1. vacuum, all at once and a range of pages at a time
+    // 2. Tuples, scans and index scans after a vacuum
+    cout << endl << "***** In RM Test Case 18 *****" << endl;
+
+    if (vacuumAndCheck(tableName, 0) < 0)
+        return -1;
+    int pagesAfter = vacuumAndCheck(tableName, 2);
+    if (pagesAfter < 0)
+        return -1;
+
+    // A compact table stays as it is, and the catalog can't be vacuumed
+    RC rc = rm->vacuum(tableName);
+    assert(rc == success && "RelationManager::vacuum() should not fail.");
+    if (getTablePageCount(tableName) != pagesAfter || rm->vacuum("Tables") == success) {
+        cout << "The second vacuum changed the table." << endl;
+        cout << "***** [FAIL] Test Case 18 failed *****" << endl;
+        return -1;
+    }
+
+    rc = rm->deleteTable(tableName);
+    assert(rc == success && "RelationManager::deleteTable() should not fail.");
+
+    cout << "***** Test Case 18 Finished. The result will be examined. *****" << endl;
+    return 0;
+}
+
+int main()
+{
+    return TEST_RM_18("tbl_vacuum");
+}
@@ -0,0 +1,95 @@
+#include "rm_test_util.h"
+
+const int fillTupleCount = 2000;
+
+// Insert the tuples, grow each of them by an update and read them back. Returns the forwarding
+// addresses followed by the reads, -1 if a tuple changed.
+int growTuples(const string &tableName, int &pages)
+{
+    vector<RID> rids;
+    RID rid;
+    char buffer[200];
+    for (int i = 0; i < fillTupleCount; i++) {
+        prepareIdTextTuple(i, 40, buffer);
+        RC rc = rm->insertTuple(tableName, buffer, rid);
+        assert(rc == success && "RelationManager::insertTuple() should not fail.");
+        rids.push_back(rid);
+    }
+    pages = getTablePageCount(tableName);
+
+    for (int i = 0; i < fillTupleCount; i++) {
+        prepareIdTextTuple(i, 60, buffer);
+        RC rc = rm->updateTuple(tableName, buffer, rids[i]);
+        assert(rc == success && "RelationManager::updateTuple() should not fail.");
+    }
+
+    FileStats *stats = StatsRegistry::instance()->getFileStats(tableName + ".t");
+    uint64_t hopsBefore = stats->forwardHops;
+    char returnedData[200];
+    for (int i = 0; i < fillTupleCount; i++) {
+        int size = prepareIdTextTuple(i, 60, buffer);
+        RC rc = rm->readTuple(tableName, rids[i], returnedData);
+        assert(rc == success && "RelationManager::readTuple() should not fail.");
+        if (memcmp(buffer, returnedData, size) != 0)
+            return -1;
+    }
+    return stats->forwardHops - hopsBefore;
+}
+
+RC TEST_RM_19(const string &fullTableName, const string &sparseTableName)
+{
+    // Functions Tested:
+    // 1. createTable with a fill factor
+    // 2. getFillFactor
+    // 3. Updates growing tuples on packed and on sparse pages
+    cout << endl << "***** In RM Test Case 19 *****" << endl;
+
+    RC rc = createIdTextTable(fullTableName, "comment", 100, 100);
+    assert(rc == success && "RelationManager::createTable() should not fail.");
+    rc = createIdTextTable(sparseTableName, "comment", 100, 70);
+    assert(rc == success && "RelationManager::createTable() should not fail.");
+
+    unsigned fullFillFactor, sparseFillFactor;
+    rc = rm->getFillFactor(fullTableName, fullFillFactor);
+    assert(rc == success && "RelationManager::getFillFactor() should not fail.");
+    rc = rm->getFillFactor(sparseTableName, sparseFillFactor);
+    assert(rc == success && "RelationManager::getFillFactor() should not fail.");
+    if (fullFillFactor != 100 || sparseFillFactor != 70 ||
+            createIdTextTable("tbl_fill_bad", "comment", 100, 0) == success ||
+            createIdTextTable("tbl_fill_bad", "comment", 100, 101) == success) {
+        cout << "The catalog does not keep the fill factor." << endl;
+        cout << "***** [FAIL] Test Case 19 failed *****" << endl;
+        return -1;
+    }
+
+    int fullPages, sparsePages;
+    int fullHops = growTuples(fullTableName, fullPages);
+    int sparseHops = growTuples(sparseTableName, sparsePages);
+    cout << "Fill factor 100: " << fullPages << " pages, " << fullHops << " forwarding hops" << endl;
+    cout << "Fill factor 70: " << sparsePages << " pages, " << sparseHops << " forwarding hops" << endl;
+    if (fullHops < 0 || sparseHops < 0) {
+        cout << "A tuple changed." << endl;
+        cout << "***** [FAIL] Test Case 19 failed *****" << endl;
+        return -1;
+    }
+
+    // The room left on each page takes the growth
+    if (sparsePages <= fullPages || fullHops == 0 || sparseHops != 0) {
+        cout << "The fill factor did not leave room for the updates." << endl;
+        cout << "***** [FAIL] Test Case 19 failed *****" << endl;
+        return -1;
+    }
+
+    rc = rm->deleteTable(fullTableName);
+    assert(rc == success && "RelationManager::deleteTable() should not fail.");
+    rc = rm->deleteTable(sparseTableName);
+    assert(rc == success && "RelationManager::deleteTable() should not fail.");
+
+    cout << "***** Test Case 19 Finished. The result will be examined. *****" << endl;
+    return 0;
+}
+
+int main()
+{
+    return TEST_RM_19("tbl_fill_full", "tbl_fill_sparse");
+}
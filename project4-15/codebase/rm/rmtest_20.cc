@@ -0,0 +1,194 @@
+#include "rm_test_util.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+const int appendTupleCount = 2000;
+
+int appendCommentLength(int id)
+{
+    return 20 + id % 30;
+}
+
+// Whether rid comes right after prev in the order of an append-only file
+bool followsRid(const RID &prev, const RID &rid)
+{
+    if (rid.pageNum == prev.pageNum)
+        return rid.slotNum == prev.slotNum + 1;
+    return rid.pageNum == prev.pageNum + 1 && rid.slotNum == 0;
+}
+
+RC TEST_RM_20(const string &tableName)
+{
+    // Functions Tested:
+    // 1. createTable append-only
+    // 2. insertTuple filling a tail page
+    // 3. readTuple, scan and indexScan of the tuples appended
+    // 4. deleteTuple (the slot is not reused)
+    // 5. flushAll, and the tail page written when the process exits
+    cout << endl << "***** In RM Test Case 20 *****" << endl;
+
+    RC rc = createIdTextTable(tableName, "comment", 100, DEFAULT_FILL_FACTOR, true);
+    assert(rc == success && "RelationManager::createTable() should not fail.");
+    rc = rm->createIndex(tableName, "id");
+    assert(rc == success && "RelationManager::createIndex() should not fail.");
+
+    FileStats *stats = StatsRegistry::instance()->getFileStats(tableName + ".t");
+    uint64_t scannedBefore = stats->insertPagesScanned;
+    uint64_t writesBefore = stats->writes + stats->appends;
+
+    vector<RID> rids;
+    RID rid;
+    char buffer[200];
+    for (int i = 0; i < appendTupleCount; i++) {
+        prepareIdTextTuple(i, appendCommentLength(i), buffer);
+        rc = rm->insertTuple(tableName, buffer, rid);
+        assert(rc == success && "RelationManager::insertTuple() should not fail.");
+        if (!rids.empty() && !followsRid(rids.back(), rid)) {
+            cout << "Tuple " << i << " was not appended after tuple " << i - 1 << "." << endl;
+            cout << "***** [FAIL] Test Case 20 failed *****" << endl;
+            return -1;
+        }
+        rids.push_back(rid);
+    }
+
+    // Each full page was written once, the tail page is still in memory
+    uint64_t pageWrites = stats->writes + stats->appends - writesBefore;
+    cout << "Appended " << appendTupleCount << " tuples to " << rids.back().pageNum + 1 << " pages with "
+         << pageWrites << " page writes" << endl;
+    if (stats->insertPagesScanned != scannedBefore || pageWrites > rids.back().pageNum) {
+        cout << "Inserts looked for free space or wrote pages before they were full." << endl;
+        cout << "***** [FAIL] Test Case 20 failed *****" << endl;
+        return -1;
+    }
+
+    // Reads see the tuples of the tail page
+    char returnedData[200];
+    for (int i = 0; i < appendTupleCount; i++) {
+        int size = prepareIdTextTuple(i, appendCommentLength(i), buffer);
+        rc = rm->readTuple(tableName, rids[i], returnedData);
+        assert(rc == success && "RelationManager::readTuple() should not fail.");
+        if (memcmp(buffer, returnedData, size) != 0) {
+            cout << "Tuple " << i << " changed." << endl;
+            cout << "***** [FAIL] Test Case 20 failed *****" << endl;
+            return -1;
+        }
+    }
+
+    // A deleted slot is left empty, the next tuple goes after the last one
+    rc = rm->deleteTuple(tableName, rids[10]);
+    assert(rc == success && "RelationManager::deleteTuple() should not fail.");
+    prepareIdTextTuple(appendTupleCount, appendCommentLength(appendTupleCount), buffer);
+    rc = rm->insertTuple(tableName, buffer, rid);
+    assert(rc == success && "RelationManager::insertTuple() should not fail.");
+    if (!followsRid(rids.back(), rid)) {
+        cout << "The tuple inserted after a delete was not appended." << endl;
+        cout << "***** [FAIL] Test Case 20 failed *****" << endl;
+        return -1;
+    }
+    rids.push_back(rid);
+
+    // A scan returns the tuples in the order they were inserted
+    RM_ScanIterator rmsi;
+    vector<string> attributes;
+    attributes.push_back("id");
+    rc = rm->scan(tableName, "", NO_OP, NULL, attributes, rmsi);
+    assert(rc == success && "RelationManager::scan() should not fail.");
+    int expected = 0;
+    while (rmsi.getNextTuple(rid, returnedData) != RM_EOF) {
+        if (expected == 10)
+            expected++;
+        int id;
+        memcpy(&id, returnedData + 1, sizeof(int));
+        if (id != expected || rid.pageNum != rids[id].pageNum || rid.slotNum != rids[id].slotNum) {
+            cout << "The scan returned tuple " << id << " in place of tuple " << expected << "." << endl;
+            cout << "***** [FAIL] Test Case 20 failed *****" << endl;
+            return -1;
+        }
+        expected++;
+    }
+    rmsi.close();
+    if (expected != appendTupleCount + 1) {
+        cout << "The scan stopped at tuple " << expected << "." << endl;
+        cout << "***** [FAIL] Test Case 20 failed *****" << endl;
+        return -1;
+    }
+
+    // The index has the tuples that were appended
+    int id = appendTupleCount;
+    RM_IndexScanIterator rmisi;
+    rc = rm->indexScan(tableName, "id", &id, &id, true, true, rmisi);
+    assert(rc == success && "RelationManager::indexScan() should not fail.");
+    char key[sizeof(int)];
+    int matches = 0;
+    while (rmisi.getNextEntry(rid, key) != RM_EOF) {
+        if (rid.pageNum == rids[id].pageNum && rid.slotNum == rids[id].slotNum)
+            matches++;
+    }
+    rmisi.close();
+    if (matches != 1) {
+        cout << "The index does not find the last tuple." << endl;
+        cout << "***** [FAIL] Test Case 20 failed *****" << endl;
+        return -1;
+    }
+
+    // flushAll writes the tail page
+    uint64_t writesBeforeFlush = stats->writes + stats->appends;
+    rc = rm->flushAll();
+    assert(rc == success && "RelationManager::flushAll() should not fail.");
+    prepareIdTextTuple(appendTupleCount + 1, appendCommentLength(appendTupleCount + 1), buffer);
+    rc = rm->insertTuple(tableName, buffer, rid);
+    assert(rc == success && "RelationManager::insertTuple() should not fail.");
+    rc = rm->flushAll();
+    assert(rc == success && "RelationManager::flushAll() should not fail.");
+    if (stats->writes + stats->appends != writesBeforeFlush + 1) {
+        cout << "flushAll wrote " << stats->writes + stats->appends - writesBeforeFlush << " pages, not the tail page." << endl;
+        cout << "***** [FAIL] Test Case 20 failed *****" << endl;
+        return -1;
+    }
+
+    rc = rm->deleteTable(tableName);
+    assert(rc == success && "RelationManager::deleteTable() should not fail.");
+
+    // A process that appends and exits leaves the tuples its index entries point to
+    rc = createIdTextTable(tableName, "comment", 100, DEFAULT_FILL_FACTOR, true);
+    assert(rc == success && "RelationManager::createTable() should not fail.");
+    rc = rm->createIndex(tableName, "id");
+    assert(rc == success && "RelationManager::createIndex() should not fail.");
+    pid_t child = fork();
+    if (child == 0) {
+        for (int i = 0; i < 10; i++) {
+            prepareIdTextTuple(i, appendCommentLength(i), buffer);
+            rm->insertTuple(tableName, buffer, rid);
+        }
+        exit(0);
+    }
+    int status;
+    waitpid(child, &status, 0);
+    rc = rm->indexScan(tableName, "id", NULL, NULL, true, true, rmisi);
+    assert(rc == success && "RelationManager::indexScan() should not fail.");
+    matches = 0;
+    while (rmisi.getNextEntry(rid, key) != RM_EOF) {
+        memcpy(&id, key, sizeof(int));
+        int size = prepareIdTextTuple(id, appendCommentLength(id), buffer);
+        if (rm->readTuple(tableName, rid, returnedData) == success && memcmp(buffer, returnedData, size) == 0)
+            matches++;
+    }
+    rmisi.close();
+    if (matches != 10) {
+        cout << "Only " << matches << " of the 10 tuples indexed before the exit were written." << endl;
+        cout << "***** [FAIL] Test Case 20 failed *****" << endl;
+        return -1;
+    }
+
+    rc = rm->deleteTable(tableName);
+    assert(rc == success && "RelationManager::deleteTable() should not fail.");
+
+    cout << "***** Test Case 20 Finished. The result will be examined. *****" << endl;
+    return 0;
+}
+
+int main()
+{
+    return TEST_RM_20("tbl_append");
+}
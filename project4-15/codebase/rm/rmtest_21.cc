@@ -0,0 +1,110 @@
+#include "rm_test_util.h"
+
+const int overflowTupleCount = 300;
+const int longBodyLength = 6000;
+
+// Every third tuple has a body longer than a page
+int prepareOverflowTuple(int id, void *buffer)
+{
+    return prepareIdTextTuple(id, id % 3 == 0 ? longBodyLength : 30 + id % 40, buffer, 10);
+}
+
+RC TEST_RM_21(const string &tableName)
+{
+    // Functions Tested:
+    // 1. storeOutOfLine on a table with tuples
+    // 2. insertTuple of tuples larger than a page
+    // 3. readTuple, readAttribute and scan of the tuples
+    // 4. deleteTable dropping the overflow pages
+    cout << endl << "***** In RM Test Case 21 *****" << endl;
+
+    RC rc = createIdTextTable(tableName, "body", longBodyLength);
+    assert(rc == success && "RelationManager::createTable() should not fail.");
+
+    vector<RID> rids(overflowTupleCount);
+    char *buffer = (char *) malloc(2 * PAGE_SIZE);
+    char *returnedData = (char *) malloc(2 * PAGE_SIZE);
+    for (int i = 0; i < overflowTupleCount; i++) {
+        if (i % 3 == 0)
+            continue;
+        prepareOverflowTuple(i, buffer);
+        rc = rm->insertTuple(tableName, buffer, rids[i]);
+        assert(rc == success && "RelationManager::insertTuple() should not fail.");
+    }
+
+    rc = rm->storeOutOfLine("Tables", "table-name");
+    assert(rc != success && "The columns of the catalog should stay in their tuples.");
+    rc = rm->storeOutOfLine(tableName, "body", 100, true);
+    assert(rc == success && "RelationManager::storeOutOfLine() should not fail.");
+
+    for (int i = 0; i < overflowTupleCount; i += 3) {
+        prepareOverflowTuple(i, buffer);
+        rc = rm->insertTuple(tableName, buffer, rids[i]);
+        assert(rc == success && "RelationManager::insertTuple() should not fail.");
+    }
+
+    for (int i = 0; i < overflowTupleCount; i++) {
+        int size = prepareOverflowTuple(i, buffer);
+        rc = rm->readTuple(tableName, rids[i], returnedData);
+        assert(rc == success && "RelationManager::readTuple() should not fail.");
+        if (memcmp(buffer, returnedData, size) != 0) {
+            cout << "Tuple " << i << " changed." << endl;
+            cout << "***** [FAIL] Test Case 21 failed *****" << endl;
+            return -1;
+        }
+    }
+    prepareOverflowTuple(42, buffer);
+    rc = rm->readAttribute(tableName, rids[42], "body", returnedData);
+    assert(rc == success && "RelationManager::readAttribute() should not fail.");
+    if (memcmp(buffer + 1 + sizeof(int), returnedData + 1, sizeof(int) + longBodyLength) != 0) {
+        cout << "The body of tuple 42 changed." << endl;
+        cout << "***** [FAIL] Test Case 21 failed *****" << endl;
+        return -1;
+    }
+
+    // The ids are scanned without reading the bodies, only the header page of the overflow file
+    FileStats *overflowStats = StatsRegistry::instance()->getFileStats(tableName + ".t.ovf");
+    uint64_t readsBefore = overflowStats->reads;
+    RM_ScanIterator rmsi;
+    vector<string> attributes;
+    attributes.push_back("id");
+    rc = rm->scan(tableName, "", NO_OP, NULL, attributes, rmsi);
+    assert(rc == success && "RelationManager::scan() should not fail.");
+    RID rid;
+    int scanned = 0;
+    long long idSum = 0;
+    while (rmsi.getNextTuple(rid, returnedData) != RM_EOF) {
+        int id;
+        memcpy(&id, returnedData + 1, sizeof(int));
+        idSum += id;
+        scanned++;
+    }
+    rmsi.close();
+    cout << "Scanned " << scanned << " ids with " << overflowStats->reads - readsBefore << " overflow page reads" << endl;
+    if (scanned != overflowTupleCount || idSum != (long long) overflowTupleCount * (overflowTupleCount - 1) / 2 ||
+        overflowStats->reads > readsBefore + 1) {
+        cout << "The scan of the ids was wrong or read the bodies." << endl;
+        cout << "***** [FAIL] Test Case 21 failed *****" << endl;
+        return -1;
+    }
+
+    rc = rm->deleteTable(tableName);
+    assert(rc == success && "RelationManager::deleteTable() should not fail.");
+    FILE *overflowFile = fopen((tableName + ".t.ovf").c_str(), "rb");
+    if (overflowFile != NULL) {
+        fclose(overflowFile);
+        cout << "The overflow pages outlived the table." << endl;
+        cout << "***** [FAIL] Test Case 21 failed *****" << endl;
+        return -1;
+    }
+
+    free(buffer);
+    free(returnedData);
+    cout << "***** Test Case 21 Finished. The result will be examined. *****" << endl;
+    return 0;
+}
+
+int main()
+{
+    return TEST_RM_21("tbl_overflow");
+}